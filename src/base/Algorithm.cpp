@@ -1,4 +1,8 @@
 #include <algorithm>
+#include <future>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include "base/Algorithm.hpp"
 
 
@@ -304,57 +308,152 @@ double Geo::degree_to_rad(double value)
 }
 
 
-void Geo::down_sampling(Geo::Polyline &points, const double distance)
+namespace
 {
-    points.remove_repeated_points();
-    if (points.size() <= 2 || distance <= 0)
+// 查找(index0, index1)内到线段index0-index1距离平方最大且大于threshold的点,不存在时返回index0
+size_t farthest_point(const double *xs, const double *ys, const size_t index0, const size_t index1, const double threshold)
+{
+    const double ax = xs[index0], ay = ys[index0];
+    const double dx = xs[index1] - ax, dy = ys[index1] - ay;
+    const double len = dx * dx + dy * dy, inv = len > 0 ? 1 / len : 0;
+    double max_distance = threshold;
+    size_t index = index0, i = index0 + 1;
+
+#ifdef __AVX2__
+    if (index1 - i >= 8)
+    {
+        const __m256d vax = _mm256_set1_pd(ax), vay = _mm256_set1_pd(ay), vdx = _mm256_set1_pd(dx), vdy = _mm256_set1_pd(dy);
+        const __m256d vinv = _mm256_set1_pd(inv), zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1), four = _mm256_set1_pd(4);
+        __m256d max_values = _mm256_set1_pd(threshold), max_indexs = _mm256_set1_pd(index0);
+        __m256d indexs = _mm256_set_pd(i + 3, i + 2, i + 1, i);
+        for (; i + 4 <= index1; i += 4)
+        {
+            const __m256d px = _mm256_sub_pd(_mm256_loadu_pd(xs + i), vax), py = _mm256_sub_pd(_mm256_loadu_pd(ys + i), vay);
+            __m256d t = _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(px, vdx), _mm256_mul_pd(py, vdy)), vinv);
+            t = _mm256_min_pd(_mm256_max_pd(t, zero), one);
+            const __m256d ex = _mm256_sub_pd(px, _mm256_mul_pd(t, vdx)), ey = _mm256_sub_pd(py, _mm256_mul_pd(t, vdy));
+            const __m256d values = _mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey));
+            const __m256d mask = _mm256_cmp_pd(values, max_values, _CMP_GT_OQ);
+            max_values = _mm256_blendv_pd(max_values, values, mask);
+            max_indexs = _mm256_blendv_pd(max_indexs, indexs, mask);
+            indexs = _mm256_add_pd(indexs, four);
+        }
+        double lane_values[4], lane_indexs[4];
+        _mm256_storeu_pd(lane_values, max_values);
+        _mm256_storeu_pd(lane_indexs, max_indexs);
+        // 距离相等时取下标最小的点,与逐点扫描的结果一致
+        for (int j = 0; j < 4; ++j)
+        {
+            if (const size_t k = lane_indexs[j];
+                k != index0 && (lane_values[j] > max_distance || (lane_values[j] == max_distance && (index == index0 || k < index))))
+            {
+                max_distance = lane_values[j];
+                index = k;
+            }
+        }
+    }
+#endif
+
+    for (; i < index1; ++i)
     {
-        return;
+        const double px = xs[i] - ax, py = ys[i] - ay;
+        const double t = std::min(std::max((px * dx + py * dy) * inv, 0.0), 1.0);
+        const double ex = px - t * dx, ey = py - t * dy;
+        if (const double value = ex * ex + ey * ey; value > max_distance)
+        {
+            max_distance = value;
+            index = i;
+        }
     }
-    std::vector<bool> mask(points.size(), true);
+    return index;
+}
+
+// 各区间互不相交,两侧都较大时左侧交给其他线程处理,level为已拆分的次数,最多拆分到约16个线程
+void down_sampling_subfunc(const double *xs, const double *ys, char *mask, const size_t index0, const size_t index1, const double threshold,
+                           const int level)
+{
+    std::vector<std::future<void>> futures;
     std::vector<std::tuple<size_t, size_t>> stack;
-    mask.front() = mask.back() = false;
-    stack.emplace_back(0, mask.size() - 1);
+    stack.emplace_back(index0, index1);
     while (!stack.empty())
     {
-        const auto [index0, index1] = stack.back();
+        const auto [i0, i1] = stack.back();
         stack.pop_back();
-        double maxDistance = -1;
-        size_t index = index0;
-        for (size_t i = index0 + 1; i < index1; ++i)
+        if (const size_t index = farthest_point(xs, ys, i0, i1, threshold); index > i0)
         {
-            if (const double currentDistance = Geo::distance(points[i], points[index0], points[index1], false);
-                currentDistance > distance && maxDistance < currentDistance)
+            mask[index] = 0;
+            if (level + static_cast<int>(futures.size()) < 4 && index - i0 > 65536 && i1 - index > 65536)
+            {
+                futures.emplace_back(std::async(std::launch::async, down_sampling_subfunc, xs, ys, mask, i0, index, threshold,
+                                                level + static_cast<int>(futures.size()) + 1));
+            }
+            else
             {
-                maxDistance = currentDistance;
-                index = i;
+                stack.emplace_back(i0, index);
             }
+            stack.emplace_back(index, i1);
         }
-        if (index > index0)
+    }
+    for (std::future<void> &f : futures)
+    {
+        f.wait();
+    }
+}
+} // namespace
+
+void Geo::down_sampling(const Geo::Polyline &points, const double distance, std::vector<size_t> &indices)
+{
+    const size_t count = points.size();
+    if (count <= 2 || distance <= 0)
+    {
+        for (size_t i = 0; i < count; ++i)
         {
-            mask[index] = false;
-            stack.emplace_back(index0, index);
-            stack.emplace_back(index, index1);
+            indices.push_back(i);
         }
+        return;
     }
 
-    for (size_t i = points.size() - 2; i > 0; --i)
+    std::vector<double> xs(count), ys(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xs[i] = points[i].x;
+        ys[i] = points[i].y;
+    }
+    std::vector<char> mask(count, 1);
+    mask.front() = mask.back() = 0;
+    down_sampling_subfunc(xs.data(), ys.data(), mask.data(), 0, count - 1, distance * distance, 0);
+    for (size_t i = 0; i < count; ++i)
     {
-        if (mask[i])
+        if (!mask[i])
         {
-            points.remove(i);
+            indices.push_back(i);
         }
     }
 }
 
-
-void Geo::remove_repeated_point(std::vector<Geo::Point> &points)
+void Geo::down_sampling(Geo::Polyline &points, const double distance)
 {
-    for (size_t i = points.size() - 1; i > 0; --i)
+    points.remove_repeated_points();
+    std::vector<size_t> indices;
+    down_sampling(points, distance, indices);
+
+    // 保留的点前移,最后一次性删除尾部
+    const size_t count = points.size(), kept = indices.size();
+    for (size_t i = 0; i < kept; ++i)
     {
-        if (points[i - 1] == points[i])
+        if (indices[i] != i)
         {
-            points.erase(points.begin() + i);
+            points[i] = points[indices[i]];
         }
     }
+    if (kept < count)
+    {
+        points.remove(kept, count - kept);
+    }
+}
+
+
+void Geo::remove_repeated_point(std::vector<Geo::Point> &points)
+{
+    points.erase(std::unique(points.begin(), points.end()), points.end());
 }
\ No newline at end of file
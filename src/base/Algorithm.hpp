@@ -7,10 +7,13 @@
 #include "algorithm/Distance.hpp"
 #include "algorithm/EarCut.hpp"
 #include "algorithm/Foot.hpp"
+#include "algorithm/HashGrid.hpp"
 #include "algorithm/Split.hpp"
 #include "algorithm/Offset.hpp"
 #include "algorithm/Inside.hpp"
 #include "algorithm/Intersection.hpp"
+#include "algorithm/Overlap.hpp"
+#include "algorithm/PointGrid.hpp"
 #include "algorithm/TangencyPoint.hpp"
 #include "algorithm/ArchimedeanSpiral.hpp"
 
@@ -104,6 +107,9 @@ double degree_to_rad(double value);
 
 void down_sampling(Geo::Polyline &points, const double distance);
 
+// Douglas-Peucker化简,按顺序输出保留顶点的序号,首尾顶点总是保留,其余顶点到化简结果的距离不超过distance
+void down_sampling(const Geo::Polyline &points, const double distance, std::vector<size_t> &indices);
+
 
 void remove_repeated_point(std::vector<Geo::Point> &points);
 
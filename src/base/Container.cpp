@@ -1,7 +1,9 @@
-#include <QFontMetrics>
+#include <cfloat>
+#include <memory>
 #include <QStringList>
 #include <utility>
 
+#include "base/Algorithm.hpp"
 #include "base/Container.hpp"
 #include "base/Dimension.hpp"
 
@@ -9,33 +11,15 @@
 // Text
 
 Text::Text(const double x, const double y, const QFont &font, QString text, const int anchor_index)
-    : _text(std::move(text)), _font(font), _anchor_index(anchor_index)
+    : Text(x, y, TextStyleTable::table().intern(font), std::move(text), anchor_index)
 {
-    const QFontMetricsF font_metrics(_font);
-    double width = 2;
-    double height = -font_metrics.leading();
-    const double base_width = font_metrics.boundingRect("0").width();
-    for (const QString &txt : _text.split('\n'))
-    {
-        const QRectF rect = font_metrics.boundingRect(txt);
-        if (std::any_of(txt.begin(), txt.end(), [](QChar c) { return c > QChar(256); }))
-        {
-            width = std::max(width, rect.width() + base_width);
-        }
-        else
-        {
-            width = std::max(width, rect.width());
-        }
-        height += (rect.height() + font_metrics.leading());
-    }
-    if (width <= 2)
-    {
-        width = 20;
-    }
-    if (height <= 2)
-    {
-        height = 20;
-    }
+}
+
+Text::Text(const double x, const double y, const size_t style, QString text, const int anchor_index)
+    : _text(std::move(text)), _style(style), _anchor_index(anchor_index)
+{
+    double width = 0, height = 0;
+    TextStyleTable::table().measure(_style, _text, width, height);
     switch (anchor_index)
     {
     case 0:
@@ -88,31 +72,8 @@ bool Text::empty() const
 void Text::set_text(const QString &str)
 {
     _text = str;
-    const QFontMetricsF font_metrics(_font);
-    double width = 2;
-    double height = -font_metrics.leading();
-    const double base_width = font_metrics.boundingRect("0").width();
-    for (const QString &txt : _text.split('\n'))
-    {
-        const QRectF rect = font_metrics.boundingRect(txt);
-        if (std::any_of(txt.begin(), txt.end(), [](QChar c) { return c > QChar(256); }))
-        {
-            width = std::max(width, rect.width() + base_width);
-        }
-        else
-        {
-            width = std::max(width, rect.width());
-        }
-        height += (rect.height() + font_metrics.leading());
-    }
-    if (width <= 2)
-    {
-        width = 20;
-    }
-    if (height <= 2)
-    {
-        height = 20;
-    }
+    double width = 0, height = 0;
+    TextStyleTable::table().measure(_style, _text, width, height);
     const double rad = angle();
     switch (_anchor_index)
     {
@@ -148,36 +109,14 @@ void Text::set_text(const QString &str)
 
 void Text::set_font(const QFont &font)
 {
-    if (_font == font)
+    const size_t style = TextStyleTable::table().intern(font);
+    if (style == _style)
     {
         return;
     }
-    _font = font;
-    const QFontMetricsF font_metrics(_font);
-    double width = 2;
-    double height = -font_metrics.leading();
-    const double base_width = font_metrics.boundingRect("0").width();
-    for (const QString &txt : _text.split('\n'))
-    {
-        const QRectF rect = font_metrics.boundingRect(txt);
-        if (std::any_of(txt.begin(), txt.end(), [](QChar c) { return c > QChar(256); }))
-        {
-            width = std::max(width, rect.width() + base_width);
-        }
-        else
-        {
-            width = std::max(width, rect.width());
-        }
-        height += (rect.height() + font_metrics.leading());
-    }
-    if (width <= 2)
-    {
-        width = 20;
-    }
-    if (height <= 2)
-    {
-        height = 20;
-    }
+    _style = style;
+    double width = 0, height = 0;
+    TextStyleTable::table().measure(_style, _text, width, height);
     const double rad = angle();
     switch (_anchor_index)
     {
@@ -213,12 +152,12 @@ void Text::set_font(const QFont &font)
 
 const QFont &Text::font() const
 {
-    return _font;
+    return TextStyleTable::table().font(_style);
 }
 
-QFont &Text::font()
+size_t Text::style() const
 {
-    return _font;
+    return _style;
 }
 
 const QString &Text::text() const
@@ -332,8 +271,8 @@ void Text::rotate(const double x, const double y, const double rad)
 
 void Text::scale(const double x, const double y, const double k)
 {
-    QFont font(_font);
-    font.setPointSizeF(std::max(_font.pointSizeF() * k, 1.0));
+    QFont font(this->font());
+    font.setPointSizeF(std::max(font.pointSizeF() * k, 1.0));
     set_font(font);
 }
 
@@ -377,8 +316,7 @@ Geo::AABBRectParams Text::aabbrect_params() const
 void Text::paint(QPainter &painter) const
 {
     painter.rotate(-angle() * 180 / Geo::PI);
-    painter.setFont(_font);
-    // const double h = -QFontMetricsF(_font).height();
+    // const double h = -QFontMetricsF(font()).height();
     // const QStringList txts = _text.split('\n');
     // int index = txts.size();
     // for (const QString &txt : txts)
@@ -1127,3 +1065,235 @@ const Geo::AABBRect &Combination::border() const
 {
     return _border;
 }
+
+
+// Array
+
+namespace
+{
+bool is_intersected(const Geo::AABBRect &rect, const Geo::Geometry *object)
+{
+    switch (object->type())
+    {
+    case Geo::Type::TEXT:
+        {
+            const Text *text = static_cast<const Text *>(object);
+            return Geo::is_intersected(rect, text->shape(0), text->shape(1), text->shape(2), text->shape(3));
+        }
+    case Geo::Type::POLYGON:
+        return Geo::is_intersected(rect, *static_cast<const Geo::Polygon *>(object));
+    case Geo::Type::CIRCLE:
+        return Geo::is_intersected(rect, *static_cast<const Geo::Circle *>(object));
+    case Geo::Type::ELLIPSE:
+        return Geo::is_intersected(rect, *static_cast<const Geo::Ellipse *>(object));
+    case Geo::Type::POLYLINE:
+        return Geo::is_intersected(rect, *static_cast<const Geo::Polyline *>(object));
+    case Geo::Type::BEZIER:
+        return Geo::is_intersected(rect, static_cast<const Geo::CubicBezier *>(object)->shape());
+    case Geo::Type::BSPLINE:
+        return Geo::is_intersected(rect, static_cast<const Geo::BSpline *>(object)->shape());
+    case Geo::Type::ARC:
+        return Geo::is_intersected(rect, *static_cast<const Geo::Arc *>(object));
+    case Geo::Type::POINT:
+        return Geo::is_inside(*static_cast<const Geo::Point *>(object), rect, true);
+    case Geo::Type::COMBINATION:
+        {
+            const Combination *combination = static_cast<const Combination *>(object);
+            return std::any_of(combination->begin(), combination->end(),
+                               [&](const Geo::Geometry *item) { return is_intersected(rect, item); });
+        }
+    default:
+        return false;
+    }
+}
+} // namespace
+
+Array::Array(const std::vector<Geo::Geometry *> &objects)
+{
+    for (const Geo::Geometry *object : objects)
+    {
+        if (const Array *array = dynamic_cast<const Array *>(object))
+        {
+            // 阵列不嵌套,源图形中的阵列展开为各实例的图形
+            for (Geo::Geometry *item : array->explode())
+            {
+                _source.append(item);
+            }
+        }
+        else
+        {
+            _source.append(object->clone());
+        }
+        _source.back()->is_selected = false;
+    }
+    _source_rect = _source.aabbrect_params();
+}
+
+Geo::Type Array::type() const
+{
+    return Geo::Type::ARRAY;
+}
+
+bool Array::empty() const
+{
+    return _source.empty() || _instances.empty();
+}
+
+Array *Array::clone() const
+{
+    return new Array(*this);
+}
+
+ContainerGroup &Array::source()
+{
+    return _source;
+}
+
+const ContainerGroup &Array::source() const
+{
+    return _source;
+}
+
+size_t Array::size() const
+{
+    return _instances.size();
+}
+
+const std::array<double, 6> &Array::operator[](const size_t index) const
+{
+    return _instances[index];
+}
+
+void Array::append(const std::array<double, 6> &mat)
+{
+    _instances.push_back(mat);
+}
+
+void Array::clear()
+{
+    _source.clear();
+    _instances.clear();
+    _source_rect = Geo::AABBRectParams();
+}
+
+void Array::transform(const double a, const double b, const double c, const double d, const double e, const double f)
+{
+    // 实例变换左乘新的变换,源图形保持不变
+    for (std::array<double, 6> &mat : _instances)
+    {
+        mat = {a * mat[0] + b * mat[3], a * mat[1] + b * mat[4], a * mat[2] + b * mat[5] + c,
+               d * mat[0] + e * mat[3], d * mat[1] + e * mat[4], d * mat[2] + e * mat[5] + f};
+    }
+}
+
+void Array::transform(const double mat[6])
+{
+    transform(mat[0], mat[1], mat[2], mat[3], mat[4], mat[5]);
+}
+
+void Array::translate(const double tx, const double ty)
+{
+    for (std::array<double, 6> &mat : _instances)
+    {
+        mat[2] += tx;
+        mat[5] += ty;
+    }
+}
+
+void Array::rotate(const double x, const double y, const double rad)
+{
+    const double cos = std::cos(rad), sin = std::sin(rad);
+    transform(cos, -sin, x - x * cos + y * sin, sin, cos, y - x * sin - y * cos);
+}
+
+void Array::scale(const double x, const double y, const double k)
+{
+    transform(k, 0, x * (1 - k), 0, k, y * (1 - k));
+}
+
+Geo::AABBRect Array::bounding_rect() const
+{
+    if (empty())
+    {
+        return Geo::AABBRect();
+    }
+    const Geo::AABBRectParams params = aabbrect_params();
+    return Geo::AABBRect(params.left, params.top, params.right, params.bottom);
+}
+
+Geo::AABBRectParams Array::aabbrect_params() const
+{
+    Geo::AABBRectParams params;
+    if (empty())
+    {
+        return params;
+    }
+    params.left = params.bottom = DBL_MAX;
+    params.right = params.top = -DBL_MAX;
+    for (size_t i = 0, count = _instances.size(); i < count; ++i)
+    {
+        const Geo::AABBRectParams rect = aabbrect_params(i);
+        params.left = std::min(params.left, rect.left);
+        params.right = std::max(params.right, rect.right);
+        params.bottom = std::min(params.bottom, rect.bottom);
+        params.top = std::max(params.top, rect.top);
+    }
+    return params;
+}
+
+Geo::AABBRectParams Array::aabbrect_params(const size_t index) const
+{
+    // 源图形包围盒的四个角点经实例变换后的包围盒
+    const std::array<double, 6> &mat = _instances[index];
+    Geo::AABBRectParams params{DBL_MAX, -DBL_MAX, -DBL_MAX, DBL_MAX};
+    const double left = _source_rect.left, top = _source_rect.top, right = _source_rect.right, bottom = _source_rect.bottom;
+    for (const Geo::Point &point : {Geo::Point(left, top), Geo::Point(right, top), Geo::Point(right, bottom), Geo::Point(left, bottom)})
+    {
+        const double x = mat[0] * point.x + mat[1] * point.y + mat[2], y = mat[3] * point.x + mat[4] * point.y + mat[5];
+        params.left = std::min(params.left, x);
+        params.right = std::max(params.right, x);
+        params.bottom = std::min(params.bottom, y);
+        params.top = std::max(params.top, y);
+    }
+    return params;
+}
+
+ContainerGroup *Array::instance(const size_t index) const
+{
+    ContainerGroup *group = new ContainerGroup(_source);
+    group->transform(_instances[index].data());
+    return group;
+}
+
+size_t Array::find(const Geo::AABBRect &rect) const
+{
+    const Geo::AABBRectParams params = rect.aabbrect_params();
+    for (size_t i = 0, count = _instances.size(); i < count; ++i)
+    {
+        if (!Geo::is_intersected(params, aabbrect_params(i)))
+        {
+            continue;
+        }
+        const std::unique_ptr<ContainerGroup> group(instance(i));
+        if (std::any_of(group->begin(), group->end(), [&](const Geo::Geometry *item) { return is_intersected(rect, item); }))
+        {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+std::vector<Geo::Geometry *> Array::explode() const
+{
+    std::vector<Geo::Geometry *> objects;
+    objects.reserve(_instances.size() * _source.size());
+    for (const std::array<double, 6> &mat : _instances)
+    {
+        for (const Geo::Geometry *item : _source)
+        {
+            objects.push_back(item->clone());
+            objects.back()->transform(mat.data());
+        }
+    }
+    return objects;
+}
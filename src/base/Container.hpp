@@ -1,16 +1,18 @@
 #pragma once
 
+#include <array>
 #include <QFont>
 #include <QString>
 #include <QPainter>
 #include "base/Geometry.hpp"
+#include "base/TextStyle.hpp"
 
 
 class Text : public Geo::Geometry
 {
 private:
     QString _text;
-    QFont _font;
+    size_t _style = 0; // TextStyleTable中的样式序号
     int _anchor_index = 3;
     double _font_size = 10;
     Geo::Point _shape[4] = {Geo::Point(0, 10), Geo::Point(10, 10), Geo::Point(10, 0), Geo::Point(0, 0)};
@@ -22,6 +24,8 @@ public:
 public:
     Text(const double x, const double y, const QFont &font, QString text = "Text", const int anchor_index = 3);
 
+    Text(const double x, const double y, const size_t style, QString text = "Text", const int anchor_index = 3);
+
     Text(const Text &text) = default;
 
     Geo::Type type() const override;
@@ -38,7 +42,7 @@ public:
 
     const QFont &font() const;
 
-    QFont &font();
+    size_t style() const;
 
     const QString &text() const;
 
@@ -78,6 +82,7 @@ public:
 
     Geo::AABBRectParams aabbrect_params() const override;
 
+    // 调用前需将painter的字体设为font()
     void paint(QPainter &painter) const;
 };
 
@@ -250,3 +255,67 @@ public:
 
     const Geo::AABBRect &border() const;
 };
+
+// 阵列,只保存一份源图形和各实例相对源图形的仿射变换,绘制时按实例变换,需要时再展开为独立图形
+class Array : public Geo::Geometry
+{
+private:
+    ContainerGroup _source;
+    std::vector<std::array<double, 6>> _instances;
+    Geo::AABBRectParams _source_rect;
+
+public:
+    Array() = default;
+
+    Array(const Array &array) = default;
+
+    // 复制objects作为源图形,其中的阵列展开后复制
+    Array(const std::vector<Geo::Geometry *> &objects);
+
+    Geo::Type type() const override;
+
+    bool empty() const override;
+
+    Array *clone() const override;
+
+    Array &operator=(const Array &array) = default;
+
+    ContainerGroup &source();
+
+    const ContainerGroup &source() const;
+
+    // 实例数
+    size_t size() const;
+
+    const std::array<double, 6> &operator[](const size_t index) const;
+
+    void append(const std::array<double, 6> &mat);
+
+    void clear() override;
+
+    void transform(const double a, const double b, const double c, const double d, const double e, const double f) override;
+
+    void transform(const double mat[6]) override;
+
+    void translate(const double tx, const double ty) override;
+
+    void rotate(const double x, const double y, const double rad) override; // 弧度制
+
+    void scale(const double x, const double y, const double k) override;
+
+    Geo::AABBRect bounding_rect() const override;
+
+    Geo::AABBRectParams aabbrect_params() const override;
+
+    // 第index个实例的包围盒
+    Geo::AABBRectParams aabbrect_params(const size_t index) const;
+
+    // 第index个实例的图形副本
+    ContainerGroup *instance(const size_t index) const;
+
+    // 与rect相交的第一个实例序号,先按实例包围盒筛选,只对候选实例生成图形副本精确判断,没有时返回SIZE_MAX
+    size_t find(const Geo::AABBRect &rect) const;
+
+    // 展开为独立图形,由调用者释放
+    std::vector<Geo::Geometry *> explode() const;
+};
@@ -7,6 +7,11 @@
 #include "io/TextEncoding.hpp"
 
 
+Editor::Editor()
+{
+    _view_tree.set_removed_callback([this](const Geo::Geometry *object) { forget_selected(object); });
+}
+
 Editor::~Editor()
 {
     delete _graph;
@@ -27,6 +32,8 @@ void Editor::init()
             _graph->append_group();
         }
         _view_tree.build(_graph);
+        _selected_objects.clear();
+        _selected_indices.clear();
         _backup.clear();
         _backup.set_graph(_graph);
     }
@@ -45,6 +52,8 @@ void Editor::load_graph(Graph *graph, const QString &path)
     {
         _graph = nullptr;
         _view_tree.clear();
+        _selected_objects.clear();
+        _selected_indices.clear();
     }
 }
 
@@ -61,6 +70,8 @@ void Editor::load_graph(Graph *graph)
     {
         _graph = nullptr;
         _view_tree.clear();
+        _selected_objects.clear();
+        _selected_indices.clear();
     }
 }
 
@@ -73,6 +84,8 @@ void Editor::delete_graph()
         _current_group = 0;
         _file_path.clear();
         _backup.clear();
+        _selected_objects.clear();
+        _selected_indices.clear();
     }
 }
 
@@ -98,14 +111,46 @@ const Graph *Editor::graph() const
 
 void Editor::refresh_visible_objects(const Geo::AABBRectParams &rect)
 {
-    return _view_tree.find_visible_objects(rect);
+    return _view_tree.set_visible_rect(rect);
 }
 
-const std::vector<Geo::Geometry *> &Editor::visible_objects() const
+const std::vector<Geo::Geometry *> &Editor::visible_objects()
 {
     return _view_tree.visible_objects();
 }
 
+void Editor::find_objects(const Geo::AABBRectParams &rect, std::vector<Geo::Geometry *> &objects)
+{
+    return _view_tree.find_visible_objects(rect, objects);
+}
+
+SnapIndex &Editor::snap_index()
+{
+    return _view_tree.snap_index();
+}
+
+size_t Editor::view_modification(const Geo::Geometry *object) const
+{
+    return object == nullptr ? _view_tree.modification() : _view_tree.modification(object);
+}
+
+const Geo::AABBRectParams *Editor::view_rect(const Geo::Geometry *object) const
+{
+    return _view_tree.rect(object);
+}
+
+const std::vector<Geo::Geometry *> &Editor::current_group_objects()
+{
+    const ContainerGroup &group = _graph->container_group(_current_group);
+    if (const std::tuple<size_t, size_t, size_t> key(_view_tree.version(), _current_group, group.size()); key != _current_group_key)
+    {
+        _current_group_key = key;
+        _current_group_objects.assign(group.begin(), group.end());
+        std::sort(_current_group_objects.begin(), _current_group_objects.end());
+    }
+    return _current_group_objects;
+}
+
 std::vector<Geo::Point> &Editor::point_cache()
 {
     return _point_cache;
@@ -133,6 +178,8 @@ void Editor::set_current_group(const size_t index)
                 object->is_selected = false;
             }
         }
+        _selected_objects.clear();
+        _selected_indices.clear();
     }
 }
 
@@ -187,6 +234,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
         rect.top = point.y + catch_distance + 1;
         visible_objects.clear();
         _view_tree.find_visible_objects(rect, visible_objects);
+        std::sort(visible_objects.begin(), visible_objects.end());
         std::set_intersection(visible_objects.begin(), visible_objects.end(), current_group_objects.begin(), current_group_objects.end(),
                               std::back_inserter(objects));
         std::unordered_map<const Geo::Geometry *, size_t> orders;
@@ -211,7 +259,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
             t = static_cast<Text *>(it);
             if (Geo::is_inside(point, t->shape(0), t->shape(1), t->shape(2), t->shape(3), false))
             {
-                t->is_selected = true;
+                set_selected(t, true);
                 return t;
             }
             t = nullptr;
@@ -222,7 +270,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
             {
                 if (Geo::distance_square(point, (*polygon)[i], (*polygon)[i - 1]) <= catch_distance * catch_distance)
                 {
-                    polygon->is_selected = true;
+                    set_selected(polygon, true);
                     return polygon;
                 }
             }
@@ -233,7 +281,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
             if (std::abs(Geo::distance(point, *circle) - circle->radius) <= catch_distance ||
                 Geo::distance(point, *circle) <= catch_distance)
             {
-                circle->is_selected = true;
+                set_selected(circle, true);
                 return circle;
             }
             circle = nullptr;
@@ -244,7 +292,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
             {
                 if (Geo::distance(point, *ellipse) <= catch_distance)
                 {
-                    ellipse->is_selected = true;
+                    set_selected(ellipse, true);
                     return ellipse;
                 }
             }
@@ -254,7 +302,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                              std::max(ellipse->lengtha(), ellipse->lengthb()) * 2) <= catch_distance ||
                     Geo::distance_square(point, (ellipse->c0() + ellipse->c1()) / 2) <= catch_distance)
                 {
-                    ellipse->is_selected = true;
+                    set_selected(ellipse, true);
                     return ellipse;
                 }
             }
@@ -272,7 +320,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                         t = static_cast<Text *>(item);
                         if (Geo::is_inside(point, t->shape(0), t->shape(1), t->shape(2), t->shape(3), false))
                         {
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return cb;
                         }
                         t = nullptr;
@@ -283,7 +331,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                         {
                             if (Geo::distance_square(point, (*polygon)[i], (*polygon)[i - 1]) <= catch_distance * catch_distance)
                             {
-                                cb->is_selected = true;
+                                set_selected(cb, true);
                                 return cb;
                             }
                         }
@@ -294,7 +342,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                         if (std::abs(Geo::distance(point, *circle) - circle->radius) <= catch_distance ||
                             Geo::distance(point, *circle) <= catch_distance)
                         {
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return cb;
                         }
                         circle = nullptr;
@@ -305,7 +353,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                                      std::max(ellipse->lengtha(), ellipse->lengthb()) * 2) <= catch_distance ||
                             Geo::distance(point, (ellipse->c0() + ellipse->c1()) / 2) <= catch_distance)
                         {
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return cb;
                         }
                         ellipse = nullptr;
@@ -316,7 +364,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                         {
                             if (Geo::distance_square(point, (*p)[i - 1], (*p)[i]) <= catch_distance * catch_distance)
                             {
-                                cb->is_selected = true;
+                                set_selected(cb, true);
                                 return cb;
                             }
                         }
@@ -328,7 +376,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                         {
                             if (Geo::distance_square(point, b->shape()[i - 1], b->shape()[i]) <= catch_distance * catch_distance)
                             {
-                                cb->is_selected = true;
+                                set_selected(cb, true);
                                 return cb;
                             }
                         }
@@ -340,7 +388,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                         {
                             if (Geo::distance_square(point, bs->shape()[i - 1], bs->shape()[i]) <= catch_distance * catch_distance)
                             {
-                                cb->is_selected = true;
+                                set_selected(cb, true);
                                 return cb;
                             }
                         }
@@ -350,7 +398,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                         arc = static_cast<Geo::Arc *>(item);
                         if (Geo::distance(point, *arc) <= catch_distance)
                         {
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return cb;
                         }
                         arc = nullptr;
@@ -359,7 +407,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
                         if (Geo::Point *pt = static_cast<Geo::Point *>(item);
                             Geo::distance_square(point, *pt) <= catch_distance * catch_distance)
                         {
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return cb;
                         }
                         break;
@@ -376,7 +424,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
             {
                 if (Geo::distance_square(point, (*p)[i - 1], (*p)[i]) <= catch_distance * catch_distance)
                 {
-                    p->is_selected = true;
+                    set_selected(p, true);
                     return p;
                 }
             }
@@ -398,7 +446,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
             {
                 if (Geo::distance_square(point, b->shape()[i - 1], b->shape()[i]) <= catch_distance * catch_distance)
                 {
-                    b->is_selected = true;
+                    set_selected(b, true);
                     return b;
                 }
             }
@@ -420,7 +468,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
             {
                 if (Geo::distance_square(point, bs->shape()[i - 1], bs->shape()[i]) <= catch_distance * catch_distance)
                 {
-                    bs->is_selected = true;
+                    set_selected(bs, true);
                     return bs;
                 }
             }
@@ -430,7 +478,7 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
             arc = static_cast<Geo::Arc *>(it);
             if (Geo::distance(point, *arc) <= catch_distance)
             {
-                arc->is_selected = true;
+                set_selected(arc, true);
                 return arc;
             }
             arc = nullptr;
@@ -438,14 +486,22 @@ Geo::Geometry *Editor::select(const Geo::Point &point, const bool reset_others,
         case Geo::Type::POINT:
             if (Geo::Point *pt = static_cast<Geo::Point *>(it); Geo::distance_square(point, *pt) <= catch_distance * catch_distance)
             {
-                pt->is_selected = true;
+                set_selected(pt, true);
                 return pt;
             }
             break;
         case Geo::Type::DIMENSION:
             if (static_cast<Dim::Dimension *>(it)->select(point, catch_distance))
             {
-                it->is_selected = true;
+                set_selected(it, true);
+                return it;
+            }
+            break;
+        case Geo::Type::ARRAY:
+            if (static_cast<Array *>(it)->find(Geo::AABBRect(point.x - catch_distance, point.y + catch_distance, point.x + catch_distance,
+                                                             point.y - catch_distance)) != SIZE_MAX)
+            {
+                set_selected(it, true);
                 return it;
             }
             break;
@@ -493,7 +549,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
             if (Geo::is_inside(point, t->shape(0), t->shape(1), t->shape(2), t->shape(3), false))
             {
                 bool state = t->is_selected;
-                t->is_selected = true;
+                set_selected(t, true);
                 return std::make_tuple(t, state);
             }
             t = nullptr;
@@ -503,7 +559,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
             if (Geo::is_inside(point, *polygon, true))
             {
                 bool state = polygon->is_selected;
-                polygon->is_selected = true;
+                set_selected(polygon, true);
                 return std::make_tuple(polygon, state);
             }
             for (size_t i = 1, count = polygon->size(); i < count; ++i)
@@ -511,7 +567,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                 if (Geo::distance_square(point, (*polygon)[i], (*polygon)[i - 1]) <= catch_distance * catch_distance)
                 {
                     bool state = polygon->is_selected;
-                    polygon->is_selected = true;
+                    set_selected(polygon, true);
                     return std::make_tuple(polygon, state);
                 }
             }
@@ -522,7 +578,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
             if (Geo::distance_square(point, *circle) <= std::pow(catch_distance + circle->radius, 2))
             {
                 bool state = circle->is_selected;
-                circle->is_selected = true;
+                set_selected(circle, true);
                 return std::make_tuple(circle, state);
             }
             circle = nullptr;
@@ -533,7 +589,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                 catch_distance + std::max(ellipse->lengtha(), ellipse->lengthb()) * 2)
             {
                 bool state = ellipse->is_selected;
-                ellipse->is_selected = true;
+                set_selected(ellipse, true);
                 return std::make_tuple(ellipse, state);
             }
             ellipse = nullptr;
@@ -551,7 +607,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                         if (Geo::is_inside(point, t->shape(0), t->shape(1), t->shape(2), t->shape(3), false))
                         {
                             bool state = cb->is_selected;
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return std::make_tuple(cb, state);
                         }
                         t = nullptr;
@@ -560,7 +616,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                         if (Geo::is_inside(point, *static_cast<Geo::Polygon *>(item), true))
                         {
                             bool state = cb->is_selected;
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return std::make_tuple(cb, state);
                         }
                         break;
@@ -568,7 +624,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                         if (Geo::is_inside(point, *static_cast<Geo::Circle *>(item), true))
                         {
                             bool state = cb->is_selected;
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return std::make_tuple(cb, state);
                         }
                         break;
@@ -576,7 +632,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                         if (Geo::is_inside(point, *static_cast<Geo::Ellipse *>(item), true))
                         {
                             bool state = cb->is_selected;
-                            cb->is_selected = true;
+                            set_selected(cb, true);
                             return std::make_tuple(cb, state);
                         }
                         break;
@@ -587,7 +643,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                             if (Geo::distance_square(point, (*p)[i - 1], (*p)[i]) <= catch_distance * catch_distance)
                             {
                                 bool state = cb->is_selected;
-                                cb->is_selected = true;
+                                set_selected(cb, true);
                                 return std::make_tuple(cb, state);
                             }
                         }
@@ -600,7 +656,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                             if (Geo::distance_square(point, b->shape()[i - 1], b->shape()[i]) <= catch_distance * catch_distance)
                             {
                                 bool state = cb->is_selected;
-                                cb->is_selected = true;
+                                set_selected(cb, true);
                                 return std::make_tuple(cb, state);
                             }
                         }
@@ -613,7 +669,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                             if (Geo::distance_square(point, bs->shape()[i - 1], bs->shape()[i]) <= catch_distance * catch_distance)
                             {
                                 bool state = cb->is_selected;
-                                cb->is_selected = true;
+                                set_selected(cb, true);
                                 return std::make_tuple(cb, state);
                             }
                         }
@@ -633,7 +689,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                 if (Geo::distance_square(point, (*p)[i - 1], (*p)[i]) <= catch_distance * catch_distance)
                 {
                     bool state = p->is_selected;
-                    p->is_selected = true;
+                    set_selected(p, true);
                     return std::make_tuple(p, state);
                 }
             }
@@ -656,7 +712,7 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                 if (Geo::distance_square(point, b->shape()[i - 1], b->shape()[i]) <= catch_distance * catch_distance)
                 {
                     bool state = b->is_selected;
-                    b->is_selected = true;
+                    set_selected(b, true);
                     return std::make_tuple(b, state);
                 }
             }
@@ -679,12 +735,21 @@ std::tuple<Geo::Geometry *, bool> Editor::select_with_state(const Geo::Point &po
                 if (Geo::distance_square(point, bs->shape()[i - 1], bs->shape()[i]) <= catch_distance * catch_distance)
                 {
                     bool state = bs->is_selected;
-                    bs->is_selected = true;
+                    set_selected(bs, true);
                     return std::make_tuple(bs, state);
                 }
             }
             bs = nullptr;
             break;
+        case Geo::Type::ARRAY:
+            if (static_cast<Array *>(*it)->find(Geo::AABBRect(point.x - catch_distance, point.y + catch_distance,
+                                                              point.x + catch_distance, point.y - catch_distance)) != SIZE_MAX)
+            {
+                bool state = (*it)->is_selected;
+                set_selected(*it, true);
+                return std::make_tuple(*it, state);
+            }
+            break;
         default:
             break;
         }
@@ -706,66 +771,137 @@ std::vector<Geo::Geometry *> Editor::select(const Geo::AABBRect &rect, const boo
         reset_selected_mark();
     }
 
+    // 四叉树只包含可见组的图形,当前组不可见且不限于可见图形时只能逐个检查当前组
     std::vector<Geo::Geometry *> objects;
-    if (visible_only)
+    if (const ContainerGroup &group = _graph->container_group(_current_group); !visible_only && !group.visible())
     {
-        std::vector<Geo::Geometry *> current_group_objects(_graph->container_group(_current_group).begin(),
-                                                           _graph->container_group(_current_group).end());
-        std::sort(current_group_objects.begin(), current_group_objects.end());
-        std::set_intersection(_view_tree.visible_objects().begin(), _view_tree.visible_objects().end(), current_group_objects.begin(),
-                              current_group_objects.end(), std::back_inserter(objects));
+        objects.assign(group.begin(), group.end());
     }
     else
     {
-        objects.assign(_graph->container_group(_current_group).begin(), _graph->container_group(_current_group).end());
+        // 包围盒在rect内的图形必然与rect相交,直接选中,只有包围盒跨越rect边界的图形需要精确判断
+        std::vector<Geo::Geometry *> contained, crossed;
+        _view_tree.find_objects(rect.aabbrect_params(), contained, crossed);
+        bool other_groups = false;
+        for (const ContainerGroup &other : _graph->container_groups())
+        {
+            if (&other != &group && other.visible() && !other.empty())
+            {
+                other_groups = true;
+                break;
+            }
+        }
+        const std::vector<Geo::Geometry *> *group_objects = other_groups ? &current_group_objects() : nullptr;
+        if (other_groups || visible_only)
+        {
+            const std::vector<Geo::Geometry *> &visible_objects = _view_tree.visible_objects();
+            for (std::vector<Geo::Geometry *> *candidates : {&contained, &crossed})
+            {
+                candidates->erase(
+                    std::remove_if(candidates->begin(), candidates->end(),
+                                   [&](Geo::Geometry *object)
+                                   {
+                                       return (other_groups && !std::binary_search(group_objects->begin(), group_objects->end(), object)) ||
+                                              (visible_only && !std::binary_search(visible_objects.begin(), visible_objects.end(), object));
+                                   }),
+                    candidates->end());
+            }
+        }
+
+        for (Geo::Geometry *object : contained)
+        {
+            switch (object->type())
+            {
+            case Geo::Type::COMBINATION:
+                if (!static_cast<Combination *>(object)->empty())
+                {
+                    result.push_back(object);
+                }
+                break;
+            case Geo::Type::TEXT:
+            case Geo::Type::POLYGON:
+            case Geo::Type::CIRCLE:
+            case Geo::Type::ELLIPSE:
+            case Geo::Type::POLYLINE:
+            case Geo::Type::BEZIER:
+            case Geo::Type::BSPLINE:
+            case Geo::Type::ARC:
+            case Geo::Type::POINT:
+            case Geo::Type::DIMENSION:
+            case Geo::Type::ARRAY:
+                result.push_back(object);
+                break;
+            default:
+                break;
+            }
+        }
+        objects.swap(crossed);
     }
 
-    if (const size_t count = objects.size(); count < 2000)
+    // 精确判断按线程数分段并行执行
+    const size_t count = objects.size();
+    const size_t thread_count = std::clamp<size_t>(count / 1000, 1, std::max(std::thread::hardware_concurrency(), 1u));
+    if (thread_count == 1)
     {
         select_subfunc(rect, &objects, 0, count, &result);
     }
-    else if (count < 4000)
-    {
-        std::vector<Geo::Geometry *> temp0, temp1;
-        const size_t step = count / 2;
-        std::thread thread0(&Editor::select_subfunc, rect, &objects, 0, step, &temp0);
-        std::thread thread1(&Editor::select_subfunc, rect, &objects, step, count, &temp1);
-        thread0.join();
-        thread1.join();
-        result.insert(result.end(), temp0.begin(), temp0.end());
-        result.insert(result.end(), temp1.begin(), temp1.end());
-    }
-    else if (count < 6000)
+    else
     {
-        std::vector<Geo::Geometry *> temp[3];
-        const size_t step = count / 3;
-        std::thread threads[3] = {std::thread(&Editor::select_subfunc, rect, &objects, 0, step, &temp[0]),
-                                  std::thread(&Editor::select_subfunc, rect, &objects, step, step * 2, &temp[1]),
-                                  std::thread(&Editor::select_subfunc, rect, &objects, step * 2, count, &temp[2])};
-        for (int i = 0; i < 3; ++i)
+        std::vector<std::vector<Geo::Geometry *>> temp(thread_count);
+        std::vector<std::thread> threads;
+        const size_t step = count / thread_count;
+        for (size_t i = 0; i < thread_count; ++i)
         {
-            threads[i].join();
-            result.insert(result.end(), temp[i].begin(), temp[i].end());
+            threads.emplace_back(&Editor::select_subfunc, rect, &objects, step * i, i + 1 == thread_count ? count : step * (i + 1),
+                                 &temp[i]);
         }
-    }
-    else
-    {
-        std::vector<Geo::Geometry *> temp[4];
-        const size_t step = count / 4;
-        std::thread threads[4] = {std::thread(&Editor::select_subfunc, rect, &objects, 0, step, &temp[0]),
-                                  std::thread(&Editor::select_subfunc, rect, &objects, step, step * 2, &temp[1]),
-                                  std::thread(&Editor::select_subfunc, rect, &objects, step * 2, step * 3, &temp[2]),
-                                  std::thread(&Editor::select_subfunc, rect, &objects, step * 3, count, &temp[3])};
-        for (int i = 0; i < 4; ++i)
+        for (size_t i = 0; i < thread_count; ++i)
         {
             threads[i].join();
             result.insert(result.end(), temp[i].begin(), temp[i].end());
         }
     }
+    // select_subfunc在多个线程中只修改选中标记,结果在此统一加入选中集合
+    for (Geo::Geometry *object : result)
+    {
+        set_selected(object, true);
+    }
     std::sort(result.begin(), result.end());
     return result;
 }
 
+void Editor::refresh_selected_objects() const
+{
+    // 移出四叉树的图形已由forget_selected置为nullptr,其余图形都可以访问
+    size_t count = 0;
+    for (Geo::Geometry *object : _selected_objects)
+    {
+        if (object == nullptr)
+        {
+            continue;
+        }
+        if (object->is_selected)
+        {
+            _selected_indices[object] = count;
+            _selected_objects[count++] = object;
+        }
+        else
+        {
+            _selected_indices.erase(object);
+        }
+    }
+    _selected_objects.resize(count);
+}
+
+void Editor::forget_selected(const Geo::Geometry *object)
+{
+    if (auto it = _selected_indices.find(object); it != _selected_indices.end())
+    {
+        _selected_objects[it->second] = nullptr;
+        _selected_indices.erase(it);
+    }
+}
+
 std::vector<Geo::Geometry *> Editor::selected(const bool visible_only) const
 {
     std::vector<Geo::Geometry *> result;
@@ -775,20 +911,8 @@ std::vector<Geo::Geometry *> Editor::selected(const bool visible_only) const
     }
     if (visible_only)
     {
-        for (ContainerGroup &group : _graph->container_groups())
-        {
-            if (!group.visible())
-            {
-                continue;
-            }
-            for (Geo::Geometry *object : group)
-            {
-                if (object->is_selected)
-                {
-                    result.push_back(object);
-                }
-            }
-        }
+        refresh_selected_objects();
+        result.assign(_selected_objects.begin(), _selected_objects.end());
     }
     else
     {
@@ -813,29 +937,44 @@ const size_t Editor::selected_count() const
     {
         return 0;
     }
-    size_t count = 0;
-    for (ContainerGroup &group : _graph->container_groups())
+    refresh_selected_objects();
+    return _selected_objects.size();
+}
+
+void Editor::reset_selected_mark(const bool value)
+{
+    if (_graph == nullptr || _graph->empty())
+    {
+        return;
+    }
+    if (value)
+    {
+        for (Geo::Geometry *object : _graph->container_group(_current_group))
+        {
+            set_selected(object, true);
+        }
+    }
+    else
     {
-        for (Geo::Geometry *object : group)
+        // 隐藏图层中的图形已移出选中集合但仍带有选中标记,按图层逐个清除
+        for (ContainerGroup &group : _graph->container_groups())
         {
-            if (object->is_selected)
+            for (Geo::Geometry *object : group)
             {
-                ++count;
+                object->is_selected = false;
             }
         }
+        _selected_objects.clear();
+        _selected_indices.clear();
     }
-    return count;
 }
 
-void Editor::reset_selected_mark(const bool value)
+void Editor::set_selected(Geo::Geometry *object, const bool value)
 {
-    if (_graph == nullptr || _graph->empty())
-    {
-        return;
-    }
-    for (Geo::Geometry *container : _graph->container_group(_current_group))
+    object->is_selected = value;
+    if (value && _selected_indices.try_emplace(object, _selected_objects.size()).second)
     {
-        container->is_selected = value;
+        _selected_objects.push_back(object);
     }
 }
 
@@ -850,6 +989,13 @@ void Editor::undo()
     _view_tree.remove(_backup.removed);
     _view_tree.append(_backup.appended);
     _view_tree.update(_backup.updated);
+    for (Geo::Geometry *object : _backup.appended)
+    {
+        if (object->is_selected)
+        {
+            set_selected(object, true);
+        }
+    }
 }
 
 void Editor::set_backup_count(const size_t count)
@@ -857,6 +1003,21 @@ void Editor::set_backup_count(const size_t count)
     _backup.set_count(count);
 }
 
+void Editor::set_backup_spill(const bool value)
+{
+    _backup.set_spill(value);
+}
+
+void Editor::set_backup_memory_limit(const size_t bytes)
+{
+    _backup.set_memory_limit(bytes);
+}
+
+size_t Editor::backup_memory_usage() const
+{
+    return _backup.memory_usage();
+}
+
 void Editor::push_backup_command(UndoStack::Command *command)
 {
     _view_tree.remove(command->removed);
@@ -868,6 +1029,23 @@ void Editor::push_backup_command(UndoStack::Command *command)
     return _backup.push_command(command);
 }
 
+void Editor::begin_transaction()
+{
+    _backup.begin_transaction();
+    _view_tree.begin_batch();
+}
+
+void Editor::commit_transaction()
+{
+    _view_tree.end_batch();
+    _backup.commit_transaction();
+}
+
+bool Editor::in_transaction() const
+{
+    return _backup.in_transaction();
+}
+
 
 void Editor::remove_group(const size_t index)
 {
@@ -1130,6 +1308,7 @@ void Editor::translate_points(Geo::Geometry *points, const double x0, const doub
         break;
     case Geo::Type::TEXT:
     case Geo::Type::COMBINATION:
+    case Geo::Type::ARRAY:
     case Geo::Type::POINT:
         points->translate(x1 - x0, y1 - y0);
         break;
@@ -1248,7 +1427,7 @@ void Editor::translate_points(Geo::Geometry *points, const double x0, const doub
                     }
 
                     temp->control_points[index].translate(x1 - x0, y1 - y0);
-                    temp->update_shape(Geo::BSpline::default_step, Geo::BSpline::default_down_sampling_value);
+                    temp->update_shape(index, Geo::BSpline::default_step);
                 }
             }
             else
@@ -1400,6 +1579,7 @@ bool Editor::paste(const double tx, const double ty)
     {
         _graph->container_group(_current_group).append(geo->clone());
         _graph->container_group(_current_group).back()->translate(tx, ty);
+        set_selected(_graph->container_group(_current_group).back(), true);
         items.emplace_back(_graph->container_group(_current_group).back(), _current_group, index++);
         _view_tree.append(_graph->container_group(_current_group).back());
     }
@@ -1412,76 +1592,82 @@ bool Editor::paste(const double tx, const double ty)
 
 bool Editor::connect(const std::vector<Geo::Geometry *> &objects, const double connect_distance)
 {
-    if (_graph == nullptr || objects.empty())
+    if (_graph == nullptr || objects.empty() || !(connect_distance > 0))
     {
         return false;
     }
 
+    // 端点网格中第k条多段线的起点id为k*2,终点id为k*2+1
     std::vector<Geo::Polyline *> polylines;
     std::vector<size_t> indexs;
+    std::vector<Geo::Point> points;
     ContainerGroup &group = _graph->container_group(_current_group);
-    for (Geo::Geometry *object : objects)
     {
-        if (object->type() == Geo::Type::POLYLINE)
+        std::unordered_map<const Geo::Geometry *, size_t> group_indexs;
+        for (size_t i = 0, count = group.size(); i < count; ++i)
+        {
+            group_indexs.emplace(group[i], i);
+        }
+        for (Geo::Geometry *object : objects)
         {
-            polylines.push_back(static_cast<Geo::Polyline *>(object));
-            indexs.push_back(std::distance(group.begin(), std::find(group.begin(), group.end(), object)));
+            if (object->type() == Geo::Type::POLYLINE)
+            {
+                polylines.push_back(static_cast<Geo::Polyline *>(object));
+                const auto it = group_indexs.find(object);
+                indexs.push_back(it == group_indexs.end() ? group.size() : it->second);
+                points.push_back(polylines.back()->front());
+                points.push_back(polylines.back()->back());
+            }
         }
     }
+    Geo::PointGrid grid(points, connect_distance);
     std::vector<bool> merged(polylines.size(), false);
 
+    // 查找序号最小的一对可连接多段线,同一条多段线的两个端点都可连接时起点优先
     Geo::Polyline *polyline = nullptr;
     size_t index = 0;
-    for (size_t i = 0, count = indexs.size(); i < count; ++i)
+    for (size_t i = 0, count = polylines.size(); i < count; ++i)
     {
-        const Geo::Point front_i = polylines[i]->front();
-        const Geo::Point back_i = polylines[i]->back();
-        for (size_t j = i + 1; j < count; ++j)
+        grid.remove(points[i * 2], i * 2);
+        grid.remove(points[i * 2 + 1], i * 2 + 1);
+        const size_t id0 = grid.find(points[i * 2]), id1 = grid.find(points[i * 2 + 1]);
+        if (id0 == SIZE_MAX && id1 == SIZE_MAX)
+        {
+            continue;
+        }
+
+        const size_t j = std::min(id0 / 2, id1 / 2);
+        if (id0 / 2 == j)
         {
-            const Geo::Point front_j = polylines[j]->front();
-            const Geo::Point back_j = polylines[j]->back();
-            if (Geo::distance_square(front_i, front_j) < connect_distance * connect_distance)
+            if (id0 % 2 == 0)
             {
                 polyline = new Geo::Polyline(polylines[i]->begin(), polylines[i]->end());
                 std::reverse(polyline->begin(), polyline->end());
                 polyline->append(polylines[j]->begin(), polylines[j]->end());
-
-                merged[i] = merged[j] = true;
-                index = i;
-                i = count;
-                break;
             }
-            else if (Geo::distance_square(front_i, back_j) < connect_distance * connect_distance)
+            else
             {
                 polyline = new Geo::Polyline(polylines[j]->begin(), polylines[j]->end());
                 polyline->append(polylines[i]->begin(), polylines[i]->end());
-
-                merged[i] = merged[j] = true;
-                index = i;
-                i = count;
-                break;
             }
-            else if (Geo::distance_square(back_i, front_j) < connect_distance * connect_distance)
+        }
+        else
+        {
+            polyline = new Geo::Polyline(polylines[i]->begin(), polylines[i]->end());
+            if (id1 % 2 == 0)
             {
-                polyline = new Geo::Polyline(polylines[i]->begin(), polylines[i]->end());
                 polyline->append(polylines[j]->begin(), polylines[j]->end());
-
-                merged[i] = merged[j] = true;
-                index = i;
-                i = count;
-                break;
             }
-            else if (Geo::distance_square(back_i, back_j) < connect_distance * connect_distance)
+            else
             {
-                polyline = new Geo::Polyline(polylines[i]->begin(), polylines[i]->end());
                 polyline->append(polylines[j]->rbegin(), polylines[j]->rend());
-
-                merged[i] = merged[j] = true;
-                index = i;
-                i = count;
-                break;
             }
         }
+        grid.remove(points[j * 2], j * 2);
+        grid.remove(points[j * 2 + 1], j * 2 + 1);
+        merged[i] = merged[j] = true;
+        index = i;
+        break;
     }
 
     if (polyline == nullptr)
@@ -1489,65 +1675,82 @@ bool Editor::connect(const std::vector<Geo::Geometry *> &objects, const double c
         return false;
     }
 
-    for (size_t i = 0, count = polylines.size(); i < count;)
+    // 之前扫描过的多段线重新放回网格,之后不断连接序号最小的可连接多段线
+    for (size_t i = 0; i < index; ++i)
     {
-        if (merged[i])
+        grid.insert(points[i * 2], i * 2);
+        grid.insert(points[i * 2 + 1], i * 2 + 1);
+    }
+    while (!grid.empty())
+    {
+        const size_t id0 = grid.find(polyline->front()), id1 = grid.find(polyline->back());
+        if (id0 == SIZE_MAX && id1 == SIZE_MAX)
         {
-            ++i;
-            continue;
+            break;
         }
 
-        Geo::Point front_i = polylines[i]->front();
-        Geo::Point back_i = polylines[i]->back();
-        if (Geo::distance_square(polyline->front(), front_i) < connect_distance * connect_distance)
-        {
-            polyline->insert(0, polylines[i]->rbegin(), polylines[i]->rend());
-            merged[i] = true;
-            i = 0;
-        }
-        else if (Geo::distance_square(polyline->front(), back_i) < connect_distance * connect_distance)
+        const size_t i = std::min(id0 / 2, id1 / 2);
+        if (id0 / 2 == i)
         {
-            polyline->insert(0, polylines[i]->begin(), polylines[i]->end());
-            merged[i] = true;
-            i = 0;
+            if (id0 % 2 == 0)
+            {
+                polyline->insert(0, polylines[i]->rbegin(), polylines[i]->rend());
+            }
+            else
+            {
+                polyline->insert(0, polylines[i]->begin(), polylines[i]->end());
+            }
         }
-        else if (Geo::distance_square(polyline->back(), front_i) < connect_distance * connect_distance)
+        else if (id1 % 2 == 0)
         {
             polyline->append(polylines[i]->begin(), polylines[i]->end());
-            merged[i] = true;
-            i = 0;
-        }
-        else if (Geo::distance_square(polyline->back(), back_i) < connect_distance * connect_distance)
-        {
-            polyline->append(polylines[i]->rbegin(), polylines[i]->rend());
-            merged[i] = true;
-            i = 0;
         }
         else
         {
-            ++i;
+            polyline->append(polylines[i]->rbegin(), polylines[i]->rend());
         }
+        grid.remove(points[i * 2], i * 2);
+        grid.remove(points[i * 2 + 1], i * 2 + 1);
+        merged[i] = true;
     }
 
-    for (size_t i = polylines.size() - 1; i > 0; --i)
+    std::vector<bool> removed(group.size(), false);
+    std::vector<std::tuple<Geo::Geometry *, size_t>> items;
+    for (size_t i = 0, count = polylines.size(); i < count; ++i)
     {
-        if (!merged[i])
+        if (merged[i] && indexs[i] < group.size())
         {
-            indexs.erase(indexs.begin() + i);
+            removed[indexs[i]] = true;
         }
     }
-    if (!merged.front())
+    for (size_t i = 0, count = group.size(); i < count; ++i)
     {
-        indexs.erase(indexs.begin());
+        if (removed[i])
+        {
+            _view_tree.remove(group[i]);
+            items.emplace_back(group[i], i);
+        }
     }
-    std::sort(indexs.begin(), indexs.end(), std::greater<>());
-    std::vector<std::tuple<Geo::Geometry *, size_t>> items(indexs.size());
-    for (size_t i : indexs)
+    // 一次性移除被连接的多段线,避免逐个从容器中间删除
     {
-        _view_tree.remove(group[i]);
-        items.emplace_back(group.pop(i), i);
+        std::vector<Geo::Geometry *> others;
+        others.reserve(group.size() - items.size());
+        for (size_t i = 0, count = group.size(); i < count; ++i)
+        {
+            if (!removed[i])
+            {
+                others.push_back(group[i]);
+            }
+        }
+        while (!group.empty())
+        {
+            group.pop_back();
+        }
+        for (Geo::Geometry *object : others)
+        {
+            group.append(object);
+        }
     }
-    std::reverse(items.begin(), items.end());
 
     if (group.size() <= index)
     {
@@ -1810,7 +2013,7 @@ bool Editor::blend(const Geo::Geometry *object0, const Geo::Geometry *object1, c
 
     if (Geo::CubicBezier *bezier = Geo::blend(pre0, point0, point1, pre1))
     {
-        bezier->is_selected = true;
+        set_selected(bezier, true);
         _graph->container_group(_current_group).append(bezier);
         _view_tree.append(bezier);
         _backup.push_command(
@@ -1842,7 +2045,7 @@ bool Editor::close_polyline(const std::vector<Geo::Geometry *> &objects)
         if (const Geo::Polyline *polyline = static_cast<const Geo::Polyline *>(object); polyline->size() >= 3)
         {
             shape = new Geo::Polygon(*polyline);
-            shape->is_selected = true;
+            set_selected(shape, true);
             size_t index = std::distance(group.begin(), std::find(group.begin(), group.end(), object));
             add_items.emplace_back(shape, _current_group, index);
             _view_tree.append(shape);
@@ -1865,6 +2068,38 @@ bool Editor::close_polyline(const std::vector<Geo::Geometry *> &objects)
     }
 }
 
+std::vector<Geo::Geometry *> Editor::explode_arrays(const std::vector<Array *> &arrays)
+{
+    // 阵列从后往前移出图层,展开的图形追加到图层末尾
+    ContainerGroup &group = _graph->container_group(_current_group);
+    std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> add_items, remove_items;
+    std::vector<Geo::Geometry *> objects;
+    std::vector<size_t> indexs;
+    for (const Array *array : arrays)
+    {
+        indexs.push_back(std::distance(group.begin(), std::find(group.begin(), group.end(), array)));
+    }
+    std::sort(indexs.rbegin(), indexs.rend());
+    for (const size_t index : indexs)
+    {
+        _view_tree.remove(group[index]);
+        remove_items.emplace_back(group.pop(index), _current_group, index);
+    }
+    for (const std::tuple<Geo::Geometry *, size_t, size_t> &item : remove_items)
+    {
+        for (Geo::Geometry *object : static_cast<const Array *>(std::get<0>(item))->explode())
+        {
+            group.append(object);
+            set_selected(object, true);
+            _view_tree.append(object);
+            add_items.emplace_back(object, _current_group, group.size() - 1);
+            objects.push_back(object);
+        }
+    }
+    _backup.push_command(new UndoStack::ObjectCommand(add_items, remove_items));
+    return objects;
+}
+
 bool Editor::combinate(const std::vector<Geo::Geometry *> &objects)
 {
     if (_graph == nullptr || objects.size() < 2)
@@ -1872,10 +2107,31 @@ bool Editor::combinate(const std::vector<Geo::Geometry *> &objects)
         return false;
     }
 
+    // 阵列不嵌套在组合中,先展开为独立图形再组合
+    std::vector<Geo::Geometry *> members;
+    std::vector<Array *> arrays;
+    for (Geo::Geometry *object : objects)
+    {
+        if (object->type() == Geo::Type::ARRAY)
+        {
+            arrays.push_back(static_cast<Array *>(object));
+        }
+        else
+        {
+            members.push_back(object);
+        }
+    }
+    begin_transaction();
+    if (!arrays.empty())
+    {
+        std::vector<Geo::Geometry *> exploded = explode_arrays(arrays);
+        members.insert(members.end(), exploded.begin(), exploded.end());
+    }
+
     Combination *combination = new Combination();
     ContainerGroup &group = _graph->container_group(_current_group);
     std::vector<std::tuple<Combination *, size_t, std::vector<Geo::Geometry *>>> items;
-    for (Geo::Geometry *object : objects)
+    for (Geo::Geometry *object : members)
     {
         if (object->type() == Geo::Type::DIMENSION)
         {
@@ -1897,12 +2153,13 @@ bool Editor::combinate(const std::vector<Geo::Geometry *> &objects)
     }
 
     std::reverse(combination->begin(), combination->end());
-    combination->is_selected = true;
+    set_selected(combination, true);
     combination->update_border();
     _graph->container_group(_current_group).append(combination);
     _view_tree.append(combination);
 
     _backup.push_command(new UndoStack::CombinateCommand(combination, items, _current_group));
+    commit_transaction();
     _graph->modified = true;
 
     return true;
@@ -1916,6 +2173,7 @@ bool Editor::detach(const std::vector<Geo::Geometry *> &objects)
     }
 
     std::vector<std::tuple<Combination *, size_t>> combiantions;
+    std::vector<Array *> arrays;
     ContainerGroup &group = _graph->container_group(_current_group);
     for (Geo::Geometry *object : objects)
     {
@@ -1924,22 +2182,36 @@ bool Editor::detach(const std::vector<Geo::Geometry *> &objects)
             combiantions.emplace_back(static_cast<Combination *>(object),
                                       std::distance(group.begin(), std::find(group.begin(), group.end(), object)));
         }
+        else if (object->type() == Geo::Type::ARRAY)
+        {
+            arrays.push_back(static_cast<Array *>(object));
+        }
     }
-    if (combiantions.empty())
+    if (combiantions.empty() && arrays.empty())
     {
         return false;
     }
 
-    std::reverse(combiantions.begin(), combiantions.end());
-    _backup.push_command(new UndoStack::CombinateCommand(combiantions, _current_group));
-    for (std::tuple<Combination *, size_t> &combination : combiantions)
+    begin_transaction();
+    if (!combiantions.empty())
+    {
+        std::reverse(combiantions.begin(), combiantions.end());
+        _backup.push_command(new UndoStack::CombinateCommand(combiantions, _current_group));
+        for (std::tuple<Combination *, size_t> &combination : combiantions)
+        {
+            std::reverse(std::get<0>(combination)->begin(), std::get<0>(combination)->end());
+            group.pop(std::find(group.rbegin(), group.rend(), std::get<0>(combination)));
+            _view_tree.remove(std::get<0>(combination));
+            _view_tree.append(std::vector<Geo::Geometry *>(std::get<0>(combination)->begin(), std::get<0>(combination)->end()));
+            group.append(*static_cast<ContainerGroup *>(std::get<0>(combination)));
+        }
+    }
+
+    if (!arrays.empty())
     {
-        std::reverse(std::get<0>(combination)->begin(), std::get<0>(combination)->end());
-        group.pop(std::find(group.rbegin(), group.rend(), std::get<0>(combination)));
-        _view_tree.remove(std::get<0>(combination));
-        _view_tree.append(std::vector<Geo::Geometry *>(std::get<0>(combination)->begin(), std::get<0>(combination)->end()));
-        group.append(*static_cast<ContainerGroup *>(std::get<0>(combination)));
+        explode_arrays(arrays);
     }
+    commit_transaction();
 
     _graph->modified = true;
 
@@ -1969,7 +2241,7 @@ bool Editor::mirror(const std::vector<Geo::Geometry *> &objects, const Geo::Poin
             {
                 _graph->container_group(_current_group).append(obj->clone());
                 _graph->container_group(_current_group).back()->transform(mat);
-                _graph->container_group(_current_group).back()->is_selected = true;
+                set_selected(_graph->container_group(_current_group).back(), true);
                 items.emplace_back(_graph->container_group(_current_group).back(), _current_group, index++);
                 _view_tree.append(_graph->container_group(_current_group).back());
             }
@@ -1984,7 +2256,7 @@ bool Editor::mirror(const std::vector<Geo::Geometry *> &objects, const Geo::Poin
             if (obj->type() != Geo::Type::DIMENSION)
             {
                 obj->transform(mat);
-                obj->is_selected = true;
+                set_selected(obj, true);
                 items.push_back(obj);
             }
         }
@@ -2091,7 +2363,7 @@ bool Editor::offset(const std::vector<Geo::Geometry *> &objects, const double di
         default:
             break;
         }
-        object->is_selected = false;
+        set_selected(object, false);
     }
 
     if (count == _graph->container_group(_current_group).size())
@@ -3043,7 +3315,7 @@ bool Editor::fillet(Geo::Polygon *shape, const Geo::Point &point, const double r
             {
                 std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> add_items, remove_items;
                 _view_tree.remove(_graph->container_group(_current_group).pop(i));
-                shape->is_selected = false;
+                set_selected(shape, false);
                 remove_items.emplace_back(shape, _current_group, i);
                 std::vector<Geo::Point> points(shape->begin(), shape->end() - 1);
                 std::rotate(points.begin(), points.begin() + index1, points.end());
@@ -3054,7 +3326,7 @@ bool Editor::fillet(Geo::Polygon *shape, const Geo::Point &point, const double r
                 _graph->container_group(_current_group).insert(i, polyline);
                 _view_tree.append(polyline);
                 Geo::Arc *a = new Geo::Arc(arc);
-                a->is_selected = true;
+                set_selected(a, true);
                 add_items.emplace_back(a, _current_group, i + 1);
                 _graph->container_group(_current_group).insert(i + 1, a);
                 _view_tree.append(a);
@@ -3094,7 +3366,7 @@ bool Editor::fillet(Geo::Polygon *shape, const Geo::Point &point, const double r
             {
                 std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> add_items, remove_items;
                 _view_tree.remove(_graph->container_group(_current_group).pop(i));
-                shape->is_selected = false;
+                set_selected(shape, false);
                 remove_items.emplace_back(shape, _current_group, i);
                 std::vector<Geo::Point> points(shape->begin(), shape->end() - 1);
                 std::rotate(points.begin(), points.begin() + index1, points.end());
@@ -3105,7 +3377,7 @@ bool Editor::fillet(Geo::Polygon *shape, const Geo::Point &point, const double r
                 _graph->container_group(_current_group).insert(i, polyline);
                 _view_tree.append(polyline);
                 Geo::CubicBezier *a = new Geo::CubicBezier(arc);
-                a->is_selected = true;
+                set_selected(a, true);
                 add_items.emplace_back(a, _current_group, i + 1);
                 _graph->container_group(_current_group).insert(i + 1, a);
                 _view_tree.append(a);
@@ -3142,7 +3414,7 @@ bool Editor::fillet(Geo::Polyline *polyline, const Geo::Point &point, const doub
             {
                 std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> add_items, remove_items;
                 _view_tree.remove(_graph->container_group(_current_group).pop(i));
-                polyline->is_selected = false;
+                set_selected(polyline, false);
                 remove_items.emplace_back(polyline, _current_group, i);
                 Geo::Polyline *polyline0 = new Geo::Polyline(polyline->begin(), polyline->begin() + index + 1);
                 polyline0->back() = arc.control_points[0];
@@ -3150,7 +3422,7 @@ bool Editor::fillet(Geo::Polyline *polyline, const Geo::Point &point, const doub
                 _graph->container_group(_current_group).insert(i, polyline0);
                 _view_tree.append(polyline0);
                 Geo::Arc *a = new Geo::Arc(arc);
-                a->is_selected = true;
+                set_selected(a, true);
                 add_items.emplace_back(a, _current_group, i + 1);
                 _graph->container_group(_current_group).insert(i + 1, a);
                 _view_tree.append(a);
@@ -3192,7 +3464,7 @@ bool Editor::fillet(Geo::Polyline *polyline, const Geo::Point &point, const doub
             {
                 std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> add_items, remove_items;
                 _view_tree.remove(_graph->container_group(_current_group).pop(i));
-                polyline->is_selected = false;
+                set_selected(polyline, false);
                 remove_items.emplace_back(polyline, _current_group, i);
                 Geo::Polyline *polyline0 = new Geo::Polyline(polyline->begin(), polyline->begin() + index + 1);
                 polyline0->back() = arc.front();
@@ -3200,7 +3472,7 @@ bool Editor::fillet(Geo::Polyline *polyline, const Geo::Point &point, const doub
                 _graph->container_group(_current_group).insert(i, polyline0);
                 _view_tree.append(polyline0);
                 Geo::CubicBezier *a = new Geo::CubicBezier(arc);
-                a->is_selected = true;
+                set_selected(a, true);
                 add_items.emplace_back(a, _current_group, i + 1);
                 _graph->container_group(_current_group).insert(i + 1, a);
                 _view_tree.append(a);
@@ -3523,13 +3795,13 @@ bool Editor::fillet(Geo::Polyline *polyline0, const Geo::Point &point0, Geo::Pol
         {
             ++k;
             _view_tree.remove(_graph->container_group(_current_group).pop(i));
-            polyline0->is_selected = false;
+            set_selected(polyline0, false);
             remove_items.emplace_back(polyline0, _current_group, i);
             size_t j = i;
             if (polyline0_copy.size() > 1)
             {
                 Geo::Polyline *polyline = new Geo::Polyline(polyline0_copy);
-                polyline->is_selected = false;
+                set_selected(polyline, false);
                 add_items.emplace_back(polyline, _current_group, i);
                 _graph->container_group(_current_group).insert(i, polyline);
                 _view_tree.append(polyline);
@@ -3542,24 +3814,24 @@ bool Editor::fillet(Geo::Polyline *polyline0, const Geo::Point &point0, Geo::Pol
             add_items.emplace_back(polyline2, _current_group, j + 1);
             _graph->container_group(_current_group).insert(j + 1, polyline2);
             _view_tree.append(polyline2);
-            polyline2->is_selected = false;
+            set_selected(polyline2, false);
             add_items.emplace_back(arc, _current_group, j + 2);
             _graph->container_group(_current_group).insert(j + 2, arc);
             _view_tree.append(arc);
-            arc->is_selected = true;
+            set_selected(arc, true);
             ++count;
         }
         else if (_graph->container_group(_current_group)[i] == polyline1)
         {
             ++k;
             _view_tree.remove(_graph->container_group(_current_group).pop(i));
-            polyline1->is_selected = false;
+            set_selected(polyline1, false);
             remove_items.emplace_back(polyline1, _current_group, i);
             size_t j = i;
             if (polyline1_copy.size() > 1)
             {
                 Geo::Polyline *polyline = new Geo::Polyline(polyline1_copy);
-                polyline->is_selected = false;
+                set_selected(polyline, false);
                 add_items.emplace_back(polyline, _current_group, i);
                 _graph->container_group(_current_group).insert(i, polyline);
                 _view_tree.append(polyline);
@@ -3572,7 +3844,7 @@ bool Editor::fillet(Geo::Polyline *polyline0, const Geo::Point &point0, Geo::Pol
             add_items.emplace_back(polyline3, _current_group, j + 1);
             _graph->container_group(_current_group).insert(j + 1, polyline3);
             _view_tree.append(polyline3);
-            polyline3->is_selected = false;
+            set_selected(polyline3, false);
         }
     }
     _backup.push_command(new UndoStack::ObjectCommand(add_items, remove_items));
@@ -3880,13 +4152,13 @@ bool Editor::fillet(Geo::Polyline *polyline0, const Geo::Point &point0, Geo::Pol
         {
             ++k;
             _view_tree.remove(_graph->container_group(_current_group).pop(i));
-            polyline0->is_selected = false;
+            set_selected(polyline0, false);
             remove_items.emplace_back(polyline0, _current_group, i);
             size_t j = i;
             if (polyline0_copy.size() > 1)
             {
                 Geo::Polyline *polyline = new Geo::Polyline(polyline0_copy);
-                polyline->is_selected = false;
+                set_selected(polyline, false);
                 add_items.emplace_back(polyline, _current_group, i);
                 _graph->container_group(_current_group).insert(i, polyline);
                 _view_tree.append(polyline);
@@ -3899,24 +4171,24 @@ bool Editor::fillet(Geo::Polyline *polyline0, const Geo::Point &point0, Geo::Pol
             add_items.emplace_back(polyline2, _current_group, j + 1);
             _graph->container_group(_current_group).insert(j + 1, polyline2);
             _view_tree.append(polyline2);
-            polyline2->is_selected = false;
+            set_selected(polyline2, false);
             add_items.emplace_back(arc, _current_group, j + 2);
             _graph->container_group(_current_group).insert(j + 2, arc);
             _view_tree.append(arc);
-            arc->is_selected = true;
+            set_selected(arc, true);
             ++count;
         }
         else if (_graph->container_group(_current_group)[i] == polyline1)
         {
             ++k;
             _view_tree.remove(_graph->container_group(_current_group).pop(i));
-            polyline1->is_selected = false;
+            set_selected(polyline1, false);
             remove_items.emplace_back(polyline1, _current_group, i);
             size_t j = i;
             if (polyline1_copy.size() > 1)
             {
                 Geo::Polyline *polyline = new Geo::Polyline(polyline1_copy);
-                polyline->is_selected = false;
+                set_selected(polyline, false);
                 add_items.emplace_back(polyline, _current_group, i);
                 _graph->container_group(_current_group).insert(i, polyline);
                 _view_tree.append(polyline);
@@ -3929,7 +4201,7 @@ bool Editor::fillet(Geo::Polyline *polyline0, const Geo::Point &point0, Geo::Pol
             add_items.emplace_back(polyline3, _current_group, j + 1);
             _graph->container_group(_current_group).insert(j + 1, polyline3);
             _view_tree.append(polyline3);
-            polyline3->is_selected = false;
+            set_selected(polyline3, false);
         }
     }
     _backup.push_command(new UndoStack::ObjectCommand(add_items, remove_items));
@@ -4583,7 +4855,7 @@ bool Editor::chamfer(Geo::Polygon *shape, const Geo::Point &point, const double
         {
             tuple_shape.emplace_back(point.x, point.y);
         }
-        _backup.push_command(new UndoStack::ChangeShapeCommand(shape, tuple_shape));
+        UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(shape, tuple_shape);
 
         if (Geo::distance(polygon[index1], polygon[index2]) > distance)
         {
@@ -4615,6 +4887,7 @@ bool Editor::chamfer(Geo::Polygon *shape, const Geo::Point &point, const double
             polygon.remove(index1);
         }
 
+        _backup.push_command(command);
         _view_tree.update(shape);
         _graph->modified = true;
         return true;
@@ -4645,7 +4918,7 @@ bool Editor::chamfer(Geo::Polyline *polyline, const Geo::Point &point, const dou
         {
             tuple_shape.emplace_back(point.x, point.y);
         }
-        _backup.push_command(new UndoStack::ChangeShapeCommand(polyline, tuple_shape));
+        UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(polyline, tuple_shape);
 
         if (Geo::distance((*polyline)[index + 1], (*polyline)[index]) > distance)
         {
@@ -4662,6 +4935,7 @@ bool Editor::chamfer(Geo::Polyline *polyline, const Geo::Point &point, const dou
             polyline->remove(index);
         }
 
+        _backup.push_command(command);
         _view_tree.update(polyline);
         _graph->modified = true;
         return true;
@@ -4867,34 +5141,22 @@ bool Editor::line_array(const std::vector<Geo::Geometry *> &objects, int x, int
         y = -y;
     }
 
-    std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> items;
-    size_t index = _graph->container_group(_current_group).size();
+    // 副本只记录为阵列实例的平移,由阵列统一绘制和索引
+    std::vector<Geo::Geometry *> sources;
+    std::copy_if(objects.begin(), objects.end(), std::back_inserter(sources),
+                 [](const Geo::Geometry *object) { return object->type() != Geo::Type::DIMENSION; });
+    Array *array = new Array(sources);
     for (int i = 0; i < x; ++i)
     {
         for (int j = 0; j < y; ++j)
         {
-            if (i == 0 && j == 0)
-            {
-                continue;
-            }
-            for (Geo::Geometry *object : objects)
+            if (i != 0 || j != 0)
             {
-                if (object->type() != Geo::Type::DIMENSION)
-                {
-                    _graph->container_group(_current_group).append(object->clone());
-                    _graph->container_group(_current_group).back()->translate(x_space * i, y_space * j);
-                    _graph->container_group(_current_group).back()->is_selected = true;
-                    _view_tree.append(_graph->container_group(_current_group).back());
-                    items.emplace_back(_graph->container_group(_current_group).back(), _current_group, index++);
-                }
+                array->append({1, 0, x_space * i, 0, 1, y_space * j});
             }
         }
     }
-
-    _graph->modified = true;
-    _backup.push_command(new UndoStack::ObjectCommand(items, true));
-
-    return true;
+    return append_array(array);
 }
 
 bool Editor::ring_array(const std::vector<Geo::Geometry *> &objects, const double x, const double y, const int n)
@@ -4908,30 +5170,35 @@ bool Editor::ring_array(const std::vector<Geo::Geometry *> &objects, const doubl
     {
         if (obj->type() != Geo::Type::DIMENSION)
         {
-            obj->is_selected = true;
+            set_selected(obj, true);
         }
     }
 
-    std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> items;
-    size_t index = _graph->container_group(_current_group).size();
+    std::vector<Geo::Geometry *> sources;
+    std::copy_if(objects.begin(), objects.end(), std::back_inserter(sources),
+                 [](const Geo::Geometry *object) { return object->type() != Geo::Type::DIMENSION; });
+    Array *array = new Array(sources);
     for (int i = 1; i < n; ++i)
     {
-        for (Geo::Geometry *obj : objects)
-        {
-            if (obj->type() != Geo::Type::DIMENSION)
-            {
-                _graph->container_group(_current_group).append(obj->clone());
-                _graph->container_group(_current_group).back()->rotate(x, y, 2 * Geo::PI * i / n);
-                _graph->container_group(_current_group).back()->is_selected = true;
-                _view_tree.append(_graph->container_group(_current_group).back());
-                items.emplace_back(_graph->container_group(_current_group).back(), _current_group, index++);
-            }
-        }
+        const double rad = 2 * Geo::PI * i / n, cos = std::cos(rad), sin = std::sin(rad);
+        array->append({cos, -sin, x - x * cos + y * sin, sin, cos, y - x * sin - y * cos});
     }
+    return append_array(array);
+}
 
+bool Editor::append_array(Array *array)
+{
+    if (array->empty())
+    {
+        delete array;
+        return false;
+    }
+    ContainerGroup &group = _graph->container_group(_current_group);
+    group.append(array);
+    set_selected(array, true);
+    _view_tree.append(array);
     _graph->modified = true;
-    _backup.push_command(new UndoStack::ObjectCommand(items, true));
-
+    _backup.push_command(new UndoStack::ObjectCommand(array, _current_group, group.size() - 1, true));
     return true;
 }
 
@@ -5377,8 +5644,9 @@ void Editor::trim(Geo::Polyline *polyline, const double x, const double y)
             {
                 shape.emplace_back(point.x, point.y);
             }
-            _backup.push_command(new UndoStack::ChangeShapeCommand(polyline, shape));
+            UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(polyline, shape);
             polyline->remove(0);
+            _backup.push_command(command);
             _view_tree.update(polyline);
         }
         else if (tail == polyline->back())
@@ -5388,8 +5656,9 @@ void Editor::trim(Geo::Polyline *polyline, const double x, const double y)
             {
                 shape.emplace_back(point.x, point.y);
             }
-            _backup.push_command(new UndoStack::ChangeShapeCommand(polyline, shape));
+            UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(polyline, shape);
             polyline->remove(polyline->size() - 1);
+            _backup.push_command(command);
             _view_tree.update(polyline);
         }
         else
@@ -5424,9 +5693,10 @@ void Editor::trim(Geo::Polyline *polyline, const double x, const double y)
             {
                 shape.emplace_back(point.x, point.y);
             }
-            _backup.push_command(new UndoStack::ChangeShapeCommand(polyline, shape));
+            UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(polyline, shape);
             polyline->front() = point1;
-            polyline->is_selected = false;
+            _backup.push_command(command);
+            set_selected(polyline, false);
             _view_tree.update(polyline);
         }
         else
@@ -5462,9 +5732,10 @@ void Editor::trim(Geo::Polyline *polyline, const double x, const double y)
             {
                 shape.emplace_back(point.x, point.y);
             }
-            _backup.push_command(new UndoStack::ChangeShapeCommand(polyline, shape));
+            UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(polyline, shape);
             polyline->back() = point0;
-            polyline->is_selected = false;
+            _backup.push_command(command);
+            set_selected(polyline, false);
             _view_tree.update(polyline);
         }
         else
@@ -6321,13 +6592,7 @@ void Editor::trim(Geo::BSpline *bspline, const double x, const double y)
         double min_dis[2] = {DBL_MAX, DBL_MAX};
         while (anchor_t <= knots[nplusc - 1])
         {
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic ? 3 : 2, anchor_t, npts, knots, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts; ++i)
-            {
-                coord += bspline->control_points[i] * nbasis[i];
-            }
+            const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, anchor_t, npts, knots, bspline->control_points);
             if (double dis = Geo::distance(coord, anchor); dis < min_dis[0])
             {
                 temp.clear();
@@ -6352,13 +6617,7 @@ void Editor::trim(Geo::BSpline *bspline, const double x, const double y)
                 for (double x = lower; x < upper + step; x += step)
                 {
                     x = x < upper ? x : upper;
-                    std::vector<double> nbasis;
-                    Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                    Geo::Point coord;
-                    for (size_t i = 0; i < npts; ++i)
-                    {
-                        coord += bspline->control_points[i] * nbasis[i];
-                    }
+                    const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline->control_points);
                     if (double dis = Geo::distance(anchor, coord); dis < min_dis[1])
                     {
                         min_dis[1] = dis;
@@ -6383,13 +6642,7 @@ void Editor::trim(Geo::BSpline *bspline, const double x, const double y)
                 for (double x = lower, dis0 = 0; x < upper + step; x += step)
                 {
                     x = x < upper ? x : upper;
-                    std::vector<double> nbasis;
-                    Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                    Geo::Point coord;
-                    for (size_t i = 0; i < npts; ++i)
-                    {
-                        coord += bspline->control_points[i] * nbasis[i];
-                    }
+                    const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline->control_points);
                     if (const double dis = Geo::distance(coord, anchor) * 1e9; dis < min_dis[1])
                     {
                         min_dis[1] = dis;
@@ -6455,13 +6708,7 @@ void Editor::trim(Geo::BSpline *bspline, const double x, const double y)
                 }
             }
 
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic ? 3 : 2, v, npts, knots, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts; ++i)
-            {
-                coord += bspline->control_points[i] * nbasis[i];
-            }
+            const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, v, npts, knots, bspline->control_points);
             result.emplace_back(std::min(min_dis[0], min_dis[1]), v, coord);
         }
 
@@ -7051,6 +7298,7 @@ void Editor::trim(Geo::Arc *arc, const double x, const double y)
 void Editor::trim(Geo::Ellipse *ellipse, const double x, const double y)
 {
     std::vector<Geo::Point> intersections;
+    std::vector<const Geo::Ellipse *> ellipses;
     for (const Geo::Geometry *object : _graph->container_group(_current_group))
     {
         std::vector<Geo::Point> temp;
@@ -7098,21 +7346,7 @@ void Editor::trim(Geo::Ellipse *ellipse, const double x, const double y)
         case Geo::Type::ELLIPSE:
             if (ellipse != object)
             {
-                Geo::Point point0, point1, point2, point3;
-                switch (Geo::is_intersected(*static_cast<const Geo::Ellipse *>(object), *ellipse, point0, point1, point2, point3))
-                {
-                case 4:
-                    intersections.emplace_back(point3);
-                case 3:
-                    intersections.emplace_back(point2);
-                case 2:
-                    intersections.emplace_back(point1);
-                case 1:
-                    intersections.emplace_back(point0);
-                    break;
-                default:
-                    break;
-                }
+                ellipses.push_back(static_cast<const Geo::Ellipse *>(object));
             }
             break;
         case Geo::Type::BEZIER:
@@ -7145,6 +7379,7 @@ void Editor::trim(Geo::Ellipse *ellipse, const double x, const double y)
             break;
         }
     }
+    Geo::is_intersected(*ellipse, ellipses, intersections);
 
     if (ellipse->is_arc())
     {
@@ -7468,7 +7703,7 @@ void Editor::extend(Geo::Polyline *polyline, const double x, const double y)
     {
         shape.emplace_back(point.x, point.y);
     }
-    _backup.push_command(new UndoStack::ChangeShapeCommand(polyline, shape));
+    UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(polyline, shape);
     if (head == polyline->front()) // 延长头
     {
         polyline->front() = expoint;
@@ -7477,6 +7712,7 @@ void Editor::extend(Geo::Polyline *polyline, const double x, const double y)
     {
         polyline->back() = expoint;
     }
+    _backup.push_command(command);
     _view_tree.update(polyline);
 }
 
@@ -7647,7 +7883,7 @@ void Editor::extend(Geo::CubicBezier *bezier, const double x, const double y)
     {
         shape.emplace_back(point.x, point.y);
     }
-    _backup.push_command(new UndoStack::ChangeShapeCommand(bezier, shape));
+    UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(bezier, shape);
 
     if (head == bezier->front()) // 延长头
     {
@@ -7666,6 +7902,7 @@ void Editor::extend(Geo::CubicBezier *bezier, const double x, const double y)
         bezier->append(expoint);
     }
     bezier->update_shape(Geo::CubicBezier::default_step, Geo::CubicBezier::default_down_sampling_value);
+    _backup.push_command(command);
     _view_tree.append(bezier);
 }
 
@@ -7833,19 +8070,16 @@ void Editor::extend(Geo::BSpline *bspline, const double x, const double y)
         return;
     }
 
+    std::vector<std::tuple<double, double>> shape, path;
+    for (const Geo::Point &point : bspline->path_points)
     {
-        std::vector<std::tuple<double, double>> shape, path;
-        std::vector<double> knots(bspline->knots());
-        for (const Geo::Point &point : bspline->path_points)
-        {
-            path.emplace_back(point.x, point.y);
-        }
-        for (const Geo::Point &point : bspline->control_points)
-        {
-            shape.emplace_back(point.x, point.y);
-        }
-        _backup.push_command(new UndoStack::ChangeShapeCommand(bspline, shape, path, knots));
+        path.emplace_back(point.x, point.y);
+    }
+    for (const Geo::Point &point : bspline->control_points)
+    {
+        shape.emplace_back(point.x, point.y);
     }
+    UndoStack::ChangeShapeCommand *command = new UndoStack::ChangeShapeCommand(bspline, shape, path, bspline->knots());
 
     if (head == bspline->front()) // 延长头
     {
@@ -7855,8 +8089,9 @@ void Editor::extend(Geo::BSpline *bspline, const double x, const double y)
     {
         bspline->extend_back(expoint);
     }
-    bspline->is_selected = true;
+    set_selected(bspline, true);
     bspline->update_shape(Geo::BSpline::default_step, Geo::BSpline::default_down_sampling_value);
+    _backup.push_command(command);
     _view_tree.update(bspline);
 }
 
@@ -8429,9 +8664,9 @@ bool Editor::auto_aligning(Geo::Geometry *src, const Geo::Geometry *dst, std::li
     double left = rect.left, top = rect.top, right = rect.right, bottom = rect.bottom;
 
     const size_t count = reflines.size();
-    const Geo::AABBRectParams dst_rect(dst->aabbrect_params());
-    const Geo::Point dst_center((dst_rect.left + dst_rect.right) / 2, (dst_rect.top + dst_rect.bottom) / 2);
-    const double dst_left = dst_rect.left, dst_top = dst_rect.top, dst_right = dst_rect.right, dst_bottom = dst_rect.bottom;
+    const AligningLines &lines = aligning_lines(dst);
+    const Geo::Point dst_center(lines.x[1], lines.y[1]);
+    const double dst_left = lines.x[0], dst_top = lines.y[0], dst_right = lines.x[2], dst_bottom = lines.y[2];
     const double align_distance = 2.0 / _view_ratio;
 
     if (std::abs(dst_left - center.x) < align_distance)
@@ -8596,9 +8831,9 @@ bool Editor::auto_aligning(Geo::Point &coord, const Geo::Geometry *dst, std::lis
     }
 
     const size_t count = reflines.size();
-    const Geo::AABBRectParams dst_rect(dst->aabbrect_params());
-    const Geo::Point dst_center((dst_rect.left + dst_rect.right) / 2, (dst_rect.top + dst_rect.bottom) / 2);
-    const double dst_left = dst_rect.left, dst_top = dst_rect.top, dst_right = dst_rect.right, dst_bottom = dst_rect.bottom;
+    const AligningLines &lines = aligning_lines(dst);
+    const Geo::Point dst_center(lines.x[1], lines.y[1]);
+    const double dst_left = lines.x[0], dst_top = lines.y[0], dst_right = lines.x[2], dst_bottom = lines.y[2];
     const double align_distance = 2.0 / _view_ratio;
 
     if (std::abs(dst_center.x - coord.x) < align_distance)
@@ -8635,89 +8870,119 @@ bool Editor::auto_aligning(Geo::Point &coord, const Geo::Geometry *dst, std::lis
     return count != reflines.size();
 }
 
-bool Editor::auto_aligning(Geo::Geometry *points, std::list<QLineF> &reflines, const bool current_group_only)
+const Editor::AligningLines &Editor::aligning_lines(const Geo::Geometry *dst)
 {
-    if (points == nullptr || _graph == nullptr || _graph->empty())
+    // 增删图形后地址可能被复用,整体清空
+    if (_aligning_lines_version != _view_tree.version())
     {
-        return false;
+        _aligning_lines.clear();
+        _aligning_lines_version = _view_tree.version();
     }
-
-    Geo::Point center;
+    const size_t modification = _view_tree.modification(dst);
+    AligningLines &lines = _aligning_lines[dst];
+    if (modification == 0 || lines.modification != modification)
     {
-        const Geo::AABBRectParams rect = points->aabbrect_params();
-        center.x = (rect.left + rect.right) / 2;
-        center.y = (rect.top + rect.bottom) / 2;
+        const Geo::AABBRectParams *cached_rect = _view_tree.rect(dst);
+        const Geo::AABBRectParams rect(cached_rect == nullptr ? dst->aabbrect_params() : *cached_rect);
+        lines.x[0] = rect.left, lines.x[1] = (rect.left + rect.right) / 2, lines.x[2] = rect.right;
+        lines.y[0] = rect.top, lines.y[1] = (rect.top + rect.bottom) / 2, lines.y[2] = rect.bottom;
+        lines.modification = modification;
     }
-    Geo::Geometry *dst = nullptr;
-    double temp = 0, distance = DBL_MAX;
+    return lines;
+}
 
-    if (current_group_only)
+Geo::Geometry *Editor::find_aligning_target(const Geo::Point &anchor, const Geo::Geometry *exclude, const bool skip_selected,
+                                             const bool current_group_only)
+{
+    if (!std::isfinite(anchor.x) || !std::isfinite(anchor.y))
+    {
+        return nullptr;
+    }
+    const std::vector<Geo::Geometry *> *group_objects = current_group_only ? &current_group_objects() : nullptr;
+    const Geo::AABBRectParams &tree_rect = _view_tree.rect();
+    // anchor在四叉树范围外时从到范围的距离开始查找,否则第一次查询必然为空
+    const double outside = std::hypot(std::max({tree_rect.left - anchor.x, anchor.x - tree_rect.right, 0.0}),
+                                      std::max({tree_rect.bottom - anchor.y, anchor.y - tree_rect.top, 0.0}));
+    std::vector<Geo::Geometry *> objects;
+    std::vector<std::tuple<double, Geo::Geometry *>> candidates;
+    // 从光标附近开始逐步扩大查询范围,直到找到的最近目标一定在范围内或范围覆盖整个四叉树
+    for (double radius = std::max({64.0 / _view_ratio, outside, Geo::EPSILON});; radius *= 4)
     {
-        for (Geo::Geometry *geo : _graph->container_group(_current_group))
+        Geo::AABBRectParams rect;
+        rect.left = anchor.x - radius, rect.right = anchor.x + radius;
+        rect.bottom = anchor.y - radius, rect.top = anchor.y + radius;
+        objects.clear();
+        _view_tree.find_visible_objects(rect, objects);
+
+        candidates.clear();
+        for (Geo::Geometry *object : objects)
         {
-            if (!(geo->type() == Geo::Type::POLYGON || geo->type() == Geo::Type::CIRCLE || geo->type() == Geo::Type::ELLIPSE) ||
-                geo == points)
+            if (!(object->type() == Geo::Type::POLYGON || object->type() == Geo::Type::CIRCLE || object->type() == Geo::Type::ELLIPSE) ||
+                object == exclude || (skip_selected && object->is_selected) ||
+                (group_objects != nullptr && !std::binary_search(group_objects->begin(), group_objects->end(), object)))
             {
                 continue;
             }
+            // 到包围盒的距离是到图形距离的下界
+            const Geo::AABBRectParams &object_rect = *_view_tree.rect(object);
+            const double dx = std::max({object_rect.left - anchor.x, anchor.x - object_rect.right, 0.0});
+            const double dy = std::max({object_rect.bottom - anchor.y, anchor.y - object_rect.top, 0.0});
+            candidates.emplace_back(std::hypot(dx, dy), object);
+        }
+        std::sort(candidates.begin(), candidates.end());
 
-            switch (geo->type())
+        Geo::Geometry *dst = nullptr;
+        double distance = DBL_MAX;
+        for (const auto &[lower_bound, object] : candidates)
+        {
+            if (lower_bound >= distance)
+            {
+                break;
+            }
+            double temp = DBL_MAX;
+            switch (object->type())
             {
             case Geo::Type::POLYGON:
-                temp = Geo::distance(center, *static_cast<Geo::Polygon *>(geo));
+                temp = Geo::distance(anchor, *static_cast<Geo::Polygon *>(object));
                 break;
             case Geo::Type::CIRCLE:
-                temp = Geo::distance(center, *static_cast<Geo::Circle *>(geo));
+                temp = Geo::distance(anchor, *static_cast<Geo::Circle *>(object));
                 break;
             case Geo::Type::ELLIPSE:
-                temp = Geo::distance(center, *static_cast<Geo::Ellipse *>(geo));
+                temp = Geo::distance(anchor, *static_cast<Geo::Ellipse *>(object));
                 break;
             default:
                 break;
             }
-
             if (temp < distance)
             {
-                dst = geo;
+                dst = object;
                 distance = temp;
             }
         }
-    }
-    else
-    {
-        for (ContainerGroup &group : _graph->container_groups())
+
+        if (distance <= radius || (rect.left <= tree_rect.left && rect.right >= tree_rect.right && rect.bottom <= tree_rect.bottom &&
+                                   rect.top >= tree_rect.top))
         {
-            for (Geo::Geometry *geo : group)
-            {
-                if (!(geo->type() == Geo::Type::POLYGON || geo->type() == Geo::Type::CIRCLE || geo->type() == Geo::Type::ELLIPSE) ||
-                    geo == points)
-                {
-                    continue;
-                }
+            return dst;
+        }
+    }
+}
 
-                switch (geo->type())
-                {
-                case Geo::Type::POLYGON:
-                    temp = Geo::distance(center, *static_cast<Geo::Polygon *>(geo));
-                    break;
-                case Geo::Type::CIRCLE:
-                    temp = Geo::distance(center, *static_cast<Geo::Circle *>(geo));
-                    break;
-                case Geo::Type::ELLIPSE:
-                    temp = Geo::distance(center, *static_cast<Geo::Ellipse *>(geo));
-                    break;
-                default:
-                    break;
-                }
+bool Editor::auto_aligning(Geo::Geometry *points, std::list<QLineF> &reflines, const bool current_group_only)
+{
+    if (points == nullptr || _graph == nullptr || _graph->empty())
+    {
+        return false;
+    }
 
-                if (temp < distance)
-                {
-                    dst = geo;
-                    distance = temp;
-                }
-            }
-        }
+    Geo::Point center;
+    {
+        const Geo::AABBRectParams rect = points->aabbrect_params();
+        center.x = (rect.left + rect.right) / 2;
+        center.y = (rect.top + rect.bottom) / 2;
     }
+    Geo::Geometry *dst = find_aligning_target(center, points, false, current_group_only);
 
     bool flag = false;
     if (points != _catched_points && auto_aligning(points, _catched_points, reflines))
@@ -8750,76 +9015,7 @@ bool Editor::auto_aligning(Geo::Geometry *points, const double x, const double y
     }
 
     const Geo::Point anchor(x, y);
-    Geo::Geometry *dst = nullptr;
-    double temp = 0, distance = DBL_MAX;
-
-    if (current_group_only)
-    {
-        for (Geo::Geometry *geo : _graph->container_group(_current_group))
-        {
-            if (!(geo->type() == Geo::Type::POLYGON || geo->type() == Geo::Type::CIRCLE || geo->type() == Geo::Type::ELLIPSE) ||
-                geo == points)
-            {
-                continue;
-            }
-
-            switch (geo->type())
-            {
-            case Geo::Type::POLYGON:
-                temp = Geo::distance(anchor, *static_cast<Geo::Polygon *>(geo));
-                break;
-            case Geo::Type::CIRCLE:
-                temp = Geo::distance(anchor, *static_cast<Geo::Circle *>(geo));
-                break;
-            case Geo::Type::ELLIPSE:
-                temp = Geo::distance(anchor, *static_cast<Geo::Ellipse *>(geo));
-                break;
-            default:
-                break;
-            }
-
-            if (temp < distance)
-            {
-                dst = geo;
-                distance = temp;
-            }
-        }
-    }
-    else
-    {
-        for (ContainerGroup &group : _graph->container_groups())
-        {
-            for (Geo::Geometry *geo : group)
-            {
-                if (!(geo->type() == Geo::Type::POLYGON || geo->type() == Geo::Type::CIRCLE || geo->type() == Geo::Type::ELLIPSE) ||
-                    geo == points)
-                {
-                    continue;
-                }
-
-                switch (geo->type())
-                {
-                case Geo::Type::POLYGON:
-                    temp = Geo::distance(anchor, *static_cast<Geo::Polygon *>(geo));
-                    break;
-                case Geo::Type::CIRCLE:
-                    temp = Geo::distance(anchor, *static_cast<Geo::Circle *>(geo));
-                    break;
-                case Geo::Type::ELLIPSE:
-                    temp = Geo::distance(anchor, *static_cast<Geo::Ellipse *>(geo));
-                    break;
-                default:
-                    break;
-                }
-
-                if (temp < distance)
-                {
-                    dst = geo;
-                    distance = temp;
-                }
-            }
-        }
-    }
+    Geo::Geometry *dst = find_aligning_target(anchor, points, false, current_group_only);
 
     _catched_points = nullptr;
     bool flag = false;
@@ -8852,76 +9048,7 @@ bool Editor::auto_aligning(Geo::Point &coord, std::list<QLineF> &reflines, const
     }
 
     const Geo::Point anchor(coord);
-    Geo::Geometry *dst = nullptr;
-    double temp = 0, distance = DBL_MAX;
-
-    if (current_group_only)
-    {
-        for (Geo::Geometry *geo : _graph->container_group(_current_group))
-        {
-            if (!(geo->type() == Geo::Type::POLYGON || geo->type() == Geo::Type::CIRCLE || geo->type() == Geo::Type::ELLIPSE) ||
-                geo->is_selected)
-            {
-                continue;
-            }
-
-            switch (geo->type())
-            {
-            case Geo::Type::POLYGON:
-                temp = Geo::distance(anchor, *static_cast<Geo::Polygon *>(geo));
-                break;
-            case Geo::Type::CIRCLE:
-                temp = Geo::distance(anchor, *static_cast<Geo::Circle *>(geo));
-                break;
-            case Geo::Type::ELLIPSE:
-                temp = Geo::distance(anchor, *static_cast<Geo::Ellipse *>(geo));
-                break;
-            default:
-                break;
-            }
-
-            if (temp < distance)
-            {
-                dst = geo;
-                distance = temp;
-            }
-        }
-    }
-    else
-    {
-        for (ContainerGroup &group : _graph->container_groups())
-        {
-            for (Geo::Geometry *geo : group)
-            {
-                if (!(geo->type() == Geo::Type::POLYGON || geo->type() == Geo::Type::CIRCLE || geo->type() == Geo::Type::ELLIPSE) ||
-                    geo->is_selected)
-                {
-                    continue;
-                }
-
-                switch (geo->type())
-                {
-                case Geo::Type::POLYGON:
-                    temp = Geo::distance(anchor, *static_cast<Geo::Polygon *>(geo));
-                    break;
-                case Geo::Type::CIRCLE:
-                    temp = Geo::distance(anchor, *static_cast<Geo::Circle *>(geo));
-                    break;
-                case Geo::Type::ELLIPSE:
-                    temp = Geo::distance(anchor, *static_cast<Geo::Ellipse *>(geo));
-                    break;
-                default:
-                    break;
-                }
-
-                if (temp < distance)
-                {
-                    dst = geo;
-                    distance = temp;
-                }
-            }
-        }
-    }
+    Geo::Geometry *dst = find_aligning_target(anchor, nullptr, true, current_group_only);
 
     _catched_points = nullptr;
     bool flag = false;
@@ -9002,381 +9129,223 @@ void Editor::auto_combinate()
     }
 
     std::sort(all_containers.begin(), all_containers.end(),
-              [&](const Geo::Geometry *a, const Geo::Geometry *b) { return areas[a] > areas[b]; });
+              [&](const Geo::Geometry *a, const Geo::Geometry *b) { return areas.at(a) > areas.at(b); });
     std::sort(all_polylines.begin(), all_polylines.end(),
-              [&](const Geo::Geometry *a, const Geo::Geometry *b) { return lengths[a] > lengths[b]; });
+              [&](const Geo::Geometry *a, const Geo::Geometry *b) { return lengths.at(a) > lengths.at(b); });
 
-    std::unordered_map<const Geo::Geometry *, Geo::AABBRect> container_rects, polyline_rects;
+    std::vector<Geo::AABBRectParams> container_rects, polyline_rects;
     for (const Geo::Geometry *object : all_containers)
     {
-        container_rects.insert_or_assign(object, object->bounding_rect());
+        container_rects.emplace_back(object->aabbrect_params());
     }
     for (const Geo::Geometry *object : all_polylines)
     {
-        polyline_rects.insert_or_assign(object, object->bounding_rect());
+        polyline_rects.emplace_back(object->aabbrect_params());
     }
 
-    _graph->append_group();
-    for (size_t i = 0, count = all_containers.size(); i < count; ++i)
+    // 面积较大的图形container与面积较小的图形object是否相交
+    const auto is_container_overlapped = [](const Geo::Geometry *container, const Geo::Geometry *object) -> bool
     {
-        Geo::AABBRect current_rect = container_rects[all_containers[i]];
-        std::vector<Geo::AABBRect> current_rects({current_rect});
-        std::vector<Geo::Geometry *> objects({all_containers[i]});
-        for (size_t j = i + 1; j < count; ++j)
+        switch (container->type())
         {
-            if (!Geo::is_intersected(current_rect, container_rects[all_containers[j]]))
-            {
-                continue;
-            }
-
-            const Geo::AABBRect &container_rect = container_rects[all_containers[j]];
-            for (size_t k = 0, object_count = objects.size(); k < object_count; ++k)
+        case Geo::Type::POLYGON:
             {
-                if (!Geo::is_intersected(current_rects[k], container_rect))
+                const Geo::Polygon *polygon = static_cast<const Geo::Polygon *>(container);
+                switch (object->type())
                 {
-                    continue;
+                case Geo::Type::POLYGON:
+                    return Geo::NoAABBTest::is_intersected(*polygon, *static_cast<const Geo::Polygon *>(object));
+                case Geo::Type::CIRCLE:
+                    return Geo::is_intersected(*polygon, *static_cast<const Geo::Circle *>(object));
+                case Geo::Type::ELLIPSE:
+                    return Geo::is_intersected(*polygon, *static_cast<const Geo::Ellipse *>(object));
+                default:
+                    return false;
                 }
-                switch (objects[k]->type())
+            }
+        case Geo::Type::CIRCLE:
+            {
+                const Geo::Circle *circle = static_cast<const Geo::Circle *>(container);
+                switch (object->type())
                 {
                 case Geo::Type::POLYGON:
-                    {
-                        Geo::Polygon *polygon = static_cast<Geo::Polygon *>(objects[k]);
-                        switch (all_containers[j]->type())
-                        {
-                        case Geo::Type::POLYGON:
-                            if (Geo::NoAABBTest::is_intersected(*polygon, *static_cast<Geo::Polygon *>(all_containers[j])))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        case Geo::Type::CIRCLE:
-                            if (Geo::is_intersected(*polygon, *static_cast<Geo::Circle *>(all_containers[j])))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        case Geo::Type::ELLIPSE:
-                            if (Geo::is_intersected(*polygon, *static_cast<Geo::Ellipse *>(all_containers[j])))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-                    }
-                    break;
+                    return Geo::is_inside(*circle, *static_cast<const Geo::Polygon *>(object));
                 case Geo::Type::CIRCLE:
-                    {
-                        Geo::Circle *circle = static_cast<Geo::Circle *>(objects[k]);
-                        switch (all_containers[j]->type())
-                        {
-                        case Geo::Type::POLYGON:
-                            if (Geo::is_inside(*circle, *static_cast<Geo::Polygon *>(all_containers[j])))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        case Geo::Type::CIRCLE:
-                            if (Geo::is_inside(*circle, *static_cast<Geo::Circle *>(all_containers[j])))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        case Geo::Type::ELLIPSE:
-                            if (Geo::Point point0, point1, point2, point3; Geo::is_intersected(
-                                    *circle, *static_cast<Geo::Ellipse *>(all_containers[j]), point0, point1, point2, point3))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-                    }
-                    break;
+                    return Geo::is_inside(*circle, *static_cast<const Geo::Circle *>(object));
                 case Geo::Type::ELLIPSE:
                     {
-                        Geo::Ellipse *ellipse = static_cast<Geo::Ellipse *>(objects[k]);
-                        switch (all_containers[j]->type())
-                        {
-                        case Geo::Type::POLYGON:
-                            if (Geo::is_intersected(*static_cast<Geo::Polygon *>(all_containers[j]), *ellipse))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        case Geo::Type::CIRCLE:
-                            if (Geo::Point point0, point1, point2, point3; Geo::is_intersected(
-                                    *static_cast<Geo::Circle *>(all_containers[j]), *ellipse, point0, point1, point2, point3))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        case Geo::Type::ELLIPSE:
-                            if (Geo::Point point0, point1, point2, point3; Geo::is_intersected(
-                                    *ellipse, *static_cast<Geo::Ellipse *>(all_containers[j]), point0, point1, point2, point3))
-                            {
-                                objects.push_back(all_containers[j]);
-                                current_rect += container_rects[all_containers[j]];
-                                current_rects.emplace_back(container_rects[all_containers[j]]);
-                                all_containers.erase(all_containers.begin() + j);
-                                j = i;
-                                --count;
-                                k = object_count - 1;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
+                        Geo::Point point0, point1, point2, point3;
+                        return Geo::is_intersected(*circle, *static_cast<const Geo::Ellipse *>(object), point0, point1, point2, point3);
                     }
-                    break;
                 default:
-                    break;
+                    return false;
                 }
             }
-        }
-
-        for (size_t k = 0, polyline_count = all_polylines.size(), object_count = objects.size(); k < polyline_count; ++k)
-        {
-            if (!Geo::is_intersected(current_rect, polyline_rects[all_polylines[k]]))
-            {
-                continue;
-            }
-            for (size_t j = 0; j < object_count; ++j)
+        case Geo::Type::ELLIPSE:
             {
-                switch (objects[j]->type())
+                const Geo::Ellipse *ellipse = static_cast<const Geo::Ellipse *>(container);
+                Geo::Point point0, point1, point2, point3;
+                switch (object->type())
                 {
                 case Geo::Type::POLYGON:
-                    switch (all_polylines[k]->type())
-                    {
-                    case Geo::Type::POLYLINE:
-                        if (Geo::is_intersected(*static_cast<Geo::Polyline *>(all_polylines[k]), *static_cast<Geo::Polygon *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::BEZIER:
-                        if (Geo::is_intersected(static_cast<Geo::CubicBezier *>(all_polylines[k])->shape(),
-                                                *static_cast<Geo::Polygon *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::BSPLINE:
-                        if (Geo::is_intersected(static_cast<Geo::BSpline *>(all_polylines[k])->shape(),
-                                                *static_cast<Geo::Polygon *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::TEXT:
-                        if (Geo::is_intersected(static_cast<Text *>(all_polylines[k])->convex_hull(),
-                                                *static_cast<Geo::Polygon *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::POINT:
-                        if (Geo::is_inside(*static_cast<Geo::Point *>(all_polylines[k]), *static_cast<Geo::Polygon *>(objects[j]), true))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    default:
-                        break;
-                    }
-                    break;
+                    return Geo::is_intersected(*static_cast<const Geo::Polygon *>(object), *ellipse);
                 case Geo::Type::CIRCLE:
-                    switch (all_polylines[k]->type())
-                    {
-                    case Geo::Type::POLYLINE:
-                        if (Geo::is_intersected(*static_cast<Geo::Polyline *>(all_polylines[k]), *static_cast<Geo::Circle *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::BEZIER:
-                        if (Geo::is_intersected(static_cast<Geo::CubicBezier *>(all_polylines[k])->shape(),
-                                                *static_cast<Geo::Circle *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::BSPLINE:
-                        if (Geo::is_intersected(static_cast<Geo::BSpline *>(all_polylines[k])->shape(),
-                                                *static_cast<Geo::Circle *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::TEXT:
-                        if (Geo::is_intersected(static_cast<Text *>(all_polylines[k])->convex_hull(),
-                                                *static_cast<Geo::Circle *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::POINT:
-                        if (Geo::is_inside(*static_cast<Geo::Point *>(all_polylines[k]), *static_cast<Geo::Circle *>(objects[j]), true))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    default:
-                        break;
-                    }
-                    break;
+                    return Geo::is_intersected(*static_cast<const Geo::Circle *>(object), *ellipse, point0, point1, point2, point3);
                 case Geo::Type::ELLIPSE:
-                    switch (all_polylines[k]->type())
-                    {
-                    case Geo::Type::POLYLINE:
-                        if (Geo::is_intersected(*static_cast<Geo::Polyline *>(all_polylines[k]), *static_cast<Geo::Ellipse *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::BEZIER:
-                        if (Geo::is_intersected(static_cast<Geo::CubicBezier *>(all_polylines[k])->shape(),
-                                                *static_cast<Geo::Ellipse *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::BSPLINE:
-                        if (Geo::is_intersected(static_cast<Geo::CubicBezier *>(all_polylines[k])->shape(),
-                                                *static_cast<Geo::Ellipse *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::TEXT:
-                        if (Geo::is_intersected(static_cast<Text *>(all_polylines[k])->convex_hull(),
-                                                *static_cast<Geo::Circle *>(objects[j])))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    case Geo::Type::POINT:
-                        if (Geo::is_inside(*static_cast<Geo::Point *>(all_polylines[k]), *static_cast<Geo::Ellipse *>(objects[j]), true))
-                        {
-                            objects.push_back(all_polylines[k]);
-                            all_polylines.erase(all_polylines.begin() + k--);
-                            --polyline_count;
-                            j = object_count - 1;
-                        }
-                        break;
-                    default:
-                        break;
-                    }
-                    break;
+                    return Geo::is_intersected(*ellipse, *static_cast<const Geo::Ellipse *>(object), point0, point1, point2, point3);
                 default:
-                    break;
+                    return false;
+                }
+            }
+        default:
+            return false;
+        }
+    };
+
+    // 多段线等非封闭图形object是否与封闭图形container相交
+    const auto is_polyline_overlapped = [](const Geo::Geometry *container, const Geo::Geometry *object) -> bool
+    {
+        switch (container->type())
+        {
+        case Geo::Type::POLYGON:
+            {
+                const Geo::Polygon &polygon = *static_cast<const Geo::Polygon *>(container);
+                switch (object->type())
+                {
+                case Geo::Type::POLYLINE:
+                    return Geo::is_intersected(*static_cast<const Geo::Polyline *>(object), polygon);
+                case Geo::Type::BEZIER:
+                    return Geo::is_intersected(static_cast<const Geo::CubicBezier *>(object)->shape(), polygon);
+                case Geo::Type::BSPLINE:
+                    return Geo::is_intersected(static_cast<const Geo::BSpline *>(object)->shape(), polygon);
+                case Geo::Type::TEXT:
+                    return Geo::is_intersected(static_cast<const Text *>(object)->convex_hull(), polygon);
+                case Geo::Type::POINT:
+                    return Geo::is_inside(*static_cast<const Geo::Point *>(object), polygon, true);
+                default:
+                    return false;
+                }
+            }
+        case Geo::Type::CIRCLE:
+            {
+                const Geo::Circle &circle = *static_cast<const Geo::Circle *>(container);
+                switch (object->type())
+                {
+                case Geo::Type::POLYLINE:
+                    return Geo::is_intersected(*static_cast<const Geo::Polyline *>(object), circle);
+                case Geo::Type::BEZIER:
+                    return Geo::is_intersected(static_cast<const Geo::CubicBezier *>(object)->shape(), circle);
+                case Geo::Type::BSPLINE:
+                    return Geo::is_intersected(static_cast<const Geo::BSpline *>(object)->shape(), circle);
+                case Geo::Type::TEXT:
+                    return Geo::is_intersected(static_cast<const Text *>(object)->convex_hull(), circle);
+                case Geo::Type::POINT:
+                    return Geo::is_inside(*static_cast<const Geo::Point *>(object), circle, true);
+                default:
+                    return false;
+                }
+            }
+        case Geo::Type::ELLIPSE:
+            {
+                const Geo::Ellipse &ellipse = *static_cast<const Geo::Ellipse *>(container);
+                switch (object->type())
+                {
+                case Geo::Type::POLYLINE:
+                    return Geo::is_intersected(*static_cast<const Geo::Polyline *>(object), ellipse);
+                case Geo::Type::BEZIER:
+                    return Geo::is_intersected(static_cast<const Geo::CubicBezier *>(object)->shape(), ellipse);
+                case Geo::Type::BSPLINE:
+                    return Geo::is_intersected(static_cast<const Geo::BSpline *>(object)->shape(), ellipse);
+                case Geo::Type::TEXT:
+                    return Geo::is_intersected(static_cast<const Text *>(object)->convex_hull(), ellipse);
+                case Geo::Type::POINT:
+                    return Geo::is_inside(*static_cast<const Geo::Point *>(object), ellipse, true);
+                default:
+                    return false;
                 }
             }
+        default:
+            return false;
+        }
+    };
+
+    // 谓词在多个线程中只读访问图形,先在此处建立弧长表等首次查询时才生成的缓存
+    for (const Geo::Geometry *object : all_containers)
+    {
+        object->length();
+    }
+
+    // 相交的封闭图形归为一组,每组以其中面积最大的图形的序号为代表
+    std::vector<std::vector<size_t>> overlaps;
+    Geo::find_overlapped_rects(container_rects, overlaps);
+    Geo::filter_overlaps(overlaps, [&](const size_t i, const size_t j)
+                         { return is_container_overlapped(all_containers[i], all_containers[j]); });
+    std::vector<size_t> roots(all_containers.size());
+    const auto find_root = [&](size_t index)
+    {
+        while (roots[index] != index)
+        {
+            index = roots[index] = roots[roots[index]];
+        }
+        return index;
+    };
+    for (size_t j = 0, count = all_containers.size(); j < count; ++j)
+    {
+        roots[j] = j;
+        for (const size_t i : overlaps[j])
+        {
+            if (const size_t root0 = find_root(i), root1 = find_root(j); root0 < root1)
+            {
+                roots[root1] = root0;
+            }
+            else if (root1 < root0)
+            {
+                roots[root0] = root1;
+            }
+        }
+    }
+
+    // 多段线归入与之相交且代表序号最小的组
+    std::vector<std::vector<Geo::Geometry *>> combinations(all_containers.size());
+    for (size_t i = 0, count = all_containers.size(); i < count; ++i)
+    {
+        combinations[find_root(i)].push_back(all_containers[i]);
+    }
+    Geo::find_overlapped_rects(container_rects, polyline_rects, overlaps);
+    Geo::filter_overlaps(overlaps, [&](const size_t i, const size_t j)
+                         { return is_polyline_overlapped(all_containers[i], all_polylines[j]); });
+    std::vector<Geo::Geometry *> rest_polylines;
+    for (size_t j = 0, count = all_polylines.size(); j < count; ++j)
+    {
+        size_t root = SIZE_MAX;
+        for (const size_t i : overlaps[j])
+        {
+            root = std::min(root, find_root(i));
+        }
+        if (root == SIZE_MAX)
+        {
+            rest_polylines.push_back(all_polylines[j]);
         }
+        else
+        {
+            combinations[root].push_back(all_polylines[j]);
+        }
+    }
 
+    _graph->append_group();
+    for (const std::vector<Geo::Geometry *> &objects : combinations)
+    {
         if (objects.size() > 1)
         {
             _graph->back().append(new Combination(objects.begin(), objects.end()));
         }
-        else
+        else if (objects.size() == 1)
         {
-            _graph->back().append(all_containers[i]);
+            _graph->back().append(objects.front());
         }
     }
 
-    for (Geo::Geometry *polyline : all_polylines)
+    for (Geo::Geometry *polyline : rest_polylines)
     {
         _graph->back().append(polyline);
     }
@@ -9391,7 +9360,6 @@ void Editor::auto_layering()
     }
 
     std::vector<Geo::Geometry *> all_containers, all_polylines;
-    std::unordered_map<const Geo::Geometry *, Geo::AABBRect> rects;
     for (ContainerGroup &group : _graph->container_groups())
     {
         while (!group.empty())
@@ -9408,7 +9376,6 @@ void Editor::auto_layering()
                 break;
             default:
                 all_containers.emplace_back(group.pop_back());
-                rects.insert_or_assign(all_containers.back(), all_containers.back()->bounding_rect());
                 break;
             }
         }
@@ -9441,152 +9408,118 @@ void Editor::auto_layering()
                 areas.insert_or_assign(object, static_cast<const Geo::Ellipse *>(object)->area());
                 break;
             default:
-                break; // Not sure if only three types needs to be checked.
-                       // Remove this and see the error to check if anything that nedds to be checked is missing.
+                areas.insert_or_assign(object, 0);
+                break;
             }
         }
         std::sort(all_containers.begin(), all_containers.end(),
-                  [&](const Geo::Geometry *a, const Geo::Geometry *b) { return areas[a] > areas[b]; });
+                  [&](const Geo::Geometry *a, const Geo::Geometry *b) { return areas.at(a) > areas.at(b); });
     }
 
-    _graph->append_group();
-    while (!all_containers.empty())
+    // 面积较小的图形object与已分层的较大图形container相交时不能放在同一层
+    const auto is_overlapped = [](const Geo::Geometry *container, const Geo::Geometry *object) -> bool
     {
-        _graph->back().append(all_containers.front());
-        all_containers.erase(all_containers.begin());
-        std::unordered_map<const Geo::Geometry *, Geo::AABBRect> current_rects;
-        current_rects.insert_or_assign(_graph->back().front(), rects[_graph->back().front()]);
-        for (size_t i = 0, count = all_containers.size(); i < count; ++i)
+        switch (object->type())
         {
-            bool flag = true;
-            switch (all_containers[i]->type())
+        case Geo::Type::POLYGON:
             {
-            case Geo::Type::POLYGON:
-                {
-                    const Geo::Polygon *polygon = static_cast<const Geo::Polygon *>(all_containers[i]);
-                    const Geo::AABBRect &rect = rects[polygon];
-                    for (Geo::Geometry *geo : _graph->back())
-                    {
-                        switch (geo->type())
-                        {
-                        case Geo::Type::POLYGON:
-                            if (Geo::is_intersected(rect, current_rects[geo]) &&
-                                Geo::NoAABBTest::is_intersected(*polygon, *static_cast<Geo::Polygon *>(geo)))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        case Geo::Type::CIRCLE:
-                            if (Geo::is_intersected(*polygon, *static_cast<Geo::Circle *>(geo)))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        case Geo::Type::ELLIPSE:
-                            if (Geo::is_intersected(*polygon, *static_cast<Geo::Ellipse *>(geo)))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-                        if (!flag)
-                        {
-                            break;
-                        }
-                    }
-                }
-                break;
-            case Geo::Type::CIRCLE:
+                const Geo::Polygon *polygon = static_cast<const Geo::Polygon *>(object);
+                switch (container->type())
                 {
-                    const Geo::Circle *circle = static_cast<const Geo::Circle *>(all_containers[i]);
-                    for (Geo::Geometry *geo : _graph->back())
-                    {
-                        switch (geo->type())
-                        {
-                        case Geo::Type::POLYGON:
-                            if (Geo::is_inside(*circle, *static_cast<Geo::Polygon *>(geo)))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        case Geo::Type::CIRCLE:
-                            if (Geo::is_intersected(*circle, *static_cast<Geo::Circle *>(geo)))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        case Geo::Type::ELLIPSE:
-                            if (Geo::is_inside(*circle, *static_cast<Geo::Ellipse *>(geo)))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-                        if (!flag)
-                        {
-                            break;
-                        }
-                    }
+                case Geo::Type::POLYGON:
+                    return Geo::NoAABBTest::is_intersected(*polygon, *static_cast<const Geo::Polygon *>(container));
+                case Geo::Type::CIRCLE:
+                    return Geo::is_intersected(*polygon, *static_cast<const Geo::Circle *>(container));
+                case Geo::Type::ELLIPSE:
+                    return Geo::is_intersected(*polygon, *static_cast<const Geo::Ellipse *>(container));
+                default:
+                    return false;
                 }
-                break;
-            case Geo::Type::ELLIPSE:
+            }
+        case Geo::Type::CIRCLE:
+            {
+                const Geo::Circle *circle = static_cast<const Geo::Circle *>(object);
+                switch (container->type())
                 {
-                    const Geo::Ellipse *ellipse = static_cast<const Geo::Ellipse *>(all_containers[i]);
-                    for (Geo::Geometry *geo : _graph->back())
-                    {
-                        switch (geo->type())
-                        {
-                        case Geo::Type::POLYGON:
-                            if (Geo::is_intersected(*static_cast<Geo::Polygon *>(geo), *ellipse))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        case Geo::Type::CIRCLE:
-                            if (Geo::Point point0, point1, point2, point3;
-                                Geo::is_intersected(*static_cast<Geo::Circle *>(geo), *ellipse, point0, point1, point2, point3))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        case Geo::Type::ELLIPSE:
-                            if (Geo::Point point0, point1, point2, point3;
-                                Geo::is_intersected(*ellipse, *static_cast<Geo::Ellipse *>(geo), point0, point1, point2, point3))
-                            {
-                                flag = false;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-                        if (!flag)
-                        {
-                            break;
-                        }
-                    }
+                case Geo::Type::POLYGON:
+                    return Geo::is_inside(*circle, *static_cast<const Geo::Polygon *>(container));
+                case Geo::Type::CIRCLE:
+                    return Geo::is_intersected(*circle, *static_cast<const Geo::Circle *>(container));
+                case Geo::Type::ELLIPSE:
+                    return Geo::is_inside(*circle, *static_cast<const Geo::Ellipse *>(container));
+                default:
+                    return false;
                 }
-                break;
-            default:
-                break;
             }
-            if (flag)
+        case Geo::Type::ELLIPSE:
             {
-                if (dynamic_cast<const Geo::Polygon *>(all_containers[i]) != nullptr)
+                const Geo::Ellipse *ellipse = static_cast<const Geo::Ellipse *>(object);
+                Geo::Point point0, point1, point2, point3;
+                switch (container->type())
                 {
-                    current_rects.insert_or_assign(all_containers[i], rects[all_containers[i]]);
+                case Geo::Type::POLYGON:
+                    return Geo::is_intersected(*static_cast<const Geo::Polygon *>(container), *ellipse);
+                case Geo::Type::CIRCLE:
+                    return Geo::is_intersected(*static_cast<const Geo::Circle *>(container), *ellipse, point0, point1, point2, point3);
+                case Geo::Type::ELLIPSE:
+                    return Geo::is_intersected(*ellipse, *static_cast<const Geo::Ellipse *>(container), point0, point1, point2, point3);
+                default:
+                    return false;
                 }
-                _graph->back().append(all_containers[i]);
-                all_containers.erase(all_containers.begin() + i--);
-                --count;
             }
+        default:
+            return false;
         }
-        _graph->append_group();
+    };
+
+    // 按面积从大到小依次放入第一个没有与之相交的图形的层
+    std::vector<std::vector<size_t>> overlaps;
+    {
+        std::vector<Geo::AABBRectParams> rects;
+        for (const Geo::Geometry *object : all_containers)
+        {
+            rects.emplace_back(object->aabbrect_params());
+        }
+        Geo::find_overlapped_rects(rects, overlaps);
+    }
+    // 谓词在多个线程中只读访问图形,先在此处建立弧长表等首次查询时才生成的缓存
+    for (const Geo::Geometry *object : all_containers)
+    {
+        object->length();
+    }
+    Geo::filter_overlaps(overlaps, [&](const size_t i, const size_t j) { return is_overlapped(all_containers[i], all_containers[j]); });
+    std::vector<size_t> layers(all_containers.size(), 0);
+    size_t layers_count = 0;
+    for (size_t j = 0, count = all_containers.size(); j < count; ++j)
+    {
+        std::vector<size_t> used_layers;
+        for (const size_t i : overlaps[j])
+        {
+            used_layers.push_back(layers[i]);
+        }
+        std::sort(used_layers.begin(), used_layers.end());
+        for (const size_t layer : used_layers)
+        {
+            if (layer == layers[j])
+            {
+                ++layers[j];
+            }
+            else if (layer > layers[j])
+            {
+                break;
+            }
+        }
+        layers_count = std::max(layers_count, layers[j] + 1);
     }
 
+    for (size_t i = 0; i <= layers_count; ++i)
+    {
+        _graph->append_group();
+    }
+    for (size_t i = 0, count = all_containers.size(); i < count; ++i)
+    {
+        _graph->container_group(layers[i]).append(all_containers[i]);
+    }
     for (Geo::Geometry *geo : all_polylines)
     {
         _graph->back().append(geo);
@@ -9609,190 +9542,107 @@ void Editor::auto_connect()
         return;
     }
 
-    std::unordered_map<Geo::Polyline *, size_t> object_order;
-    std::unordered_map<int, std::vector<Geo::Polyline *>> distance_object_map0,
-        distance_object_map1; // front distance, back distance
+    // 端点网格中第k条多段线的起点id为k*2,终点id为k*2+1
+    ContainerGroup &group = _graph->container_group();
+    std::vector<size_t> indexs;
+    std::vector<Geo::Point> points;
+    for (size_t i = 0, count = group.size(); i < count; ++i)
     {
-        size_t index = 0;
-        for (Geo::Geometry *object : _graph->container_group())
+        if (group[i]->type() == Geo::Type::POLYLINE)
         {
-            if (object->type() == Geo::Type::POLYLINE)
-            {
-                Geo::Polyline *polyline = static_cast<Geo::Polyline *>(object);
-                double distance0 = std::hypot(polyline->front().x, polyline->front().y);
-                double distance1 = std::hypot(polyline->back().x, polyline->back().y);
-                object_order.insert_or_assign(polyline, index++);
-                if (distance_object_map0.find(distance0) == distance_object_map0.end())
-                {
-                    distance_object_map0.insert_or_assign(distance0, std::vector<Geo::Polyline *>{polyline});
-                }
-                else
-                {
-                    distance_object_map0[distance0].push_back(polyline);
-                }
-                if (distance_object_map1.find(distance1) == distance_object_map1.end())
-                {
-                    distance_object_map1.insert_or_assign(distance1, std::vector<Geo::Polyline *>{polyline});
-                }
-                else
-                {
-                    distance_object_map1[distance1].push_back(polyline);
-                }
-            }
+            const Geo::Polyline *polyline = static_cast<const Geo::Polyline *>(group[i]);
+            indexs.push_back(i);
+            points.push_back(polyline->front());
+            points.push_back(polyline->back());
         }
     }
+    if (indexs.empty())
+    {
+        return;
+    }
 
-    for (size_t i = 0, count = _graph->container_group().size(); i < count; ++i)
+    Geo::PointGrid grid(points, 0);
+    std::vector<bool> merged(group.size(), false);
+    for (size_t k = 0, count = indexs.size(); k < count; ++k)
     {
-        Geo::Polyline *polyline0 = nullptr;
-        Geo::Point front_i, back_i;
-        if (_graph->container_group()[i]->type() == Geo::Type::POLYLINE)
-        {
-            polyline0 = static_cast<Geo::Polyline *>(_graph->container_group()[i]);
-            front_i = polyline0->front();
-            back_i = polyline0->back();
-        }
-        else
+        const size_t i = indexs[k];
+        if (merged[i])
         {
             continue;
         }
-        {
-            const double distance0 = std::hypot(front_i.x, front_i.y), distance1 = std::hypot(back_i.x, back_i.y);
-            distance_object_map0[distance0].erase(
-                std::find(distance_object_map0[distance0].begin(), distance_object_map0[distance0].end(), polyline0));
-            distance_object_map1[distance1].erase(
-                std::find(distance_object_map1[distance1].begin(), distance_object_map1[distance1].end(), polyline0));
-        }
+        Geo::Polyline *polyline0 = static_cast<Geo::Polyline *>(group[i]);
+        Geo::Point front_i = polyline0->front(), back_i = polyline0->back();
+        grid.remove(points[k * 2], k * 2);
+        grid.remove(points[k * 2 + 1], k * 2 + 1);
 
         while (true)
         {
-            size_t j = SIZE_MAX;
-            Geo::Polyline *polyline1 = nullptr;
-            Geo::Point front_j, back_j;
-
-            {
-                const double distance0 = std::hypot(front_i.x, front_i.y);
-                const double distance1 = std::hypot(back_i.x, back_i.y);
-                Geo::Polyline *object_j = nullptr;
-
-                if (distance_object_map0.find(distance0) != distance_object_map0.end())
-                {
-                    for (Geo::Polyline *object : distance_object_map0[distance0])
-                    {
-                        polyline1 = object;
-                        front_j = polyline1->front();
-                        if (front_i == front_j && object_order[object] < j)
-                        {
-                            object_j = object;
-                            j = object_order[object_j];
-                        }
-                    }
-                }
-
-                if (distance_object_map1.find(distance0) != distance_object_map1.end())
-                {
-                    for (Geo::Polyline *object : distance_object_map1[distance0])
-                    {
-                        polyline1 = object;
-                        back_j = polyline1->back();
-                        if (front_i == back_j && object_order[object] < j)
-                        {
-                            object_j = object;
-                            j = object_order[object_j];
-                        }
-                    }
-                }
-
-                if (distance_object_map0.find(distance1) != distance_object_map0.end())
-                {
-                    for (Geo::Polyline *object : distance_object_map0[distance1])
-                    {
-                        polyline1 = static_cast<Geo::Polyline *>(object);
-                        front_j = polyline1->front();
-                        if (back_i == front_j && object_order[object] < j)
-                        {
-                            object_j = object;
-                            j = object_order[object_j];
-                        }
-                    }
-                }
-
-                if (distance_object_map1.find(distance1) != distance_object_map1.end())
-                {
-                    for (Geo::Polyline *object : distance_object_map1[distance1])
-                    {
-                        polyline1 = object;
-                        back_j = polyline1->back();
-                        if (back_i == back_j && object_order[object] < j)
-                        {
-                            object_j = object;
-                            j = object_order[object_j];
-                        }
-                    }
-                }
-
-                polyline1 = object_j;
-            }
-
-            if (polyline1 == nullptr)
+            // 序号最小的可连接多段线
+            const size_t id = std::min(grid.find(front_i), grid.find(back_i));
+            if (id == SIZE_MAX)
             {
                 break;
             }
-
-            front_j = polyline1->front();
-            back_j = polyline1->back();
-
-            if (const double distance = std::hypot(front_j.x, front_j.y); distance_object_map0.find(distance) != distance_object_map0.end())
-            {
-                distance_object_map0[distance].erase(
-                    std::find(distance_object_map0[distance].begin(), distance_object_map0[distance].end(), polyline1));
-            }
-            if (const double distance = std::hypot(back_j.x, back_j.y); distance_object_map1.find(distance) != distance_object_map1.end())
-            {
-                distance_object_map1[distance].erase(
-                    std::find(distance_object_map1[distance].begin(), distance_object_map1[distance].end(), polyline1));
-            }
-            j = std::distance(_graph->container_group().begin(),
-                              std::find(_graph->container_group().begin(), _graph->container_group().end(), polyline1));
+            const size_t j = id / 2;
+            const Geo::Point &front_j = points[j * 2], &back_j = points[j * 2 + 1];
+            const Geo::Polyline *polyline1 = static_cast<const Geo::Polyline *>(group[indexs[j]]);
+            grid.remove(front_j, j * 2);
+            grid.remove(back_j, j * 2 + 1);
+            merged[indexs[j]] = true;
 
             if (front_i == front_j)
             {
                 polyline0->insert(0, polyline1->rbegin(), polyline1->rend());
                 front_i = polyline0->front();
-                _graph->container_group().remove(j--);
-                --count;
             }
             else if (front_i == back_j)
             {
                 polyline0->insert(0, polyline1->begin(), polyline1->end());
                 front_i = polyline0->front();
-                _graph->container_group().remove(j--);
-                --count;
             }
             else if (back_i == front_j)
             {
                 polyline0->append(polyline1->begin(), polyline1->end());
                 back_i = polyline0->back();
-                _graph->container_group().remove(j--);
-                --count;
             }
-            else if (back_i == back_j)
+            else
             {
                 polyline0->append(polyline1->rbegin(), polyline1->rend());
                 back_i = polyline0->back();
-                _graph->container_group().remove(j--);
-                --count;
             }
 
             if (front_i == back_i)
             {
-                _graph->container_group().insert(i, new Geo::Polygon(polyline0->begin(), polyline0->end()));
-                _graph->container_group().remove(i + 1);
+                *(group.begin() + i) = new Geo::Polygon(polyline0->begin(), polyline0->end());
+                delete polyline0;
                 break;
             }
         }
     }
 
+    // 被连接的多段线最后统一删除,避免逐个从容器中间删除
+    std::vector<Geo::Geometry *> objects;
+    objects.reserve(group.size());
+    for (size_t i = 0, count = group.size(); i < count; ++i)
+    {
+        if (merged[i])
+        {
+            delete group[i];
+        }
+        else
+        {
+            objects.push_back(group[i]);
+        }
+    }
+    while (!group.empty())
+    {
+        group.pop_back();
+    }
+    for (Geo::Geometry *object : objects)
+    {
+        group.append(object);
+    }
+
     _view_tree.build(_graph);
 }
 
@@ -9803,14 +9653,13 @@ void Editor::text_to_polylines(Text *text)
     {
         return;
     }
-    std::ifstream cfile("./fonts/HZFS.SHX", std::ios::binary);
-    std::ifstream efile("./fonts/ISO.SHX", std::ios::binary);
-    if (!cfile.is_open() || !efile.is_open())
+    SHXReader::SHXFont *cfont = SHXReader::SHXFont::font("./fonts/HZFS.SHX");
+    SHXReader::SHXFont *efont = SHXReader::SHXFont::font("./fonts/ISO.SHX");
+    if (cfont == nullptr || efont == nullptr)
     {
         return;
     }
 
-    SHXReader::SHXFont cfont(&cfile), efont(&efile);
     Combination *combination = new Combination();
     const std::string result = TextEncoding::utf8_to_gbk(text->text().toUtf8().toStdString());
     const int font_size = text->font().pointSize();
@@ -9822,7 +9671,7 @@ void Editor::text_to_polylines(Text *text)
         {
             const int code = ((result[i] & 0xFF) << 8) | (result[i + 1] & 0xFF);
             ++i;
-            SHXReader::SHXShape shape = cfont.char_shape(code, font_size);
+            SHXReader::SHXShape shape = cfont->char_shape(code, font_size);
             for (Geo::Polyline &polyline : shape.polylines)
             {
                 polyline.translate(x, y);
@@ -9840,7 +9689,7 @@ void Editor::text_to_polylines(Text *text)
         }
         else
         {
-            SHXReader::SHXShape shape = efont.char_shape(result[i], font_size / 2);
+            SHXReader::SHXShape shape = efont->char_shape(result[i], font_size / 2);
             for (Geo::Polyline &polyline : shape.polylines)
             {
                 polyline.translate(x, y);
@@ -10087,6 +9936,13 @@ void Editor::select_subfunc(const Geo::AABBRect &rect, const std::vector<Geo::Ge
                 result->push_back(container);
             }
             break;
+        case Geo::Type::ARRAY:
+            if (static_cast<const Array *>(container)->find(rect) != SIZE_MAX)
+            {
+                container->is_selected = true;
+                result->push_back(container);
+            }
+            break;
         default:
             break;
         }
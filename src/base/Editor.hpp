@@ -1,4 +1,5 @@
 #pragma once
+#include <unordered_map>
 #include "base/UndoStack.hpp"
 #include "base/Algorithm.hpp"
 #include "draw/QuadTree.hpp"
@@ -16,8 +17,25 @@ private:
     size_t _current_group = 0;
     double _view_ratio = 1.0;
 
+    std::vector<Geo::Geometry *> _current_group_objects; // 排序后的当前图层图形
+    std::tuple<size_t, size_t, size_t> _current_group_key = {SIZE_MAX, SIZE_MAX, SIZE_MAX};
+
     Geo::Geometry *_catched_points = nullptr;
 
+    // 选中图形按选中顺序保存,移出四叉树的图形立即置为nullptr,取消选中的图形在查询时清理,其余图形都未被删除
+    mutable std::vector<Geo::Geometry *> _selected_objects;
+    mutable std::unordered_map<const Geo::Geometry *, size_t> _selected_indices; // 各图形在_selected_objects中的位置
+
+    // 自动对齐目标的候选参考线位置,拖动时每次移动都会用到,按目标缓存
+    struct AligningLines
+    {
+        double x[3] = {0, 0, 0}; // 左、中、右竖直参考线
+        double y[3] = {0, 0, 0}; // 上、中、下水平参考线
+        size_t modification = 0; // 生成时目标在四叉树中的修改序号
+    };
+    std::unordered_map<const Geo::Geometry *, AligningLines> _aligning_lines;
+    size_t _aligning_lines_version = SIZE_MAX; // 生成缓存时四叉树的version
+
 public:
     std::vector<std::tuple<double, double>> edited_shape;
     std::vector<std::tuple<double, double>> edited_path;
@@ -26,8 +44,24 @@ public:
 private:
     void init();
 
+    // 清理已移出四叉树或取消选中的图形
+    void refresh_selected_objects() const;
+
+    // 图形移出四叉树时从选中集合中移除,不访问图形
+    void forget_selected(const Geo::Geometry *object);
+
+    // dst的候选参考线,dst修改后重新生成
+    const AligningLines &aligning_lines(const Geo::Geometry *dst);
+
+    // 查找离anchor最近的多边形、圆或椭圆作为自动对齐的目标,anchor在四叉树范围外时同样查找
+    Geo::Geometry *find_aligning_target(const Geo::Point &anchor, const Geo::Geometry *exclude, const bool skip_selected,
+                                        const bool current_group_only);
+
+    // 将当前图层中的阵列展开为独立图形并选中,压入一个撤销命令,返回展开的图形
+    std::vector<Geo::Geometry *> explode_arrays(const std::vector<Array *> &arrays);
+
 public:
-    Editor() = default;
+    Editor();
 
     ~Editor();
 
@@ -45,9 +79,24 @@ public:
 
     const Graph *graph() const;
 
+    // 只记录可见区域,可见图形在visible_objects中按需查找
     void refresh_visible_objects(const Geo::AABBRectParams &rect);
 
-    const std::vector<Geo::Geometry *> &visible_objects() const;
+    const std::vector<Geo::Geometry *> &visible_objects();
+
+    // 查找包围盒与rect相交的图形,结果不排序
+    void find_objects(const Geo::AABBRectParams &rect, std::vector<Geo::Geometry *> &objects);
+
+    SnapIndex &snap_index();
+
+    // 视图四叉树的增删改计数,object不为nullptr时为object最后一次加入或修改时的计数
+    size_t view_modification(const Geo::Geometry *object = nullptr) const;
+
+    // 图形加入视图四叉树时记录的包围盒,不在四叉树中时返回nullptr
+    const Geo::AABBRectParams *view_rect(const Geo::Geometry *object) const;
+
+    // 按地址排序的当前图层图形,图层或图形变化后才重新生成
+    const std::vector<Geo::Geometry *> &current_group_objects();
 
     std::vector<Geo::Point> &point_cache();
 
@@ -75,14 +124,33 @@ public:
 
     void reset_selected_mark(const bool value = false);
 
+    // 修改图形的选中状态,所有选中和取消选中都应经过此函数
+    void set_selected(Geo::Geometry *object, const bool value);
+
     const std::vector<Geo::Geometry *> &paste_table() const;
 
     void undo();
 
     void set_backup_count(const size_t count);
 
+    // 是否将较早的撤销记录中被删除的图形写入临时文件
+    void set_backup_spill(const bool value);
+
+    // 撤销记录的内存上限,超出时丢弃最早的记录
+    void set_backup_memory_limit(const size_t bytes);
+
+    // 撤销记录占用的内存字节数
+    size_t backup_memory_usage() const;
+
     void push_backup_command(UndoStack::Command *command);
 
+    // 事务期间的命令合并为一个撤销记录,四叉树和捕捉点索引的更新推迟到提交时,事务可嵌套
+    void begin_transaction();
+
+    void commit_transaction();
+
+    bool in_transaction() const;
+
     // Layer Operation
     void remove_group(const size_t index);
 
@@ -165,6 +233,7 @@ public:
 
     bool split(Geo::Geometry *object, const Geo::Point &pos);
 
+    // 阵列结果为一个Array对象,用detach展开为独立图形
     bool line_array(const std::vector<Geo::Geometry *> &objects, int x, int y, double x_space, double y_space);
 
     bool ring_array(const std::vector<Geo::Geometry *> &objects, const double x, const double y, const int n);
@@ -234,6 +303,9 @@ public:
     void bspline_to_bezier(Geo::BSpline *bspline);
 
 private:
+    // 将阵列加入当前图层并记录撤销命令,空阵列直接释放
+    bool append_array(Array *array);
+
     static void select_subfunc(const Geo::AABBRect &rect, const std::vector<Geo::Geometry *> *objects, const size_t start, const size_t end,
                                std::vector<Geo::Geometry *> *result);
 };
@@ -5,6 +5,9 @@
 #include <cstdint>
 #include <numeric>
 #include <future>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #include "base/Algorithm.hpp"
 #include "base/Math.hpp"
@@ -12,6 +15,119 @@
 using namespace Geo;
 
 
+ArcLengthTable::ArcLengthTable(const ArcLengthTable &table)
+{
+    std::lock_guard<std::mutex> lock(table._mutex);
+    _params = table._params;
+    _lengths = table._lengths;
+    _key.store(table._key.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+ArcLengthTable &ArcLengthTable::operator=(const ArcLengthTable &table)
+{
+    if (this != &table)
+    {
+        std::scoped_lock lock(_mutex, table._mutex);
+        _params = table._params;
+        _lengths = table._lengths;
+        _key.store(table._key.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    return *this;
+}
+
+void ArcLengthTable::build(const size_t key, const std::function<double(const double)> &norm,
+                           const std::function<std::vector<double>()> &params)
+{
+    if (_key.load(std::memory_order_acquire) == key)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_key.load(std::memory_order_relaxed) == key)
+    {
+        return; // 等待期间已由其他线程建立
+    }
+    _params = params();
+    _lengths.assign(1, 0);
+    for (size_t i = 1, count = _params.size(); i < count; ++i)
+    {
+        _lengths.push_back(_lengths.back() + Math::adaptive_simpson_3_8(norm, _params[i - 1], _params[i]));
+    }
+    _key.store(key, std::memory_order_release);
+}
+
+void ArcLengthTable::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _params.clear();
+    _lengths.clear();
+    _key.store(0, std::memory_order_release);
+}
+
+bool ArcLengthTable::empty() const
+{
+    return _params.size() < 2;
+}
+
+double ArcLengthTable::length() const
+{
+    return _lengths.empty() ? 0 : _lengths.back();
+}
+
+double ArcLengthTable::length(const std::function<double(const double)> &norm, const double t) const
+{
+    if (empty() || t <= _params.front())
+    {
+        return 0;
+    }
+    else if (t >= _params.back())
+    {
+        return _lengths.back();
+    }
+    const size_t i = std::upper_bound(_params.begin(), _params.end(), t) - _params.begin() - 1;
+    return _lengths[i] + Math::adaptive_simpson_3_8(norm, _params[i], t);
+}
+
+double ArcLengthTable::param(const std::function<double(const double)> &norm, const double length) const
+{
+    if (empty() || length <= 0)
+    {
+        return _params.empty() ? 0 : _params.front();
+    }
+    else if (length >= _lengths.back())
+    {
+        return _params.back();
+    }
+
+    const size_t i = std::upper_bound(_lengths.begin(), _lengths.end(), length) - _lengths.begin() - 1;
+    const double target = length - _lengths[i];
+    double low = _params[i], high = _params[i + 1];
+    double t = low + (high - low) * target / (_lengths[i + 1] - _lengths[i]);
+    // 牛顿迭代,迭代点越出有根区间时改用二分
+    for (int j = 0; j < 64; ++j)
+    {
+        const double d = Math::adaptive_simpson_3_8(norm, _params[i], t) - target;
+        if (std::abs(d) < 1e-11)
+        {
+            break;
+        }
+        (d < 0 ? low : high) = t;
+        const double v = norm(t);
+        double next = v > 0 ? t - d / v : (low + high) / 2;
+        if (next <= low || next >= high)
+        {
+            next = (low + high) / 2;
+        }
+        if (std::abs(next - t) < 1e-15)
+        {
+            break;
+        }
+        t = next;
+    }
+    return t;
+}
+
+
 double Geometry::length() const
 {
     return 0;
@@ -235,6 +351,257 @@ void Point::operator/=(const double k)
     y /= k;
 }
 
+// SharedPoints
+
+SharedPoints::SharedPoints(const std::vector<Point>::const_iterator &begin, const std::vector<Point>::const_iterator &end)
+    : _data(std::make_shared<std::vector<Point>>(begin, end))
+{
+}
+
+SharedPoints::SharedPoints(const std::initializer_list<Point> &points) : _data(std::make_shared<std::vector<Point>>(points))
+{
+}
+
+SharedPoints::SharedPoints(const SharedPoints &points)
+    : _data(points._lent && points._data != nullptr ? std::make_shared<std::vector<Point>>(*points._data) : points._data),
+      _revision(points._revision)
+{
+}
+
+void SharedPoints::detach()
+{
+    if (_data == nullptr)
+    {
+        _data = std::make_shared<std::vector<Point>>();
+    }
+    else if (_data.use_count() > 1)
+    {
+        _data = std::make_shared<std::vector<Point>>(*_data);
+    }
+}
+
+SharedPoints &SharedPoints::lend()
+{
+    detach();
+    _lent = true;
+    return *this;
+}
+
+std::vector<Point> &SharedPoints::data()
+{
+    ++_revision;
+    detach();
+    return *_data;
+}
+
+const std::vector<Point> &SharedPoints::const_data() const
+{
+    static const std::vector<Point> empty_points;
+    return _data == nullptr ? empty_points : *_data;
+}
+
+SharedPoints &SharedPoints::operator=(const SharedPoints &points)
+{
+    if (this != &points)
+    {
+        // 原数组上交出的引用不再属于本对象
+        _data = points._lent && points._data != nullptr ? std::make_shared<std::vector<Point>>(*points._data) : points._data;
+        _lent = false;
+        ++_revision;
+    }
+    return *this;
+}
+
+SharedPoints::operator const std::vector<Point> &() const
+{
+    return const_data();
+}
+
+size_t SharedPoints::revision() const
+{
+    return _revision;
+}
+
+bool SharedPoints::shared() const
+{
+    return _data != nullptr && _data.use_count() > 1;
+}
+
+size_t SharedPoints::size() const
+{
+    return _data == nullptr ? 0 : _data->size();
+}
+
+bool SharedPoints::empty() const
+{
+    return _data == nullptr || _data->empty();
+}
+
+void SharedPoints::clear()
+{
+    ++_revision;
+    if (_data != nullptr && _data.use_count() == 1)
+    {
+        _data->clear();
+    }
+    else
+    {
+        _data.reset();
+    }
+}
+
+void SharedPoints::reserve(const size_t count)
+{
+    data().reserve(count);
+}
+
+void SharedPoints::shrink_to_fit()
+{
+    if (_data != nullptr && _data.use_count() == 1)
+    {
+        _data->shrink_to_fit();
+    }
+}
+
+Point &SharedPoints::operator[](const size_t index)
+{
+    return data()[index];
+}
+
+const Point &SharedPoints::operator[](const size_t index) const
+{
+    return (*_data)[index];
+}
+
+Point &SharedPoints::at(const size_t index)
+{
+    return data().at(index);
+}
+
+const Point &SharedPoints::at(const size_t index) const
+{
+    return const_data().at(index);
+}
+
+Point &SharedPoints::front()
+{
+    return data().front();
+}
+
+const Point &SharedPoints::front() const
+{
+    return _data->front();
+}
+
+Point &SharedPoints::back()
+{
+    return data().back();
+}
+
+const Point &SharedPoints::back() const
+{
+    return _data->back();
+}
+
+std::vector<Point>::iterator SharedPoints::begin()
+{
+    return data().begin();
+}
+
+std::vector<Point>::const_iterator SharedPoints::begin() const
+{
+    return const_data().begin();
+}
+
+std::vector<Point>::const_iterator SharedPoints::cbegin() const
+{
+    return const_data().cbegin();
+}
+
+std::vector<Point>::iterator SharedPoints::end()
+{
+    return data().end();
+}
+
+std::vector<Point>::const_iterator SharedPoints::end() const
+{
+    return const_data().end();
+}
+
+std::vector<Point>::const_iterator SharedPoints::cend() const
+{
+    return const_data().cend();
+}
+
+std::vector<Point>::reverse_iterator SharedPoints::rbegin()
+{
+    return data().rbegin();
+}
+
+std::vector<Point>::const_reverse_iterator SharedPoints::rbegin() const
+{
+    return const_data().rbegin();
+}
+
+std::vector<Point>::const_reverse_iterator SharedPoints::crbegin() const
+{
+    return const_data().crbegin();
+}
+
+std::vector<Point>::reverse_iterator SharedPoints::rend()
+{
+    return data().rend();
+}
+
+std::vector<Point>::const_reverse_iterator SharedPoints::rend() const
+{
+    return const_data().rend();
+}
+
+std::vector<Point>::const_reverse_iterator SharedPoints::crend() const
+{
+    return const_data().crend();
+}
+
+void SharedPoints::push_back(const Point &point)
+{
+    data().push_back(point);
+}
+
+void SharedPoints::pop_back()
+{
+    data().pop_back();
+}
+
+std::vector<Point>::iterator SharedPoints::insert(const std::vector<Point>::const_iterator &pos, const Point &point)
+{
+    const std::ptrdiff_t index = pos - const_data().cbegin();
+    std::vector<Point> &points = data();
+    return points.insert(points.cbegin() + index, point);
+}
+
+std::vector<Point>::iterator SharedPoints::insert(const std::vector<Point>::const_iterator &pos, const size_t count, const Point &point)
+{
+    const std::ptrdiff_t index = pos - const_data().cbegin();
+    std::vector<Point> &points = data();
+    return points.insert(points.cbegin() + index, count, point);
+}
+
+std::vector<Point>::iterator SharedPoints::erase(const std::vector<Point>::const_iterator &pos)
+{
+    const std::ptrdiff_t index = pos - const_data().cbegin();
+    std::vector<Point> &points = data();
+    return points.erase(points.cbegin() + index);
+}
+
+std::vector<Point>::iterator SharedPoints::erase(const std::vector<Point>::const_iterator &begin,
+                                                 const std::vector<Point>::const_iterator &end)
+{
+    const std::ptrdiff_t index0 = begin - const_data().cbegin(), index1 = end - const_data().cbegin();
+    std::vector<Point> &points = data();
+    return points.erase(points.cbegin() + index0, points.cbegin() + index1);
+}
+
 // Polyline
 
 Polyline::Polyline(const Polygon &polygon) : _points(polygon.begin(), polygon.end())
@@ -279,6 +646,11 @@ void Polyline::clear()
     _points.clear();
 }
 
+void Polyline::shrink_to_fit()
+{
+    _points.shrink_to_fit();
+}
+
 Polyline *Polyline::clone() const
 {
     return new Polyline(*this);
@@ -315,7 +687,7 @@ bool Polyline::is_self_intersected() const
 Point &Polyline::operator[](const size_t index)
 {
     assert(index < _points.size());
-    return _points[index];
+    return _points.lend()[index];
 }
 
 const Point &Polyline::operator[](const size_t index) const
@@ -326,7 +698,7 @@ const Point &Polyline::operator[](const size_t index) const
 
 Point &Polyline::at(const size_t index)
 {
-    return _points.at(index);
+    return _points.lend().at(index);
 }
 
 const Point &Polyline::at(const size_t index) const
@@ -458,7 +830,7 @@ void Polyline::flip()
 Point &Polyline::front()
 {
     assert(!_points.empty());
-    return _points.front();
+    return _points.lend().front();
 }
 
 const Point &Polyline::front() const
@@ -470,7 +842,7 @@ const Point &Polyline::front() const
 Point &Polyline::back()
 {
     assert(!_points.empty());
-    return _points.back();
+    return _points.lend().back();
 }
 
 const Point &Polyline::back() const
@@ -481,7 +853,7 @@ const Point &Polyline::back() const
 
 std::vector<Point>::iterator Polyline::begin()
 {
-    return _points.begin();
+    return _points.lend().begin();
 }
 
 std::vector<Point>::const_iterator Polyline::begin() const
@@ -496,7 +868,7 @@ std::vector<Point>::const_iterator Polyline::cbegin() const
 
 std::vector<Point>::iterator Polyline::end()
 {
-    return _points.end();
+    return _points.lend().end();
 }
 
 std::vector<Point>::const_iterator Polyline::end() const
@@ -511,7 +883,7 @@ std::vector<Point>::const_iterator Polyline::cend() const
 
 std::vector<Point>::reverse_iterator Polyline::rbegin()
 {
-    return _points.rbegin();
+    return _points.lend().rbegin();
 }
 
 std::vector<Point>::const_reverse_iterator Polyline::rbegin() const
@@ -526,7 +898,7 @@ std::vector<Point>::const_reverse_iterator Polyline::crbegin() const
 
 std::vector<Point>::reverse_iterator Polyline::rend()
 {
-    return _points.rend();
+    return _points.lend().rend();
 }
 
 std::vector<Point>::const_reverse_iterator Polyline::rend() const
@@ -541,7 +913,8 @@ std::vector<Point>::const_reverse_iterator Polyline::crend() const
 
 std::vector<Point>::iterator Polyline::find(const Point &point)
 {
-    return std::find(_points.begin(), _points.end(), point);
+    SharedPoints &points = _points.lend();
+    return std::find(points.begin(), points.end(), point);
 }
 
 std::vector<Point>::const_iterator Polyline::find(const Point &point) const
@@ -721,17 +1094,7 @@ AABBRectParams Polyline::aabbrect_params() const
 
 void Polyline::remove_repeated_points()
 {
-    if (_points.empty())
-    {
-        return;
-    }
-    for (size_t i = _points.size() - 1; i > 0; --i)
-    {
-        if (_points[i] == _points[i - 1])
-        {
-            _points.erase(_points.begin() + i);
-        }
-    }
+    _points.erase(std::unique(_points.begin(), _points.end()), _points.end());
 }
 
 Point Polyline::shape_point(const size_t index, const double t) const
@@ -1264,10 +1627,11 @@ void Polygon::reorder_points(const bool cw)
         return;
     }
 
+    const SharedPoints &points = _points; // 只读,不需要复制共享的数据
     double result = 0;
     for (size_t i = 0, count = size() - 1; i < count; ++i)
     {
-        result += (_points[i].x * _points[i + 1].y - _points[i + 1].x * _points[i].y);
+        result += (points[i].x * points[i + 1].y - points[i + 1].x * points[i].y);
     }
     if (cw)
     {
@@ -1552,13 +1916,14 @@ const Point &Polygon::next_point(const size_t index) const
 
 Point &Polygon::next_point(const size_t index)
 {
+    SharedPoints &points = _points.lend();
     if (index < size() - 1)
     {
-        return _points[index + 1];
+        return points[index + 1];
     }
     else
     {
-        return _points[1];
+        return points[1];
     }
 }
 
@@ -1588,13 +1953,14 @@ const Point &Polygon::last_point(const size_t index) const
 
 Point &Polygon::last_point(const size_t index)
 {
+    SharedPoints &points = _points.lend();
     if (index > 0)
     {
-        return _points[index - 1];
+        return points[index - 1];
     }
     else
     {
-        return _points[_points.size() - 2];
+        return points[points.size() - 2];
     }
 }
 
@@ -2184,6 +2550,16 @@ const Polyline &CubicBezier::shape() const
     return _shape;
 }
 
+double CubicBezier::step() const
+{
+    return _step;
+}
+
+double CubicBezier::down_sampling_value() const
+{
+    return _down_sampling_value;
+}
+
 void CubicBezier::update_control_points()
 {
     std::vector<Geo::Point> paths(_points);
@@ -2207,50 +2583,96 @@ void CubicBezier::update_control_points()
 void CubicBezier::update_shape(const double step, const double down_sampling_value)
 {
     assert(0 < step && step < 1);
+    _step = step;
+    _down_sampling_value = down_sampling_value;
     _shape.clear();
+    _arc_lengths.clear();
     if (_points.size() <= 3)
     {
         return;
     }
     const int nums[4] = {1, 3, 3, 1};
+    const SharedPoints &points = _points; // 只读,不需要复制共享的数据
 
     for (size_t i = 0, end = _points.size() - 3; i < end; i += 3)
     {
-        _shape.append(_points[i]);
+        _shape.append(points[i]);
         double t = 0;
         while (t <= 1)
         {
             Geo::Point point;
             for (int j = 0; j <= 3; ++j)
             {
-                point += (_points[j + i] * (nums[j] * std::pow(1 - t, 3 - j) * std::pow(t, j)));
+                point += (points[j + i] * (nums[j] * std::pow(1 - t, 3 - j) * std::pow(t, j)));
             }
             _shape.append(point);
             t += step;
         }
     }
-    _shape.append(_points.back());
+    _shape.append(points.back());
     _shape.remove_repeated_points();
     Geo::down_sampling(_shape, down_sampling_value);
 }
 
 double CubicBezier::length() const
 {
-    double result = 0;
-    for (size_t i = 0, count = _points.size() / 3; i < count; ++i)
-    {
-        Math::CurveNorm f = [this, i](const double t) { return tangent(i, t).length(); };
-        result += Math::adaptive_simpson_3_8(f, 0, 1);
-    }
-    return result;
+    return arc_lengths().length();
+}
+
+const ArcLengthTable &CubicBezier::arc_lengths() const
+{
+    // 以控制点的修改序号为版本,经Polyline接口修改控制点后也会重建
+    _arc_lengths.build(_points.revision(), [this](const double t) { return arc_norm(t); },
+                       [this]()
+                       {
+                           // 每段曲线再等分为4个分段
+                           std::vector<double> params;
+                           if (_points.size() <= 3)
+                           {
+                               return params;
+                           }
+                           for (size_t i = 0, count = _points.size() / 3; i < count; ++i)
+                           {
+                               for (int j = 0; j < 4; ++j)
+                               {
+                                   params.push_back(i + j / 4.0);
+                               }
+                           }
+                           params.push_back(_points.size() / 3);
+                           return params;
+                       });
+    return _arc_lengths;
+}
+
+double CubicBezier::arc_norm(const double t) const
+{
+    const size_t index = std::min<size_t>(t, _points.size() / 3 - 1);
+    return tangent(index, t - index).length();
+}
+
+double CubicBezier::param_to_length(const double t) const
+{
+    return arc_lengths().length([this](const double v) { return arc_norm(v); }, t);
+}
+
+double CubicBezier::length_to_param(const double length) const
+{
+    return arc_lengths().param([this](const double v) { return arc_norm(v); }, length);
 }
 
 void CubicBezier::clear()
 {
     _shape.clear();
+    _arc_lengths.clear();
     Polyline::clear();
 }
 
+void CubicBezier::shrink_to_fit()
+{
+    _shape.shrink_to_fit();
+    Polyline::shrink_to_fit();
+}
+
 CubicBezier *CubicBezier::clone() const
 {
     return new CubicBezier(*this);
@@ -2262,6 +2684,9 @@ CubicBezier &CubicBezier::operator=(const CubicBezier &bezier)
     {
         Polyline::operator=(bezier);
         _shape = bezier._shape;
+        _arc_lengths = bezier._arc_lengths;
+        _step = bezier._step;
+        _down_sampling_value = bezier._down_sampling_value;
     }
     return *this;
 }
@@ -2270,12 +2695,14 @@ void CubicBezier::transform(const double a, const double b, const double c, cons
 {
     Polyline::transform(a, b, c, d, e, f);
     _shape.transform(a, b, c, d, e, f);
+    _arc_lengths.clear();
 }
 
 void CubicBezier::transform(const double mat[6])
 {
     Polyline::transform(mat);
     _shape.transform(mat);
+    _arc_lengths.clear();
 }
 
 void CubicBezier::translate(const double tx, const double ty)
@@ -2294,6 +2721,7 @@ void CubicBezier::scale(const double x, const double y, const double k)
 {
     Polyline::scale(x, y, k);
     _shape.scale(x, y, k);
+    _arc_lengths.clear();
 }
 
 Polygon CubicBezier::convex_hull() const
@@ -2561,7 +2989,7 @@ Ellipse::Ellipse(const Point &a0, const Point &a1, const Point &b0, const Point
     update_shape(Geo::Ellipse::default_down_sampling_value);
 }
 
-Ellipse::Ellipse(const Ellipse &ellipse) : Geometry(ellipse), _shape(ellipse._shape)
+Ellipse::Ellipse(const Ellipse &ellipse) : Geometry(ellipse), _shape(ellipse._shape), _arc_lengths(ellipse._arc_lengths)
 {
     _a[0] = ellipse._a[0];
     _a[1] = ellipse._a[1];
@@ -2587,6 +3015,7 @@ Ellipse &Ellipse::operator=(const Ellipse &ellipse)
         _arc_param[0] = ellipse._arc_param[0];
         _arc_param[1] = ellipse._arc_param[1];
         _shape = ellipse._shape;
+        _arc_lengths = ellipse._arc_lengths;
     }
     return *this;
 }
@@ -2635,6 +3064,7 @@ double Ellipse::param_to_angle(double param) const
 
 void Ellipse::update_angle_param(const double start, const double end, const bool is_param)
 {
+    _arc_lengths.clear();
     if (is_param)
     {
         _arc_param[0] = start, _arc_param[1] = end;
@@ -2693,6 +3123,47 @@ double Ellipse::length() const
     }
 }
 
+const ArcLengthTable &Ellipse::arc_lengths() const
+{
+    // 修改椭圆的函数都会清空弧长表,版本固定为1
+    _arc_lengths.build(1, [this](const double t) { return arc_norm(t); },
+                       [this]()
+                       {
+                           std::vector<double> params;
+                           if (empty())
+                           {
+                               return params;
+                           }
+                           // 椭圆弧从_arc_param[0]逆时针到_arc_param[1],整椭圆取[0, 2PI]
+                           const double start = is_arc() ? _arc_param[0] : 0;
+                           const double end =
+                               is_arc() ? (_arc_param[1] < _arc_param[0] ? _arc_param[1] + Geo::PI * 2 : _arc_param[1]) : Geo::PI * 2;
+                           for (int i = 0; i < 64; ++i)
+                           {
+                               params.push_back(start + (end - start) * i / 64);
+                           }
+                           params.push_back(end);
+                           return params;
+                       });
+    return _arc_lengths;
+}
+
+double Ellipse::arc_norm(const double t) const
+{
+    const double a = lengtha(), b = lengthb();
+    return std::hypot(a * std::sin(t), b * std::cos(t));
+}
+
+double Ellipse::param_to_length(const double t) const
+{
+    return arc_lengths().length([this](const double v) { return arc_norm(v); }, t);
+}
+
+double Ellipse::length_to_param(const double length) const
+{
+    return arc_lengths().param([this](const double v) { return arc_norm(v); }, length);
+}
+
 bool Ellipse::empty() const
 {
     return _a[0] == _a[1] || _b[0] == _b[1];
@@ -2700,6 +3171,7 @@ bool Ellipse::empty() const
 
 void Ellipse::clear()
 {
+    _arc_lengths.clear();
     _a[0].clear();
     _a[1].clear();
     _b[0].clear();
@@ -2713,6 +3185,7 @@ Ellipse *Ellipse::clone() const
 
 void Ellipse::transform(const double a, const double b, const double c, const double d, const double e, const double f)
 {
+    _arc_lengths.clear();
     _a[0].transform(a, b, c, d, e, f);
     _a[1].transform(a, b, c, d, e, f);
     _b[0].transform(a, b, c, d, e, f);
@@ -2729,6 +3202,7 @@ void Ellipse::transform(const double a, const double b, const double c, const do
 
 void Ellipse::transform(const double mat[6])
 {
+    _arc_lengths.clear();
     _a[0].transform(mat);
     _a[1].transform(mat);
     _b[0].transform(mat);
@@ -2763,6 +3237,7 @@ void Ellipse::rotate(const double x, const double y, const double rad)
 
 void Ellipse::scale(const double x, const double y, const double k)
 {
+    _arc_lengths.clear();
     _a[0].scale(x, y, k);
     _a[1].scale(x, y, k);
     _b[0].scale(x, y, k);
@@ -2851,6 +3326,7 @@ Geo::Point Ellipse::center() const
 
 void Ellipse::set_lengtha(const double a)
 {
+    _arc_lengths.clear();
     if (_a[0] == _a[1])
     {
         if (_b[0] == _b[1])
@@ -2876,6 +3352,7 @@ void Ellipse::set_lengtha(const double a)
 
 void Ellipse::set_lengthb(const double b)
 {
+    _arc_lengths.clear();
     if (_b[0] == _b[1])
     {
         if (_a[0] == _a[1])
@@ -2908,6 +3385,7 @@ void Ellipse::set_center(const double x, const double y)
 void Ellipse::reset_parameter(const Geo::Point &a0, const Geo::Point &a1, const Geo::Point &b0, const Geo::Point &b1,
                               const double start_anlge, const double end_angle)
 {
+    _arc_lengths.clear();
     _a[0] = a0, _a[1] = a1;
     _b[0] = b0, _b[1] = b1;
     _arc_angle[0] = start_anlge, _arc_angle[1] = end_angle;
@@ -2928,6 +3406,7 @@ void Ellipse::reset_parameter(const Geo::Point &a0, const Geo::Point &a1, const
 
 void Ellipse::reset_parameter(const double parameters[10])
 {
+    _arc_lengths.clear();
     _a[0].x = parameters[0], _a[0].y = parameters[1];
     _a[1].y = parameters[2], _a[1].y = parameters[3];
     _b[0].x = parameters[4], _b[0].y = parameters[5];
@@ -3038,6 +3517,7 @@ double Ellipse::arc_param1() const
 
 void Ellipse::update_shape(const double down_sampling_value)
 {
+    _arc_lengths.clear();
     const Geo::Point point = center();
     if (_arc_angle[0] == _arc_angle[1] || _arc_angle[1] - _arc_angle[0] == Geo::PI * 2)
     {
@@ -3144,11 +3624,15 @@ BSpline &BSpline::operator=(const BSpline &bspline)
     {
         Geometry::operator=(bspline);
         _shape = bspline._shape;
+        _shape_spans = bspline._shape_spans;
+        _arc_lengths = bspline._arc_lengths;
         controls_model = bspline.controls_model;
         control_points = bspline.control_points;
         path_points = bspline.path_points;
         _path_values = bspline._path_values;
         _knots = bspline._knots;
+        _step = bspline._step;
+        _down_sampling_value = bspline._down_sampling_value;
     }
     return *this;
 }
@@ -3160,12 +3644,46 @@ const Polyline &BSpline::shape() const
 
 double BSpline::length() const
 {
-    if (_knots.empty())
-    {
-        return 0;
-    }
-    Math::CurveNorm f = [this](const double t) { return tangent(t).length(); };
-    return Math::adaptive_simpson_3_8(f, _knots.front(), _knots.back());
+    return arc_lengths().length();
+}
+
+const ArcLengthTable &BSpline::arc_lengths() const
+{
+    // 控制点和节点只在update_shape等函数中生效,这些函数都会清空弧长表,版本固定为1
+    _arc_lengths.build(1, [this](const double t) { return tangent(t).length(); },
+                       [this]()
+                       {
+                           std::vector<double> params;
+                           if (_knots.empty())
+                           {
+                               return params;
+                           }
+                           // 每个非空节点区间再等分为4个分段
+                           params.push_back(_knots.front());
+                           for (size_t i = 1, count = _knots.size(); i < count; ++i)
+                           {
+                               if (_knots[i] > _knots[i - 1])
+                               {
+                                   for (int j = 1; j < 4; ++j)
+                                   {
+                                       params.push_back(_knots[i - 1] + (_knots[i] - _knots[i - 1]) * j / 4.0);
+                                   }
+                                   params.push_back(_knots[i]);
+                               }
+                           }
+                           return params;
+                       });
+    return _arc_lengths;
+}
+
+double BSpline::param_to_length(const double t) const
+{
+    return arc_lengths().length([this](const double v) { return tangent(v).length(); }, t);
+}
+
+double BSpline::length_to_param(const double length) const
+{
+    return arc_lengths().param([this](const double v) { return tangent(v).length(); }, length);
 }
 
 bool BSpline::empty() const
@@ -3176,15 +3694,26 @@ bool BSpline::empty() const
 void BSpline::clear()
 {
     _shape.clear();
+    _shape_spans.clear();
+    _arc_lengths.clear();
     control_points.clear();
     path_points.clear();
 }
 
+void BSpline::shrink_to_fit()
+{
+    _shape.shrink_to_fit();
+    _shape_spans.shrink_to_fit();
+    control_points.shrink_to_fit();
+    path_points.shrink_to_fit();
+}
+
 void BSpline::transform(const double a, const double b, const double c, const double d, const double e, const double f)
 {
     _shape.transform(a, b, c, d, e, f);
     std::for_each(path_points.begin(), path_points.end(), [=](Point &point) { point.transform(a, b, c, d, e, f); });
     std::for_each(control_points.begin(), control_points.end(), [=](Point &point) { point.transform(a, b, c, d, e, f); });
+    _arc_lengths.clear();
 }
 
 void BSpline::transform(const double mat[6])
@@ -3192,6 +3721,7 @@ void BSpline::transform(const double mat[6])
     _shape.transform(mat);
     std::for_each(path_points.begin(), path_points.end(), [=](Point &point) { point.transform(mat); });
     std::for_each(control_points.begin(), control_points.end(), [=](Point &point) { point.transform(mat); });
+    _arc_lengths.clear();
 }
 
 void BSpline::translate(const double tx, const double ty)
@@ -3213,6 +3743,7 @@ void BSpline::scale(const double x, const double y, const double k)
     _shape.scale(x, y, k);
     std::for_each(path_points.begin(), path_points.end(), [=](Point &point) { point.scale(x, y, k); });
     std::for_each(control_points.begin(), control_points.end(), [=](Point &point) { point.scale(x, y, k); });
+    _arc_lengths.clear();
 }
 
 Polygon BSpline::convex_hull() const
@@ -3245,6 +3776,16 @@ const Point &BSpline::back() const
     return _shape.back();
 }
 
+double BSpline::step() const
+{
+    return _step;
+}
+
+double BSpline::down_sampling_value() const
+{
+    return _down_sampling_value;
+}
+
 const std::vector<double> &BSpline::knots() const
 {
     return _knots;
@@ -3253,6 +3794,7 @@ const std::vector<double> &BSpline::knots() const
 void BSpline::set_knots(const std::vector<double>::const_iterator &begin, const std::vector<double>::const_iterator &end)
 {
     _knots.assign(begin, end);
+    _arc_lengths.clear();
 }
 
 void BSpline::reverse()
@@ -3266,100 +3808,164 @@ void BSpline::reverse()
 
 void BSpline::rbasis(const int order, const double t, const size_t npts, const std::vector<double> &x, std::vector<double> &output)
 {
-    const size_t nplusc = npts + order + 1;
-    std::vector<double> temp(nplusc, 0);
-    // calculate the first order nonrational basis functions n[i]
-    for (size_t i = 0; i < nplusc - 1; ++i)
+    output.assign(npts, 0);
+    if (const size_t span = Math::bspline_span(order, npts, x.data(), t); span == npts)
     {
-        if ((t >= x[i]) && (t < x[i + 1]))
+        if (npts > 0 && t >= x.back())
         {
-            temp[i] = 1;
+            output.back() = 1;
         }
     }
-
-    // calculate the higher order nonrational basis functions
-    for (int k = 2; k <= order + 1; ++k)
+    else if (t >= x[order] && t <= x[npts])
     {
-        for (size_t i = 0; i < nplusc - k; ++i)
-        {
-            // if the lower order basis function is zero skip the calculation
-            if (temp[i] != 0)
-            {
-                temp[i] = ((t - x[i]) * temp[i]) / (x[i + k - 1] - x[i]);
-            }
-            // if the lower order basis function is zero skip the calculation
-            if (temp[i + 1] != 0)
-            {
-                temp[i] += ((x[i + k] - t) * temp[i + 1]) / (x[i + k] - x[i + 1]);
-            }
-        }
+        Math::bspline_basis(order, span, x.data(), t, &output[span - order]);
     }
+}
 
-    // pick up last point
-    if (t >= x[nplusc - 1])
+Point BSpline::de_boor(const int order, const double t, const size_t npts, const std::vector<double> &knots, const std::vector<Point> &b)
+{
+    const size_t span = Math::bspline_span(order, npts, knots.data(), t);
+    if (span == npts)
     {
-        temp[npts - 1] = 1;
+        return b.back();
     }
 
-    // calculate sum for denominator of rational basis functions
-    double sum = 0;
-    for (size_t i = 0; i < npts; ++i)
+    const double value = std::clamp(t, knots[order], knots[npts]);
+    Point d[Math::MAX_BSPLINE_ORDER + 1];
+    for (int j = 0; j <= order; ++j)
     {
-        sum += temp[i];
+        d[j] = b[span - order + j];
     }
-
-    output.resize(npts, 0);
-    // form rational basis functions and put in r vector
-    if (sum != 0)
+    for (int r = 1; r <= order; ++r)
     {
-        for (size_t i = 0; i < npts; ++i)
+        for (int j = order; j >= r; --j)
         {
-            output[i] = temp[i] / sum;
+            const size_t i = span - order + j;
+            const double alpha = (value - knots[i]) / (knots[i + order + 1 - r] - knots[i]);
+            d[j].x = d[j - 1].x * (1 - alpha) + d[j].x * alpha;
+            d[j].y = d[j - 1].y * (1 - alpha) + d[j].y * alpha;
         }
     }
+    return d[order];
 }
 
-void BSpline::rbspline(const int order, const size_t npts, const size_t p1, const std::vector<double> &knots, const std::vector<Point> &b,
-                       std::vector<Point> &p)
+void BSpline::de_boor(const int order, const size_t npts, const std::vector<double> &knots, const std::vector<Point> &b, const double *t,
+                      const size_t count, Point *output)
 {
-    const size_t nplusc = npts + order + 1;
-    // calculate the points on the rational B-spline curve
-    double t = knots[0];
-    const double step = (knots[nplusc - 1] - t) / (p1 - 1);
-
-    if (const size_t count = p.size(); count <= 3000)
+    size_t i = 0;
+#ifdef __AVX2__
+    if (Math::bspline_span(order, npts, knots.data(), knots[order]) != npts)
     {
-        for (Geo::Point &vp : p)
+        const double lower = knots[order], upper = knots[npts];
+        for (; i + 4 <= count; i += 4)
         {
-            if (knots[nplusc - 1] - t < 5e-6)
+            size_t span[4];
+            double values[4];
+            for (int k = 0; k < 4; ++k)
             {
-                t = knots[nplusc - 1];
+                values[k] = std::clamp(t[i + k], lower, upper);
+                span[k] = Math::bspline_span(order, npts, knots.data(), values[k]);
             }
-            // generate the basis function for this value of t
-            std::vector<double> nbasis;
-            rbasis(order, t, npts, knots, nbasis);
-            // generate a point on the curve
-            for (size_t j = 0, count = nbasis.size(); j < count; ++j)
+
+            // 4个参数同时计算非零基函数
+            const __m256d vt = _mm256_loadu_pd(values);
+            __m256d nbasis[Math::MAX_BSPLINE_ORDER + 1], left[Math::MAX_BSPLINE_ORDER + 1], right[Math::MAX_BSPLINE_ORDER + 1];
+            nbasis[0] = _mm256_set1_pd(1.0);
+            for (int j = 1; j <= order; ++j)
             {
-                if (nbasis[j] > 0)
+                left[j] = _mm256_sub_pd(vt, _mm256_set_pd(knots[span[3] + 1 - j], knots[span[2] + 1 - j], knots[span[1] + 1 - j],
+                                                          knots[span[0] + 1 - j]));
+                right[j] = _mm256_sub_pd(_mm256_set_pd(knots[span[3] + j], knots[span[2] + j], knots[span[1] + j], knots[span[0] + j]), vt);
+                __m256d saved = _mm256_setzero_pd();
+                for (int r = 0; r < j; ++r)
                 {
-                    for (int i = 0; i <= order && j < count; ++i, ++j)
-                    {
-                        vp += b[j] * nbasis[j];
-                    }
-                    break;
+                    const __m256d temp = _mm256_div_pd(nbasis[r], _mm256_add_pd(right[r + 1], left[j - r]));
+                    nbasis[r] = _mm256_add_pd(saved, _mm256_mul_pd(right[r + 1], temp));
+                    saved = _mm256_mul_pd(left[j - r], temp);
                 }
+                nbasis[j] = saved;
             }
-            t += step;
+
+            __m256d x = _mm256_setzero_pd(), y = _mm256_setzero_pd();
+            for (int j = 0; j <= order; ++j)
+            {
+                const Point &p0 = b[span[0] - order + j], &p1 = b[span[1] - order + j];
+                const Point &p2 = b[span[2] - order + j], &p3 = b[span[3] - order + j];
+                x = _mm256_add_pd(x, _mm256_mul_pd(nbasis[j], _mm256_set_pd(p3.x, p2.x, p1.x, p0.x)));
+                y = _mm256_add_pd(y, _mm256_mul_pd(nbasis[j], _mm256_set_pd(p3.y, p2.y, p1.y, p0.y)));
+            }
+            double xs[4], ys[4];
+            _mm256_storeu_pd(xs, x);
+            _mm256_storeu_pd(ys, y);
+            for (int k = 0; k < 4; ++k)
+            {
+                output[i + k].x = xs[k];
+                output[i + k].y = ys[k];
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        output[i] = de_boor(order, t[i], npts, knots, b);
+    }
+}
+
+Point BSpline::de_boor_derivative(const int order, const double t, const int n, const size_t npts, const std::vector<double> &knots,
+                                  const std::vector<Point> &b)
+{
+    if (n > order)
+    {
+        return Point();
+    }
+    const size_t span = Math::bspline_span(order, npts, knots.data(), t);
+    if (span == npts)
+    {
+        return n == 0 ? b.back() : Point();
+    }
+
+    // 在当前区间内逐阶求导数曲线的控制点
+    Point d[Math::MAX_BSPLINE_ORDER + 1];
+    for (int j = 0; j <= order; ++j)
+    {
+        d[j] = b[span - order + j];
+    }
+    for (int k = 1; k <= n; ++k)
+    {
+        for (int j = order; j >= k; --j)
+        {
+            const size_t i = span - order + j;
+            const double denom = knots[i + order - k + 1] - knots[i];
+            d[j] = denom == 0 ? Point() : (d[j] - d[j - 1]) * (order - k + 1) / denom;
         }
     }
+
+    double nbasis[Math::MAX_BSPLINE_ORDER + 1];
+    Math::bspline_basis(order - n, span, knots.data(), std::clamp(t, knots[order], knots[npts]), nbasis);
+    Point result;
+    for (int j = n; j <= order; ++j)
+    {
+        result.x += d[j].x * nbasis[j - n];
+        result.y += d[j].y * nbasis[j - n];
+    }
+    return result;
+}
+
+void BSpline::rbspline(const int order, const size_t npts, const std::vector<double> &knots, const std::vector<Point> &b,
+                       const std::vector<double> &values, std::vector<Point> &p)
+{
+    p.resize(values.size());
+    if (const size_t count = values.size(); count <= 3000)
+    {
+        rbspline_subfunc(order, npts, 0, count, &knots, &b, &values, &p);
+    }
     else
     {
         std::vector<std::future<void>> futures;
         for (size_t i = 0; i < count; i += 3000)
         {
-            futures.emplace_back(std::async(std::launch::async, &BSpline::rbspline_subfunc, order, npts, step, i, std::min(i + 3000, count),
-                                            &knots, &b, &p));
+            futures.emplace_back(std::async(std::launch::async, &BSpline::rbspline_subfunc, order, npts, i, std::min(i + 3000, count),
+                                            &knots, &b, &values, &p));
         }
         for (std::future<void> &f : futures)
         {
@@ -3368,35 +3974,159 @@ void BSpline::rbspline(const int order, const size_t npts, const size_t p1, cons
     }
 }
 
-void BSpline::rbspline_subfunc(const int order, const size_t npts, const double step, const size_t start, const size_t end,
-                               const std::vector<double> *knots, const std::vector<Point> *b, std::vector<Point> *p)
+void BSpline::rbspline_subfunc(const int order, const size_t npts, const size_t start, const size_t end, const std::vector<double> *knots,
+                               const std::vector<Point> *b, const std::vector<double> *values, std::vector<Point> *p)
+{
+    for (size_t i = start; i < end; i += 256)
+    {
+        de_boor(order, npts, *knots, *b, values->data() + i, std::min<size_t>(256, end - i), p->data() + i);
+    }
+}
+
+size_t BSpline::span_points_count(const int order, const size_t span, const double step) const
+{
+    const size_t npts = control_points.size();
+    if (_knots[span + 1] <= _knots[span])
+    {
+        return 0;
+    }
+    // 与整条曲线的分辨率保持一致,按节点区间长度分配采样点
+    const double points_count = std::max(npts * 8.0, (npts - order) / step);
+    const double ratio = (_knots[span + 1] - _knots[span]) / (_knots[npts] - _knots[order]);
+    return std::max<size_t>(2, std::ceil(points_count * ratio));
+}
+
+void BSpline::span_values(const int order, const size_t first, const size_t last, const double step, std::vector<double> &values,
+                          std::vector<size_t> &counts) const
+{
+    for (size_t span = first; span <= last; ++span)
+    {
+        const size_t count = span_points_count(order, span, step);
+        const double t0 = _knots[span], dt = (_knots[span + 1] - t0) / count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            values.push_back(t0 + dt * i);
+        }
+        counts.push_back(count);
+    }
+}
+
+void BSpline::update_spans(const int order, const double step, const double down_sampling_value)
 {
-    const size_t nplusc = npts + order + 1;
-    double t = knots->front() + step * start;
-    for (size_t i = start; i < end; ++i)
+    _step = step;
+    _down_sampling_value = down_sampling_value;
+    const size_t npts = control_points.size();
+    _shape.clear();
+    _shape_spans.clear();
+    _arc_lengths.clear();
+    if (npts <= static_cast<size_t>(order))
     {
-        Geo::Point &vp = p->at(i);
-        if (knots->at(nplusc - 1) - t < 5e-6)
+        _shape.append(control_points.front());
+        _shape.append(control_points.back());
+        return;
+    }
+
+    std::vector<double> values;
+    std::vector<size_t> counts;
+    span_values(order, order, npts - 1, step, values, counts);
+    values.push_back(_knots[npts]);
+    std::vector<Point> points;
+    rbspline(order, npts, _knots, control_points, values, points);
+    // 控制点模式下path_points由曲线求得,尚未更新
+    points.front() = controls_model || path_points.empty() ? control_points.front() : path_points.front();
+    points.back() = controls_model || path_points.empty() ? control_points.back() : path_points.back();
+
+    // 逐区间抽稀,区间端点保留在_shape中,拖动控制点时只需替换受影响的区间
+    Polyline span_shape;
+    for (size_t i = 0, index = 0, count = counts.size(); i < count; index += counts[i++])
+    {
+        _shape_spans.push_back(_shape.size());
+        if (counts[i] == 0)
+        {
+            continue;
+        }
+        span_shape.clear();
+        span_shape.append(points.begin() + index, points.begin() + index + counts[i] + 1);
+        Geo::down_sampling(span_shape, down_sampling_value);
+        _shape.append(span_shape.begin(), span_shape.end() - 1);
+    }
+    _shape_spans.push_back(_shape.size());
+    _shape.append(points.back());
+
+    if (controls_model)
+    {
+        path_points.clear();
+        for (const double t : _path_values)
         {
-            t = knots->at(nplusc - 1);
+            path_points.emplace_back(at(t));
         }
-        // generate the basis function for this value of t
-        std::vector<double> nbasis;
-        rbasis(order, t, npts, *knots, nbasis);
-        // generate a point on the curve
-        for (size_t j = 0, count = nbasis.size(); j < count; ++j)
+    }
+}
+
+bool BSpline::update_spans(const int order, const size_t index, const double step)
+{
+    const size_t npts = control_points.size();
+    if (index >= npts || npts <= static_cast<size_t>(order) || _shape_spans.size() != npts - order + 1)
+    {
+        return false;
+    }
+    _arc_lengths.clear();
+
+    // 控制点index只影响节点区间[index, index + order]
+    const size_t first = std::max<size_t>(index, order), last = std::min(index + order, npts - 1);
+    std::vector<double> values;
+    std::vector<size_t> counts;
+    span_values(order, first, last, step, values, counts);
+    std::vector<Point> points;
+    rbspline(order, npts, _knots, control_points, values, points);
+    if (first == static_cast<size_t>(order))
+    {
+        points.front() = control_points.front();
+    }
+
+    const size_t begin = _shape_spans[first - order], end = _shape_spans[last - order + 1];
+    const size_t overlap = std::min(end - begin, points.size());
+    std::copy(points.begin(), points.begin() + overlap, _shape.begin() + begin);
+    if (end - begin > points.size())
+    {
+        _shape.remove(begin + overlap, end - begin - overlap);
+    }
+    else if (end - begin < points.size())
+    {
+        _shape.insert(begin + overlap, points.cbegin() + overlap, points.cend());
+    }
+    if (last == npts - 1)
+    {
+        _shape.back() = control_points.back();
+    }
+
+    for (size_t i = first, offset = begin; i <= last; ++i)
+    {
+        _shape_spans[i - order] = offset;
+        offset += counts[i - first];
+    }
+    for (size_t i = last - order + 1, count = _shape_spans.size(); i < count; ++i)
+    {
+        _shape_spans[i] = _shape_spans[i] + points.size() - (end - begin);
+    }
+
+    if (controls_model && path_points.size() == _path_values.size())
+    {
+        const double t0 = _knots[first], t1 = _knots[last + 1];
+        for (size_t i = 0, count = _path_values.size(); i < count; ++i)
         {
-            if (nbasis[j] > 0)
+            if (t0 <= _path_values[i] && _path_values[i] <= t1)
             {
-                for (int i = 0; i <= order && j < count; ++i, ++j)
-                {
-                    vp += b->at(j) * nbasis[j];
-                }
-                break;
+                path_points[i] = at(_path_values[i]);
             }
         }
-        t += step;
     }
+    return true;
+}
+
+const std::vector<size_t> &BSpline::shape_spans() const
+{
+    return _shape_spans;
 }
 
 
@@ -3579,10 +4309,7 @@ void QuadBSpline::update_control_points() // 从LibreCAD抄的
         return;
     }
 
-    double *dx = new double[dim];
-    double *dy = new double[dim];
-    double *dx2 = new double[dim];
-    double *dy2 = new double[dim];
+    std::vector<double> dx(dim), dy(dim), dx2(dim), dy2(dim);
     {
         double *pdDiag = matrix.data();
         double *pdDiag1 = &matrix[n - 2];
@@ -3617,10 +4344,6 @@ void QuadBSpline::update_control_points() // 从LibreCAD抄的
         }
         control_points.emplace_back(path_points[n - 1]);
     }
-    delete[] dx;
-    delete[] dy;
-    delete[] dx2;
-    delete[] dy2;
 }
 
 bool QuadBSpline::get_three_points_control(const Point &point0, const Point &point1, const Point &point2, Point &output) // 从LibreCAD抄的
@@ -3647,9 +4370,10 @@ void QuadBSpline::get_matrix(const size_t count, const std::vector<double> &dt,
         return;
     }
 
-    size_t dim = 3 * count - 8;    // 主对角线元素(n-2) + 上对角线元素(n-3) + 下对角线元素(n-3)
-    double *res = new double[dim]; // 三对角矩阵
+    const size_t dim = 3 * count - 8; // 主对角线元素(n-2) + 上对角线元素(n-3) + 下对角线元素(n-3)
+    output.assign(dim, 0);            // 三对角矩阵
     {
+        double *res = output.data();
         double *pdDiag = res;                  // 主对角线元素
         double *pdDiag1 = &res[count - 2];     // 上对角线元素
         double *pdDiag2 = &res[2 * count - 5]; // 下对角线元素
@@ -3675,8 +4399,6 @@ void QuadBSpline::get_matrix(const size_t count, const std::vector<double> &dt,
         pdDiag2[count - 4] = x1 / pdDiag[count - 4];                                 // U矩阵下对角线最后一个元素
         pdDiag[count - 3] = std::sqrt(x2 - pdDiag1[count - 4] * pdDiag2[count - 4]); // L矩阵主对角线最后一个元素,使用平方根分解而非追赶分解
     }
-    output.assign(res, res + dim);
-    delete[] res;
 }
 
 void QuadBSpline::knot(const size_t num, std::vector<double> &output) // 从LibreCAD抄的
@@ -3689,27 +4411,14 @@ void QuadBSpline::knot(const size_t num, std::vector<double> &output) // 从Libr
 
 void QuadBSpline::update_shape(const double step, const double down_sampling_value)
 {
-    const size_t npts = control_points.size();
-
-    // resolution:
-    const size_t points_count = std::max(npts * 8.0, (npts - 2) / step);
-
-    std::vector<Point> points(points_count, Point(0, 0));
-    rbspline(2, npts, points_count, _knots, control_points, points);
-
-    _shape.clear();
-    _shape.append(path_points.empty() ? control_points.front() : path_points.front());
-    _shape.append(points.begin(), points.end());
-    _shape.append(path_points.empty() ? control_points.back() : path_points.back());
-    Geo::down_sampling(_shape, down_sampling_value);
+    update_spans(2, step, down_sampling_value);
+}
 
-    if (controls_model)
+void QuadBSpline::update_shape(const size_t index, const double step)
+{
+    if (!update_spans(2, index, step))
     {
-        path_points.clear();
-        for (const double t : _path_values)
-        {
-            path_points.emplace_back(QuadBSpline::at(t));
-        }
+        QuadBSpline::update_shape(step, BSpline::default_down_sampling_value);
     }
 }
 
@@ -3734,14 +4443,7 @@ void QuadBSpline::insert(const double t)
         }
     }
 
-    const size_t npts = control_points.size();
-    std::vector<double> nbasis;
-    rbasis(2, t, npts, _knots, nbasis);
-    Geo::Point anchor;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        anchor += control_points[i] * nbasis[i];
-    }
+    const Geo::Point anchor = de_boor(2, t, control_points.size(), _knots, control_points);
 
     Geo::Point array[2];
     for (size_t i = k, j = 1; i > k - 2; --i, --j)
@@ -3815,15 +4517,7 @@ Geo::Point QuadBSpline::at(const double t) const
     {
         return control_points.back();
     }
-    const size_t npts = control_points.size();
-    std::vector<double> nbasis;
-    rbasis(2, t, npts, _knots, nbasis);
-    Geo::Point point;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        point += control_points[i] * nbasis[i];
-    }
-    return point;
+    return de_boor(2, t, control_points.size(), _knots, control_points);
 }
 
 Geo::Point QuadBSpline::tangent(const double t) const
@@ -3836,22 +4530,7 @@ Geo::Point QuadBSpline::tangent(const double t) const
     {
         return control_points.back() - control_points[control_points.size() - 2];
     }
-    const size_t npts = control_points.size() - 1;
-    std::vector<double> nbasis;
-    const std::vector<double> knots(_knots.begin() + 1, _knots.end() - 1); // 一阶导数的节点矢量
-    rbasis(1, t, npts, knots, nbasis);
-    std::vector<Geo::Point> points;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        const double denom = _knots[i + 3] - _knots[i + 1];
-        points.emplace_back((control_points[i + 1] - control_points[i]) * 2 / denom);
-    }
-    Geo::Point tang;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        tang += points[i] * nbasis[i];
-    }
-    return tang;
+    return de_boor_derivative(2, t, 1, control_points.size(), _knots, control_points);
 }
 
 Geo::Point QuadBSpline::vertical(const double t) const
@@ -3927,26 +4606,7 @@ QuadBSpline *QuadBSpline::range(const double t0, const double t1) const
 
 Geo::Point QuadBSpline::derivative(const double t, const int n) const
 {
-    Geo::Point result;
-    if (n > 2)
-    {
-        return result;
-    }
-    const size_t npts = control_points.size() - n;
-    std::vector<double> nbasis;
-    const std::vector<double> knots(_knots.begin() + n, _knots.end() - n); // 二阶导数的节点矢量
-    rbasis(2 - n, t, npts, knots, nbasis);
-    std::vector<Geo::Point> points;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        const double denom = knots[i + 3 - n] - knots[i];
-        points.emplace_back((control_points[i + 1] - control_points[i]) * (3 - n) / denom);
-    }
-    for (size_t i = 0; i < npts; ++i)
-    {
-        result += points[i] * nbasis[i];
-    }
-    return result;
+    return de_boor_derivative(2, t, n, control_points.size(), _knots, control_points);
 }
 
 
@@ -4081,10 +4741,10 @@ void CubicBSpline::update_control_points()
         return;
     }
 
-    double *delta = new double[n + 5];
+    std::vector<double> delta(n + 5);
     {
         _knots.assign(n + 6, 0);
-        double *l = new double[n - 1];
+        std::vector<double> l(n - 1);
         double l1 = 0;
         for (size_t i = 0; i < n - 1; ++i)
         {
@@ -4098,18 +4758,14 @@ void CubicBSpline::update_control_points()
         }
         _path_values.clear();
         _path_values.push_back(0);
+        double l2 = 0;
         for (size_t i = 4; i < n + 2; ++i)
         {
-            double l2 = 0;
-            for (size_t j = 0; j < i - 3; ++j)
-            {
-                l2 += l[j];
-            }
+            l2 += l[i - 4];
             _knots[i] = l2 / l1;
             _path_values.push_back(_knots[i]);
         }
         _path_values.push_back(1);
-        delete[] l;
 
         for (size_t i = 0; i < n + 5; ++i)
         {
@@ -4117,11 +4773,8 @@ void CubicBSpline::update_control_points()
         }
     }
 
-    double *a = new double[n];
-    double *b = new double[n];
-    double *c = new double[n];
-    double *e = new double[n];
-    double *f = new double[n];
+    // 第i行的非零元素为a[i], b[i], c[i],首行位于第0-2列,末行位于第n-3至n-1列,其余行位于第i-1至i+1列
+    std::vector<double> a(n), b(n), c(n), e(n), f(n);
     // 抛物线条件
     a[0] = 1 - delta[3] * delta[4] / std::pow(delta[3] + delta[4], 2);
     b[0] = delta[3] / (delta[3] + delta[4]) * (delta[4] / (delta[3] + delta[4]) - delta[3] / (delta[3] + delta[4] + delta[5]));
@@ -4143,47 +4796,83 @@ void CubicBSpline::update_control_points()
         e[i] = (delta[i + 2] + delta[i + 3]) * path_points[i].x;
         f[i] = (delta[i + 2] + delta[i + 3]) * path_points[i].y;
     }
-    delete[] delta;
-    double *matrix = new double[n * n];
-    std::fill_n(matrix, n * n, 0);
-    matrix[0] = a[0];
-    matrix[1] = b[0];
-    matrix[2] = c[0];
-    matrix[n * n - 3] = a[n - 1];
-    matrix[n * n - 2] = b[n - 1];
-    matrix[n * n - 1] = c[n - 1];
-    for (size_t i = 1; i < n - 1; ++i)
+
+    std::vector<double> x(n), y(n);
+    bool solved = true;
+    {
+        // 用第1行消去首行第2列的元素,用第n-2行消去末行第n-3列的元素,化为三对角矩阵后使用追赶法求解
+        std::vector<double> lower(n), diag(n), upper(n), ex(e), fy(f);
+        for (size_t i = 1; i < n - 1; ++i)
+        {
+            lower[i] = a[i];
+            diag[i] = b[i];
+            upper[i] = c[i];
+        }
+        lower[0] = 0, diag[0] = a[0], upper[0] = b[0];
+        lower[n - 1] = b[n - 1], diag[n - 1] = c[n - 1], upper[n - 1] = 0;
+        if (c[0] != 0 && c[1] != 0)
+        {
+            const double k = c[0] / c[1];
+            diag[0] -= k * a[1];
+            upper[0] -= k * b[1];
+            ex[0] -= k * e[1];
+            fy[0] -= k * f[1];
+        }
+        else if (c[0] != 0)
+        {
+            solved = false;
+        }
+        if (a[n - 1] != 0 && a[n - 2] != 0)
+        {
+            const double k = a[n - 1] / a[n - 2];
+            lower[n - 1] -= k * b[n - 2];
+            diag[n - 1] -= k * c[n - 2];
+            ex[n - 1] -= k * e[n - 2];
+            fy[n - 1] -= k * f[n - 2];
+        }
+        else if (a[n - 1] != 0)
+        {
+            solved = false;
+        }
+        solved = solved && Math::solve_tridiagonal(lower.data(), diag.data(), upper.data(), ex.data(), n, x.data()) &&
+                 Math::solve_tridiagonal(lower.data(), diag.data(), upper.data(), fy.data(), n, y.data());
+    }
+    if (!solved) // 主元为0时退回到稠密矩阵求解
     {
-        matrix[i * n + i - 1] = a[i];
-        matrix[i * n + i] = b[i];
-        matrix[i * n + i + 1] = c[i];
-    }
-    delete[] a;
-    delete[] b;
-    delete[] c;
-
-    double *x = new double[n];
-    double *y = new double[n];
-    Math::solve(matrix, n, e, x);
-    Math::solve(matrix, n, f, y);
-    delete[] matrix;
-    delete[] e;
-    delete[] f;
+        std::vector<double> matrix(n * n, 0);
+        matrix[0] = a[0];
+        matrix[1] = b[0];
+        matrix[2] = c[0];
+        matrix[n * n - 3] = a[n - 1];
+        matrix[n * n - 2] = b[n - 1];
+        matrix[n * n - 1] = c[n - 1];
+        for (size_t i = 1; i < n - 1; ++i)
+        {
+            matrix[i * n + i - 1] = a[i];
+            matrix[i * n + i] = b[i];
+            matrix[i * n + i + 1] = c[i];
+        }
+        Math::solve(matrix.data(), n, e.data(), x.data());
+        Math::solve(matrix.data(), n, f.data(), y.data());
+    }
+
     control_points.emplace_back(path_points.front());
     for (size_t i = 0; i < n; ++i)
     {
         control_points.emplace_back(x[i], y[i]);
     }
     control_points.emplace_back(path_points.back());
-    delete[] x;
-    delete[] y;
 }
 
 void CubicBSpline::update_shape(const double step, const double down_sampling_value)
 {
-    _shape.clear();
     if (control_points.size() == 2)
     {
+        _step = step;
+        _down_sampling_value = down_sampling_value;
+        _shape.clear();
+        _shape_spans.clear();
+        _arc_lengths.clear();
         _shape.append(control_points.front());
         _shape.append(control_points.back());
         if (controls_model)
@@ -4192,27 +4881,14 @@ void CubicBSpline::update_shape(const double step, const double down_sampling_va
         }
         return;
     }
+    update_spans(3, step, down_sampling_value);
+}
 
-    const size_t npts = control_points.size();
-
-    // resolution:
-    const size_t points_count = std::max(npts * 8.0, (npts - 3) / step);
-
-    std::vector<Point> points(points_count, Point(0, 0));
-    rbspline(3, npts, points_count, _knots, control_points, points);
-
-    _shape.append(path_points.empty() ? control_points.front() : path_points.front());
-    _shape.append(points.begin(), points.end());
-    _shape.append(path_points.empty() ? control_points.back() : path_points.back());
-    Geo::down_sampling(_shape, down_sampling_value);
-
-    if (controls_model)
+void CubicBSpline::update_shape(const size_t index, const double step)
+{
+    if (!update_spans(3, index, step))
     {
-        path_points.clear();
-        for (const double t : _path_values)
-        {
-            path_points.emplace_back(CubicBSpline::at(t));
-        }
+        CubicBSpline::update_shape(step, BSpline::default_down_sampling_value);
     }
 }
 
@@ -4237,14 +4913,7 @@ void CubicBSpline::insert(const double t)
         }
     }
 
-    const size_t npts = control_points.size();
-    std::vector<double> nbasis;
-    rbasis(3, t, npts, _knots, nbasis);
-    Geo::Point anchor;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        anchor += control_points[i] * nbasis[i];
-    }
+    const Geo::Point anchor = de_boor(3, t, control_points.size(), _knots, control_points);
 
     Geo::Point array[3];
     for (size_t i = k, j = 2; i > k - 3; --i, --j)
@@ -4318,15 +4987,7 @@ Geo::Point CubicBSpline::at(const double t) const
     {
         return control_points.back();
     }
-    const size_t npts = control_points.size();
-    std::vector<double> nbasis;
-    rbasis(3, t, npts, _knots, nbasis);
-    Geo::Point point;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        point += control_points[i] * nbasis[i];
-    }
-    return point;
+    return de_boor(3, t, control_points.size(), _knots, control_points);
 }
 
 Geo::Point CubicBSpline::tangent(const double t) const
@@ -4339,22 +5000,7 @@ Geo::Point CubicBSpline::tangent(const double t) const
     {
         return control_points.back() - control_points[control_points.size() - 2];
     }
-    const size_t npts = control_points.size() - 1;
-    std::vector<double> nbasis;
-    const std::vector<double> knots(_knots.begin() + 1, _knots.end() - 1); // 二阶导数的节点矢量
-    rbasis(2, t, npts, knots, nbasis);
-    std::vector<Geo::Point> points;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        const double denom = _knots[i + 4] - _knots[i + 1];
-        points.emplace_back((control_points[i + 1] - control_points[i]) * 3 / denom);
-    }
-    Geo::Point tang;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        tang += points[i] * nbasis[i];
-    }
-    return tang;
+    return de_boor_derivative(3, t, 1, control_points.size(), _knots, control_points);
 }
 
 Geo::Point CubicBSpline::vertical(const double t) const
@@ -4436,26 +5082,7 @@ CubicBSpline *CubicBSpline::range(const double t0, const double t1) const
 
 Geo::Point CubicBSpline::derivative(const double t, const int n) const
 {
-    Geo::Point result;
-    if (n > 3)
-    {
-        return result;
-    }
-    const size_t npts = control_points.size() - n;
-    std::vector<double> nbasis;
-    const std::vector<double> knots(_knots.begin() + n, _knots.end() - n); // 二阶导数的节点矢量
-    rbasis(3 - n, t, npts, knots, nbasis);
-    std::vector<Geo::Point> points;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        const double denom = knots[i + 4 - n] - knots[i];
-        points.emplace_back((control_points[i + 1] - control_points[i]) * (4 - n) / denom);
-    }
-    for (size_t i = 0; i < npts; ++i)
-    {
-        result += points[i] * nbasis[i];
-    }
-    return result;
+    return de_boor_derivative(3, t, n, control_points.size(), _knots, control_points);
 }
 
 
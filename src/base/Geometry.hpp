@@ -1,7 +1,11 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
 #include <cfloat>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <QString>
 
 
@@ -26,6 +30,7 @@ enum class Type
     TEXT,
     CONTAINERGROUP,
     COMBINATION,
+    ARRAY,
     GRAPH,
 
     DIMENSION
@@ -43,6 +48,39 @@ struct AABBRectParams
     double bottom = 0;
 };
 
+// 累计弧长表,记录分段端点参数及其累计弧长,二分查找所在分段后在分段内求解弧长与参数的对应关系
+// 可在多个线程中同时建表和查询,修改曲线并清空表时不能与查询并发
+class ArcLengthTable
+{
+private:
+    std::vector<double> _params;
+    std::vector<double> _lengths;
+    std::atomic<size_t> _key{0}; // 建表时曲线的版本,0表示未建表
+    mutable std::mutex _mutex;
+
+public:
+    ArcLengthTable() = default;
+
+    ArcLengthTable(const ArcLengthTable &table);
+
+    ArcLengthTable &operator=(const ArcLengthTable &table);
+
+    // 表不是按版本key建立时在锁内建表,多个线程同时调用只建一次;params返回升序的分段端点参数,norm为切向量长度,key不为0
+    void build(const size_t key, const std::function<double(const double)> &norm, const std::function<std::vector<double>()> &params);
+
+    void clear();
+
+    bool empty() const;
+
+    double length() const;
+
+    // 从起点到参数t的弧长
+    double length(const std::function<double(const double)> &norm, const double t) const;
+
+    // 弧长length对应的参数
+    double param(const std::function<double(const double)> &norm, const double length) const;
+};
+
 class Geometry
 {
 public:
@@ -198,10 +236,141 @@ public:
 
 using Vector = Point;
 
+// 写时复制的点数组,复制时共享数据,非const访问前若数据被共享则先复制一份,只读时应通过const引用访问
+// 别名规则:可写的引用或迭代器指向取得时的数组,之后复制出的对象若仍共享该数组,经引用写入会同时修改副本,
+// 因此向外交出可写引用或迭代器前须调用lend,此后复制时总是复制数据;内部写入不交出引用时直接使用非const接口即可
+class SharedPoints
+{
+private:
+    std::shared_ptr<std::vector<Point>> _data;
+    size_t _revision = 1; // 修改序号,复制构造时保留,赋值和每次可写访问时递增
+    bool _lent = false;   // 已向外交出可写引用或迭代器,复制时不再共享数据
+
+private:
+    std::vector<Point> &data();
+
+    const std::vector<Point> &const_data() const;
+
+public:
+    SharedPoints() = default;
+
+    SharedPoints(const std::vector<Point>::const_iterator &begin, const std::vector<Point>::const_iterator &end);
+
+    SharedPoints(const std::initializer_list<Point> &points);
+
+    SharedPoints(const SharedPoints &points);
+
+    SharedPoints &operator=(const SharedPoints &points);
+
+    // 数据被共享时复制一份,此后写入不影响其他对象
+    void detach();
+
+    // 向外交出可写引用或迭代器前调用,复制共享的数据并标记此后复制时不再共享
+    SharedPoints &lend();
+
+    operator const std::vector<Point> &() const;
+
+    // 修改序号相同时点数据未变,可用于判断依赖点数据的缓存是否过期
+    size_t revision() const;
+
+    // 是否与其他图形共享数据
+    bool shared() const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    void clear();
+
+    void reserve(const size_t count);
+
+    // 数据未被共享时释放多余容量
+    void shrink_to_fit();
+
+    Point &operator[](const size_t index);
+
+    const Point &operator[](const size_t index) const;
+
+    Point &at(const size_t index);
+
+    const Point &at(const size_t index) const;
+
+    Point &front();
+
+    const Point &front() const;
+
+    Point &back();
+
+    const Point &back() const;
+
+    std::vector<Point>::iterator begin();
+
+    std::vector<Point>::const_iterator begin() const;
+
+    std::vector<Point>::const_iterator cbegin() const;
+
+    std::vector<Point>::iterator end();
+
+    std::vector<Point>::const_iterator end() const;
+
+    std::vector<Point>::const_iterator cend() const;
+
+    std::vector<Point>::reverse_iterator rbegin();
+
+    std::vector<Point>::const_reverse_iterator rbegin() const;
+
+    std::vector<Point>::const_reverse_iterator crbegin() const;
+
+    std::vector<Point>::reverse_iterator rend();
+
+    std::vector<Point>::const_reverse_iterator rend() const;
+
+    std::vector<Point>::const_reverse_iterator crend() const;
+
+    template <typename... Args> Point &emplace_back(Args &&...args)
+    {
+        return data().emplace_back(std::forward<Args>(args)...);
+    }
+
+    void push_back(const Point &point);
+
+    void pop_back();
+
+    // 数据被共享时直接分配新的数组,不复制原数据
+    template <typename Iter> void assign(Iter begin, Iter end)
+    {
+        ++_revision;
+        if (_data != nullptr && _data.use_count() == 1)
+        {
+            _data->assign(begin, end);
+        }
+        else
+        {
+            _data = std::make_shared<std::vector<Point>>(begin, end);
+        }
+    }
+
+    // pos可以是复制前取得的迭代器
+    std::vector<Point>::iterator insert(const std::vector<Point>::const_iterator &pos, const Point &point);
+
+    std::vector<Point>::iterator insert(const std::vector<Point>::const_iterator &pos, const size_t count, const Point &point);
+
+    template <typename Iter> std::vector<Point>::iterator insert(const std::vector<Point>::const_iterator &pos, Iter begin, Iter end)
+    {
+        const std::ptrdiff_t index = pos - const_data().cbegin();
+        std::vector<Point> &points = data();
+        return points.insert(points.cbegin() + index, begin, end);
+    }
+
+    std::vector<Point>::iterator erase(const std::vector<Point>::const_iterator &pos);
+
+    std::vector<Point>::iterator erase(const std::vector<Point>::const_iterator &begin, const std::vector<Point>::const_iterator &end);
+};
+
 class Polyline : public Geometry
 {
 protected:
-    std::vector<Point> _points;
+    SharedPoints _points;
 
 public:
     Polyline() = default;
@@ -224,6 +393,8 @@ public:
 
     void clear() override;
 
+    void shrink_to_fit();
+
     Polyline *clone() const override;
 
     bool is_self_intersected() const;
@@ -664,6 +835,8 @@ class CubicBezier : public Polyline
 {
 private:
     Polyline _shape;
+    mutable ArcLengthTable _arc_lengths; // 首次查询长度时建立,修改曲线后清空,经Polyline接口修改控制点后按修改序号重建
+    double _step = default_step, _down_sampling_value = default_down_sampling_value; // 最近一次更新_shape的采样参数
 
 public:
     static double default_step;
@@ -686,10 +859,21 @@ public:
 
     void update_shape(const double step = 0.01, const double down_sampling_value = 0.02);
 
+    double step() const;
+
+    double down_sampling_value() const;
+
     double length() const override;
 
+    // 弧长参数化,参数的整数部分为曲线段下标,小数部分为段内参数
+    double param_to_length(const double t) const;
+
+    double length_to_param(const double length) const;
+
     void clear() override;
 
+    void shrink_to_fit();
+
     CubicBezier *clone() const override;
 
     CubicBezier &operator=(const CubicBezier &bezier);
@@ -721,6 +905,11 @@ public:
     CubicBezier *range(const size_t index0, const double t0, const size_t index1, const double t1) const;
 
     Point derivative(const size_t index, const double t, const int n) const;
+
+private:
+    const ArcLengthTable &arc_lengths() const;
+
+    double arc_norm(const double t) const;
 };
 
 class Ellipse : public Geometry
@@ -735,6 +924,7 @@ private:
     double _arc_param[2] = {0, 0};
     Point _a[2], _b[2], _point[2];
     Polyline _shape;
+    mutable ArcLengthTable _arc_lengths; // 首次查询时建立,修改椭圆后清空
 
 public:
     Ellipse() = default;
@@ -769,6 +959,11 @@ public:
 
     double length() const override;
 
+    // 弧长参数化,参数角从arc_param0()开始计算弧长,整椭圆从0开始
+    double param_to_length(const double t) const;
+
+    double length_to_param(const double length) const;
+
     bool empty() const override;
 
     void clear() override;
@@ -865,14 +1060,22 @@ public:
 
     // 参数角截取椭圆弧
     Ellipse *range(const double t0, const double t1) const;
+
+private:
+    const ArcLengthTable &arc_lengths() const;
+
+    double arc_norm(const double t) const;
 };
 
 class BSpline : public Geometry
 {
 protected:
     Polyline _shape;
+    std::vector<size_t> _shape_spans; // 每个节点区间的首个采样点在_shape中的下标,最后一个元素为_shape终点的下标
+    mutable ArcLengthTable _arc_lengths; // 首次查询长度时建立,修改曲线后清空
     std::vector<double> _knots;
     std::vector<double> _path_values;
+    double _step = default_step, _down_sampling_value = default_down_sampling_value; // 最近一次整体更新_shape的采样参数
 
 public:
     bool controls_model = false;
@@ -893,16 +1096,33 @@ public:
 
     virtual void update_shape(const double step, const double down_sampling_value) = 0;
 
+    // 只移动了第index个控制点时,仅重新计算受影响的order + 1个节点区间
+    virtual void update_shape(const size_t index, const double step) = 0;
+
     virtual void insert(const double t) = 0;
 
     const Polyline &shape() const;
 
+    const std::vector<size_t> &shape_spans() const;
+
+    double step() const;
+
+    double down_sampling_value() const;
+
     double length() const override;
 
+    // 弧长参数化,参数t处的弧长
+    double param_to_length(const double t) const;
+
+    // 弧长参数化,弧长length处的参数
+    double length_to_param(const double length) const;
+
     bool empty() const override;
 
     void clear() override;
 
+    void shrink_to_fit();
+
     void transform(const double a, const double b, const double c, const double d, const double e, const double f) override;
 
     void transform(const double mat[6]) override;
@@ -943,16 +1163,41 @@ public:
 
     static void rbasis(const int order, const double t, const size_t npts, const std::vector<double> &x, std::vector<double> &output);
 
-    static void rbspline(const int order, const size_t npts, const size_t p1, const std::vector<double> &knots, const std::vector<Point> &b,
-                         std::vector<Point> &p);
+    // de Boor算法求值,只计算t所在节点区间的order + 1个控制点
+    static Point de_boor(const int order, const double t, const size_t npts, const std::vector<double> &knots, const std::vector<Point> &b);
+
+    // 批量求值,支持AVX2时每次计算4个参数
+    static void de_boor(const int order, const size_t npts, const std::vector<double> &knots, const std::vector<Point> &b, const double *t,
+                        const size_t count, Point *output);
+
+    // n阶导数,只计算t所在节点区间的order + 1个控制点
+    static Point de_boor_derivative(const int order, const double t, const int n, const size_t npts, const std::vector<double> &knots,
+                                    const std::vector<Point> &b);
+
+    static void rbspline(const int order, const size_t npts, const std::vector<double> &knots, const std::vector<Point> &b,
+                         const std::vector<double> &values, std::vector<Point> &p);
 
     virtual BSpline *range(const double t0, const double t1) const = 0;
 
     virtual Point derivative(const double t, const int n) const = 0;
 
+protected:
+    // 按节点区间采样并逐区间抽稀
+    void update_spans(const int order, const double step, const double down_sampling_value);
+
+    // 重新采样控制点index影响的节点区间并替换_shape中对应的点,拖动过程中不抽稀以保持点数稳定
+    bool update_spans(const int order, const size_t index, const double step);
+
+    const ArcLengthTable &arc_lengths() const;
+
 private:
-    static void rbspline_subfunc(const int order, const size_t npts, const double step, const size_t start, const size_t end,
-                                 const std::vector<double> *knots, const std::vector<Point> *b, std::vector<Point> *p);
+    size_t span_points_count(const int order, const size_t span, const double step) const;
+
+    void span_values(const int order, const size_t first, const size_t last, const double step, std::vector<double> &values,
+                     std::vector<size_t> &counts) const;
+
+    static void rbspline_subfunc(const int order, const size_t npts, const size_t start, const size_t end, const std::vector<double> *knots,
+                                 const std::vector<Point> *b, const std::vector<double> *values, std::vector<Point> *p);
 };
 
 class QuadBSpline : public BSpline
@@ -979,6 +1224,8 @@ public:
 
     void update_shape(const double step, const double down_sampling_value) override;
 
+    void update_shape(const size_t index, const double step) override;
+
     QuadBSpline *clone() const override;
 
     void insert(const double t) override;
@@ -1016,6 +1263,8 @@ public:
 
     void update_shape(const double step, const double down_sampling_value) override;
 
+    void update_shape(const size_t index, const double step) override;
+
     CubicBSpline *clone() const override;
 
     void insert(const double t) override;
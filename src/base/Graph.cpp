@@ -194,6 +194,27 @@ size_t Graph::count(const Geo::Type type, const bool include_combinated) const
     return num;
 }
 
+void Graph::explode_arrays()
+{
+    for (ContainerGroup &group : _container_groups)
+    {
+        for (size_t i = 0; i < group.size();)
+        {
+            if (group[i]->type() != Geo::Type::ARRAY)
+            {
+                ++i;
+                continue;
+            }
+            Array *array = static_cast<Array *>(group.pop(i));
+            for (Geo::Geometry *object : array->explode())
+            {
+                group.insert(i++, object);
+            }
+            delete array;
+        }
+    }
+}
+
 void Graph::clear()
 {
     _container_groups.clear();
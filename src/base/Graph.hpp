@@ -48,6 +48,9 @@ public:
 
     size_t count(const Geo::Type type, const bool include_combinated) const;
 
+    // 将阵列就地展开为独立图形
+    void explode_arrays();
+
     void clear() override;
 
     void clear(const size_t index);
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cfloat>
 #include "base/Math.hpp"
 #include <gsl/gsl_linalg.h>
 #include <gsl/gsl_cblas.h>
@@ -21,70 +22,224 @@ static const int initer = []
 }();
 
 
-int Math::ellipse_ellipse_f(const gsl_vector *x, void *params, gsl_vector *f)
+namespace
 {
-    EllipseParameter *ellipse = static_cast<EllipseParameter *>(params);
-    const double x0 = gsl_vector_get(x, 0);
-    const double x1 = gsl_vector_get(x, 1);
-
-    gsl_vector_set(f, 0,
-                   ellipse->a[0] * x0 * x0 + ellipse->b[0] * x0 * x1 + ellipse->c[0] * x1 * x1 + ellipse->d[0] * x0 + ellipse->e[0] * x1 +
-                       ellipse->f[0]);
-    gsl_vector_set(f, 1,
-                   ellipse->a[1] * x0 * x0 + ellipse->b[1] * x0 * x1 + ellipse->c[1] * x1 * x1 + ellipse->d[1] * x0 + ellipse->e[1] * x1 +
-                       ellipse->f[1]);
-
-    return GSL_SUCCESS;
+double polynomial_value(const double *coeffs, const int degree, const double x)
+{
+    double value = coeffs[degree];
+    for (int i = degree - 1; i >= 0; --i)
+    {
+        value = value * x + coeffs[i];
+    }
+    return value;
 }
 
-int Math::ellipse_ellipse_df(const gsl_vector *x, void *params, gsl_matrix *j)
+// 多项式在x处计算的舍入误差量级
+double polynomial_tolerance(const double *coeffs, const int degree, const double x)
 {
-    EllipseParameter *ellipse = static_cast<EllipseParameter *>(params);
-    const double x0 = gsl_vector_get(x, 0);
-    const double x1 = gsl_vector_get(x, 1);
-
-    gsl_matrix_set(j, 0, 0, 2 * ellipse->a[0] * x0 + ellipse->b[0] * x1 + ellipse->d[0]);
-    gsl_matrix_set(j, 1, 0, 2 * ellipse->a[1] * x0 + ellipse->b[1] * x1 + ellipse->d[1]);
-    gsl_matrix_set(j, 0, 1, 2 * ellipse->c[0] * x1 + ellipse->b[0] * x0 + ellipse->e[0]);
-    gsl_matrix_set(j, 1, 1, 2 * ellipse->c[1] * x1 + ellipse->b[1] * x0 + ellipse->e[1]);
-
-    return GSL_SUCCESS;
+    double value = std::abs(coeffs[degree]);
+    for (int i = degree - 1; i >= 0; --i)
+    {
+        value = value * std::abs(x) + std::abs(coeffs[i]);
+    }
+    return value * 1e-12;
 }
 
-int Math::ellipse_ellipse_fdf(const gsl_vector *x, void *params, gsl_vector *f, gsl_matrix *j)
+// 在函数值异号的区间[lower, upper]内用牛顿迭代求根,迭代点越出区间时改用二分
+double bracketed_root(const double *coeffs, const int degree, double lower, double upper)
 {
-    Math::ellipse_ellipse_f(x, params, f);
-    Math::ellipse_ellipse_df(x, params, j);
-    return GSL_SUCCESS;
+    double derivative[4];
+    for (int i = 0; i < degree; ++i)
+    {
+        derivative[i] = coeffs[i + 1] * (i + 1);
+    }
+    const bool increasing = polynomial_value(coeffs, degree, lower) < 0;
+    double x = (lower + upper) / 2;
+    for (int i = 0; i < 100; ++i)
+    {
+        const double value = polynomial_value(coeffs, degree, x);
+        if (value == 0)
+        {
+            break;
+        }
+        if ((value < 0) == increasing)
+        {
+            lower = x;
+        }
+        else
+        {
+            upper = x;
+        }
+        const double slope = polynomial_value(derivative, degree - 1, x);
+        double next = slope == 0 ? lower - 1 : x - value / slope;
+        if (next <= lower || next >= upper)
+        {
+            next = (lower + upper) / 2;
+        }
+        if (std::abs(next - x) <= 1e-16 * (1 + std::abs(x)))
+        {
+            return next;
+        }
+        x = next;
+    }
+    return x;
 }
+} // namespace
 
-std::tuple<double, double> Math::solve_ellipse_ellipse_intersection(EllipseParameter &param, const double init_x, const double init_y)
+int Math::solve_polynomial(const double *coeffs, int degree, double *roots)
 {
-    const size_t n = 2; // 方程组未知数的个数
-    gsl_multiroot_function_fdf f = {&Math::ellipse_ellipse_f, &Math::ellipse_ellipse_df, &Math::ellipse_ellipse_fdf, n, &param};
-
-    gsl_vector *x = gsl_vector_alloc(n);
-    gsl_vector_set(x, 0, init_x);
-    gsl_vector_set(x, 1, init_y);
+    double max_coeff = 0;
+    for (int i = 0; i <= degree; ++i)
+    {
+        max_coeff = std::max(max_coeff, std::abs(coeffs[i]));
+    }
+    while (degree > 0 && std::abs(coeffs[degree]) <= max_coeff * 1e-14)
+    {
+        --degree;
+    }
+    if (degree == 0)
+    {
+        return 0;
+    }
+    else if (degree == 1)
+    {
+        roots[0] = -coeffs[0] / coeffs[1];
+        return 1;
+    }
 
-    const gsl_multiroot_fdfsolver_type *t = gsl_multiroot_fdfsolver_gnewton;
-    gsl_multiroot_fdfsolver *s = gsl_multiroot_fdfsolver_alloc(t, n);
-    gsl_multiroot_fdfsolver_set(s, &f, x);
+    // 导函数的根将实轴分为若干单调区间,每个区间至多一个根;导函数的根处函数值近似为0时为重根
+    double derivative[4], extremums[4], bound = 0;
+    for (int i = 0; i < degree; ++i)
+    {
+        derivative[i] = coeffs[i + 1] * (i + 1);
+        bound = std::max(bound, std::abs(coeffs[i] / coeffs[degree]));
+    }
+    const int extremum_count = Math::solve_polynomial(derivative, degree - 1, extremums);
 
-    int status = GSL_CONTINUE;
     int count = 0;
-    while (status == GSL_CONTINUE && count++ < Math::MAX_ITERATION) // 这个循环迭代解方程，最多迭代Math::MAX_ITERATION次
+    double lower = -bound - 1, lower_value = polynomial_value(coeffs, degree, lower);
+    for (int i = 0; i <= extremum_count; ++i)
     {
-        gsl_multiroot_fdfsolver_iterate(s);
-        status = gsl_multiroot_test_residual(s->f, Math::EPSILON); // 判断解是否是真实解
+        const double upper = i < extremum_count ? std::clamp(extremums[i], lower, bound + 1) : bound + 1;
+        const double upper_value = polynomial_value(coeffs, degree, upper);
+        if ((lower_value < 0 && upper_value > 0) || (lower_value > 0 && upper_value < 0))
+        {
+            roots[count++] = bracketed_root(coeffs, degree, lower, upper);
+        }
+        else if (i < extremum_count && std::abs(upper_value) <= polynomial_tolerance(coeffs, degree, upper) &&
+                 (count == 0 || upper - roots[count - 1] > 1e-12 * (1 + std::abs(upper))))
+        {
+            roots[count++] = upper;
+        }
+        lower = upper, lower_value = upper_value;
     }
+    return count;
+}
 
-    std::tuple<double, double> res = std::make_tuple(gsl_vector_get(s->x, 0), gsl_vector_get(s->x, 1));
+int Math::solve_ellipse_ellipse_intersection(const EllipseParameter &param, double *x, double *y)
+{
+    // 按x的二次方程p * x^2 + q(y) * x + r(y) = 0消去x,结式为关于y的四次多项式
+    const double p[2] = {param.a[0], param.a[1]};
+    const double q[2][2] = {{param.d[0], param.b[0]}, {param.d[1], param.b[1]}};
+    const double r[2][3] = {{param.f[0], param.e[0], param.c[0]}, {param.f[1], param.e[1], param.c[1]}};
+    double u[3], v[2], w[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 3; ++i)
+    {
+        u[i] = p[0] * r[1][i] - p[1] * r[0][i];
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        v[i] = p[0] * q[1][i] - p[1] * q[0][i];
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            w[i + j] += q[0][i] * r[1][j] - q[1][i] * r[0][j];
+        }
+    }
+    double resultant[5] = {0, 0, 0, 0, 0};
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            resultant[i + j] += u[i] * u[j];
+        }
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            resultant[i + j] -= v[i] * w[j];
+        }
+    }
 
-    gsl_multiroot_fdfsolver_free(s);
-    gsl_vector_free(x);
+    double values[4];
+    const int value_count = Math::solve_polynomial(resultant, 4, values);
+    const double scale = std::max({std::abs(p[0]), std::abs(p[1]), std::abs(v[0]), std::abs(v[1])});
+    const double norm0 = std::max({std::abs(param.a[0]), std::abs(param.b[0]), std::abs(param.c[0]), std::abs(param.d[0]),
+                                   std::abs(param.e[0]), std::abs(param.f[0])});
+    const double norm1 = std::max({std::abs(param.a[1]), std::abs(param.b[1]), std::abs(param.c[1]), std::abs(param.d[1]),
+                                   std::abs(param.e[1]), std::abs(param.f[1])});
+    int count = 0;
+    for (int i = 0; i < value_count; ++i)
+    {
+        // 由两方程消去x^2项得到x,该项系数为0时x取第一条曲线上的两个解
+        double candidates[2];
+        int candidate_count = 0;
+        if (const double t = v[0] + v[1] * values[i]; std::abs(t) > scale * 1e-9)
+        {
+            candidates[candidate_count++] = -(u[0] + (u[1] + u[2] * values[i]) * values[i]) / t;
+        }
+        else
+        {
+            const double coeffs[3] = {r[0][0] + (r[0][1] + r[0][2] * values[i]) * values[i], q[0][0] + q[0][1] * values[i], p[0]};
+            candidate_count = Math::solve_polynomial(coeffs, 2, candidates);
+        }
 
-    return res;
+        for (int j = 0; j < candidate_count; ++j)
+        {
+            // 牛顿迭代修正舍入误差
+            double x0 = candidates[j], y0 = values[i], residual = DBL_MAX;
+            for (int k = 0; k < 8; ++k)
+            {
+                const double f0 = param.a[0] * x0 * x0 + param.b[0] * x0 * y0 + param.c[0] * y0 * y0 + param.d[0] * x0 + param.e[0] * y0 +
+                                  param.f[0];
+                const double f1 = param.a[1] * x0 * x0 + param.b[1] * x0 * y0 + param.c[1] * y0 * y0 + param.d[1] * x0 + param.e[1] * y0 +
+                                  param.f[1];
+                residual = std::max(std::abs(f0) / norm0, std::abs(f1) / norm1);
+                const double j00 = 2 * param.a[0] * x0 + param.b[0] * y0 + param.d[0];
+                const double j01 = param.b[0] * x0 + 2 * param.c[0] * y0 + param.e[0];
+                const double j10 = 2 * param.a[1] * x0 + param.b[1] * y0 + param.d[1];
+                const double j11 = param.b[1] * x0 + 2 * param.c[1] * y0 + param.e[1];
+                const double det = j00 * j11 - j01 * j10;
+                if (residual == 0 || std::abs(det) < 1e-12)
+                {
+                    break;
+                }
+                const double dx = (f0 * j11 - f1 * j01) / det, dy = (f1 * j00 - f0 * j10) / det;
+                x0 -= dx, y0 -= dy;
+                if (std::abs(dx) + std::abs(dy) < 1e-15)
+                {
+                    break;
+                }
+            }
+            if (residual > 1e-8)
+            {
+                continue;
+            }
+            bool repeated = false;
+            for (int k = 0; k < count && !repeated; ++k)
+            {
+                repeated = std::abs(x[k] - x0) + std::abs(y[k] - y0) < 1e-9;
+            }
+            if (!repeated && count < 4)
+            {
+                x[count] = x0, y[count++] = y0;
+            }
+        }
+    }
+    return count;
 }
 
 void Math::inverse(const double *input, const size_t n, double *output)
@@ -134,175 +289,82 @@ void Math::solve(const double *mat, const size_t n, const double *b, double *out
     delete[] a;
 }
 
-int Math::bezier_bezier_f(const gsl_vector *v, void *params, gsl_vector *f)
-{
-    BezierParameter *bezier = static_cast<BezierParameter *>(params);
-    const double t0 = gsl_vector_get(v, 0), t1 = gsl_vector_get(v, 1);
-    double coord0[2] = {0, 0}, coord1[2] = {0, 0};
-    for (int i = 0; i <= bezier[0].order; ++i)
-    {
-        coord0[0] += (bezier[0].points[i * 2] * bezier[0].values[i] * std::pow(1 - t0, bezier[0].order - i) * std::pow(t0, i));
-        coord0[1] += (bezier[0].points[i * 2 + 1] * bezier[0].values[i] * std::pow(1 - t0, bezier[0].order - i) * std::pow(t0, i));
-    }
-    for (int i = 0; i <= bezier[1].order; ++i)
-    {
-        coord1[0] += (bezier[1].points[i * 2] * bezier[1].values[i] * std::pow(1 - t1, bezier[1].order - i) * std::pow(t1, i));
-        coord1[1] += (bezier[1].points[i * 2 + 1] * bezier[1].values[i] * std::pow(1 - t1, bezier[1].order - i) * std::pow(t1, i));
-    }
-    gsl_vector_set(f, 0, coord0[0] - coord1[0]);
-    gsl_vector_set(f, 1, coord0[1] - coord1[1]);
-    return GSL_SUCCESS;
-}
-
-void Math::rbasis(const bool is_cubic, const double t, const size_t npts, const double *x, double *output)
+bool Math::solve_tridiagonal(const double *lower, const double *diag, const double *upper, const double *b, const size_t n, double *output)
 {
-    const size_t nplusc = npts + (is_cubic ? 4 : 3);
-    double *temp = new double[nplusc];
-    std::fill_n(temp, nplusc, 0);
-    for (size_t i = 0; i < nplusc - 1; ++i)
+    if (n == 0 || diag[0] == 0)
     {
-        if ((t >= x[i]) && (t < x[i + 1]))
-        {
-            temp[i] = 1;
-        }
+        return false;
     }
-
-    for (int k = 2, n = is_cubic ? 4 : 3; k <= n; ++k)
+    std::vector<double> temp(n);
+    double pivot = diag[0];
+    output[0] = b[0] / pivot;
+    for (size_t i = 1; i < n; ++i)
     {
-        for (size_t i = 0; i < nplusc - k; ++i)
+        temp[i] = upper[i - 1] / pivot;
+        pivot = diag[i] - lower[i] * temp[i];
+        if (pivot == 0)
         {
-            if (temp[i] != 0)
-            {
-                temp[i] = ((t - x[i]) * temp[i]) / (x[i + k - 1] - x[i]);
-            }
-            if (temp[i + 1] != 0)
-            {
-                temp[i] += ((x[i + k] - t) * temp[i + 1]) / (x[i + k] - x[i + 1]);
-            }
+            return false;
         }
+        output[i] = (b[i] - lower[i] * output[i - 1]) / pivot;
     }
-
-    if (t >= x[nplusc - 1])
-    {
-        temp[npts - 1] = 1;
-    }
-
-    double sum = 0;
-    for (size_t i = 0; i < npts; ++i)
-    {
-        sum += temp[i];
-    }
-
-    std::fill_n(output, npts, 0);
-    if (sum != 0)
+    for (size_t i = n - 1; i > 0; --i)
     {
-        for (size_t i = 0; i < npts; ++i)
-        {
-            output[i] = temp[i] / sum;
-        }
+        output[i - 1] -= temp[i] * output[i];
     }
-
-    delete[] temp;
+    return true;
 }
 
-int Math::bspline_bspline_f(const gsl_vector *v, void *params, gsl_vector *f)
+size_t Math::bspline_span(const int order, const size_t npts, const double *knots, const double t)
 {
-    BSplineParameter *bspline = static_cast<BSplineParameter *>(params);
-    const double t0 = gsl_vector_get(v, 0), t1 = gsl_vector_get(v, 1);
-    double coord0[2] = {0, 0}, coord1[2] = {0, 0};
+    const size_t p = order;
+    if (npts <= p)
     {
-        double *nbasis = new double[bspline[0].npts];
-        rbasis(bspline[0].is_cubic, t0, bspline[0].npts, bspline[0].values, nbasis);
-        for (size_t i = 0; i < bspline[0].npts; ++i)
-        {
-            coord0[0] += bspline[0].points[i * 2] * nbasis[i];
-            coord0[1] += bspline[0].points[i * 2 + 1] * nbasis[i];
-        }
-        delete[] nbasis;
+        return npts;
     }
+    if (t < knots[p])
     {
-        double *nbasis = new double[bspline[1].npts];
-        rbasis(bspline[1].is_cubic, t1, bspline[1].npts, bspline[1].values, nbasis);
-        for (size_t i = 0; i < bspline[1].npts; ++i)
+        for (size_t i = p; i < npts; ++i)
         {
-            coord1[0] += bspline[1].points[i * 2] * nbasis[i];
-            coord1[1] += bspline[1].points[i * 2 + 1] * nbasis[i];
+            if (knots[i] < knots[i + 1])
+            {
+                return i;
+            }
         }
-        delete[] nbasis;
-    }
-    gsl_vector_set(f, 0, coord0[0] - coord1[0]);
-    gsl_vector_set(f, 1, coord0[1] - coord1[1]);
-    return GSL_SUCCESS;
-}
-
-int Math::bezier_bspline_f(const gsl_vector *v, void *params, gsl_vector *f)
-{
-    BezierBSplineParameter *curve = static_cast<BezierBSplineParameter *>(params);
-    const double t0 = gsl_vector_get(v, 0), t1 = gsl_vector_get(v, 1);
-    double coord0[2] = {0, 0}, coord1[2] = {0, 0};
-    for (int i = 0; i <= curve->bezier.order; ++i)
-    {
-        coord0[0] += (curve->bezier.points[i * 2] * curve->bezier.values[i] * std::pow(1 - t0, curve->bezier.order - i) * std::pow(t0, i));
-        coord0[1] +=
-            (curve->bezier.points[i * 2 + 1] * curve->bezier.values[i] * std::pow(1 - t0, curve->bezier.order - i) * std::pow(t0, i));
+        return npts;
     }
+    if (t >= knots[npts])
     {
-        double *nbasis = new double[curve->bspline.npts];
-        rbasis(curve->bspline.is_cubic, t1, curve->bspline.npts, curve->bspline.values, nbasis);
-        for (size_t i = 0; i < curve->bspline.npts; ++i)
+        for (size_t i = npts; i > p; --i)
         {
-            coord1[0] += curve->bspline.points[i * 2] * nbasis[i];
-            coord1[1] += curve->bspline.points[i * 2 + 1] * nbasis[i];
+            if (knots[i - 1] < knots[i])
+            {
+                return i - 1;
+            }
         }
-        delete[] nbasis;
+        return npts;
     }
-    gsl_vector_set(f, 0, coord0[0] - coord1[0]);
-    gsl_vector_set(f, 1, coord0[1] - coord1[1]);
-    return GSL_SUCCESS;
+    // 有效定义域为[knots[order], knots[npts]]
+    return std::upper_bound(knots + p, knots + npts + 1, t) - knots - 1;
 }
 
-std::tuple<double, double> Math::solve_curve_intersection(void *param, const CurveIntersectType type, const double init_t0,
-                                                          const double init_t1)
+void Math::bspline_basis(const int order, const size_t span, const double *knots, const double t, double *output)
 {
-    const size_t n = 2; // 方程组未知数的个数
-    gsl_multiroot_function f;
-    switch (type)
-    {
-    case CurveIntersectType::BezierBezier:
-        f.f = &Math::bezier_bezier_f;
-        break;
-    case CurveIntersectType::BSplineBSpline:
-        f.f = &Math::bspline_bspline_f;
-        break;
-    case CurveIntersectType::BezierBSpline:
-        f.f = &Math::bezier_bspline_f;
-        break;
-    }
-    f.n = n;
-    f.params = param;
-
-    gsl_vector *x = gsl_vector_alloc(n);
-    gsl_vector_set(x, 0, init_t0);
-    gsl_vector_set(x, 1, init_t1);
-
-    const gsl_multiroot_fsolver_type *t = gsl_multiroot_fsolver_dnewton;
-    gsl_multiroot_fsolver *s = gsl_multiroot_fsolver_alloc(t, n);
-    gsl_multiroot_fsolver_set(s, &f, x);
-
-    int status = GSL_CONTINUE;
-    int count = 0;
-    while (status == GSL_CONTINUE && count++ < Math::MAX_ITERATION) // 这个循环迭代解方程，最多迭代Math::MAX_ITERATION次
+    double left[MAX_BSPLINE_ORDER + 1], right[MAX_BSPLINE_ORDER + 1];
+    output[0] = 1;
+    for (int j = 1; j <= order; ++j)
     {
-        gsl_multiroot_fsolver_iterate(s);
-        status = gsl_multiroot_test_residual(s->f, Math::EPSILON); // 判断解是否是真实解
+        left[j] = t - knots[span + 1 - j];
+        right[j] = knots[span + j] - t;
+        double saved = 0;
+        for (int r = 0; r < j; ++r)
+        {
+            const double temp = output[r] / (right[r + 1] + left[j - r]);
+            output[r] = saved + right[r + 1] * temp;
+            saved = left[j - r] * temp;
+        }
+        output[j] = saved;
     }
-
-    std::tuple<double, double> res = std::make_tuple(gsl_vector_get(s->x, 0), gsl_vector_get(s->x, 1));
-
-    gsl_multiroot_fsolver_free(s);
-    gsl_vector_free(x);
-
-    return res;
 }
 
 double Math::ellipse_foot_f(const double v, void *params)
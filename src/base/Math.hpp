@@ -24,13 +24,11 @@ struct EllipseParameter
     double f[2] = {0};
 };
 
-int ellipse_ellipse_f(const gsl_vector *x, void *params, gsl_vector *f);
+// 求多项式coeffs[0] + coeffs[1] * x + ... + coeffs[degree] * x^degree的全部实根并按升序写入roots,degree不超过4
+int solve_polynomial(const double *coeffs, int degree, double *roots);
 
-int ellipse_ellipse_df(const gsl_vector *x, void *params, gsl_matrix *j);
-
-int ellipse_ellipse_fdf(const gsl_vector *x, void *params, gsl_vector *f, gsl_matrix *j);
-
-std::tuple<double, double> solve_ellipse_ellipse_intersection(EllipseParameter &param, const double init_x, const double init_y);
+// 求两条二次曲线a * x^2 + b * xy + c * y^2 + d * x + e * y + f = 0的交点,最多4个,由结式化为四次方程直接求解
+int solve_ellipse_ellipse_intersection(const EllipseParameter &param, double *x, double *y);
 
 void inverse(const double *input, const size_t n, double *output);
 
@@ -38,44 +36,18 @@ void mul(const double *mat0, const size_t m0, const size_t n0, const double *mat
 
 void solve(const double *mat, const size_t n, const double *b, double *output);
 
+// 追赶法求解三对角方程组,lower[i]和upper[i]分别为第i行主对角线左右两侧的元素,主元为0时返回false
+bool solve_tridiagonal(const double *lower, const double *diag, const double *upper, const double *b, const size_t n, double *output);
 
-struct BezierParameter
-{
-    int order = 3;
-    const double *points = nullptr;
-    const int *values = nullptr;
-};
-
-int bezier_bezier_f(const gsl_vector *v, void *params, gsl_vector *f);
-
-struct BSplineParameter
-{
-    bool is_cubic = true;
-    size_t npts = 4;
-    const double *points = nullptr;
-    const double *values = nullptr;
-};
 
-void rbasis(const bool is_cubic, const double t, const size_t npts, const double *x, double *output);
+// B样条最高次数,基函数计算使用栈上的临时数组
+static const int MAX_BSPLINE_ORDER = 3;
 
-int bspline_bspline_f(const gsl_vector *v, void *params, gsl_vector *f);
-
-struct BezierBSplineParameter
-{
-    BezierParameter bezier;
-    BSplineParameter bspline;
-};
-
-int bezier_bspline_f(const gsl_vector *v, void *params, gsl_vector *f);
-
-enum class CurveIntersectType
-{
-    BezierBezier,
-    BSplineBSpline,
-    BezierBSpline
-};
+// 查找t所在的非空节点区间span,满足knots[span] <= t < knots[span + 1],t超出定义域时取首尾区间,不存在有效区间时返回npts
+size_t bspline_span(const int order, const size_t npts, const double *knots, const double t);
 
-std::tuple<double, double> solve_curve_intersection(void *param, const CurveIntersectType type, const double init_t0, const double init_t1);
+// 计算span区间上order + 1个非零基函数的值
+void bspline_basis(const int order, const size_t span, const double *knots, const double t, double *output);
 
 
 struct EllipseFootParameter // a * cost + b * sint + c * sint * cost = 0
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <QFontMetricsF>
+#include <QStringList>
+#include "base/TextStyle.hpp"
+
+
+TextStyleTable::Style::Style(const QFont &value) : font(value)
+{
+    const QFontMetricsF metrics(value);
+    leading = metrics.leading();
+    base_width = metrics.boundingRect("0").width();
+}
+
+TextStyleTable &TextStyleTable::table()
+{
+    static TextStyleTable instance;
+    return instance;
+}
+
+size_t TextStyleTable::intern(const QFont &font)
+{
+    const QString key = font.key();
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        if (auto it = _indexs.find(key); it != _indexs.end())
+        {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if (auto it = _indexs.find(key); it != _indexs.end())
+    {
+        return it->second;
+    }
+    _styles.emplace_back(font);
+    _indexs.emplace(key, _styles.size() - 1);
+    return _styles.size() - 1;
+}
+
+const QFont &TextStyleTable::font(const size_t style) const
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _styles[style].font;
+}
+
+void TextStyleTable::measure(const size_t style, const QString &text, double &width, double &height) const
+{
+    thread_local std::vector<std::unique_ptr<QFontMetricsF>> thread_metrics; // 样式序号-本线程的字体度量
+    double leading = 0, base_width = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        const Style &item = _styles[style];
+        leading = item.leading;
+        base_width = item.base_width;
+        if (thread_metrics.size() <= style)
+        {
+            thread_metrics.resize(style + 1);
+        }
+        if (thread_metrics[style] == nullptr)
+        {
+            thread_metrics[style] = std::make_unique<QFontMetricsF>(item.font);
+        }
+    }
+
+    const QFontMetricsF &metrics = *thread_metrics[style];
+    width = 2;
+    height = -leading;
+    for (const QString &txt : text.split('\n'))
+    {
+        const QRectF rect = metrics.boundingRect(txt);
+        if (std::any_of(txt.begin(), txt.end(), [](QChar c) { return c > QChar(256); }))
+        {
+            width = std::max(width, rect.width() + base_width);
+        }
+        else
+        {
+            width = std::max(width, rect.width());
+        }
+        height += (rect.height() + leading);
+    }
+    if (width <= 2)
+    {
+        width = 20;
+    }
+    if (height <= 2)
+    {
+        height = 20;
+    }
+}
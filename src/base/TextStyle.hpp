@@ -0,0 +1,41 @@
+#pragma once
+#include <deque>
+#include <map>
+#include <shared_mutex>
+#include <QFont>
+#include <QString>
+
+
+// 进程内共享的文字样式表,相同的字体只保存一份QFont和字体度量,Text只记录样式序号
+class TextStyleTable
+{
+private:
+    struct Style
+    {
+        QFont font;
+        double leading = 0;
+        double base_width = 0; // 字符"0"的宽度,含非ASCII字符的行额外加上此宽度
+
+        Style(const QFont &value);
+    };
+
+    std::deque<Style> _styles;
+    std::map<QString, size_t> _indexs; // QFont::key()-样式序号
+    mutable std::shared_mutex _mutex;
+
+private:
+    TextStyleTable() = default;
+
+    ~TextStyleTable() = default;
+
+public:
+    static TextStyleTable &table();
+
+    // 返回font对应的样式序号,表中没有时加入
+    size_t intern(const QFont &font);
+
+    const QFont &font(const size_t style) const;
+
+    // 计算多行文本的宽和高,QFontMetricsF不能跨线程共享,各线程按样式缓存自己的字体度量
+    void measure(const size_t style, const QString &text, double &width, double &height) const;
+};
@@ -1,3 +1,7 @@
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
 #include "base/UndoStack.hpp"
 #include "io/GlobalSetting.hpp"
 
@@ -5,43 +9,526 @@
 using namespace UndoStack;
 
 
+namespace
+{
+enum class SpillKind : unsigned char
+{
+    Polyline,
+    Polygon,
+    Bezier,
+    QuadBSpline,
+    CubicBSpline
+};
+
+template <typename T> void write_value(std::string &buffer, const T value)
+{
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void write_points(std::string &buffer, const std::vector<Geo::Point>::const_iterator &begin,
+                  const std::vector<Geo::Point>::const_iterator &end)
+{
+    write_value<unsigned long long>(buffer, std::distance(begin, end));
+    for (std::vector<Geo::Point>::const_iterator it = begin; it != end; ++it)
+    {
+        write_value(buffer, it->x);
+        write_value(buffer, it->y);
+    }
+}
+
+class SpillReader
+{
+private:
+    const std::string &_buffer;
+    size_t _pos = 0;
+
+public:
+    SpillReader(const std::string &buffer) : _buffer(buffer)
+    {
+    }
+
+    template <typename T> T value()
+    {
+        T result{};
+        if (_pos + sizeof(T) <= _buffer.size())
+        {
+            std::memcpy(&result, _buffer.data() + _pos, sizeof(T));
+        }
+        _pos += sizeof(T);
+        return result;
+    }
+
+    std::vector<Geo::Point> points()
+    {
+        std::vector<Geo::Point> result;
+        const size_t count = std::min<size_t>(value<unsigned long long>(), _buffer.size() / (sizeof(double) * 2));
+        result.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double x = value<double>();
+            result.emplace_back(x, value<double>());
+        }
+        return result;
+    }
+
+    std::vector<double> values()
+    {
+        std::vector<double> result(std::min<size_t>(value<unsigned long long>(), _buffer.size() / sizeof(double)));
+        for (double &item : result)
+        {
+            item = value<double>();
+        }
+        return result;
+    }
+
+    QString string()
+    {
+        const size_t count = std::min<size_t>(value<unsigned int>(), _buffer.size() / sizeof(char16_t));
+        QString result(count, QChar());
+        if (_pos + count * sizeof(char16_t) <= _buffer.size())
+        {
+            std::memcpy(result.data(), _buffer.data() + _pos, count * sizeof(char16_t));
+        }
+        _pos += count * sizeof(char16_t);
+        return result;
+    }
+};
+
+// 清空图形并释放点数据的容量,图形对象保留以免指针失效
+template <typename T> void release_points(Geo::Geometry *object)
+{
+    T *item = static_cast<T *>(object);
+    item->clear();
+    item->shrink_to_fit();
+}
+
+template <typename T> void load_bspline(Geo::Geometry *object, SpillReader &reader)
+{
+    T bspline;
+    bspline.controls_model = reader.value<bool>();
+    bspline.control_points = reader.points();
+    bspline.path_points = reader.points();
+    const std::vector<double> knots = reader.values();
+    bspline.set_knots(knots.begin(), knots.end());
+    const double step = reader.value<double>();
+    bspline.update_shape(step, reader.value<double>());
+    *static_cast<T *>(object) = bspline;
+}
+} // namespace
+
+
+SpillFile::~SpillFile()
+{
+    reset();
+}
+
+bool SpillFile::open()
+{
+    if (_file.is_open())
+    {
+        return true;
+    }
+
+    std::error_code error;
+    const std::filesystem::path dir = std::filesystem::temp_directory_path(error);
+    if (error)
+    {
+        return false;
+    }
+    _path = (dir / ("DSV_undo_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_" +
+                    std::to_string(reinterpret_cast<std::uintptr_t>(this)) + ".tmp"))
+                .string();
+    _file.open(_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    _end = 0;
+    return _file.is_open();
+}
+
+void SpillFile::reset()
+{
+    if (_file.is_open())
+    {
+        _file.close();
+        std::error_code error;
+        std::filesystem::remove(_path, error);
+    }
+    _end = 0;
+    _count = 0;
+}
+
+size_t SpillFile::memory_size(const Geo::Geometry *object)
+{
+    switch (object->type())
+    {
+    case Geo::Type::POLYLINE:
+    case Geo::Type::POLYGON:
+        return static_cast<const Geo::Polyline *>(object)->size() * sizeof(Geo::Point);
+    case Geo::Type::BEZIER:
+        {
+            const Geo::CubicBezier *bezier = static_cast<const Geo::CubicBezier *>(object);
+            return (bezier->size() + bezier->shape().size()) * sizeof(Geo::Point);
+        }
+    case Geo::Type::BSPLINE:
+        {
+            const Geo::BSpline *bspline = static_cast<const Geo::BSpline *>(object);
+            return (bspline->control_points.size() + bspline->path_points.size() + bspline->shape().size()) * sizeof(Geo::Point) +
+                   bspline->knots().size() * sizeof(double);
+        }
+    case Geo::Type::COMBINATION:
+        {
+            size_t result = 0;
+            for (const Geo::Geometry *item : *static_cast<const Combination *>(object))
+            {
+                result += memory_size(item);
+            }
+            return result;
+        }
+    case Geo::Type::ARRAY:
+        {
+            const Array *array = static_cast<const Array *>(object);
+            size_t result = array->size() * sizeof(std::array<double, 6>);
+            for (const Geo::Geometry *item : array->source())
+            {
+                result += memory_size(item);
+            }
+            return result;
+        }
+    default:
+        return 0;
+    }
+}
+
+void SpillFile::spill(Geo::Geometry *object, std::vector<Record> &records)
+{
+    std::string buffer;
+    SpillKind kind = SpillKind::Polyline;
+    switch (object->type())
+    {
+    case Geo::Type::POLYLINE:
+    case Geo::Type::POLYGON:
+    case Geo::Type::BEZIER:
+        {
+            const Geo::Polyline *polyline = static_cast<const Geo::Polyline *>(object);
+            if (object->type() == Geo::Type::POLYGON)
+            {
+                kind = SpillKind::Polygon;
+            }
+            else if (object->type() == Geo::Type::BEZIER)
+            {
+                kind = SpillKind::Bezier;
+            }
+            write_value(buffer, kind);
+            write_points(buffer, polyline->begin(), polyline->end());
+            if (kind == SpillKind::Bezier)
+            {
+                write_value(buffer, static_cast<const Geo::CubicBezier *>(object)->step());
+                write_value(buffer, static_cast<const Geo::CubicBezier *>(object)->down_sampling_value());
+            }
+        }
+        break;
+    case Geo::Type::BSPLINE:
+        {
+            const Geo::BSpline *bspline = static_cast<const Geo::BSpline *>(object);
+            kind = dynamic_cast<const Geo::QuadBSpline *>(object) == nullptr ? SpillKind::CubicBSpline : SpillKind::QuadBSpline;
+            write_value(buffer, kind);
+            write_value(buffer, bspline->controls_model);
+            write_points(buffer, bspline->control_points.begin(), bspline->control_points.end());
+            write_points(buffer, bspline->path_points.begin(), bspline->path_points.end());
+            write_value<unsigned long long>(buffer, bspline->knots().size());
+            for (const double knot : bspline->knots())
+            {
+                write_value(buffer, knot);
+            }
+            write_value(buffer, bspline->step());
+            write_value(buffer, bspline->down_sampling_value());
+        }
+        break;
+    case Geo::Type::COMBINATION:
+        for (Geo::Geometry *item : *static_cast<Combination *>(object))
+        {
+            spill(item, records);
+        }
+        return;
+    case Geo::Type::ARRAY:
+        for (Geo::Geometry *item : static_cast<Array *>(object)->source())
+        {
+            spill(item, records);
+        }
+        return;
+    default:
+        return;
+    }
+    write_value(buffer, object->is_selected);
+    write_value(buffer, object->point_index);
+    write_value(buffer, object->point_count);
+    write_value<unsigned int>(buffer, object->name.size());
+    buffer.append(reinterpret_cast<const char *>(object->name.utf16()), object->name.size() * sizeof(char16_t));
+
+    if (!open())
+    {
+        return;
+    }
+    _file.seekp(_end);
+    _file.write(buffer.data(), buffer.size());
+    if (!_file)
+    {
+        _file.clear(); // 写入失败时图形保留在内存中
+        return;
+    }
+    records.push_back(Record{object, _end, buffer.size()});
+    _end += buffer.size();
+    ++_count;
+
+    switch (kind)
+    {
+    case SpillKind::Polyline:
+        release_points<Geo::Polyline>(object);
+        break;
+    case SpillKind::Polygon:
+        release_points<Geo::Polygon>(object);
+        break;
+    case SpillKind::Bezier:
+        release_points<Geo::CubicBezier>(object);
+        break;
+    case SpillKind::QuadBSpline:
+        release_points<Geo::QuadBSpline>(object);
+        break;
+    case SpillKind::CubicBSpline:
+        release_points<Geo::CubicBSpline>(object);
+        break;
+    }
+}
+
+bool SpillFile::load(std::vector<Record> &records)
+{
+    // 全部读取成功后再写回图形,读取失败时图形保持写入文件后的状态
+    std::vector<std::string> buffers;
+    buffers.reserve(records.size());
+    for (const Record &record : records)
+    {
+        std::string &buffer = buffers.emplace_back(record.size, '\0');
+        _file.seekg(record.offset);
+        _file.read(buffer.data(), record.size);
+        const bool failed = !_file || static_cast<size_t>(_file.gcount()) != record.size;
+        _file.clear();
+        if (failed)
+        {
+            return false;
+        }
+    }
+
+    for (size_t i = 0, count = records.size(); i < count; ++i)
+    {
+        SpillReader reader(buffers[i]);
+        Geo::Geometry *object = records[i].object;
+        switch (reader.value<SpillKind>())
+        {
+        case SpillKind::Polyline:
+            {
+                const std::vector<Geo::Point> points = reader.points();
+                *static_cast<Geo::Polyline *>(object) = Geo::Polyline(points.begin(), points.end());
+            }
+            break;
+        case SpillKind::Polygon:
+            {
+                const std::vector<Geo::Point> points = reader.points();
+                *static_cast<Geo::Polygon *>(object) = Geo::Polygon(points.begin(), points.end());
+            }
+            break;
+        case SpillKind::Bezier:
+            {
+                const std::vector<Geo::Point> points = reader.points();
+                Geo::CubicBezier bezier(points.begin(), points.end(), false);
+                const double step = reader.value<double>(), down_sampling_value = reader.value<double>();
+                if (step != bezier.step() || down_sampling_value != bezier.down_sampling_value())
+                {
+                    bezier.update_shape(step, down_sampling_value);
+                }
+                *static_cast<Geo::CubicBezier *>(object) = bezier;
+            }
+            break;
+        case SpillKind::QuadBSpline:
+            load_bspline<Geo::QuadBSpline>(object, reader);
+            break;
+        case SpillKind::CubicBSpline:
+            load_bspline<Geo::CubicBSpline>(object, reader);
+            break;
+        }
+        object->is_selected = reader.value<bool>();
+        object->point_index = reader.value<unsigned long long>();
+        object->point_count = reader.value<unsigned long long>();
+        object->name = reader.string();
+    }
+    release(records);
+    return true;
+}
+
+void SpillFile::release(std::vector<Record> &records)
+{
+    _count -= std::min(_count, records.size());
+    records.clear();
+    if (_count == 0)
+    {
+        reset();
+    }
+}
+
+
+void Command::compress()
+{
+}
+
+size_t Command::memory_size() const
+{
+    return sizeof(Command) + (removed.capacity() + appended.capacity() + updated.capacity()) * sizeof(Geo::Geometry *);
+}
+
+void Command::spill(SpillFile &)
+{
+}
+
+bool Command::load()
+{
+    return true;
+}
+
+
 void CommandStack::set_count(const size_t count)
 {
     _count = count;
 }
 
+void CommandStack::set_memory_limit(const size_t bytes)
+{
+    _memory_limit = bytes;
+}
+
+size_t CommandStack::memory_usage() const
+{
+    return _memory;
+}
+
 void CommandStack::set_graph(Graph *graph)
 {
     _graph = graph;
 }
 
-void CommandStack::push_command(Command *command)
+void CommandStack::set_spill(const bool value)
 {
-    if (_commands.size() > _count)
+    _spill = value;
+    if (_spill)
     {
-        delete _commands.front();
-        _commands.erase(_commands.begin());
+        spill();
     }
+}
+
+void CommandStack::spill()
+{
+    for (size_t i = 0, count = _commands.size(); i + 1 < count && _memory > _spill_threshold; ++i)
+    {
+        _memory -= _commands[i]->memory_size();
+        _commands[i]->spill(_spill_file);
+        _memory += _commands[i]->memory_size();
+    }
+}
+
+void CommandStack::push(Command *command)
+{
+    _memory += command->memory_size();
     _commands.push_back(command);
+    while (_commands.size() > 1 && (_commands.size() > _count + 1 || _memory > _memory_limit))
+    {
+        _memory -= _commands.front()->memory_size();
+        delete _commands.front();
+        _commands.pop_front();
+    }
+    if (_spill)
+    {
+        spill();
+    }
+}
+
+void CommandStack::push_command(Command *command)
+{
+    command->compress();
+    if (_transaction != nullptr)
+    {
+        _transaction->append(command);
+    }
+    else
+    {
+        push(command);
+    }
+}
+
+void CommandStack::begin_transaction()
+{
+    if (_transaction_depth++ == 0)
+    {
+        _transaction = new CompositeCommand();
+    }
+}
+
+void CommandStack::commit_transaction()
+{
+    if (_transaction_depth == 0 || --_transaction_depth > 0)
+    {
+        return;
+    }
+
+    CompositeCommand *transaction = _transaction;
+    _transaction = nullptr;
+    if (transaction->empty())
+    {
+        delete transaction;
+    }
+    else if (transaction->size() == 1)
+    {
+        push(transaction->release());
+        delete transaction;
+    }
+    else
+    {
+        push(transaction);
+    }
+}
+
+bool CommandStack::in_transaction() const
+{
+    return _transaction != nullptr;
 }
 
 void CommandStack::clear()
 {
+    delete _transaction;
+    _transaction = nullptr;
+    _transaction_depth = 0;
     while (!_commands.empty())
     {
         delete _commands.back();
         _commands.pop_back();
     }
+    _memory = 0;
     _graph = nullptr;
 }
 
 void CommandStack::undo()
 {
-    if (_commands.empty())
+    removed.clear();
+    appended.clear();
+    updated.clear();
+    if (_commands.empty() || _transaction != nullptr)
     {
         return;
     }
 
+    const size_t size = _commands.back()->memory_size(); // undo会展开差分,先取入栈时的大小
+    if (!_commands.back()->load())
+    {
+        // 临时文件读取失败,命令保留在栈中,部分读回的图形计入内存占用
+        _memory = _memory - size + _commands.back()->memory_size();
+        return;
+    }
+    _memory -= size;
     _commands.back()->undo(_graph);
     appended = _commands.back()->appended;
     removed = _commands.back()->removed;
@@ -51,6 +538,133 @@ void CommandStack::undo()
 }
 
 
+// CompositeCommand
+CompositeCommand::~CompositeCommand()
+{
+    for (Command *command : _commands)
+    {
+        delete command;
+    }
+}
+
+void CompositeCommand::append(Command *command)
+{
+    _commands.push_back(command);
+}
+
+bool CompositeCommand::empty() const
+{
+    return _commands.empty();
+}
+
+size_t CompositeCommand::size() const
+{
+    return _commands.size();
+}
+
+Command *CompositeCommand::release()
+{
+    Command *command = _commands.empty() ? nullptr : _commands.front();
+    _commands.clear();
+    return command;
+}
+
+void CompositeCommand::undo(Graph *graph)
+{
+    enum class State
+    {
+        Removed,
+        Appended,
+        Updated
+    };
+    std::unordered_map<Geo::Geometry *, State> states;
+    std::vector<Geo::Geometry *> objects; // 按首次变化的顺序
+    for (std::vector<Command *>::reverse_iterator it = _commands.rbegin(), end = _commands.rend(); it != end; ++it)
+    {
+        (*it)->undo(graph);
+        for (Geo::Geometry *object : (*it)->removed)
+        {
+            if (auto state = states.find(object); state == states.end())
+            {
+                states.emplace(object, State::Removed);
+                objects.push_back(object);
+            }
+            else if (state->second == State::Appended)
+            {
+                states.erase(state); // 先加入后移除,对外无变化
+            }
+            else
+            {
+                state->second = State::Removed;
+            }
+        }
+        for (Geo::Geometry *object : (*it)->appended)
+        {
+            if (auto state = states.find(object); state == states.end())
+            {
+                states.emplace(object, State::Appended);
+                objects.push_back(object);
+            }
+            else if (state->second == State::Removed)
+            {
+                state->second = State::Updated; // 先移除后加入,视为修改
+            }
+        }
+        for (Geo::Geometry *object : (*it)->updated)
+        {
+            if (states.find(object) == states.end())
+            {
+                states.emplace(object, State::Updated);
+                objects.push_back(object);
+            }
+        }
+    }
+
+    for (Geo::Geometry *object : objects)
+    {
+        if (auto state = states.find(object); state != states.end())
+        {
+            switch (state->second)
+            {
+            case State::Removed:
+                removed.push_back(object);
+                break;
+            case State::Appended:
+                appended.push_back(object);
+                break;
+            case State::Updated:
+                updated.push_back(object);
+                break;
+            }
+            states.erase(state);
+        }
+    }
+}
+
+size_t CompositeCommand::memory_size() const
+{
+    size_t result = Command::memory_size() + sizeof(CompositeCommand) - sizeof(Command) + _commands.capacity() * sizeof(Command *);
+    for (const Command *command : _commands)
+    {
+        result += command->memory_size();
+    }
+    return result;
+}
+
+void CompositeCommand::spill(SpillFile &file)
+{
+    for (Command *command : _commands)
+    {
+        command->spill(file);
+    }
+}
+
+bool CompositeCommand::load()
+{
+    return std::all_of(_commands.begin(), _commands.end(), [](Command *command) { return command->load(); });
+}
+
+
 // ObjectCommand
 ObjectCommand::ObjectCommand(const std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> &objects, const bool add)
 {
@@ -94,6 +708,10 @@ ObjectCommand::ObjectCommand(const std::vector<std::tuple<Geo::Geometry *, size_
 
 ObjectCommand::~ObjectCommand()
 {
+    if (_spill_file != nullptr)
+    {
+        _spill_file->release(_spilled);
+    }
     for (std::tuple<Geo::Geometry *, size_t, size_t> &item : _remove_items)
     {
         delete std::get<0>(item);
@@ -102,6 +720,7 @@ ObjectCommand::~ObjectCommand()
 
 void ObjectCommand::undo(Graph *graph)
 {
+    load();
     std::sort(_add_items.begin(), _add_items.end(),
               [](const std::tuple<Geo::Geometry *, size_t, size_t> &a, const std::tuple<Geo::Geometry *, size_t, size_t> &b)
               { return std::get<1>(a) > std::get<1>(b) || std::get<2>(a) > std::get<2>(b); });
@@ -136,6 +755,52 @@ void ObjectCommand::undo(Graph *graph)
 }
 
 
+size_t ObjectCommand::memory_size() const
+{
+    size_t result = Command::memory_size() + sizeof(ObjectCommand) - sizeof(Command) +
+                    (_add_items.capacity() + _remove_items.capacity()) * sizeof(std::tuple<Geo::Geometry *, size_t, size_t>) +
+                    _spilled.capacity() * sizeof(SpillFile::Record);
+    if (_spill_file == nullptr)
+    {
+        for (const std::tuple<Geo::Geometry *, size_t, size_t> &item : _remove_items)
+        {
+            result += SpillFile::memory_size(std::get<0>(item));
+        }
+    }
+    return result;
+}
+
+bool ObjectCommand::load()
+{
+    if (_spill_file == nullptr)
+    {
+        return true;
+    }
+    if (!_spill_file->load(_spilled))
+    {
+        return false;
+    }
+    _spill_file = nullptr;
+    return true;
+}
+
+void ObjectCommand::spill(SpillFile &file)
+{
+    if (_spill_file != nullptr)
+    {
+        return;
+    }
+    for (const std::tuple<Geo::Geometry *, size_t, size_t> &item : _remove_items)
+    {
+        file.spill(std::get<0>(item), _spilled);
+    }
+    if (!_spilled.empty())
+    {
+        _spill_file = &file;
+    }
+}
+
+
 // TranslateCommand
 TranslateCommand::TranslateCommand(const std::vector<Geo::Geometry *> &objects, const double x, const double y)
     : _items(objects), _dx(x), _dy(y)
@@ -197,8 +862,140 @@ ChangeShapeCommand::ChangeShapeCommand(Geo::BSpline *bspline, const std::vector<
 {
 }
 
+std::vector<ChangeShapeCommand::PointsDelta> ChangeShapeCommand::diff(const std::vector<std::tuple<double, double>> &before,
+                                                                      const std::vector<Geo::Point> &after)
+{
+    std::vector<PointsDelta> result;
+    auto equal = [&](const size_t i, const size_t j)
+    { return std::get<0>(before[i]) == after[j].x && std::get<1>(before[i]) == after[j].y; };
+    if (const size_t count = before.size(); count == after.size())
+    {
+        // 点数不变时记录各个变化的区间,间隔很近的区间合并
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (equal(i, i))
+            {
+                continue;
+            }
+            size_t last = i;
+            for (size_t j = i + 1; j < count && j - last <= 4; ++j)
+            {
+                if (!equal(j, j))
+                {
+                    last = j;
+                }
+            }
+            PointsDelta delta;
+            delta.start = i;
+            delta.count = last - i + 1;
+            for (size_t j = i; j <= last; ++j)
+            {
+                delta.points.emplace_back(std::get<0>(before[j]), std::get<1>(before[j]));
+            }
+            result.emplace_back(std::move(delta));
+            i = last;
+        }
+    }
+    else
+    {
+        // 点数变化时记录去掉相同首尾后的区间
+        const size_t n = std::min(count, after.size());
+        size_t head = 0, tail = 0;
+        while (head < n && equal(head, head))
+        {
+            ++head;
+        }
+        while (tail < n - head && equal(count - 1 - tail, after.size() - 1 - tail))
+        {
+            ++tail;
+        }
+        PointsDelta delta;
+        delta.start = head;
+        delta.count = after.size() - head - tail;
+        for (size_t i = head, end = count - tail; i < end; ++i)
+        {
+            delta.points.emplace_back(std::get<0>(before[i]), std::get<1>(before[i]));
+        }
+        result.emplace_back(std::move(delta));
+    }
+    return result;
+}
+
+std::vector<std::tuple<double, double>> ChangeShapeCommand::restore(const std::vector<PointsDelta> &delta, std::vector<Geo::Point> points)
+{
+    for (auto it = delta.rbegin(), end = delta.rend(); it != end; ++it)
+    {
+        points.erase(points.begin() + it->start, points.begin() + it->start + it->count);
+        points.insert(points.begin() + it->start, it->points.begin(), it->points.end());
+    }
+    std::vector<std::tuple<double, double>> result;
+    result.reserve(points.size());
+    for (const Geo::Point &point : points)
+    {
+        result.emplace_back(point.x, point.y);
+    }
+    return result;
+}
+
+void ChangeShapeCommand::compress()
+{
+    switch (_object->type())
+    {
+    case Geo::Type::POLYLINE:
+    case Geo::Type::POLYGON:
+    case Geo::Type::BEZIER:
+        {
+            const Geo::Polyline *polyline = static_cast<const Geo::Polyline *>(_object);
+            _shape_delta = diff(_shape, std::vector<Geo::Point>(polyline->begin(), polyline->end()));
+        }
+        break;
+    case Geo::Type::BSPLINE:
+        {
+            const Geo::BSpline *bspline = static_cast<const Geo::BSpline *>(_object);
+            _shape_delta = diff(_shape, bspline->control_points);
+            _path_delta = diff(_path_points, bspline->path_points);
+            std::vector<std::tuple<double, double>>().swap(_path_points);
+        }
+        break;
+    default:
+        return;
+    }
+    std::vector<std::tuple<double, double>>().swap(_shape);
+    _compressed = true;
+}
+
+size_t ChangeShapeCommand::memory_size() const
+{
+    size_t result = Command::memory_size() + sizeof(ChangeShapeCommand) - sizeof(Command);
+    result += (_shape.capacity() + _path_points.capacity()) * sizeof(std::tuple<double, double>) + _knots.capacity() * sizeof(double);
+    for (const std::vector<PointsDelta> *deltas : {&_shape_delta, &_path_delta})
+    {
+        for (const PointsDelta &delta : *deltas)
+        {
+            result += sizeof(PointsDelta) + delta.points.capacity() * sizeof(Geo::Point);
+        }
+    }
+    return result;
+}
+
 void ChangeShapeCommand::undo(Graph *graph)
 {
+    // 撤销时图形处于压缩时的状态,由变化的区间还原修改前的点列
+    if (_compressed)
+    {
+        if (_object->type() == Geo::Type::BSPLINE)
+        {
+            const Geo::BSpline *bspline = static_cast<const Geo::BSpline *>(_object);
+            _shape = restore(_shape_delta, bspline->control_points);
+            _path_points = restore(_path_delta, bspline->path_points);
+        }
+        else
+        {
+            const Geo::Polyline *polyline = static_cast<const Geo::Polyline *>(_object);
+            _shape = restore(_shape_delta, std::vector<Geo::Point>(polyline->begin(), polyline->end()));
+        }
+    }
+
     switch (_object->type())
     {
     case Geo::Type::POLYLINE:
@@ -533,8 +1330,17 @@ GroupCommand::GroupCommand(const size_t index, const bool add, ContainerGroup &g
     group.transfer(_group);
 }
 
+GroupCommand::~GroupCommand()
+{
+    if (_spill_file != nullptr)
+    {
+        _spill_file->release(_spilled);
+    }
+}
+
 void GroupCommand::undo(Graph *graph)
 {
+    load();
     if (_add)
     {
         removed.assign(graph->container_group(_index).begin(), graph->container_group(_index).end());
@@ -556,6 +1362,50 @@ void GroupCommand::undo(Graph *graph)
 }
 
 
+size_t GroupCommand::memory_size() const
+{
+    size_t result = Command::memory_size() + sizeof(GroupCommand) - sizeof(Command) + _spilled.capacity() * sizeof(SpillFile::Record);
+    if (_spill_file == nullptr)
+    {
+        for (const Geo::Geometry *object : _group)
+        {
+            result += SpillFile::memory_size(object);
+        }
+    }
+    return result;
+}
+
+bool GroupCommand::load()
+{
+    if (_spill_file == nullptr)
+    {
+        return true;
+    }
+    if (!_spill_file->load(_spilled))
+    {
+        return false;
+    }
+    _spill_file = nullptr;
+    return true;
+}
+
+void GroupCommand::spill(SpillFile &file)
+{
+    if (_add || _spill_file != nullptr)
+    {
+        return;
+    }
+    for (Geo::Geometry *object : _group)
+    {
+        file.spill(object, _spilled);
+    }
+    if (!_spilled.empty())
+    {
+        _spill_file = &file;
+    }
+}
+
+
 // ReorderGroupCommand
 ReorderGroupCommand::ReorderGroupCommand(const size_t from, const size_t to) : _from(from), _to(to)
 {
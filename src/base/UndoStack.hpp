@@ -1,5 +1,7 @@
 #pragma once
 
+#include <deque>
+#include <fstream>
 #include <tuple>
 #include <vector>
 #include <string>
@@ -9,6 +11,51 @@
 
 namespace UndoStack
 {
+// 撤销记录的临时文件,保存较早命令所拥有图形的点数据,图形对象本身保留以免其他命令中的指针失效
+class SpillFile
+{
+public:
+    struct Record
+    {
+        Geo::Geometry *object = nullptr;
+        long long offset = 0;
+        size_t size = 0;
+    };
+
+private:
+    std::string _path;
+    std::fstream _file;
+    long long _end = 0;
+    size_t _count = 0; // 尚未读回或丢弃的记录数
+
+private:
+    bool open();
+
+    void reset();
+
+public:
+    SpillFile() = default;
+
+    SpillFile(const SpillFile &) = delete;
+
+    SpillFile &operator=(const SpillFile &) = delete;
+
+    ~SpillFile();
+
+    // 可写入文件的点数据字节数
+    static size_t memory_size(const Geo::Geometry *object);
+
+    // 写入object的点数据并释放,组合图形写入其中的各图形,不支持的类型保留在内存中
+    void spill(Geo::Geometry *object, std::vector<Record> &records);
+
+    // 读回records中的图形并清空records,读取失败时不修改图形和records并返回false
+    bool load(std::vector<Record> &records);
+
+    // 丢弃records,不读回图形
+    void release(std::vector<Record> &records);
+};
+
+
 class Command
 {
 public:
@@ -17,27 +64,97 @@ public:
     virtual ~Command() = default;
 
     virtual void undo(Graph *graph = nullptr) = 0;
+
+    // 命令入栈时图形已处于执行后的状态,子类可在此压缩保存的数据
+    virtual void compress();
+
+    // 命令占用的内存字节数,为估计值
+    virtual size_t memory_size() const;
+
+    // 将命令拥有的图形写入file以释放内存,撤销前读回
+    virtual void spill(SpillFile &file);
+
+    // 读回写入文件的图形,失败时返回false
+    virtual bool load();
 };
 
 
-class CommandStack
+// 由事务中的多个命令组成,撤销时逆序撤销各命令,removed、appended、updated为合并后的净变化
+class CompositeCommand : public Command
 {
 private:
     std::vector<Command *> _commands;
+
+public:
+    ~CompositeCommand() override;
+
+    void append(Command *command);
+
+    bool empty() const;
+
+    size_t size() const;
+
+    // 取出唯一的命令,此后CompositeCommand为空
+    Command *release();
+
+    void undo(Graph *graph = nullptr) override;
+
+    size_t memory_size() const override;
+
+    void spill(SpillFile &file) override;
+
+    bool load() override;
+};
+
+
+class CommandStack
+{
+private:
+    std::deque<Command *> _commands;
     size_t _count = 3;
+    size_t _memory_limit = 256 * 1024 * 1024; // 历史记录的内存上限
+    size_t _memory = 0;
+    CompositeCommand *_transaction = nullptr;
+    size_t _transaction_depth = 0;
+    bool _spill = false;
+    size_t _spill_threshold = 64 * 1024 * 1024; // 历史记录超过此大小时才将较早的命令写入文件
+    SpillFile _spill_file;
 
     Graph *_graph = nullptr;
 
+private:
+    // 将已压缩的命令入栈并按数量和内存上限丢弃最早的命令
+    void push(Command *command);
+
+    // 从最早的命令开始写入文件,直到内存占用不超过_spill_threshold,最新的命令总在内存中
+    void spill();
+
 public:
     std::vector<Geo::Geometry *> removed, appended, updated;
 
 public:
     void set_count(const size_t count);
 
+    void set_memory_limit(const size_t bytes);
+
+    // 开启后历史记录较大时,除最新的命令外其余命令拥有的图形写入临时文件
+    void set_spill(const bool value);
+
+    // 历史记录占用的内存字节数
+    size_t memory_usage() const;
+
     void set_graph(Graph *graph);
 
+    // 须在图形修改完成后调用,超出数量或内存上限时丢弃最早的命令,最新的命令总会保留
     void push_command(Command *command);
 
+    // 开始事务,提交前入栈的命令合并为一个命令,事务可嵌套,最外层提交时生效
+    void begin_transaction();
+
+    void commit_transaction();
+
+    bool in_transaction() const;
+
     void clear();
 
     void undo();
@@ -50,6 +167,8 @@ private:
     // object, group index, object index
     std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> _add_items;
     std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> _remove_items;
+    std::vector<SpillFile::Record> _spilled;
+    SpillFile *_spill_file = nullptr;
 
 public:
     ObjectCommand(const std::vector<std::tuple<Geo::Geometry *, size_t, size_t>> &items, const bool add);
@@ -62,6 +181,12 @@ public:
     ~ObjectCommand() override;
 
     void undo(Graph *graph = nullptr) override;
+
+    size_t memory_size() const override;
+
+    void spill(SpillFile &file) override;
+
+    bool load() override;
 };
 
 
@@ -98,11 +223,26 @@ public:
 class ChangeShapeCommand : public Command
 {
 private:
+    // 修改后点列中[start, start + count)区间在修改前为points
+    struct PointsDelta
+    {
+        size_t start = 0;
+        size_t count = 0;
+        std::vector<Geo::Point> points;
+    };
+
     std::vector<std::tuple<double, double>> _shape;
     std::vector<std::tuple<double, double>> _path_points;
     std::vector<double> _knots;
+    std::vector<PointsDelta> _shape_delta, _path_delta; // 压缩后只保存变化的区间
+    bool _compressed = false;
     Geo::Geometry *_object;
 
+private:
+    static std::vector<PointsDelta> diff(const std::vector<std::tuple<double, double>> &before, const std::vector<Geo::Point> &after);
+
+    static std::vector<std::tuple<double, double>> restore(const std::vector<PointsDelta> &delta, std::vector<Geo::Point> points);
+
 public:
     ChangeShapeCommand(Geo::Geometry *object, const std::vector<std::tuple<double, double>> &shape);
 
@@ -110,6 +250,11 @@ public:
                        const std::vector<std::tuple<double, double>> &path_points, const std::vector<double> &knots);
 
     void undo(Graph *graph = nullptr) override;
+
+    // 折线、多边形和曲线的点列与当前图形比较,只保存变化的区间
+    void compress() override;
+
+    size_t memory_size() const override;
 };
 
 
@@ -203,13 +348,23 @@ private:
     size_t _index = 0;
     bool _add = true;
     ContainerGroup _group;
+    std::vector<SpillFile::Record> _spilled;
+    SpillFile *_spill_file = nullptr;
 
 public:
     GroupCommand(const size_t index, const bool add);
 
     GroupCommand(const size_t index, const bool add, ContainerGroup &group);
 
+    ~GroupCommand() override;
+
     void undo(Graph *graph = nullptr) override;
+
+    size_t memory_size() const override;
+
+    void spill(SpillFile &file) override;
+
+    bool load() override;
 };
 
 
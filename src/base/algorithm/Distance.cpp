@@ -256,13 +256,7 @@ double Geo::distance(const Point &point, const BSpline &bspline, const bool is_c
     double min_dis[2] = {DBL_MAX, DBL_MAX};
     while (t <= knots[nplusc - 1])
     {
-        std::vector<double> nbasis;
-        Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-        Geo::Point coord;
-        for (size_t i = 0; i < npts; ++i)
-        {
-            coord += bspline.control_points[i] * nbasis[i];
-        }
+        const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, npts, knots, bspline.control_points);
         if (double dis = Geo::distance(coord, point); dis < min_dis[0])
         {
             temp.clear();
@@ -291,13 +285,7 @@ double Geo::distance(const Point &point, const BSpline &bspline, const bool is_c
             for (double x = lower; x < upper + step; x += step)
             {
                 x = x < upper ? x : upper;
-                std::vector<double> nbasis;
-                Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                Geo::Point coord;
-                for (size_t i = 0; i < npts; ++i)
-                {
-                    coord += bspline.control_points[i] * nbasis[i];
-                }
+                const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                 if (double dis = Geo::distance(point, coord); dis < min_dis[1])
                 {
                     min_dis[1] = dis;
@@ -322,13 +310,7 @@ double Geo::distance(const Point &point, const BSpline &bspline, const bool is_c
             for (double x = lower, dis0 = 0; x < upper + step; x += step)
             {
                 x = x < upper ? x : upper;
-                std::vector<double> nbasis;
-                Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                Geo::Point coord;
-                for (size_t i = 0; i < npts; ++i)
-                {
-                    coord += bspline.control_points[i] * nbasis[i];
-                }
+                const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                 if (double dis = Geo::distance(coord, point); dis < min_dis[1])
                 {
                     min_dis[1] = dis;
@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <cmath>
+#include "base/algorithm/HashGrid.hpp"
+
+
+namespace Geo
+{
+HashGrid::HashGrid(const double cell_size) : _cell_size(cell_size > 0 && std::isfinite(cell_size) ? cell_size : 1)
+{
+}
+
+void HashGrid::fit(const AABBRectParams &rect, const size_t count, const double min_size)
+{
+    const double width = rect.right - rect.left, height = rect.top - rect.bottom;
+    _cell_size = count == 0 ? 0 : std::sqrt(width * height / count);
+    if (!(_cell_size > 0) || !std::isfinite(_cell_size))
+    {
+        // 退化为线段或点时按长边均分
+        _cell_size = count == 0 ? 0 : std::max(width, height) / count;
+    }
+    _cell_size = std::max(_cell_size, min_size);
+    if (!(_cell_size > 0) || !std::isfinite(_cell_size))
+    {
+        _cell_size = 1;
+    }
+}
+
+double HashGrid::cell_size() const
+{
+    return _cell_size;
+}
+
+long long HashGrid::index(const double value) const
+{
+    return static_cast<long long>(std::clamp(std::floor(value / _cell_size), -1e9, 1e9));
+}
+
+unsigned long long HashGrid::key(const Point &point) const
+{
+    return key(index(point.x), index(point.y));
+}
+
+unsigned long long HashGrid::key(const long long col, const long long row)
+{
+    return (static_cast<unsigned long long>(static_cast<unsigned int>(col)) << 32) | static_cast<unsigned int>(row);
+}
+} // namespace Geo
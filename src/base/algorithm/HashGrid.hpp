@@ -0,0 +1,29 @@
+#pragma once
+#include "base/Geometry.hpp"
+
+
+namespace Geo
+{
+// 均匀网格的坐标换算,网格键由行列号的低32位拼成,负的行列号也不会产生未定义行为
+class HashGrid
+{
+private:
+    double _cell_size = 1;
+
+public:
+    HashGrid() = default;
+
+    explicit HashGrid(const double cell_size);
+
+    // 由范围rect和元素数量count确定网格边长,平均每个网格约一个元素,边长不小于min_size
+    void fit(const AABBRectParams &rect, const size_t count, const double min_size = 0);
+
+    double cell_size() const;
+
+    long long index(const double value) const;
+
+    unsigned long long key(const Point &point) const;
+
+    static unsigned long long key(const long long col, const long long row);
+};
+} // namespace Geo
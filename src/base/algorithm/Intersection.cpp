@@ -590,13 +590,7 @@ int Geo::is_intersected(const Point &point0, const Point &point1, const BSpline
     double min_dis[2] = {1, 1};
     while (t <= knots[nplusc - 1])
     {
-        std::vector<double> nbasis;
-        Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-        Geo::Point coord;
-        for (size_t i = 0; i < npts; ++i)
-        {
-            coord += bspline.control_points[i] * nbasis[i];
-        }
+        const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, npts, knots, bspline.control_points);
         const double dis = Geo::distance(coord, point0, point1, infinite);
         if (min_dis[0] > min_dis[1] && dis > min_dis[1])
         {
@@ -623,13 +617,7 @@ int Geo::is_intersected(const Point &point0, const Point &point1, const BSpline
             for (double x = lower; x < upper + step; x += step)
             {
                 x = x < upper ? x : upper;
-                std::vector<double> nbasis;
-                Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                Geo::Point coord;
-                for (size_t i = 0; i < npts; ++i)
-                {
-                    coord += bspline.control_points[i] * nbasis[i];
-                }
+                const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                 if (double dis = Geo::distance(coord, point0, point1, infinite); dis < min_dis[1])
                 {
                     min_dis[1] = dis;
@@ -659,13 +647,7 @@ int Geo::is_intersected(const Point &point0, const Point &point1, const BSpline
             for (double x = lower, dis0 = 0; x < upper + step; x += step)
             {
                 x = x < upper ? x : upper;
-                std::vector<double> nbasis;
-                Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                Geo::Point coord;
-                for (size_t i = 0; i < npts; ++i)
-                {
-                    coord += bspline.control_points[i] * nbasis[i];
-                }
+                const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                 if (const double dis = Geo::distance(coord, point0, point1, infinite) * 1e9; dis < min_dis[1])
                 {
                     min_dis[1] = dis;
@@ -731,13 +713,7 @@ int Geo::is_intersected(const Point &point0, const Point &point1, const BSpline
             }
         }
 
-        std::vector<double> nbasis;
-        Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-        Geo::Point coord;
-        for (size_t i = 0; i < npts; ++i)
-        {
-            coord += bspline.control_points[i] * nbasis[i];
-        }
+        const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, npts, knots, bspline.control_points);
         if (std::find(result.begin(), result.end(), coord) == result.end() && Geo::is_inside(coord, point0, point1, infinite))
         {
             result.emplace_back(coord);
@@ -1120,180 +1096,78 @@ int Geo::is_intersected(const Circle &circle, const Arc &arc, Point &output0, Po
     }
 }
 
-int Geo::is_intersected(const Ellipse &ellipse0, const Ellipse &ellipse1, Point &point0, Point &point1, Point &point2, Point &point3)
+namespace
 {
-    if (!Geo::is_intersected(ellipse0.aabbrect_params(), ellipse1.aabbrect_params()))
+// 以origin为原点、scale为单位长度的坐标系下椭圆一般方程的系数,写入param的第index组
+void set_ellipse_parameter(const Geo::Point &center, const double theta, const double a, const double b, const Geo::Point &origin,
+                           const double scale, Math::EllipseParameter &param, const int index)
+{
+    const double x = (center.x - origin.x) / scale, y = (center.y - origin.y) / scale;
+    const double sin = std::sin(theta), cos = std::cos(theta), a2 = std::pow(scale / a, 2), b2 = std::pow(scale / b, 2);
+    param.a[index] = sin * sin * b2 + cos * cos * a2;
+    param.b[index] = 2 * (a2 - b2) * sin * cos;
+    param.c[index] = cos * cos * b2 + sin * sin * a2;
+    param.d[index] = -(2 * param.a[index] * x + param.b[index] * y);
+    param.e[index] = -(2 * param.c[index] * y + param.b[index] * x);
+    param.f[index] = -(param.d[index] * x + param.e[index] * y) / 2 - 1;
+}
+
+void set_ellipse_parameter(const Geo::Ellipse &ellipse, const Geo::Point &origin, const double scale, Math::EllipseParameter &param,
+                           const int index)
+{
+    set_ellipse_parameter(ellipse.center(), Geo::angle(ellipse.a0(), ellipse.a1()), ellipse.lengtha(), ellipse.lengthb(), origin, scale,
+                          param, index);
+}
+
+// 求param中两条二次曲线的交点并变换回原坐标系
+int conic_intersections(const Math::EllipseParameter &param, const Geo::Point &origin, const double scale, Geo::Point *output)
+{
+    double x[4], y[4];
+    const int count = Math::solve_ellipse_ellipse_intersection(param, x, y);
+    for (int i = 0; i < count; ++i)
     {
-        return 0;
+        output[i].x = origin.x + x[i] * scale;
+        output[i].y = origin.y + y[i] * scale;
     }
+    return count;
+}
 
-    const Geo::Polyline &polyline0 = ellipse0.shape();
-    const Geo::Polyline &polyline1 = ellipse1.shape();
-    std::vector<Geo::Point> points;
-    for (size_t i = 1, count0 = polyline0.size(); i < count0; ++i)
+// 移除不在椭圆弧上的交点,返回剩余交点数量
+int remove_off_arc_points(const Geo::Ellipse &ellipse, Geo::Point *points, const int count)
+{
+    if (!ellipse.is_arc())
     {
-        Geo::Point point;
-        for (size_t j = 1, count1 = polyline1.size(); j < count1; ++j)
-        {
-            if (Geo::is_intersected(polyline0[i - 1], polyline0[i], polyline1[j - 1], polyline1[j], point, false) &&
-                std::find(points.cbegin(), points.cend(), point) == points.cend())
-            {
-                points.emplace_back(point);
-            }
-        }
+        return count;
     }
+    int result = 0;
+    for (int i = 0; i < count; ++i)
     {
-        const double eps = Geo::EPSILON;
-        if (ellipse0.is_arc())
-        {
-            if (Geo::distance(ellipse0.arc_point0(), ellipse1) < eps)
-            {
-                points.emplace_back(ellipse0.arc_point0());
-            }
-            if (Geo::distance(ellipse0.arc_point1(), ellipse1) < eps)
-            {
-                points.emplace_back(ellipse0.arc_point1());
-            }
-        }
-        if (ellipse1.is_arc())
+        if (Geo::distance(points[i], ellipse) < Geo::EPSILON)
         {
-            if (Geo::distance(ellipse1.arc_point0(), ellipse0) < eps)
-            {
-                points.emplace_back(ellipse1.arc_point0());
-            }
-            if (Geo::distance(ellipse1.arc_point1(), ellipse0) < eps)
-            {
-                points.emplace_back(ellipse1.arc_point1());
-            }
+            points[result++] = points[i];
         }
     }
+    return result;
+}
+} // namespace
 
-    if (points.empty())
+int Geo::is_intersected(const Ellipse &ellipse0, const Ellipse &ellipse1, Point &point0, Point &point1, Point &point2, Point &point3)
+{
+    if (!Geo::is_intersected(ellipse0.aabbrect_params(), ellipse1.aabbrect_params()))
     {
         return 0;
     }
 
-    if (points.size() > 4)
-    {
-        std::vector<std::tuple<size_t, size_t, double>> distance_table;
-        std::vector<size_t> remove_index;
-        for (size_t i = 0, count = points.size(); i < count; ++i)
-        {
-            for (size_t j = i + 1; j < count; ++j)
-            {
-                distance_table.emplace_back(i, j, Geo::distance_square(points[i], points[j]));
-            }
-        }
-        std::sort(distance_table.begin(), distance_table.end(),
-                  [](const std::tuple<size_t, size_t, double> &a, const std::tuple<size_t, size_t, double> &b)
-                  { return std::get<2>(a) > std::get<2>(b); });
-        while (points.size() - remove_index.size() > 4)
-        {
-            const size_t index = std::get<1>(distance_table.back());
-            remove_index.push_back(index);
-            distance_table.pop_back();
-            for (size_t i = distance_table.size() - 1; i > 0; --i)
-            {
-                if (std::get<1>(distance_table[i]) == index || std::get<0>(distance_table[i]) == index)
-                {
-                    distance_table.erase(distance_table.begin() + i);
-                }
-            }
-            if (std::get<1>(distance_table.front()) == index || std::get<0>(distance_table.front()) == index)
-            {
-                distance_table.erase(distance_table.begin());
-            }
-        }
-        std::sort(remove_index.begin(), remove_index.end(), std::greater<>());
-        for (const size_t index : remove_index)
-        {
-            points.erase(points.begin() + index);
-        }
-    }
-
-    const Geo::Point center0 = ellipse0.center(), center1 = ellipse1.center();
-    const double theta0 = Geo::angle(ellipse0.a0(), ellipse0.a1()), theta1 = Geo::angle(ellipse1.a0(), ellipse1.a1());
-    const double a0 = ellipse0.lengtha(), b0 = ellipse0.lengthb(), a1 = ellipse1.lengtha(), b1 = ellipse1.lengthb();
-    const double A0 = std::pow(std::sin(theta0) / b0, 2) + std::pow(std::cos(theta0) / a0, 2),
-                 A1 = std::pow(std::sin(theta1) / b1, 2) + std::pow(std::cos(theta1) / a1, 2);
-    const double B0 = 2 * (std::pow(1 / a0, 2) - std::pow(1 / b0, 2)) * std::sin(theta0) * std::cos(theta0),
-                 B1 = 2 * (std::pow(1 / a1, 2) - std::pow(1 / b1, 2)) * std::sin(theta1) * std::cos(theta1);
-    const double C0 = std::pow(std::cos(theta0) / b0, 2) + std::pow(std::sin(theta0) / a0, 2),
-                 C1 = std::pow(std::cos(theta1) / b1, 2) + std::pow(std::sin(theta1) / a1, 2);
-    const double D0 = -(2 * A0 * center0.x + B0 * center0.y), D1 = -(2 * A1 * center1.x + B1 * center1.y);
-    const double E0 = -(2 * C0 * center0.y + B0 * center0.x), E1 = -(2 * C1 * center1.y + B1 * center1.x);
-    const double F0 = -(D0 * center0.x + E0 * center0.y) / 2 - 1, F1 = -(D1 * center1.x + E1 * center1.y) / 2 - 1;
-
+    const Geo::Point origin(ellipse0.center());
+    const double scale = std::max(ellipse0.lengtha(), ellipse0.lengthb());
     Math::EllipseParameter param;
-    param.a[0] = A0, param.a[1] = A1;
-    param.b[0] = B0, param.b[1] = B1;
-    param.c[0] = C0, param.c[1] = C1;
-    param.d[0] = D0, param.d[1] = D1;
-    param.e[0] = E0, param.e[1] = E1;
-    param.f[0] = F0, param.f[1] = F1;
-    const double eps = Geo::EPSILON;
-    switch (points.size())
-    {
-    case 4:
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, points[3].x, points[3].y);
-            points[3].x = x, points[3].y = y;
-            if (ellipse0.is_arc() && Geo::distance(points[3], ellipse0) >= eps)
-            {
-                points.pop_back();
-            }
-            else if (ellipse1.is_arc() && Geo::distance(points[3], ellipse1) >= eps)
-            {
-                points.pop_back();
-            }
-        }
-        [[fallthrough]];
-    case 3:
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, points[2].x, points[2].y);
-            points[2].x = x, points[2].y = y;
-            if (ellipse0.is_arc() && Geo::distance(points[2], ellipse0) >= eps)
-            {
-                points.erase(points.begin() + 2);
-            }
-            else if (ellipse1.is_arc() && Geo::distance(points[2], ellipse1) >= eps)
-            {
-                points.erase(points.begin() + 2);
-            }
-        }
-        [[fallthrough]];
-    case 2:
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, points[1].x, points[1].y);
-            points[1].x = x, points[1].y = y;
-            if (ellipse0.is_arc() && Geo::distance(points[1], ellipse0) >= eps)
-            {
-                points.erase(points.begin() + 1);
-            }
-            else if (ellipse1.is_arc() && Geo::distance(points[1], ellipse1) >= eps)
-            {
-                points.erase(points.begin() + 1);
-            }
-        }
-        [[fallthrough]];
-    case 1:
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, points[0].x, points[0].y);
-            points[0].x = x, points[0].y = y;
-            if (ellipse0.is_arc() && Geo::distance(points[0], ellipse0) >= eps)
-            {
-                points.erase(points.begin());
-            }
-            else if (ellipse1.is_arc() && Geo::distance(points[0], ellipse1) >= eps)
-            {
-                points.erase(points.begin());
-            }
-        }
-        break;
-    default:
-        break;
-    }
-    switch (points.size())
+    set_ellipse_parameter(ellipse0, origin, scale, param, 0);
+    set_ellipse_parameter(ellipse1, origin, scale, param, 1);
+    Geo::Point points[4];
+    int count = conic_intersections(param, origin, scale, points);
+    count = remove_off_arc_points(ellipse0, points, count);
+    count = remove_off_arc_points(ellipse1, points, count);
+    switch (count)
     {
     case 4:
         point3 = points[3];
@@ -1307,153 +1181,53 @@ int Geo::is_intersected(const Ellipse &ellipse0, const Ellipse &ellipse1, Point
     default:
         break;
     }
-    return points.size();
+    return count;
 }
 
-int Geo::is_intersected(const Circle &circle, const Ellipse &ellipse, Point &point0, Point &point1, Point &point2, Point &point3)
+int Geo::is_intersected(const Ellipse &ellipse, const std::vector<const Ellipse *> &ellipses, std::vector<Point> &intersections,
+                        std::vector<size_t> *indices)
 {
-    if (!Geo::is_intersected(circle.aabbrect_params(), ellipse.aabbrect_params()))
-    {
-        return 0;
-    }
-
-    const Geo::Polygon &polygon = circle.shape();
-    const Geo::Polyline &polyline = ellipse.shape();
-    std::vector<Geo::Point> points;
-    for (size_t i = 1, count0 = polygon.size(); i < count0; ++i)
-    {
-        Geo::Point point;
-        for (size_t j = 1, count1 = polyline.size(); j < count1; ++j)
-        {
-            if (Geo::is_intersected(polygon[i - 1], polygon[i], polyline[j - 1], polyline[j], point, false) &&
-                std::find(points.cbegin(), points.cend(), point) == points.cend())
-            {
-                points.emplace_back(point);
-            }
-        }
-    }
-    if (ellipse.is_arc())
+    const size_t count = intersections.size();
+    const Geo::AABBRectParams rect = ellipse.aabbrect_params();
+    const Geo::Point origin(ellipse.center());
+    const double scale = std::max(ellipse.lengtha(), ellipse.lengthb());
+    Math::EllipseParameter param;
+    set_ellipse_parameter(ellipse, origin, scale, param, 0);
+    for (size_t i = 0, size = ellipses.size(); i < size; ++i)
     {
-        const double eps = Geo::EPSILON;
-        if (std::abs(Geo::distance(ellipse.arc_point0(), circle) - circle.radius) < eps)
+        if (ellipses[i] == &ellipse || !Geo::is_intersected(rect, ellipses[i]->aabbrect_params()))
         {
-            points.emplace_back(ellipse.arc_point0());
+            continue;
         }
-        if (std::abs(Geo::distance(ellipse.arc_point1(), circle) - circle.radius) < eps)
+        set_ellipse_parameter(*ellipses[i], origin, scale, param, 1);
+        Geo::Point points[4];
+        int num = conic_intersections(param, origin, scale, points);
+        num = remove_off_arc_points(ellipse, points, num);
+        num = remove_off_arc_points(*ellipses[i], points, num);
+        intersections.insert(intersections.end(), points, points + num);
+        if (indices != nullptr)
         {
-            points.emplace_back(ellipse.arc_point1());
+            indices->insert(indices->end(), num, i);
         }
     }
+    return intersections.size() - count;
+}
 
-    if (points.empty())
+int Geo::is_intersected(const Circle &circle, const Ellipse &ellipse, Point &point0, Point &point1, Point &point2, Point &point3)
+{
+    if (!Geo::is_intersected(circle.aabbrect_params(), ellipse.aabbrect_params()))
     {
         return 0;
     }
 
-    if (points.size() > 4)
-    {
-        std::vector<std::tuple<size_t, size_t, double>> distance_table;
-        std::vector<size_t> remove_index;
-        for (size_t i = 0, count = points.size(); i < count; ++i)
-        {
-            for (size_t j = i + 1; j < count; ++j)
-            {
-                distance_table.emplace_back(i, j, Geo::distance_square(points[i], points[j]));
-            }
-        }
-        std::sort(distance_table.begin(), distance_table.end(),
-                  [](const std::tuple<size_t, size_t, double> &a, const std::tuple<size_t, size_t, double> &b)
-                  { return std::get<2>(a) > std::get<2>(b); });
-        while (points.size() - remove_index.size() > 4)
-        {
-            const size_t index = std::get<1>(distance_table.back());
-            remove_index.push_back(index);
-            distance_table.pop_back();
-            for (size_t i = distance_table.size() - 1; i > 0; --i)
-            {
-                if (std::get<1>(distance_table[i]) == index || std::get<0>(distance_table[i]) == index)
-                {
-                    distance_table.erase(distance_table.begin() + i);
-                }
-            }
-            if (std::get<1>(distance_table.front()) == index || std::get<0>(distance_table.front()) == index)
-            {
-                distance_table.erase(distance_table.begin());
-            }
-        }
-        std::sort(remove_index.begin(), remove_index.end(), std::greater<>());
-        for (const size_t index : remove_index)
-        {
-            points.erase(points.begin() + index);
-        }
-    }
-
-    const Geo::Point &center0 = circle;
-    const Geo::Point center1 = ellipse.center();
-    const double theta0 = 0, theta1 = Geo::angle(ellipse.a0(), ellipse.a1());
-    const double a0 = circle.radius, b0 = circle.radius, a1 = ellipse.lengtha(), b1 = ellipse.lengthb();
-    const double A0 = std::pow(1 / a0, 2), A1 = std::pow(std::sin(theta1) / b1, 2) + std::pow(std::cos(theta1) / a1, 2);
-    const double B0 = 2 * (std::pow(1 / a0, 2) - std::pow(1 / b0, 2)) * std::sin(theta0) * std::cos(theta0),
-                 B1 = 2 * (std::pow(1 / a1, 2) - std::pow(1 / b1, 2)) * std::sin(theta1) * std::cos(theta1);
-    const double C0 = std::pow(1 / b0, 2), C1 = std::pow(std::cos(theta1) / b1, 2) + std::pow(std::sin(theta1) / a1, 2);
-    const double D0 = -(2 * A0 * center0.x + B0 * center0.y), D1 = -(2 * A1 * center1.x + B1 * center1.y);
-    const double E0 = -(2 * C0 * center0.y + B0 * center0.x), E1 = -(2 * C1 * center1.y + B1 * center1.x);
-    const double F0 = -(D0 * center0.x + E0 * center0.y) / 2 - 1, F1 = -(D1 * center1.x + E1 * center1.y) / 2 - 1;
-
+    const Geo::Point &origin = circle;
+    const double scale = circle.radius;
     Math::EllipseParameter param;
-    param.a[0] = A0, param.a[1] = A1;
-    param.b[0] = B0, param.b[1] = B1;
-    param.c[0] = C0, param.c[1] = C1;
-    param.d[0] = D0, param.d[1] = D1;
-    param.e[0] = E0, param.e[1] = E1;
-    param.f[0] = F0, param.f[1] = F1;
-    const double eps = Geo::EPSILON;
-    switch (points.size())
-    {
-    case 4:
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, points[3].x, points[3].y);
-            points[3].x = x, points[3].y = y;
-            if (ellipse.is_arc() && Geo::distance(points[3], ellipse) >= eps)
-            {
-                points.pop_back();
-            }
-        }
-        [[fallthrough]];
-    case 3:
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, points[2].x, points[2].y);
-            points[2].x = x, points[2].y = y;
-            if (ellipse.is_arc() && Geo::distance(points[2], ellipse) >= eps)
-            {
-                points.erase(points.begin() + 2);
-            }
-        }
-        [[fallthrough]];
-    case 2:
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, points[1].x, points[1].y);
-            points[1].x = x, points[1].y = y;
-            if (ellipse.is_arc() && Geo::distance(points[1], ellipse) >= eps)
-            {
-                points.erase(points.begin() + 1);
-            }
-        }
-        [[fallthrough]];
-    case 1:
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, points[0].x, points[0].y);
-            points[0].x = x, points[0].y = y;
-            if (ellipse.is_arc() && Geo::distance(points[0], ellipse) >= eps)
-            {
-                points.erase(points.begin());
-            }
-        }
-        break;
-    default:
-        break;
-    }
-    switch (points.size())
+    set_ellipse_parameter(circle, 0, circle.radius, circle.radius, origin, scale, param, 0);
+    set_ellipse_parameter(ellipse, origin, scale, param, 1);
+    Geo::Point points[4];
+    const int count = remove_off_arc_points(ellipse, points, conic_intersections(param, origin, scale, points));
+    switch (count)
     {
     case 4:
         point3 = points[3];
@@ -1467,7 +1241,7 @@ int Geo::is_intersected(const Circle &circle, const Ellipse &ellipse, Point &poi
     default:
         break;
     }
-    return points.size();
+    return count;
 }
 
 int Geo::is_intersected(const Ellipse &ellipse, const Arc &arc, Point &point0, Point &point1, Point &point2, Point &point3)
@@ -1843,13 +1617,7 @@ int Geo::is_intersected(const Circle &circle, const BSpline &bspline, const bool
         std::vector<double> min_dis(temp_points.size(), DBL_MAX);
         while (t <= knots[nplusc - 1])
         {
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts; ++i)
-            {
-                coord += bspline.control_points[i] * nbasis[i];
-            }
+            const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, npts, knots, bspline.control_points);
             for (size_t i = 0, count = temp_points.size(); i < count; ++i)
             {
                 if (const double dis = Geo::distance(coord, temp_points[i]); dis < min_dis[i])
@@ -1878,13 +1646,7 @@ int Geo::is_intersected(const Circle &circle, const BSpline &bspline, const bool
             for (double x = lower; x < upper + step; x += step)
             {
                 x = x < upper ? x : upper;
-                std::vector<double> nbasis;
-                Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                Geo::Point coord;
-                for (size_t i = 0; i < npts; ++i)
-                {
-                    coord += bspline.control_points[i] * nbasis[i];
-                }
+                const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                 if (double dis = Geo::distance(point, coord); dis < min_dis)
                 {
                     min_dis = dis;
@@ -1912,13 +1674,7 @@ int Geo::is_intersected(const Circle &circle, const BSpline &bspline, const bool
             for (double x = lower, dis0 = 0; x < upper + step; x += step)
             {
                 x = x < upper ? x : upper;
-                std::vector<double> nbasis;
-                Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                Geo::Point coord;
-                for (size_t i = 0; i < npts; ++i)
-                {
-                    coord += bspline.control_points[i] * nbasis[i];
-                }
+                const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                 if (const double dis = std::abs(Geo::distance(coord, circle) - circle.radius) * 1e9; dis < min_dis)
                 {
                     min_dis = dis;
@@ -1984,13 +1740,7 @@ int Geo::is_intersected(const Circle &circle, const BSpline &bspline, const bool
             }
         }
 
-        std::vector<double> nbasis;
-        Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-        point.clear();
-        for (size_t i = 0; i < npts; ++i)
-        {
-            point += bspline.control_points[i] * nbasis[i];
-        }
+        point = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, npts, knots, bspline.control_points);
         if (std::find(result.begin(), result.end(), point) == result.end() &&
             std::abs(Geo::distance(point, circle) - circle.radius) < Geo::EPSILON)
         {
@@ -2252,13 +2002,7 @@ int Geo::is_intersected(const Ellipse &ellipse, const BSpline &bspline, const bo
         std::vector<double> min_dis(temp_points.size(), DBL_MAX);
         while (t <= knots[nplusc - 1])
         {
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts; ++i)
-            {
-                coord += bspline.control_points[i] * nbasis[i];
-            }
+            const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, npts, knots, bspline.control_points);
             for (size_t i = 0, count = temp_points.size(); i < count; ++i)
             {
                 if (const double dis = Geo::distance(coord, temp_points[i]); dis < min_dis[i])
@@ -2288,13 +2032,7 @@ int Geo::is_intersected(const Ellipse &ellipse, const BSpline &bspline, const bo
             for (double x = lower; x < upper + step; x += step)
             {
                 x = x < upper ? x : upper;
-                std::vector<double> nbasis;
-                Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                Geo::Point coord;
-                for (size_t i = 0; i < npts; ++i)
-                {
-                    coord += bspline.control_points[i] * nbasis[i];
-                }
+                const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                 if (double dis = Geo::distance(point, coord); dis < min_dis)
                 {
                     min_dis = dis;
@@ -2322,13 +2060,7 @@ int Geo::is_intersected(const Ellipse &ellipse, const BSpline &bspline, const bo
             for (double x = lower, dis0 = 0; x < upper + step; x += step)
             {
                 x = x < upper ? x : upper;
-                std::vector<double> nbasis;
-                Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                Geo::Point coord;
-                for (size_t i = 0; i < npts; ++i)
-                {
-                    coord += bspline.control_points[i] * nbasis[i];
-                }
+                const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                 if (const double dis = Geo::distance(coord, ellipse) * 1e9; dis < min_dis)
                 {
                     min_dis = dis;
@@ -2394,13 +2126,7 @@ int Geo::is_intersected(const Ellipse &ellipse, const BSpline &bspline, const bo
             }
         }
 
-        std::vector<double> nbasis;
-        Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-        point.clear();
-        for (size_t i = 0; i < npts; ++i)
-        {
-            point += bspline.control_points[i] * nbasis[i];
-        }
+        point = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, npts, knots, bspline.control_points);
         if (std::find(result.begin(), result.end(), point) == result.end() && Geo::distance(point, ellipse) < eps)
         {
             result.emplace_back(point);
@@ -2494,152 +2220,314 @@ int Geo::is_intersected(const Arc &arc, const BSpline &bspline, const bool is_cu
     return temp_intersections.size();
 }
 
-int Geo::is_intersected(const CubicBezier &bezier0, const CubicBezier &bezier1, std::vector<Point> &intersections,
-                        std::vector<std::tuple<size_t, double, double, double>> *tvalues0,
-                        std::vector<std::tuple<size_t, double, double, double>> *tvalues1)
+namespace
 {
-    const int order = 3;
-    const int nums[4] = {1, 3, 3, 1};
-    const size_t count = intersections.size();
-    for (size_t p = 0, end0 = bezier0.size() - order; p < end0; p += order)
+// 曲线分解得到的Bezier曲线段,[u0, u1]为其在原曲线上的参数区间,[t0, t1]为细分后在该段上的局部参数区间
+struct BezierPiece
+{
+    double x[4] = {0, 0, 0, 0};
+    double y[4] = {0, 0, 0, 0};
+    int order = 3;
+    size_t segment = 0;
+    double u0 = 0, u1 = 1;
+    double t0 = 0, t1 = 1;
+    double left = 0, right = 0, bottom = 0, top = 0;
+};
+
+struct PieceIntersection
+{
+    size_t segment0 = 0, segment1 = 0;
+    double t0 = 0, t1 = 0;
+    Geo::Point point0, point1;
+};
+
+void update_piece_rect(BezierPiece &piece)
+{
+    piece.left = piece.right = piece.x[0];
+    piece.bottom = piece.top = piece.y[0];
+    for (int i = 1; i <= piece.order; ++i)
+    {
+        piece.left = std::min(piece.left, piece.x[i]);
+        piece.right = std::max(piece.right, piece.x[i]);
+        piece.bottom = std::min(piece.bottom, piece.y[i]);
+        piece.top = std::max(piece.top, piece.y[i]);
+    }
+}
+
+bool is_piece_intersected(const BezierPiece &piece0, const BezierPiece &piece1, const double tolerance)
+{
+    return piece0.left <= piece1.right + tolerance && piece1.left <= piece0.right + tolerance &&
+           piece0.bottom <= piece1.top + tolerance && piece1.bottom <= piece0.top + tolerance;
+}
+
+// de Casteljau算法从中点分为两段
+void split_piece(const BezierPiece &piece, BezierPiece &piece0, BezierPiece &piece1)
+{
+    piece0 = piece1 = piece;
+    double x[4], y[4];
+    std::copy(piece.x, piece.x + 4, x);
+    std::copy(piece.y, piece.y + 4, y);
+    piece0.x[0] = x[0], piece0.y[0] = y[0];
+    piece1.x[piece.order] = x[piece.order], piece1.y[piece.order] = y[piece.order];
+    for (int r = 1; r <= piece.order; ++r)
     {
-        Geo::Polyline polyline0;
-        for (double t = 0; t <= 1; t += Geo::CubicBezier::default_step)
+        for (int i = 0; i <= piece.order - r; ++i)
         {
-            Geo::Point point;
-            for (int j = 0; j <= order; ++j)
-            {
-                point += (bezier0[j + p] * (nums[j] * std::pow(1 - t, order - j) * std::pow(t, j)));
-            }
-            polyline0.append(point);
+            x[i] = (x[i] + x[i + 1]) / 2;
+            y[i] = (y[i] + y[i + 1]) / 2;
         }
-        polyline0.append(bezier0[p + order]);
-        Geo::down_sampling(polyline0, Geo::CubicBezier::default_down_sampling_value);
+        piece0.x[r] = x[0], piece0.y[r] = y[0];
+        piece1.x[piece.order - r] = x[piece.order - r], piece1.y[piece.order - r] = y[piece.order - r];
+    }
+    piece0.t1 = piece1.t0 = (piece.t0 + piece.t1) / 2;
+    update_piece_rect(piece0);
+    update_piece_rect(piece1);
+}
 
-        for (size_t q = 0, end1 = bezier1.size() - order; q < end1; q += order)
+// 内部控制点到首尾连线的距离均不超过tolerance
+bool is_piece_flat(const BezierPiece &piece, const double tolerance)
+{
+    const double dx = piece.x[piece.order] - piece.x[0], dy = piece.y[piece.order] - piece.y[0];
+    const double length = std::hypot(dx, dy);
+    for (int i = 1; i < piece.order; ++i)
+    {
+        const double px = piece.x[i] - piece.x[0], py = piece.y[i] - piece.y[0];
+        if ((length > 0 ? std::abs(px * dy - py * dx) / length : std::hypot(px, py)) > tolerance)
         {
-            Geo::Polyline polyline1;
-            for (double t = 0; t <= 1; t += Geo::CubicBezier::default_step)
-            {
-                Geo::Point point;
-                for (int j = 0; j <= order; ++j)
-                {
-                    point += (bezier1[j + q] * (nums[j] * std::pow(1 - t, order - j) * std::pow(t, j)));
-                }
-                polyline1.append(point);
-            }
-            polyline1.append(bezier1[q + order]);
-            Geo::down_sampling(polyline1, Geo::CubicBezier::default_down_sampling_value);
+            return false;
+        }
+    }
+    return true;
+}
+
+void piece_point(const BezierPiece &piece, const double t, double &px, double &py, double &dx, double &dy)
+{
+    double x[4], y[4];
+    std::copy(piece.x, piece.x + 4, x);
+    std::copy(piece.y, piece.y + 4, y);
+    for (int r = 1; r <= piece.order; ++r)
+    {
+        if (r == piece.order)
+        {
+            dx = (x[1] - x[0]) * piece.order;
+            dy = (y[1] - y[0]) * piece.order;
+        }
+        for (int i = 0; i <= piece.order - r; ++i)
+        {
+            x[i] += (x[i + 1] - x[i]) * t;
+            y[i] += (y[i + 1] - y[i]) * t;
+        }
+    }
+    px = x[0], py = y[0];
+}
 
-            if (!Geo::is_intersected(polyline0.aabbrect_params(), polyline1.aabbrect_params(), true))
+// 牛顿迭代求解piece0(t0) = piece1(t1),返回两点距离
+double refine_piece_intersection(const BezierPiece &piece0, const BezierPiece &piece1, double &t0, double &t1)
+{
+    double x0, y0, dx0, dy0, x1, y1, dx1, dy1;
+    piece_point(piece0, t0, x0, y0, dx0, dy0);
+    piece_point(piece1, t1, x1, y1, dx1, dy1);
+    double best_t0 = t0, best_t1 = t1, best_distance = std::hypot(x0 - x1, y0 - y1);
+    for (int i = 0; i < 16 && best_distance > 1e-13; ++i)
+    {
+        const double fx = x0 - x1, fy = y0 - y1;
+        const double det = dx1 * dy0 - dx0 * dy1;
+        if (std::abs(det) < 1e-300)
+        {
+            break;
+        }
+        const double dt0 = (dx1 * fy - dy1 * fx) / det, dt1 = (dx0 * fy - dy0 * fx) / det;
+        t0 = std::clamp(t0 - dt0, 0.0, 1.0);
+        t1 = std::clamp(t1 - dt1, 0.0, 1.0);
+        piece_point(piece0, t0, x0, y0, dx0, dy0);
+        piece_point(piece1, t1, x1, y1, dx1, dy1);
+        if (const double distance = std::hypot(x0 - x1, y0 - y1); distance < best_distance)
+        {
+            best_distance = distance;
+            best_t0 = t0;
+            best_t1 = t1;
+        }
+        else
+        {
+            break;
+        }
+    }
+    t0 = best_t0, t1 = best_t1;
+    return best_distance;
+}
+
+// 递归细分求两组Bezier曲线段的交点,包围盒不相交的子段直接舍弃,子段足够平直时用弦的交点作为初值迭代求精
+void intersect_pieces(const std::vector<BezierPiece> &pieces0, const std::vector<BezierPiece> &pieces1,
+                      std::vector<PieceIntersection> &output)
+{
+    std::vector<std::tuple<BezierPiece, BezierPiece, int>> stack;
+    for (const BezierPiece &root0 : pieces0)
+    {
+        for (const BezierPiece &root1 : pieces1)
+        {
+            const double size = std::max(std::max(root0.right - root0.left, root0.top - root0.bottom),
+                                         std::max(root1.right - root1.left, root1.top - root1.bottom));
+            const double tolerance = std::max(size * 1e-6, 1e-12);
+            if (!is_piece_intersected(root0, root1, tolerance))
             {
                 continue;
             }
 
-            for (size_t a = 1, count0 = polyline0.size(); a < count0; ++a)
+            stack.emplace_back(root0, root1, 0);
+            while (!stack.empty())
             {
-                for (size_t b = 1, count1 = polyline1.size(); b < count1; ++b)
+                const auto [piece0, piece1, depth] = stack.back();
+                stack.pop_back();
+                const bool flat0 = is_piece_flat(piece0, tolerance), flat1 = is_piece_flat(piece1, tolerance);
+                if ((flat0 && flat1) || depth >= 48)
                 {
-                    Geo::Point point;
-                    if (!Geo::is_intersected(polyline0[a - 1], polyline0[a], polyline1[b - 1], polyline1[b], point, false))
+                    const double ax = piece0.x[piece0.order] - piece0.x[0], ay = piece0.y[piece0.order] - piece0.y[0];
+                    const double bx = piece1.x[piece1.order] - piece1.x[0], by = piece1.y[piece1.order] - piece1.y[0];
+                    const double cx = piece1.x[0] - piece0.x[0], cy = piece1.y[0] - piece0.y[0];
+                    const double det = bx * ay - ax * by;
+                    if (det == 0)
                     {
                         continue;
                     }
-
-                    double step = 1e-3, lower0 = 0, upper0 = 1;
-                    double min_dis = DBL_MAX, t0 = 0;
-                    while (min_dis > 1e-8 && step > 1e-15)
-                    {
-                        for (double x = lower0; x < upper0 + step; x += step)
-                        {
-                            x = x < upper0 ? x : upper0;
-                            Geo::Point coord;
-                            for (int j = 0; j <= order; ++j)
-                            {
-                                coord += (bezier0[j + p] * (nums[j] * std::pow(1 - x, order - j) * std::pow(x, j)));
-                            }
-                            if (double dis = Geo::distance(point, coord); dis < min_dis)
-                            {
-                                min_dis = dis;
-                                t0 = x;
-                            }
-                        }
-                        lower0 = std::max(0.0, t0 - step);
-                        upper0 = std::min(1.0, t0 + step);
-                        step = (upper0 - lower0) / 100;
-                    }
-
-                    double lower1 = 0, upper1 = 1, t1 = 0;
-                    step = 1e-3, min_dis = DBL_MAX;
-                    while (min_dis > 1e-8 && step > 1e-15)
+                    const double s0 = (bx * cy - by * cx) / det, s1 = (ax * cy - ay * cx) / det;
+                    if (s0 < -1e-9 || s0 > 1 + 1e-9 || s1 < -1e-9 || s1 > 1 + 1e-9)
                     {
-                        for (double x = lower1; x < upper1 + step; x += step)
-                        {
-                            x = x < upper1 ? x : upper1;
-                            Geo::Point coord;
-                            for (int j = 0; j <= order; ++j)
-                            {
-                                coord += (bezier1[j + q] * (nums[j] * std::pow(1 - x, order - j) * std::pow(x, j)));
-                            }
-                            if (double dis = Geo::distance(point, coord); dis < min_dis)
-                            {
-                                min_dis = dis;
-                                t1 = x;
-                            }
-                        }
-                        lower1 = std::max(0.0, t1 - step);
-                        upper1 = std::min(1.0, t1 + step);
-                        step = (upper1 - lower1) / 100;
+                        continue;
                     }
 
-                    Math::BezierParameter params[2];
-                    params[0].order = order;
-                    params[0].values = nums;
-                    double *points0 = new double[order * 2 + 2];
-                    params[0].points = points0;
-                    for (int k = 0; k <= order; ++k)
+                    double t0 = piece0.t0 + (piece0.t1 - piece0.t0) * std::clamp(s0, 0.0, 1.0);
+                    double t1 = piece1.t0 + (piece1.t1 - piece1.t0) * std::clamp(s1, 0.0, 1.0);
+                    if (refine_piece_intersection(root0, root1, t0, t1) > tolerance)
                     {
-                        points0[k * 2] = bezier0[k + p].x;
-                        points0[k * 2 + 1] = bezier0[k + p].y;
+                        continue;
                     }
-                    params[1].order = order;
-                    params[1].values = nums;
-                    double *points1 = new double[order * 2 + 2];
-                    params[1].points = points1;
-                    for (int k = 0; k <= order; ++k)
+                    double x0, y0, x1, y1, dx, dy;
+                    piece_point(root0, t0, x0, y0, dx, dy);
+                    piece_point(root1, t1, x1, y1, dx, dy);
+                    const Geo::Point point0(x0, y0), point1(x1, y1);
+                    if (std::none_of(output.begin(), output.end(), [&](const PieceIntersection &item)
+                                     { return Geo::distance(item.point0, point0) <= tolerance; }))
                     {
-                        points1[k * 2] = bezier1[k + q].x;
-                        points1[k * 2 + 1] = bezier1[k + q].y;
+                        PieceIntersection &item = output.emplace_back();
+                        item.segment0 = root0.segment, item.segment1 = root1.segment;
+                        item.t0 = root0.u0 + (root0.u1 - root0.u0) * t0;
+                        item.t1 = root1.u0 + (root1.u1 - root1.u0) * t1;
+                        item.point0 = point0, item.point1 = point1;
                     }
-                    std::tuple<double, double> res = Math::solve_curve_intersection(params, Math::CurveIntersectType::BezierBezier, t0, t1);
-                    t0 = std::get<0>(res), t1 = std::get<1>(res);
-                    delete[] points0;
-                    delete[] points1;
-
-                    if (t0 < 0 || t0 > 1 || t1 < 0 || t1 > 1)
+                }
+                else if (!flat0 && (flat1 || std::max(piece0.right - piece0.left, piece0.top - piece0.bottom) >=
+                                                 std::max(piece1.right - piece1.left, piece1.top - piece1.bottom)))
+                {
+                    BezierPiece left, right;
+                    split_piece(piece0, left, right);
+                    if (is_piece_intersected(left, piece1, tolerance))
                     {
-                        continue;
+                        stack.emplace_back(left, piece1, depth + 1);
                     }
-
-                    Geo::Point point0, point1;
-                    for (int j = 0; j <= order; ++j)
+                    if (is_piece_intersected(right, piece1, tolerance))
                     {
-                        point0 += (bezier0[j + p] * (nums[j] * std::pow(1 - t0, order - j) * std::pow(t0, j)));
-                        point1 += (bezier1[j + q] * (nums[j] * std::pow(1 - t1, order - j) * std::pow(t1, j)));
+                        stack.emplace_back(right, piece1, depth + 1);
                     }
-                    intersections.emplace_back((point0 + point1) / 2);
-                    if (tvalues0 != nullptr)
+                }
+                else
+                {
+                    BezierPiece left, right;
+                    split_piece(piece1, left, right);
+                    if (is_piece_intersected(piece0, left, tolerance))
                     {
-                        tvalues0->emplace_back(p / order, t0, point0.x, point0.y);
+                        stack.emplace_back(piece0, left, depth + 1);
                     }
-                    if (tvalues1 != nullptr)
+                    if (is_piece_intersected(piece0, right, tolerance))
                     {
-                        tvalues1->emplace_back(q / order, t1, point1.x, point1.y);
+                        stack.emplace_back(piece0, right, depth + 1);
                     }
                 }
             }
         }
     }
+}
+
+void bezier_pieces(const Geo::CubicBezier &bezier, std::vector<BezierPiece> &output)
+{
+    for (size_t i = 0, end = bezier.size() - 3; i < end; i += 3)
+    {
+        BezierPiece &piece = output.emplace_back();
+        for (int j = 0; j < 4; ++j)
+        {
+            piece.x[j] = bezier[i + j].x;
+            piece.y[j] = bezier[i + j].y;
+        }
+        piece.segment = i / 3;
+        update_piece_rect(piece);
+    }
+}
+
+// 用开花算法将每个非空节点区间转换为Bezier曲线段
+void bspline_pieces(const Geo::BSpline &bspline, const int order, std::vector<BezierPiece> &output)
+{
+    const std::vector<double> &knots = bspline.knots();
+    const std::vector<Geo::Point> &points = bspline.control_points;
+    for (size_t k = order, npts = points.size(); k < npts; ++k)
+    {
+        if (knots[k + 1] <= knots[k])
+        {
+            continue;
+        }
+        BezierPiece &piece = output.emplace_back();
+        piece.order = order;
+        piece.segment = k;
+        piece.u0 = knots[k], piece.u1 = knots[k + 1];
+        for (int i = 0; i <= order; ++i)
+        {
+            double x[4], y[4];
+            for (int j = 0; j <= order; ++j)
+            {
+                x[j] = points[k - order + j].x;
+                y[j] = points[k - order + j].y;
+            }
+            for (int r = 1; r <= order; ++r)
+            {
+                const double u = r <= order - i ? piece.u0 : piece.u1;
+                for (int j = order; j >= r; --j)
+                {
+                    const size_t l = k - order + j;
+                    const double alpha = (u - knots[l]) / (knots[l + order + 1 - r] - knots[l]);
+                    x[j] = x[j - 1] + (x[j] - x[j - 1]) * alpha;
+                    y[j] = y[j - 1] + (y[j] - y[j - 1]) * alpha;
+                }
+            }
+            piece.x[i] = x[order];
+            piece.y[i] = y[order];
+        }
+        update_piece_rect(piece);
+    }
+}
+} // namespace
+
+int Geo::is_intersected(const CubicBezier &bezier0, const CubicBezier &bezier1, std::vector<Point> &intersections,
+                        std::vector<std::tuple<size_t, double, double, double>> *tvalues0,
+                        std::vector<std::tuple<size_t, double, double, double>> *tvalues1)
+{
+    std::vector<BezierPiece> pieces0, pieces1;
+    bezier_pieces(bezier0, pieces0);
+    bezier_pieces(bezier1, pieces1);
+    std::vector<PieceIntersection> results;
+    intersect_pieces(pieces0, pieces1, results);
+
+    const int order = 3;
+    const size_t count = intersections.size();
+    for (const PieceIntersection &result : results)
+    {
+        intersections.emplace_back((result.point0 + result.point1) / 2);
+        if (tvalues0 != nullptr)
+        {
+            tvalues0->emplace_back(result.segment0, result.t0, result.point0.x, result.point0.y);
+        }
+        if (tvalues1 != nullptr)
+        {
+            tvalues1->emplace_back(result.segment1, result.t1, result.point1.x, result.point1.y);
+        }
+    }
     if (bezier0.front() == bezier1.front())
     {
         if (std::find(intersections.begin(), intersections.end(), bezier0.front()) == intersections.end())
@@ -2708,199 +2596,26 @@ int Geo::is_intersected(const BSpline &bspline0, const bool is_cubic0, const BSp
                         std::vector<Point> &intersections, std::vector<std::tuple<double, double, double>> *tvalues0,
                         std::vector<std::tuple<double, double, double>> *tvalues1)
 {
-    std::vector<Geo::Point> temp_points;
-    for (size_t i = 1, count0 = bspline0.shape().size(); i < count0; ++i)
-    {
-        for (size_t j = 1, count1 = bspline1.shape().size(); j < count1; ++j)
-        {
-            if (Geo::Point point; Geo::is_intersected(bspline0.shape()[i - 1], bspline0.shape()[i], bspline1.shape()[j - 1],
-                                                      bspline1.shape()[j], point, false) &&
-                                  std::find(temp_points.begin(), temp_points.end(), point) == temp_points.end())
-            {
-                temp_points.emplace_back(point);
-            }
-        }
-    }
-
-    std::vector<double> values0(temp_points.size(), 0), values1(temp_points.size(), 0);
-    const std::vector<double> &knots0 = bspline0.knots(), &knots1 = bspline1.knots();
-    const size_t npts0 = bspline0.control_points.size(), npts1 = bspline1.control_points.size();
-    const size_t nplusc0 = npts0 + (is_cubic0 ? 4 : 3), nplusc1 = npts1 + (is_cubic1 ? 4 : 3);
-
-    {
-        const size_t p = std::max(npts0 * 8.0, bspline0.shape().length() / Geo::BSpline::default_step);
-        double t = knots0[0];
-        const double init_step = (knots0[nplusc0 - 1] - t) / (p - 1);
-        std::vector<double> min_dis(temp_points.size(), DBL_MAX);
-        while (t <= knots0[nplusc0 - 1])
-        {
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic0 ? 3 : 2, t, npts0, knots0, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts0; ++i)
-            {
-                coord += bspline0.control_points[i] * nbasis[i];
-            }
-            for (size_t i = 0, count = temp_points.size(); i < count; ++i)
-            {
-                if (const double dis = Geo::distance(coord, temp_points[i]); dis < min_dis[i])
-                {
-                    min_dis[i] = dis;
-                    values0[i] = t;
-                }
-            }
-            t += init_step;
-        }
-        /*for (size_t i = 0, count = values0.size(); i < count; ++i)
-        {
-            t = values0[i];
-            double lower = std::max(knots0[0], t - init_step * 2), upper = std::min(knots0[nplusc0 - 1], t + init_step * 2);
-            double step = (upper - lower) / 100, min_dis = DBL_MAX, t0 = DBL_MAX;
-            while (std::abs(t0 - t) > 1e-15 && step > 1e-15 && upper - lower > 1e-15)
-            {
-                t = t0;
-                for (double x = lower; x < upper + step; x += step)
-                {
-                    x = x < upper ? x : upper;
-                    std::vector<double> nbasis;
-                    if (is_cubic0)
-                    {
-                        Geo::CubicBSpline::rbasis(x, npts0, knots0, nbasis);
-                    }
-                    else
-                    {
-                        Geo::QuadBSpline::rbasis(x, npts0, knots0, nbasis);
-                    }
-                    Geo::Point coord;
-                    for (size_t j = 0; j < npts0; ++j)
-                    {
-                        coord += bspline0.control_points[j] * nbasis[j];
-                    }
-                    if (double dis = Geo::distance(temp_points[i], coord); dis < min_dis)
-                    {
-                        min_dis = dis;
-                        t0 = x;
-                    }
-                }
-                lower = std::max(knots0[0], t0 - step);
-                upper = std::min(knots0[nplusc0 - 1], t0 + step);
-                step = (upper - lower) / 100;
-            }
-            values0[i] = t0;
-        }*/
-    }
-    {
-        const size_t p = std::max(npts1 * 8.0, bspline1.shape().length() / Geo::BSpline::default_step);
-        double t = knots1[0];
-        const double init_step = (knots1[nplusc1 - 1] - t) / (p - 1);
-        std::vector<double> min_dis(temp_points.size(), DBL_MAX);
-        while (t <= knots1[nplusc1 - 1])
-        {
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic1 ? 3 : 2, t, npts1, knots1, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts1; ++i)
-            {
-                coord += bspline1.control_points[i] * nbasis[i];
-            }
-            for (size_t i = 0, count = temp_points.size(); i < count; ++i)
-            {
-                if (const double dis = Geo::distance(coord, temp_points[i]); dis < min_dis[i])
-                {
-                    min_dis[i] = dis;
-                    values1[i] = t;
-                }
-            }
-            t += init_step;
-        }
-        /*for (size_t i = 0, count = values1.size(); i < count; ++i)
-        {
-            t = values1[i];
-            double lower = std::max(knots1[0], t - init_step * 2), upper = std::min(knots1[nplusc1 - 1], t + init_step * 2);
-            double step = (upper - lower) / 100, min_dis = DBL_MAX, t0 = DBL_MAX;
-            while (std::abs(t0 - t) > 1e-15 && step > 1e-15 && upper - lower > 1e-15)
-            {
-                t = t0;
-                for (double x = lower; x < upper + step; x += step)
-                {
-                    x = x < upper ? x : upper;
-                    std::vector<double> nbasis;
-                    if (is_cubic1)
-                    {
-                        Geo::CubicBSpline::rbasis(x, npts1, knots1, nbasis);
-                    }
-                    else
-                    {
-                        Geo::QuadBSpline::rbasis(x, npts1, knots1, nbasis);
-                    }
-                    Geo::Point coord;
-                    for (size_t j = 0; j < npts1; ++j)
-                    {
-                        coord += bspline1.control_points[j] * nbasis[j];
-                    }
-                    if (double dis = Geo::distance(temp_points[i], coord); dis < min_dis)
-                    {
-                        min_dis = dis;
-                        t0 = x;
-                    }
-                }
-                lower = std::max(knots1[0], t0 - step);
-                upper = std::min(knots1[nplusc1 - 1], t0 + step);
-                step = (upper - lower) / 100;
-            }
-            values1[i] = t0;
-        }*/
-    }
+    std::vector<BezierPiece> pieces0, pieces1;
+    bspline_pieces(bspline0, is_cubic0 ? 3 : 2, pieces0);
+    bspline_pieces(bspline1, is_cubic1 ? 3 : 2, pieces1);
+    std::vector<PieceIntersection> results;
+    intersect_pieces(pieces0, pieces1, results);
 
     const size_t count = intersections.size();
-    Math::BSplineParameter params[2];
-    params[0].is_cubic = is_cubic0;
-    params[0].npts = npts0;
-    std::vector<double> points0;
-    for (const Geo::Point &point : bspline0.control_points)
-    {
-        points0.push_back(point.x);
-        points0.push_back(point.y);
-    }
-    params[0].points = points0.data();
-    params[0].values = knots0.data();
-    params[1].is_cubic = is_cubic1;
-    params[1].npts = npts1;
-    std::vector<double> points1;
-    for (const Geo::Point &point : bspline1.control_points)
-    {
-        points1.push_back(point.x);
-        points1.push_back(point.y);
-    }
-    params[1].points = points1.data();
-    params[1].values = knots1.data();
-    for (size_t i = 0, count = values0.size(); i < count; ++i)
+    for (const PieceIntersection &result : results)
     {
-        auto [t0, t1] = Math::solve_curve_intersection(params, Math::CurveIntersectType::BSplineBSpline, values0[i], values1[i]);
-        std::vector<double> nbasis0;
-        Geo::BSpline::rbasis(is_cubic0 ? 3 : 2, t0, npts0, knots0, nbasis0);
-        Geo::Point point0;
-        for (size_t j = 0; j < npts0; ++j)
-        {
-            point0 += bspline0.control_points[j] * nbasis0[j];
-        }
-        std::vector<double> nbasis1;
-        Geo::BSpline::rbasis(is_cubic1 ? 3 : 2, t1, npts1, knots1, nbasis1);
-        Geo::Point point1;
-        for (size_t j = 0; j < npts1; ++j)
-        {
-            point1 += bspline1.control_points[j] * nbasis1[j];
-        }
-        if (Geo::Point point((point0 + point1) / 2); std::find(intersections.begin(), intersections.end(), point) == intersections.end())
+        if (Geo::Point point((result.point0 + result.point1) / 2);
+            std::find(intersections.begin(), intersections.end(), point) == intersections.end())
         {
             intersections.emplace_back(point);
             if (tvalues0 != nullptr)
             {
-                tvalues0->emplace_back(t0, point0.x, point0.y);
+                tvalues0->emplace_back(result.t0, result.point0.x, result.point0.y);
             }
             if (tvalues1 != nullptr)
             {
-                tvalues1->emplace_back(t1, point1.x, point1.y);
+                tvalues1->emplace_back(result.t1, result.point1.x, result.point1.y);
             }
         }
     }
@@ -2973,151 +2688,27 @@ int Geo::is_intersected(const CubicBezier &bezier, const BSpline &bspline, const
                         std::vector<std::tuple<size_t, double, double, double>> *tvalues0,
                         std::vector<std::tuple<double, double, double>> *tvalues1)
 {
-    const int order = 3;
-    const int nums[4] = {1, 3, 3, 1};
-    std::vector<Geo::Point> temp_points;
-    for (size_t i = 1, count0 = bezier.shape().size(); i < count0; ++i)
-    {
-        for (size_t j = 1, count1 = bspline.shape().size(); j < count1; ++j)
-        {
-            if (Geo::Point point;
-                Geo::is_intersected(bezier.shape()[i - 1], bezier.shape()[i], bspline.shape()[j - 1], bspline.shape()[j], point, false) &&
-                std::find(temp_points.begin(), temp_points.end(), point) == temp_points.end())
-            {
-                temp_points.emplace_back(point);
-            }
-        }
-    }
-
-    std::vector<std::tuple<size_t, double>> bezier_values(temp_points.size(), std::make_tuple(0, 0.0));
-    {
-        std::vector<double> min_dis(temp_points.size(), DBL_MAX);
-        for (size_t i = 0, end = bezier.size() - order; i < end; i += order)
-        {
-            for (double t = 0; t <= 1; t += 1e-4)
-            {
-                Geo::Point coord;
-                for (int j = 0; j <= order; ++j)
-                {
-                    coord += (bezier[j + i] * (nums[j] * std::pow(1 - t, order - j) * std::pow(t, j)));
-                }
-                for (size_t j = 0, count = temp_points.size(); j < count; ++j)
-                {
-                    if (double dis = Geo::distance(temp_points[j], coord); dis < min_dis[j])
-                    {
-                        min_dis[j] = dis;
-                        bezier_values[j] = std::make_tuple(i, t);
-                    }
-                }
-            }
-        }
-        for (size_t k = 0, count = bezier_values.size(); k < count; ++k)
-        {
-            const size_t i = std::get<0>(bezier_values[k]);
-            double t = std::get<1>(bezier_values[k]);
-            double lower = std::max(0.0, t - 2e-4), upper = std::min(1.0, t + 2e-4);
-            double step = (upper - lower) / 100, min_dis = DBL_MAX;
-            while (min_dis > 1e-8 && step > 1e-15)
-            {
-                for (double x = lower; x < upper + step; x += step)
-                {
-                    x = x < upper ? x : upper;
-                    Geo::Point coord;
-                    for (int j = 0; j <= order; ++j)
-                    {
-                        coord += (bezier[j + i] * (nums[j] * std::pow(1 - x, order - j) * std::pow(x, j)));
-                    }
-                    if (double dis = Geo::distance(temp_points[k], coord); dis < min_dis)
-                    {
-                        min_dis = dis;
-                        t = x;
-                    }
-                }
-                lower = std::max(0.0, t - step);
-                upper = std::min(1.0, t + step);
-                step = (upper - lower) / 100;
-            }
-            bezier_values[k] = std::make_tuple(i, t);
-        }
-    }
-
-    const std::vector<double> &knots = bspline.knots();
-    const size_t npts = bspline.control_points.size();
-    const size_t nplusc = npts + (is_cubic ? 4 : 3);
-    std::vector<double> bspline_values(temp_points.size(), 0);
-    {
-        const size_t p = std::max(npts * 8.0, bspline.shape().length() / Geo::BSpline::default_step);
-        double t = knots[0];
-        const double init_step = (knots[nplusc - 1] - t) / (p - 1);
-        std::vector<double> min_dis(temp_points.size(), DBL_MAX);
-        while (t <= knots[nplusc - 1])
-        {
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts; ++i)
-            {
-                coord += bspline.control_points[i] * nbasis[i];
-            }
-            for (size_t i = 0, count = temp_points.size(); i < count; ++i)
-            {
-                if (const double dis = Geo::distance(coord, temp_points[i]); dis < min_dis[i])
-                {
-                    min_dis[i] = dis;
-                    bspline_values[i] = t;
-                }
-            }
-            t += init_step;
-        }
-    }
+    std::vector<BezierPiece> pieces0, pieces1;
+    bezier_pieces(bezier, pieces0);
+    bspline_pieces(bspline, is_cubic ? 3 : 2, pieces1);
+    std::vector<PieceIntersection> results;
+    intersect_pieces(pieces0, pieces1, results);
 
+    const int order = 3;
     const size_t count = intersections.size();
-    Math::BezierBSplineParameter param;
-    param.bezier.order = order;
-    param.bezier.values = nums;
-    param.bspline.is_cubic = is_cubic;
-    param.bspline.npts = npts;
-    std::vector<double> bspline_points;
-    for (const Geo::Point &point : bspline.control_points)
+    for (const PieceIntersection &result : results)
     {
-        bspline_points.push_back(point.x);
-        bspline_points.push_back(point.y);
-    }
-    param.bspline.points = bspline_points.data();
-    param.bspline.values = knots.data();
-    for (size_t i = 0, count = bezier_values.size(); i < count; ++i)
-    {
-        std::vector<double> bezier_points;
-        for (size_t j = 0, k = std::get<0>(bezier_values[i]); j <= order; ++j)
-        {
-            bezier_points.push_back(bezier[j + k].x);
-            bezier_points.push_back(bezier[j + k].y);
-        }
-        param.bezier.points = bezier_points.data();
-        auto [t0, t1] = Math::solve_curve_intersection(&param, Math::CurveIntersectType::BezierBSpline, std::get<1>(bezier_values[i]),
-                                                       bspline_values[i]);
-        Geo::Point point0;
-        for (size_t j = 0, k = std::get<0>(bezier_values[i]); j <= order; ++j)
-        {
-            point0 += (bezier[j + k] * param.bezier.values[j] * std::pow(1 - t0, order - j) * std::pow(t0, j));
-        }
-        std::vector<double> nbasis;
-        Geo::BSpline::rbasis(is_cubic ? 3 : 2, t1, npts, knots, nbasis);
-        Geo::Point point1;
-        for (size_t j = 0; j < npts; ++j)
-        {
-            point1 += bspline.control_points[j] * nbasis[j];
-        }
-        if (Geo::Point point((point0 + point1) / 2); std::find(intersections.begin(), intersections.end(), point) == intersections.end())
+        if (Geo::Point point((result.point0 + result.point1) / 2);
+            std::find(intersections.begin(), intersections.end(), point) == intersections.end())
         {
             intersections.emplace_back(point);
             if (tvalues0 != nullptr)
             {
-                tvalues0->emplace_back(std::get<0>(bezier_values[i]) / order, t0, point0.x, point0.y);
+                tvalues0->emplace_back(result.segment0, result.t0, result.point0.x, result.point0.y);
             }
             if (tvalues1 != nullptr)
             {
-                tvalues1->emplace_back(t1, point1.x, point1.y);
+                tvalues1->emplace_back(result.t1, result.point1.x, result.point1.y);
             }
         }
     }
@@ -3703,130 +3294,31 @@ bool Geo::find_intersections(const Geo::Circle &circle0, const Geo::Circle &circ
 bool Geo::find_intersections(const Geo::Ellipse &ellipse0, const Geo::Ellipse &ellipse1, const Geo::Point &pos, const double distance,
                              std::vector<Geo::Point> &intersections)
 {
-    std::vector<Geo::Point> points;
-    Geo::find_intersections(ellipse0.shape(), ellipse1.shape(), pos, distance, points);
-    {
-        const double eps = Geo::EPSILON;
-        if (ellipse0.is_arc())
-        {
-            if (const Geo::Point point(ellipse0.arc_point0());
-                Geo::distance(point, pos) <= distance && Geo::distance(point, ellipse1) < eps)
-            {
-                points.emplace_back(ellipse0.arc_point0());
-            }
-            if (const Geo::Point point(ellipse0.arc_point1());
-                Geo::distance(point, pos) <= distance && Geo::distance(point, ellipse1) < eps)
-            {
-                points.emplace_back(ellipse0.arc_point1());
-            }
-        }
-        if (ellipse1.is_arc())
-        {
-            if (const Geo::Point point(ellipse1.arc_point0());
-                Geo::distance(point, pos) <= distance && Geo::distance(point, ellipse0) < eps)
-            {
-                points.emplace_back(ellipse1.arc_point0());
-            }
-            if (const Geo::Point point(ellipse1.arc_point1());
-                Geo::distance(point, pos) <= distance && Geo::distance(point, ellipse0) < eps)
-            {
-                points.emplace_back(ellipse1.arc_point1());
-            }
-        }
-    }
-    if (points.empty())
-    {
-        return false;
-    }
-
-    for (size_t i = 0, count = points.size(); i < count; ++i)
+    const size_t count = intersections.size();
+    Geo::Point points[4];
+    for (int i = 0, num = Geo::is_intersected(ellipse0, ellipse1, points[0], points[1], points[2], points[3]); i < num; ++i)
     {
-        for (size_t j = i + 1; j < count; ++j)
+        if (Geo::distance(pos, points[i]) <= distance)
         {
-            if (points[i] == points[j])
-            {
-                points.erase(points.begin() + j);
-                --count;
-                --j;
-            }
+            intersections.emplace_back(points[i]);
         }
     }
-
-    const Geo::Point center0 = ellipse0.center(), center1 = ellipse1.center();
-    double theta0 = Geo::angle(ellipse0.a0(), ellipse0.a1()), theta1 = Geo::angle(ellipse1.a0(), ellipse1.a1());
-    double a0 = ellipse0.lengtha(), b0 = ellipse0.lengthb(), a1 = ellipse1.lengtha(), b1 = ellipse1.lengthb();
-    double A0 = (std::sin(theta0) / b0) * (std::sin(theta0) / b0) + (std::cos(theta0) / a0) * (std::cos(theta0) / a0),
-           A1 = (std::sin(theta1) / b1) * (std::sin(theta1) / b1) + (std::cos(theta1) / a1) * (std::cos(theta1) / a1);
-    double B0 = 2 * (std::pow(1 / a0, 2) - std::pow(1 / b0, 2)) * std::sin(theta0) * std::cos(theta0),
-           B1 = 2 * (std::pow(1 / a1, 2) - std::pow(1 / b1, 2)) * std::sin(theta1) * std::cos(theta1);
-    double C0 = (std::cos(theta0) / b0) * (std::cos(theta0) / b0) + (std::sin(theta0) / a0) * (std::sin(theta0) / a0),
-           C1 = (std::cos(theta1) / b1) * (std::cos(theta1) / b1) + (std::sin(theta1) / a1) * (std::sin(theta1) / a1);
-    double D0 = -(2 * A0 * center0.x + B0 * center0.y), D1 = -(2 * A1 * center1.x + B1 * center1.y);
-    double E0 = -(2 * C0 * center0.y + B0 * center0.x), E1 = -(2 * C1 * center1.y + B1 * center1.x);
-    double F0 = -(D0 * center0.x + E0 * center0.y) / 2 - 1, F1 = -(D1 * center1.x + E1 * center1.y) / 2 - 1;
-
-    Math::EllipseParameter param;
-    param.a[0] = A0, param.a[1] = A1;
-    param.b[0] = B0, param.b[1] = B1;
-    param.c[0] = C0, param.c[1] = C1;
-    param.d[0] = D0, param.d[1] = D1;
-    param.e[0] = E0, param.e[1] = E1;
-    param.f[0] = F0, param.f[1] = F1;
-
-    for (Geo::Point &point : points)
-    {
-        auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, point.x, point.y);
-        point.x = x, point.y = y;
-    }
-    intersections.insert(intersections.end(), points.begin(), points.end());
-    return true;
+    return intersections.size() > count;
 }
 
 bool Geo::find_intersections(const Geo::Ellipse &ellipse, const Geo::Circle &circle, const Geo::Point &pos, const double distance,
                              std::vector<Geo::Point> &intersections)
 {
-    const size_t count0 = intersections.size();
-    if (std::vector<Geo::Point> points; Geo::find_intersections(ellipse.shape(), circle.shape(), pos, distance, points))
-    {
-        intersections.insert(intersections.end(), points.begin(), points.end());
-    }
-    else
+    const size_t count = intersections.size();
+    Geo::Point points[4];
+    for (int i = 0, num = Geo::is_intersected(circle, ellipse, points[0], points[1], points[2], points[3]); i < num; ++i)
     {
-        return false;
-    }
-
-    if (intersections.size() > count0)
-    {
-        const Geo::Point &center0 = circle;
-        const Geo::Point center1 = ellipse.center();
-        const double theta0 = 0, theta1 = Geo::angle(ellipse.a0(), ellipse.a1());
-        const double a0 = circle.radius, b0 = circle.radius, a1 = ellipse.lengtha(), b1 = ellipse.lengthb();
-        const double A0 = std::pow(1 / a0, 2), A1 = std::pow(std::sin(theta1) / b1, 2) + std::pow(std::cos(theta1) / a1, 2);
-        const double B0 = 2 * (std::pow(1 / a0, 2) - std::pow(1 / b0, 2)) * std::sin(theta0) * std::cos(theta0),
-                     B1 = 2 * (std::pow(1 / a1, 2) - std::pow(1 / b1, 2)) * std::sin(theta1) * std::cos(theta1);
-        const double C0 = std::pow(1 / b0, 2), C1 = std::pow(std::cos(theta1) / b1, 2) + std::pow(std::sin(theta1) / a1, 2);
-        const double D0 = -(2 * A0 * center0.x + B0 * center0.y), D1 = -(2 * A1 * center1.x + B1 * center1.y);
-        const double E0 = -(2 * C0 * center0.y + B0 * center0.x), E1 = -(2 * C1 * center1.y + B1 * center1.x);
-        const double F0 = -(D0 * center0.x + E0 * center0.y) / 2 - 1, F1 = -(D1 * center1.x + E1 * center1.y) / 2 - 1;
-
-        Math::EllipseParameter param;
-        param.a[0] = A0, param.a[1] = A1;
-        param.b[0] = B0, param.b[1] = B1;
-        param.c[0] = C0, param.c[1] = C1;
-        param.d[0] = D0, param.d[1] = D1;
-        param.e[0] = E0, param.e[1] = E1;
-        param.f[0] = F0, param.f[1] = F1;
-        for (size_t i = count0, count1 = intersections.size(); i < count1; ++i)
-        {
-            auto [x, y] = Math::solve_ellipse_ellipse_intersection(param, intersections[i].x, intersections[i].y);
-            intersections[i].x = x, intersections[i].y = y;
+        if (Geo::distance(pos, points[i]) <= distance)
+        {
+            intersections.emplace_back(points[i]);
         }
-        return true;
-    }
-    else
-    {
-        return false;
     }
+    return intersections.size() > count;
 }
 
 bool Geo::find_intersections(const Geo::Geometry *object0, const Geo::Geometry *object1, const Geo::Point &pos, const double distance,
@@ -69,6 +69,10 @@ int is_intersected(const Circle &circle, const Arc &arc, Point &output0, Point &
 // 计算两椭圆交点
 int is_intersected(const Ellipse &ellipse0, const Ellipse &ellipse1, Point &point0, Point &point1, Point &point2, Point &point3);
 
+// 批量计算椭圆与多个椭圆的交点,indices记录交点所属椭圆的下标,返回交点数量
+int is_intersected(const Ellipse &ellipse, const std::vector<const Ellipse *> &ellipses, std::vector<Point> &intersections,
+                   std::vector<size_t> *indices = nullptr);
+
 // 计算圆与椭圆的交点
 int is_intersected(const Circle &circle, const Ellipse &ellipse, Point &point0, Point &point1, Point &point2, Point &point3);
 
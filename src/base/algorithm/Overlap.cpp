@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include "base/algorithm/Overlap.hpp"
+#include "base/algorithm/HashGrid.hpp"
+
+
+namespace
+{
+// 按左边界扫描,活动矩形按纵向分桶保存,只检查与当前矩形纵向范围相交的桶,桶内移除右边界已被扫过的矩形,
+// 宽而扁的矩形很多时也不必与全部活动矩形逐个比较,对每对相交的矩形调用callback
+void sweep_rects(const std::vector<Geo::AABBRectParams> &rects, const std::function<void(const size_t, const size_t)> &callback)
+{
+    if (rects.empty())
+    {
+        return;
+    }
+
+    std::vector<size_t> order(rects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b) { return rects[a].left < rects[b].left; });
+
+    // 桶高取矩形平均高度,且不小于纵向总范围的1/n,每个矩形跨越的桶数有上限
+    double bottom = DBL_MAX, top = -DBL_MAX, height = 0;
+    for (const Geo::AABBRectParams &rect : rects)
+    {
+        bottom = std::min(bottom, rect.bottom);
+        top = std::max(top, rect.top);
+        height += rect.top - rect.bottom;
+    }
+    const Geo::HashGrid grid(std::max(height, top - bottom) / rects.size());
+
+    std::unordered_map<long long, std::vector<size_t>> buckets;
+    std::vector<size_t> visited(rects.size(), SIZE_MAX); // 跨越多个桶的矩形只与当前矩形比较一次
+    for (const size_t index : order)
+    {
+        const Geo::AABBRectParams &rect = rects[index];
+        const long long first = grid.index(rect.bottom), last = grid.index(rect.top);
+        for (long long row = first; row <= last; ++row)
+        {
+            const auto it = buckets.find(row);
+            if (it == buckets.end())
+            {
+                continue;
+            }
+            std::vector<size_t> &active = it->second;
+            size_t count = 0;
+            for (const size_t i : active)
+            {
+                if (rects[i].right < rect.left)
+                {
+                    continue;
+                }
+                active[count++] = i;
+                if (visited[i] != index)
+                {
+                    visited[i] = index;
+                    if (rects[i].bottom <= rect.top && rects[i].top >= rect.bottom)
+                    {
+                        callback(i, index);
+                    }
+                }
+            }
+            active.resize(count);
+        }
+        for (long long row = first; row <= last; ++row)
+        {
+            buckets[row].push_back(index);
+        }
+    }
+}
+} // namespace
+
+void Geo::find_overlapped_rects(const std::vector<AABBRectParams> &rects, std::vector<std::vector<size_t>> &overlaps)
+{
+    overlaps.assign(rects.size(), std::vector<size_t>());
+    sweep_rects(rects, [&](const size_t a, const size_t b) { overlaps[std::max(a, b)].push_back(std::min(a, b)); });
+    for (std::vector<size_t> &items : overlaps)
+    {
+        std::sort(items.begin(), items.end());
+    }
+}
+
+void Geo::find_overlapped_rects(const std::vector<AABBRectParams> &rects0, const std::vector<AABBRectParams> &rects1,
+                                std::vector<std::vector<size_t>> &overlaps)
+{
+    std::vector<AABBRectParams> rects(rects0);
+    rects.insert(rects.end(), rects1.begin(), rects1.end());
+    overlaps.assign(rects1.size(), std::vector<size_t>());
+    const size_t offset = rects0.size();
+    sweep_rects(rects,
+                [&](const size_t a, const size_t b)
+                {
+                    if (a < offset && b >= offset)
+                    {
+                        overlaps[b - offset].push_back(a);
+                    }
+                    else if (b < offset && a >= offset)
+                    {
+                        overlaps[a - offset].push_back(b);
+                    }
+                });
+    for (std::vector<size_t> &items : overlaps)
+    {
+        std::sort(items.begin(), items.end());
+    }
+}
+
+void Geo::filter_overlaps(std::vector<std::vector<size_t>> &overlaps, const std::function<bool(const size_t, const size_t)> &is_overlapped)
+{
+    const auto filter = [&](const size_t begin, const size_t end)
+    {
+        for (size_t j = begin; j < end; ++j)
+        {
+            std::vector<size_t> &items = overlaps[j];
+            items.erase(std::remove_if(items.begin(), items.end(), [&](const size_t i) { return !is_overlapped(i, j); }), items.end());
+        }
+    };
+
+    size_t pairs = 0;
+    for (const std::vector<size_t> &items : overlaps)
+    {
+        pairs += items.size();
+    }
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    if (pairs < 256 || threads == 1)
+    {
+        return filter(0, overlaps.size());
+    }
+
+    // 按候选对数量把序号分成若干段,每段交给一个线程
+    std::vector<std::future<void>> futures;
+    const size_t step = pairs / threads + 1;
+    for (size_t begin = 0, end = 0, count = 0; end < overlaps.size();)
+    {
+        count += overlaps[end++].size();
+        if (count >= step || end == overlaps.size())
+        {
+            futures.emplace_back(std::async(std::launch::async, filter, begin, end));
+            begin = end;
+            count = 0;
+        }
+    }
+    for (std::future<void> &f : futures)
+    {
+        f.wait();
+    }
+}
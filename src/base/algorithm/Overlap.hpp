@@ -0,0 +1,18 @@
+#pragma once
+#include <functional>
+#include "base/Geometry.hpp"
+
+
+namespace Geo
+{
+// 按左边界排序扫描求包围盒相交的矩形对,overlaps[j]为与rects[j]相交且序号小于j的矩形序号
+void find_overlapped_rects(const std::vector<AABBRectParams> &rects, std::vector<std::vector<size_t>> &overlaps);
+
+// overlaps[j]为与rects1[j]相交的rects0中的矩形序号
+void find_overlapped_rects(const std::vector<AABBRectParams> &rects0, const std::vector<AABBRectParams> &rects1,
+                           std::vector<std::vector<size_t>> &overlaps);
+
+// 多线程地用is_overlapped(i, j)筛选overlaps[j]中的序号i,只保留返回true的序号
+// is_overlapped会被多个线程同时调用,只能读取图形,延迟生成的缓存需在调用前建立
+void filter_overlaps(std::vector<std::vector<size_t>> &overlaps, const std::function<bool(const size_t, const size_t)> &is_overlapped);
+} // namespace Geo
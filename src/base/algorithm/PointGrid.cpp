@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cfloat>
+#include "base/algorithm/PointGrid.hpp"
+#include "base/algorithm/Distance.hpp"
+
+
+namespace Geo
+{
+PointGrid::PointGrid(const std::vector<Point> &points, const double tolerance) : _tolerance(std::max(tolerance, 0.0))
+{
+    AABBRectParams rect{DBL_MAX, -DBL_MAX, -DBL_MAX, DBL_MAX};
+    for (const Point &point : points)
+    {
+        rect.left = std::min(rect.left, point.x);
+        rect.right = std::max(rect.right, point.x);
+        rect.bottom = std::min(rect.bottom, point.y);
+        rect.top = std::max(rect.top, point.y);
+    }
+    // 网格边长不小于容差,查询只需扫描相邻网格
+    _grid.fit(rect, points.size(), _tolerance);
+
+    _cells.reserve(points.size());
+    for (size_t i = 0, count = points.size(); i < count; ++i)
+    {
+        insert(points[i], i);
+    }
+}
+
+size_t PointGrid::size() const
+{
+    return _size;
+}
+
+bool PointGrid::empty() const
+{
+    return _size == 0;
+}
+
+void PointGrid::clear()
+{
+    _cells.clear();
+    _size = 0;
+}
+
+void PointGrid::insert(const Point &point, const size_t id)
+{
+    _cells[_grid.key(point)].push_back(Item{point, id});
+    ++_size;
+}
+
+bool PointGrid::remove(const Point &point, const size_t id)
+{
+    const auto cell = _cells.find(_grid.key(point));
+    if (cell == _cells.end())
+    {
+        return false;
+    }
+    std::vector<Item> &items = cell->second;
+    const auto it = std::find_if(items.begin(), items.end(), [=](const Item &item) { return item.id == id; });
+    if (it == items.end())
+    {
+        return false;
+    }
+    *it = items.back();
+    items.pop_back();
+    if (items.empty())
+    {
+        _cells.erase(cell);
+    }
+    --_size;
+    return true;
+}
+
+size_t PointGrid::find(const Point &point) const
+{
+    size_t id = SIZE_MAX;
+    if (_size == 0)
+    {
+        return id;
+    }
+
+    const long long left = _grid.index(point.x - _tolerance), right = _grid.index(point.x + _tolerance);
+    const long long bottom = _grid.index(point.y - _tolerance), top = _grid.index(point.y + _tolerance);
+    const double tolerance = _tolerance * _tolerance;
+    for (long long col = left; col <= right; ++col)
+    {
+        for (long long row = bottom; row <= top; ++row)
+        {
+            const auto cell = _cells.find(HashGrid::key(col, row));
+            if (cell == _cells.end())
+            {
+                continue;
+            }
+            for (const Item &item : cell->second)
+            {
+                if (item.id < id && (_tolerance > 0 ? distance_square(point, item.point) < tolerance : point == item.point))
+                {
+                    id = item.id;
+                }
+            }
+        }
+    }
+    return id;
+}
+} // namespace Geo
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include "base/algorithm/HashGrid.hpp"
+
+
+namespace Geo
+{
+// 带容差的点哈希网格,网格边长不小于容差,查询只需扫描相邻网格,插入、删除和查找的期望复杂度为O(1)
+class PointGrid
+{
+private:
+    struct Item
+    {
+        Point point;
+        size_t id = 0;
+    };
+
+    double _tolerance = 0;
+    HashGrid _grid;
+    size_t _size = 0;
+    std::unordered_map<unsigned long long, std::vector<Item>> _cells;
+
+public:
+    // 由points的范围和数量确定网格边长,并以points中的序号为id插入所有点,tolerance为0时只匹配坐标完全相同的点
+    PointGrid(const std::vector<Point> &points, const double tolerance);
+
+    size_t size() const;
+
+    bool empty() const;
+
+    void clear();
+
+    void insert(const Point &point, const size_t id);
+
+    bool remove(const Point &point, const size_t id);
+
+    // 返回与point距离小于容差的点中最小的id,没有时返回SIZE_MAX
+    size_t find(const Point &point) const;
+};
+} // namespace Geo
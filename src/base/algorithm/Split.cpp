@@ -363,13 +363,7 @@ bool Geo::split(const BSpline &bspline, const bool is_cubic, const Point &pos, B
         double min_dis[2] = {DBL_MAX, DBL_MAX};
         while (t <= knots[nplusc - 1])
         {
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts; ++i)
-            {
-                coord += bspline.control_points[i] * nbasis[i];
-            }
+            const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, npts, knots, bspline.control_points);
             if (double dis = Geo::distance(coord, pos); dis < min_dis[0])
             {
                 temp.clear();
@@ -394,13 +388,7 @@ bool Geo::split(const BSpline &bspline, const bool is_cubic, const Point &pos, B
                 for (double x = lower; x < upper + step; x += step)
                 {
                     x = x < upper ? x : upper;
-                    std::vector<double> nbasis;
-                    Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                    Geo::Point coord;
-                    for (size_t i = 0; i < npts; ++i)
-                    {
-                        coord += bspline.control_points[i] * nbasis[i];
-                    }
+                    const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                     if (double dis = Geo::distance(pos, coord); dis < min_dis[1])
                     {
                         min_dis[1] = dis;
@@ -425,13 +413,7 @@ bool Geo::split(const BSpline &bspline, const bool is_cubic, const Point &pos, B
                 for (double x = lower, dis0 = 0; x < upper + step; x += step)
                 {
                     x = x < upper ? x : upper;
-                    std::vector<double> nbasis;
-                    Geo::BSpline::rbasis(is_cubic ? 3 : 2, x, npts, knots, nbasis);
-                    Geo::Point coord;
-                    for (size_t i = 0; i < npts; ++i)
-                    {
-                        coord += bspline.control_points[i] * nbasis[i];
-                    }
+                    const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, x, npts, knots, bspline.control_points);
                     if (const double dis = Geo::distance(coord, pos) * 1e9; dis < min_dis[1])
                     {
                         min_dis[1] = dis;
@@ -497,13 +479,7 @@ bool Geo::split(const BSpline &bspline, const bool is_cubic, const Point &pos, B
                 }
             }
 
-            std::vector<double> nbasis;
-            Geo::BSpline::rbasis(is_cubic ? 3 : 2, v, npts, knots, nbasis);
-            Geo::Point coord;
-            for (size_t i = 0; i < npts; ++i)
-            {
-                coord += bspline.control_points[i] * nbasis[i];
-            }
+            const Geo::Point coord = Geo::BSpline::de_boor(is_cubic ? 3 : 2, v, npts, knots, bspline.control_points);
             result.emplace_back(std::min(min_dis[0], min_dis[1]), v, coord);
         }
 
@@ -655,16 +631,7 @@ bool Geo::split(const BSpline &bspline, const bool is_cubic, const double t, BSp
 
     std::vector<double> knots = bspline.knots();
     const size_t p = is_cubic ? 3 : 2;
-    std::vector<double> nbasis;
-    Geo::Point anchor;
-    {
-        const size_t npts = bspline.control_points.size();
-        Geo::BSpline::rbasis(is_cubic ? 3 : 2, t, npts, knots, nbasis);
-        for (size_t i = 0; i < npts; ++i)
-        {
-            anchor += bspline.control_points[i] * nbasis[i];
-        }
-    }
+    const Geo::Point anchor = Geo::BSpline::de_boor(is_cubic ? 3 : 2, t, bspline.control_points.size(), knots, bspline.control_points);
     size_t k = 0, anchor_index = 1;
     for (size_t i = 1, count = knots.size(); i < count; ++i)
     {
@@ -863,97 +830,22 @@ bool Geo::split(const Polyline &polyline, const size_t n, std::vector<std::tuple
 bool Geo::split(const CubicBezier &bezier, const size_t n, std::vector<std::tuple<size_t, double>> &pos)
 {
     const size_t parts = bezier.size() / 3;
-    std::vector<double> length_of_part;
-    double part_length = 0;
-    for (size_t i = 0; i < parts; ++i)
-    {
-        Math::CurveNorm f = [&, i](const double t) { return bezier.tangent(i, t).length(); };
-        length_of_part.push_back(Math::adaptive_simpson_3_8(f, 0, 1));
-        part_length += length_of_part.back();
-    }
-    part_length /= n;
-    const double eps = 1e-11;
-    for (size_t i = 1, index = 0; i < n; ++i)
+    const double part_length = bezier.length() / n;
+    for (size_t i = 1; i < n; ++i)
     {
-        double target_length = part_length;
-        while (index < parts && target_length > length_of_part[index])
-        {
-            target_length -= length_of_part[index];
-            length_of_part[index] = 0;
-            ++index;
-        }
-
-        Math::CurveNorm f = [&, index](const double t) { return bezier.tangent(index, t).length(); };
-        double last_t = 0, t = 0.5;
-        const double t0 = (!pos.empty() && std::get<0>(pos.back()) == index) ? std::get<1>(pos.back()) : 0;
-        double approx_length = 0;
-        for (int j = 0; j < 1000; ++j)
-        {
-            approx_length = Math::adaptive_simpson_3_8(f, t0, t);
-            const double d = approx_length - target_length;
-            if (std::abs(d) < eps)
-            {
-                break;
-            }
-
-            const double first_order = bezier.derivative(index, t, 1).length();
-            const double second_order = bezier.derivative(index, t, 2).length();
-            const double numerator = d * first_order;
-            const double denominator = d * second_order + first_order * first_order;
-            t -= (numerator / denominator);
-            if (std::abs(t - last_t) < eps)
-            {
-                break;
-            }
-            else
-            {
-                last_t = t;
-            }
-        }
-
-        length_of_part[index] -= approx_length;
-        pos.emplace_back(index, std::min(1.0, std::max(t0, t)));
+        const double t = bezier.length_to_param(part_length * i);
+        const size_t index = std::min<size_t>(t, parts - 1);
+        pos.emplace_back(index, std::min(1.0, t - index));
     }
     return !pos.empty();
 }
 
 bool Geo::split(const BSpline &bspline, const size_t n, std::vector<double> &pos)
 {
-    const double max_t = bspline.knots().back();
-    const double step_t = max_t / n;
-    const double total_length = bspline.length();
-    const double part_length = total_length / n;
-    const double eps = 1e-11;
-    double t0 = bspline.knots().front();
-    const Math::CurveNorm f = [&](const double t) { return bspline.tangent(t).length(); };
+    const double part_length = bspline.length() / n;
     for (size_t i = 1; i < n; ++i)
     {
-        double approx_length = 0, t = t0 + step_t, last_t = t0;
-        for (int j = 0; j < 1000; ++j)
-        {
-            approx_length = Math::adaptive_simpson_3_8(f, t0, t);
-            const double d = approx_length - part_length;
-            if (std::abs(d) < eps)
-            {
-                break;
-            }
-
-            const double first_order = bspline.derivative(t, 1).length();
-            const double second_order = bspline.derivative(t, 2).length();
-            const double numerator = d * first_order;
-            const double denominator = d * second_order + first_order * first_order;
-            t -= (numerator / denominator);
-            if (std::abs(t - last_t) < eps)
-            {
-                break;
-            }
-            else
-            {
-                last_t = t;
-            }
-        }
-        pos.push_back(t);
-        t0 = t;
+        pos.push_back(bspline.length_to_param(part_length * i));
     }
     return !pos.empty();
 }
@@ -966,27 +858,9 @@ bool Geo::split(const Ellipse &ellipse, const size_t n, std::vector<double> &pos
     }
 
     const double part_length = ellipse.length() / n;
-    const double a = ellipse.lengtha(), b = ellipse.lengthb();
-    const double angle1 = ellipse.arc_param1();
-    double t = ellipse.arc_param0();
     for (size_t i = 1; i < n; ++i)
     {
-        double low = t, high = angle1 < t ? angle1 + Math::PI * 2 : angle1;
-        while (high - low > 1e-14)
-        {
-            const double mid = (low + high) / 2;
-            const double length_mid = Math::ellipse_arc_length(a, b, t, mid);
-            if (length_mid < part_length)
-            {
-                low = mid;
-            }
-            else
-            {
-                high = mid;
-            }
-        }
-        t = (low + high) / 2;
-        pos.push_back(t);
+        pos.push_back(ellipse.length_to_param(part_length * i));
     }
     return !pos.empty();
 }
@@ -1026,96 +900,20 @@ bool Geo::split(const Polyline &polyline, const double step, std::vector<std::tu
 bool Geo::split(const CubicBezier &bezier, const double step, std::vector<std::tuple<size_t, double>> &pos)
 {
     const size_t parts = bezier.size() / 3;
-    std::vector<double> length_of_part;
-    double bezier_length = 0;
-    for (size_t i = 0; i < parts; ++i)
+    for (size_t i = 1, n = bezier.length() / step; i <= n; ++i)
     {
-        Math::CurveNorm f = [&, i](const double t) { return bezier.tangent(i, t).length(); };
-        length_of_part.push_back(Math::adaptive_simpson_3_8(f, 0, 1));
-        bezier_length += length_of_part.back();
-    }
-    const double eps = 1e-11;
-    for (size_t i = 0, index = 0, n = bezier_length / step; i < n; ++i)
-    {
-        double target_length = step;
-        while (index < parts && target_length > length_of_part[index])
-        {
-            target_length -= length_of_part[index];
-            length_of_part[index] = 0;
-            ++index;
-        }
-
-        Math::CurveNorm f = [&, index](const double t) { return bezier.tangent(index, t).length(); };
-        double last_t = 0, t = 0.5;
-        const double t0 = (!pos.empty() && std::get<0>(pos.back()) == index) ? std::get<1>(pos.back()) : 0;
-        double approx_length = 0;
-        for (int j = 0; j < 1000; ++j)
-        {
-            approx_length = Math::adaptive_simpson_3_8(f, t0, t);
-            const double d = approx_length - target_length;
-            if (std::abs(d) < eps)
-            {
-                break;
-            }
-
-            const double first_order = bezier.derivative(index, t, 1).length();
-            const double second_order = bezier.derivative(index, t, 2).length();
-            const double numerator = d * first_order;
-            const double denominator = d * second_order + first_order * first_order;
-            t -= (numerator / denominator);
-            if (std::abs(t - last_t) < eps)
-            {
-                break;
-            }
-            else
-            {
-                last_t = t;
-            }
-        }
-
-        length_of_part[index] -= approx_length;
-        pos.emplace_back(index, std::min(1.0, std::max(t0, t)));
+        const double t = bezier.length_to_param(step * i);
+        const size_t index = std::min<size_t>(t, parts - 1);
+        pos.emplace_back(index, std::min(1.0, t - index));
     }
     return !pos.empty();
 }
 
 bool Geo::split(const BSpline &bspline, const double step, std::vector<double> &pos)
 {
-    const double max_t = bspline.knots().back();
-    const double total_length = bspline.length();
-    const size_t n = total_length / step;
-    const double step_t = max_t / n;
-    const double eps = 1e-11;
-    double t0 = bspline.knots().front();
-    const Math::CurveNorm f = [&](const double t) { return bspline.tangent(t).length(); };
-    for (size_t i = 0; i < n; ++i)
+    for (size_t i = 1, n = bspline.length() / step; i <= n; ++i)
     {
-        double approx_length = 0, t = t0 + step_t, last_t = t0;
-        for (int j = 0; j < 1000; ++j)
-        {
-            approx_length = Math::adaptive_simpson_3_8(f, t0, t);
-            const double d = approx_length - step;
-            if (std::abs(d) < eps)
-            {
-                break;
-            }
-
-            const double first_order = bspline.derivative(t, 1).length();
-            const double second_order = bspline.derivative(t, 2).length();
-            const double numerator = d * first_order;
-            const double denominator = d * second_order + first_order * first_order;
-            t -= (numerator / denominator);
-            if (std::abs(t - last_t) < eps)
-            {
-                break;
-            }
-            else
-            {
-                last_t = t;
-            }
-        }
-        pos.push_back(t);
-        t0 = t;
+        pos.push_back(bspline.length_to_param(step * i));
     }
     return !pos.empty();
 }
@@ -1140,27 +938,9 @@ bool Geo::split(const Ellipse &ellipse, const double step, std::vector<double> &
         return false;
     }
 
-    const double a = ellipse.lengtha(), b = ellipse.lengthb();
-    const double angle1 = ellipse.arc_param1();
-    double t = ellipse.arc_param0();
-    for (size_t i = 0, n = ellipse.length() / step; i < n; ++i)
+    for (size_t i = 1, n = ellipse.length() / step; i <= n; ++i)
     {
-        double low = t, high = angle1 < t ? angle1 + Math::PI * 2 : angle1;
-        while (high - low > 1e-14)
-        {
-            const double mid = (low + high) / 2;
-            const double length_mid = Math::ellipse_arc_length(a, b, t, mid);
-            if (length_mid < step)
-            {
-                low = mid;
-            }
-            else
-            {
-                high = mid;
-            }
-        }
-        t = (low + high) / 2;
-        pos.push_back(t);
+        pos.push_back(ellipse.length_to_param(step * i));
     }
     return !pos.empty();
 }
\ No newline at end of file
@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <future>
+#include <iterator>
+#include <utility>
 #include <QPainter>
 #include <QPainterPath>
 #include "base/Algorithm.hpp"
@@ -17,6 +20,16 @@ Canvas::Canvas(QWidget *parent) : QOpenGLWidget(parent), _input_line(this), _men
 
 Canvas::~Canvas()
 {
+    {
+        std::lock_guard<std::mutex> lock(_catch_worker.mutex);
+        _catch_worker.quit = true;
+    }
+    _catch_worker.condition.notify_one();
+    if (_catch_worker.thread.joinable())
+    {
+        _catch_worker.thread.join();
+    }
+
     makeCurrent();
     {
         unsigned int temp[4] = {_base_vbo.origin_and_select_rect, _base_vbo.catched_points, _base_vbo.operation_shape,
@@ -28,35 +41,37 @@ Canvas::~Canvas()
         glDeleteBuffers(4, temp);
     }
     {
-        unsigned int temp[7] = {_shape_vbo.polyline,
+        unsigned int temp[9] = {_shape_vbo.polyline,
                                 _shape_vbo.polygon,
                                 _shape_vbo.circle,
                                 _shape_vbo.curve,
                                 _shape_vbo.circle_printable_points,
                                 _shape_vbo.curve_printable_points,
-                                _shape_vbo.point};
-        glDeleteBuffers(7, temp);
+                                _shape_vbo.point,
+                                _shape_vbo.array,
+                                _shape_vbo.array_instance};
+        glDeleteBuffers(9, temp);
     }
     {
-        unsigned int temp[4] = {_shape_ibo.polyline, _shape_ibo.polygon, _shape_ibo.circle, _shape_ibo.curve};
-        glDeleteBuffers(4, temp);
+        unsigned int temp[5] = {_shape_ibo.polyline, _shape_ibo.polygon, _shape_ibo.circle, _shape_ibo.curve, _shape_ibo.array};
+        glDeleteBuffers(5, temp);
     }
     {
-        unsigned int temp[5] = {_selected_ibo.polyline, _selected_ibo.polygon, _selected_ibo.circle, _selected_ibo.curve,
-                                _selected_ibo.point};
-        glDeleteBuffers(5, temp);
+        unsigned int temp[6] = {_selected_vbo.polyline, _selected_vbo.polygon, _selected_vbo.circle, _selected_vbo.curve,
+                                _selected_vbo.point,    _selected_vbo.array};
+        glDeleteBuffers(6, temp);
     }
     {
         unsigned int temp[2] = {_texture.vbo, _texture.ibo};
         glDeleteBuffers(2, temp);
     }
     {
-        unsigned int temp[16] = {_vao.polyline, _vao.polygon, _vao.circle, _vao.curve, _vao.point,
+        unsigned int temp[17] = {_vao.polyline, _vao.polygon, _vao.circle, _vao.curve, _vao.point,
                                  _vao.circle_printable_points, _vao.curve_printable_points,
                                  _vao.dim_lines, _vao.dim_arrows, _vao.dim_selected_lines, _vao.dim_selected_arrows,
                                  _vao.operation_shape, _vao.operation_tool_lines, _vao.catched_points,
-                                 _vao.origin_and_select_rect, _vao.text};
-        glDeleteVertexArrays(16, temp);
+                                 _vao.origin_and_select_rect, _vao.text, _vao.array};
+        glDeleteVertexArrays(17, temp);
     }
     glDeleteProgram(_shader_program);
     doneCurrent();
@@ -69,6 +84,7 @@ void Canvas::init()
     CanvasOperations::CanvasOperation::operation().init();
     _cpus = std::max(2u, std::thread::hardware_concurrency() / 2);
     _input_line.hide();
+    _catch_worker.thread = std::thread(&Canvas::catch_worker_loop, this);
 }
 
 Editor &Canvas::editor()
@@ -115,9 +131,13 @@ void Canvas::initializeGL()
     _uniforms.ctm = glGetUniformLocation(_shader_program, "ctm");
     _uniforms.color = glGetUniformLocation(_shader_program, "color");
     _uniforms.enable_tex = glGetUniformLocation(_shader_program, "enableTex");
+    _uniforms.selected_color = glGetUniformLocation(_shader_program, "selectedColor");
+    _uniforms.enable_instance = glGetUniformLocation(_shader_program, "enableInstance");
 
     glUseProgram(_shader_program);
     glUniformMatrix3dv(_uniforms.ctm, 1, GL_FALSE, _canvas_ctm); // ctm
+    glUniform4f(_uniforms.selected_color, 1.0f, 0.0f, 0.0f, 1.0f);
+    glUniform1i(_uniforms.enable_instance, 0);
 
     {
         unsigned int temp[4];
@@ -136,8 +156,8 @@ void Canvas::initializeGL()
         _dimension_vbo.selected_arrows = temp[3];
     }
     {
-        unsigned int temp[7];
-        glCreateBuffers(7, temp);
+        unsigned int temp[9];
+        glCreateBuffers(9, temp);
         _shape_vbo.polyline = temp[0];
         _shape_vbo.polygon = temp[1];
         _shape_vbo.circle = temp[2];
@@ -145,23 +165,27 @@ void Canvas::initializeGL()
         _shape_vbo.circle_printable_points = temp[4];
         _shape_vbo.curve_printable_points = temp[5];
         _shape_vbo.point = temp[6];
+        _shape_vbo.array = temp[7];
+        _shape_vbo.array_instance = temp[8];
     }
     {
-        unsigned int temp[4];
-        glCreateBuffers(4, temp);
+        unsigned int temp[5];
+        glCreateBuffers(5, temp);
         _shape_ibo.polyline = temp[0];
         _shape_ibo.polygon = temp[1];
         _shape_ibo.circle = temp[2];
         _shape_ibo.curve = temp[3];
+        _shape_ibo.array = temp[4];
     }
     {
-        unsigned int temp[5];
-        glCreateBuffers(5, temp);
-        _selected_ibo.polyline = temp[0];
-        _selected_ibo.polygon = temp[1];
-        _selected_ibo.circle = temp[2];
-        _selected_ibo.curve = temp[3];
-        _selected_ibo.point = temp[4];
+        unsigned int temp[6];
+        glCreateBuffers(6, temp);
+        _selected_vbo.polyline = temp[0];
+        _selected_vbo.polygon = temp[1];
+        _selected_vbo.circle = temp[2];
+        _selected_vbo.curve = temp[3];
+        _selected_vbo.point = temp[4];
+        _selected_vbo.array = temp[5];
     }
 
     {
@@ -211,11 +235,18 @@ void Canvas::initializeGL()
         glEnableVertexAttribArray(0);
         glVertexAttribLPointer(0, 2, GL_DOUBLE, 2 * sizeof(double), nullptr);
     };
-    make_pos_vao(_vao.polyline, _shape_vbo.polyline);
-    make_pos_vao(_vao.polygon, _shape_vbo.polygon);
-    make_pos_vao(_vao.circle, _shape_vbo.circle);
-    make_pos_vao(_vao.curve, _shape_vbo.curve);
-    make_pos_vao(_vao.point, _shape_vbo.point);
+    // 图形 VAO 额外记录逐顶点的选中标记(location = 2),未启用该属性的 VAO 读到的标记恒为 0
+    auto make_shape_vao = [&](unsigned int &vao, const unsigned int vbo, const unsigned int selected_vbo) {
+        make_pos_vao(vao, vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, selected_vbo);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(unsigned char), nullptr);
+    };
+    make_shape_vao(_vao.polyline, _shape_vbo.polyline, _selected_vbo.polyline);
+    make_shape_vao(_vao.polygon, _shape_vbo.polygon, _selected_vbo.polygon);
+    make_shape_vao(_vao.circle, _shape_vbo.circle, _selected_vbo.circle);
+    make_shape_vao(_vao.curve, _shape_vbo.curve, _selected_vbo.curve);
+    make_shape_vao(_vao.point, _shape_vbo.point, _selected_vbo.point);
     make_pos_vao(_vao.circle_printable_points, _shape_vbo.circle_printable_points);
     make_pos_vao(_vao.curve_printable_points, _shape_vbo.curve_printable_points);
     make_pos_vao(_vao.dim_lines, _dimension_vbo.lines);
@@ -227,6 +258,17 @@ void Canvas::initializeGL()
     make_pos_vao(_vao.catched_points, _base_vbo.catched_points);
     make_pos_vao(_vao.origin_and_select_rect, _base_vbo.origin_and_select_rect);
 
+    // 阵列:选中标记和变换矩阵按实例步进(divisor = 1),矩阵两行分别占 location 3 和 4
+    make_shape_vao(_vao.array, _shape_vbo.array, _selected_vbo.array);
+    glVertexAttribDivisor(2, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.array_instance);
+    glEnableVertexAttribArray(3);
+    glVertexAttribLPointer(3, 3, GL_DOUBLE, 6 * sizeof(double), nullptr);
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(4);
+    glVertexAttribLPointer(4, 3, GL_DOUBLE, 6 * sizeof(double), (void *)(3 * sizeof(double)));
+    glVertexAttribDivisor(4, 1);
+
     // 文本四边形:位置 + 纹理坐标(stride = 4*sizeof(double)),并绑定固定的 IBO。
     glGenVertexArrays(1, &_vao.text);
     glBindVertexArray(_vao.text);
@@ -279,20 +321,54 @@ void Canvas::paintGL()
     glUseProgram(_shader_program);
     glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
+    // 只提交与可见区域相交的块,块内索引以块的起始顶点为基准顶点
+    const Geo::AABBRectParams visible_area = _visible_area.aabbrect_params();
+    std::vector<VBOChunks::Range> ranges;
+    std::vector<GLsizei> counts;
+    std::vector<const void *> offsets;
+    std::vector<GLint> firsts;
+    auto draw_chunks = [&](const VBOChunks &chunks, const GLenum mode, const bool vertices)
+    {
+        ranges.clear(), counts.clear(), offsets.clear(), firsts.clear();
+        chunks.visible_ranges(visible_area, ranges);
+        for (const VBOChunks::Range &range : ranges)
+        {
+            if (vertices)
+            {
+                counts.push_back(range.vertex_count);
+            }
+            else if (range.index_count > 0)
+            {
+                counts.push_back(range.index_count);
+                offsets.push_back(reinterpret_cast<const void *>(sizeof(unsigned int) * range.index_offset));
+            }
+            else
+            {
+                continue;
+            }
+            firsts.push_back(range.vertex_offset);
+        }
+        if (counts.empty())
+        {
+            return;
+        }
+        if (vertices)
+        {
+            glMultiDrawArrays(mode, firsts.data(), counts.data(), counts.size());
+        }
+        else
+        {
+            glMultiDrawElementsBaseVertex(mode, counts.data(), GL_UNSIGNED_INT, offsets.data(), counts.size(), firsts.data());
+        }
+    };
+
     if (_shape_index_count.polyline > 0) // polyline
     {
         glBindVertexArray(_vao.polyline);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.polyline); // polyline
         glUniform4f(_uniforms.color, 1.0f, 1.0f, 1.0f, 1.0f);       // color 绘制线 normal
-        glDrawElements(GL_LINE_STRIP, _shape_index_count.polyline, GL_UNSIGNED_INT, nullptr);
-
-        if (_selected_index_count.polyline > 0) // selected
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.polyline); // selected
-            glUniform4f(_uniforms.color, 1.0f, 0.0f, 0.0f, 1.0f);          // color 绘制线 selected
-            glDrawElements(GL_LINE_STRIP, _selected_index_count.polyline, GL_UNSIGNED_INT, nullptr);
-        }
+        draw_chunks(_chunks.polyline, GL_LINE_STRIP, false);
     }
 
     if (_shape_index_count.polygon > 0) // polygon
@@ -301,14 +377,7 @@ void Canvas::paintGL()
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.polygon); // polygon
         glUniform4f(_uniforms.color, 1.0f, 1.0f, 1.0f, 1.0f);      // color 绘制线 normal
-        glDrawElements(GL_LINE_STRIP, _shape_index_count.polygon, GL_UNSIGNED_INT, nullptr);
-
-        if (_selected_index_count.polygon > 0) // selected
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.polygon); // selected
-            glUniform4f(_uniforms.color, 1.0f, 0.0f, 0.0f, 1.0f);         // color 绘制线 selected
-            glDrawElements(GL_LINE_STRIP, _selected_index_count.polygon, GL_UNSIGNED_INT, nullptr);
-        }
+        draw_chunks(_chunks.polygon, GL_LINE_STRIP, false);
     }
 
     if (_shape_index_count.circle > 0) // circle
@@ -317,14 +386,7 @@ void Canvas::paintGL()
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.circle); // circle
         glUniform4f(_uniforms.color, 1.0f, 1.0f, 1.0f, 1.0f);     // color 绘制线 normal
-        glDrawElements(GL_LINE_STRIP, _shape_index_count.circle, GL_UNSIGNED_INT, nullptr);
-
-        if (_selected_index_count.circle > 0) // selected
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.circle); // selected
-            glUniform4f(_uniforms.color, 1.0f, 0.0f, 0.0f, 1.0f);        // color 绘制线 selected
-            glDrawElements(GL_LINE_STRIP, _selected_index_count.circle, GL_UNSIGNED_INT, nullptr);
-        }
+        draw_chunks(_chunks.circle, GL_LINE_STRIP, false);
     }
 
     if (_shape_index_count.curve > 0) // curve
@@ -333,28 +395,42 @@ void Canvas::paintGL()
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.curve); // curve
         glUniform4f(_uniforms.color, 1.0f, 1.0f, 1.0f, 1.0f);    // color 绘制线 normal
-        glDrawElements(GL_LINE_STRIP, _shape_index_count.curve, GL_UNSIGNED_INT, nullptr);
+        draw_chunks(_chunks.curve, GL_LINE_STRIP, false);
+    }
+
+    if (!_array_draws.empty()) // array
+    {
+        glBindVertexArray(_vao.array);
 
-        if (_selected_index_count.curve > 0) // selected
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.array); // array
+        glUniform4f(_uniforms.color, 1.0f, 1.0f, 1.0f, 1.0f);    // color 绘制线 normal
+        glUniform1i(_uniforms.enable_instance, 1);
+        for (const ArrayDraw &draw : _array_draws)
         {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.curve); // selected
-            glUniform4f(_uniforms.color, 1.0f, 0.0f, 0.0f, 1.0f);       // color 绘制线 selected
-            glDrawElements(GL_LINE_STRIP, _selected_index_count.curve, GL_UNSIGNED_INT, nullptr);
+            if (!Geo::is_intersected(visible_area, draw.rect))
+            {
+                continue;
+            }
+            if (draw.index_count > 0)
+            {
+                glDrawElementsInstancedBaseInstance(GL_LINE_STRIP, draw.index_count, GL_UNSIGNED_INT,
+                                                    (void *)(draw.index_offset * sizeof(unsigned int)), draw.instance_count,
+                                                    draw.instance_offset);
+            }
+            if (draw.point_count > 0)
+            {
+                glDrawArraysInstancedBaseInstance(GL_POINTS, draw.point_offset, draw.point_count, draw.instance_count,
+                                                  draw.instance_offset);
+            }
         }
+        glUniform1i(_uniforms.enable_instance, 0);
     }
 
     if (_point_count.point > 0) // point
     {
         glBindVertexArray(_vao.point);
         glUniform4f(_uniforms.color, 1.0f, 1.0f, 1.0f, 1.0f); // color 绘制线 normal
-        glDrawArrays(GL_POINTS, 0, _point_count.point);
-
-        if (_selected_index_count.point > 0) // selected
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.point); // points
-            glUniform4f(_uniforms.color, 1.0f, 0.0f, 0.0f, 1.0f);       // color 绘制线 selected
-            glDrawElements(GL_POINTS, _selected_index_count.point, GL_UNSIGNED_INT, nullptr);
-        }
+        draw_chunks(_chunks.point, GL_POINTS, true);
     }
 
     if (_point_count.dim_lines > 0 || _point_count.dim_arrows > 0)
@@ -381,16 +457,17 @@ void Canvas::paintGL()
 
     if (GlobalSetting::setting().show_points)
     {
-        glUniform4f(_uniforms.color, 0.031372f, 0.572549f, 0.815686f, 1.0f); // color
+        glUniform4f(_uniforms.color, 0.031372f, 0.572549f, 0.815686f, 1.0f);          // color
+        glUniform4f(_uniforms.selected_color, 0.031372f, 0.572549f, 0.815686f, 1.0f); // 顶点不区分选中
         if (_point_count.polyline > 0)
         {
             glBindVertexArray(_vao.polyline);
-            glDrawArrays(GL_POINTS, 0, _point_count.polyline);
+            draw_chunks(_chunks.polyline, GL_POINTS, true);
         }
         if (_point_count.polygon > 0)
         {
             glBindVertexArray(_vao.polygon);
-            glDrawArrays(GL_POINTS, 0, _point_count.polygon);
+            draw_chunks(_chunks.polygon, GL_POINTS, true);
         }
         if (_point_count.circle > 0)
         {
@@ -402,6 +479,7 @@ void Canvas::paintGL()
             glBindVertexArray(_vao.curve_printable_points);
             glDrawArrays(GL_POINTS, 0, _point_count.curve);
         }
+        glUniform4f(_uniforms.selected_color, 1.0f, 0.0f, 0.0f, 1.0f);
     }
 
     if (!CanvasOperations::CanvasOperation::shape.empty())
@@ -624,7 +702,9 @@ void Canvas::mouseMoveEvent(QMouseEvent *event)
     double canvas_x1 = real_x1 * _canvas_ctm[0] + real_y1 * _canvas_ctm[3] + _canvas_ctm[6];
     double canvas_y1 = real_x1 * _canvas_ctm[1] + real_y1 * _canvas_ctm[4] + _canvas_ctm[7];
     const bool catched_point = _bool_flags.show_catched_points;
-    if (Geo::Point coord; catch_cursor(real_x1, real_y1, coord, _catch_distance, event->buttons() & Qt::MouseButton::LeftButton))
+    _catch_worker.buttons = event->buttons();
+    _catch_worker.modifiers = event->modifiers();
+    if (Geo::Point coord; catch_cursor(real_x1, real_y1, coord, _catch_distance, event->buttons() & Qt::MouseButton::LeftButton, true))
     {
         real_x1 = coord.x, real_y1 = coord.y;
         coord = real_coord_to_view_coord(coord.x, coord.y);
@@ -656,8 +736,8 @@ void Canvas::mouseMoveEvent(QMouseEvent *event)
         makeCurrent();
         glUniformMatrix3dv(_uniforms.ctm, 1, GL_FALSE, _canvas_ctm); // ctm
         doneCurrent();
-        refresh_vbo(false);
-        refresh_selected_ibo();
+        // 常驻VBO与视图无关,平移只需更新ctm,绘制时按块剔除
+        _editor.refresh_visible_objects(_visible_area.aabbrect_params());
         update();
     }
 
@@ -1002,7 +1082,7 @@ void Canvas::add_geometry(const std::vector<Geo::Geometry *> &objects)
 
 void Canvas::show_menu(Geo::Geometry *object)
 {
-    refresh_selected_ibo(object);
+    refresh_selected_ibo();
     _menu.exec(object);
     return;
 }
@@ -1154,12 +1234,60 @@ Geo::Point Canvas::canvas_coord_to_real_coord(const double x, const double y) co
     return {(x - _canvas_ctm[6] - _canvas_ctm[3] * t) / _canvas_ctm[0], t};
 }
 
-bool Canvas::catch_cursor(const double x, const double y, Geo::Point &coord, const double distance, const bool skip_selected)
+bool Canvas::catch_cursor(const double x, const double y, Geo::Point &coord, const double distance, const bool skip_selected,
+                          const bool async)
 {
+    const size_t id = ++_catch_worker.latest_id; // 之前未完成的后台捕捉结果作废
     _catched_objects.clear();
     refresh_catached_points(x, y, distance, _catched_objects, skip_selected, !GlobalSetting::setting().to_all_layers);
     Geo::Point pos(x, y);
-    if (refresh_catchline_points(_catched_objects, distance, pos))
+    bool catched = false;
+    if (async)
+    {
+        const CanvasOperations::Tool tool = CanvasOperations::CanvasOperation::tool[0];
+        const bool drawing = tool > CanvasOperations::Tool::Move && tool < CanvasOperations::Tool::Mirror;
+        CatchedPoints points;
+        find_catched_points(_catched_objects, distance, pos, points);
+        if (CatchTask task; (_catch_types.foot || _catch_types.tangency) && drawing && !_catched_objects.empty())
+        {
+            task.id = id;
+            task.pos = pos;
+            task.press_pos.x = CanvasOperations::CanvasOperation::press_pos[0];
+            task.press_pos.y = CanvasOperations::CanvasOperation::press_pos[1];
+            task.catch_foot = _catch_types.foot;
+            task.catch_tangency = _catch_types.tangency;
+            if (_catch_worker.modification != _editor.view_modification())
+            {
+                _catch_worker.snapshots.clear();
+                _catch_worker.modification = _editor.view_modification();
+            }
+            for (const Geo::Geometry *object : _catched_objects)
+            {
+                std::shared_ptr<const Geo::Geometry> &snapshot = _catch_worker.snapshots[object];
+                if (snapshot == nullptr)
+                {
+                    snapshot.reset(object->clone());
+                }
+                task.objects.push_back(snapshot);
+            }
+            task.points = points;
+            {
+                std::lock_guard<std::mutex> lock(_catch_worker.mutex);
+                _catch_worker.task = std::move(task);
+                _catch_worker.pending = true;
+            }
+            _catch_worker.condition.notify_one();
+        }
+        // 先用顶点、中点和交点更新捕捉点,垂足和切点由后台线程补充
+        catched = apply_catched_points(points, distance, pos);
+        _catch_worker.cursor = Geo::Point(x, y);
+        _catch_worker.coord = pos;
+    }
+    else
+    {
+        catched = refresh_catchline_points(_catched_objects, distance, pos);
+    }
+    if (catched)
     {
         coord = pos;
         _bool_flags.show_catched_points = true;
@@ -1173,6 +1301,7 @@ bool Canvas::catch_cursor(const double x, const double y, Geo::Point &coord, con
 
 bool Canvas::catch_point(const double x, const double y, Geo::Point &coord, const double distance)
 {
+    ++_catch_worker.latest_id;
     _catched_objects.clear();
     if (refresh_catached_points(x, y, distance, _catched_objects, false, !GlobalSetting::setting().to_all_layers))
     {
@@ -1197,20 +1326,57 @@ bool Canvas::catch_point(const double x, const double y, Geo::Point &coord, cons
 }
 
 
+void Canvas::begin_transaction()
+{
+    _editor.begin_transaction();
+}
+
+void Canvas::commit_transaction()
+{
+    _editor.commit_transaction();
+    if (_editor.in_transaction())
+    {
+        return;
+    }
+
+    PendingRefresh pending = std::move(_pending_refresh);
+    _pending_refresh = PendingRefresh();
+    if (pending.all)
+    {
+        refresh_vbo(pending.flush);
+    }
+    else if (!pending.types.empty())
+    {
+        refresh_vbo(pending.flush, pending.types);
+    }
+    if (pending.selected)
+    {
+        refresh_selected_ibo();
+    }
+}
+
 void Canvas::refresh_vbo(const bool flush)
 {
+    if (_editor.in_transaction())
+    {
+        _pending_refresh.all = true;
+        _pending_refresh.flush |= flush;
+        return;
+    }
+
     _editor.refresh_visible_objects(_visible_area.aabbrect_params());
     std::future<VBOData> polyline_vbo = std::async(std::launch::async, &Canvas::refresh_polyline_vbo, this, flush),
                          polygon_vbo = std::async(std::launch::async, &Canvas::refresh_polygon_vbo, this, flush),
                          circle_vbo = std::async(std::launch::async, &Canvas::refresh_circle_vbo, this, flush),
                          curve_vbo = std::async(std::launch::async, &Canvas::refresh_curve_vbo, this, flush),
-                         point_vbo = std::async(std::launch::async, &Canvas::refresh_point_vbo, this, flush);
+                         point_vbo = std::async(std::launch::async, &Canvas::refresh_point_vbo, this, flush),
+                         array_vbo = std::async(std::launch::async, &Canvas::refresh_array_vbo, this, flush);
     std::future<DimVBOData> dim_vbo = std::async(std::launch::async, &Canvas::refresh_dimension_vbo, this, flush);
     std::future<VBOData> circle_printable_points, curve_printable_points;
     if (GlobalSetting::setting().show_points)
     {
-        circle_printable_points = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this);
-        curve_printable_points = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this);
+        circle_printable_points = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this, flush);
+        curve_printable_points = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this, flush);
     }
 
     makeCurrent();
@@ -1232,46 +1398,46 @@ void Canvas::refresh_vbo(const bool flush)
     }
 
     circle_vbo.wait();
-    if (VBOData data = circle_vbo.get(); !data.vbo_data.empty())
+    if (VBOData data = circle_vbo.get(); !data.chunks.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.circle); // circle
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.circle);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.circle, _selected_vbo.circle, _shape_ibo.circle);
     }
 
     curve_vbo.wait();
-    if (VBOData data = curve_vbo.get(); !data.vbo_data.empty())
+    if (VBOData data = curve_vbo.get(); !data.chunks.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.curve); // curve
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.curve);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.curve, _selected_vbo.curve, _shape_ibo.curve);
     }
 
     polyline_vbo.wait();
-    if (VBOData data = polyline_vbo.get(); !data.vbo_data.empty())
+    if (VBOData data = polyline_vbo.get(); !data.chunks.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.polyline);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.polyline);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.polyline, _selected_vbo.polyline, _shape_ibo.polyline);
     }
 
     polygon_vbo.wait();
-    if (VBOData data = polygon_vbo.get(); !data.vbo_data.empty())
+    if (VBOData data = polygon_vbo.get(); !data.chunks.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.polygon);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.polygon);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.polygon, _selected_vbo.polygon, _shape_ibo.polygon);
     }
 
     point_vbo.wait();
-    if (VBOData data = point_vbo.get(); !data.vbo_data.empty())
+    if (VBOData data = point_vbo.get(); !data.chunks.empty())
+    {
+        upload_chunks(data.chunks, _shape_vbo.point, _selected_vbo.point, 0);
+    }
+
+    array_vbo.wait();
+    if (VBOData data = array_vbo.get(); !data.instance_data.empty())
     {
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.point); // point
+        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.array); // array
         glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.array_instance);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.instance_data.size(), data.instance_data.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, _selected_vbo.array);
+        glBufferData(GL_ARRAY_BUFFER, data.selected_data.size(), data.selected_data.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.array);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
     }
 
     dim_vbo.wait();
@@ -1288,28 +1454,29 @@ void Canvas::refresh_vbo(const bool flush)
 
 void Canvas::refresh_vbo(const bool flush, const Geo::Type type)
 {
+    if (_editor.in_transaction())
+    {
+        _pending_refresh.types.insert(type);
+        _pending_refresh.flush |= flush;
+        return;
+    }
+
     _editor.refresh_visible_objects(_visible_area.aabbrect_params());
     switch (type)
     {
     case Geo::Type::POLYLINE:
-        if (VBOData data = refresh_polyline_vbo(flush); !data.vbo_data.empty())
+        if (VBOData data = refresh_polyline_vbo(flush); !data.chunks.empty())
         {
             makeCurrent();
-            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.polyline);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.polyline);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+            upload_chunks(data.chunks, _shape_vbo.polyline, _selected_vbo.polyline, _shape_ibo.polyline);
             doneCurrent();
         }
         break;
     case Geo::Type::POLYGON:
-        if (VBOData data = refresh_polygon_vbo(flush); !data.vbo_data.empty())
+        if (VBOData data = refresh_polygon_vbo(flush); !data.chunks.empty())
         {
             makeCurrent();
-            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.polygon);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.polygon);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+            upload_chunks(data.chunks, _shape_vbo.polygon, _selected_vbo.polygon, _shape_ibo.polygon);
             doneCurrent();
         }
         break;
@@ -1320,15 +1487,12 @@ void Canvas::refresh_vbo(const bool flush, const Geo::Type type)
             std::future<VBOData> point;
             if (GlobalSetting::setting().show_points)
             {
-                point = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this);
+                point = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this, flush);
             }
-            if (VBOData data = refresh_circle_vbo(flush); !data.vbo_data.empty())
+            if (VBOData data = refresh_circle_vbo(flush); !data.chunks.empty())
             {
                 makeCurrent();
-                glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.circle);
-                glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.circle);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+                upload_chunks(data.chunks, _shape_vbo.circle, _selected_vbo.circle, _shape_ibo.circle);
                 doneCurrent();
             }
             if (GlobalSetting::setting().show_points)
@@ -1350,15 +1514,12 @@ void Canvas::refresh_vbo(const bool flush, const Geo::Type type)
             std::future<VBOData> point;
             if (GlobalSetting::setting().show_points)
             {
-                point = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this);
+                point = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this, flush);
             }
-            if (VBOData data = refresh_curve_vbo(flush); !data.vbo_data.empty())
+            if (VBOData data = refresh_curve_vbo(flush); !data.chunks.empty())
             {
                 makeCurrent();
-                glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.curve);
-                glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.curve);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+                upload_chunks(data.chunks, _shape_vbo.curve, _selected_vbo.curve, _shape_ibo.curve);
                 doneCurrent();
             }
             if (GlobalSetting::setting().show_points)
@@ -1377,11 +1538,25 @@ void Canvas::refresh_vbo(const bool flush, const Geo::Type type)
     case Geo::Type::TEXT:
         break;
     case Geo::Type::POINT:
-        if (VBOData data = refresh_point_vbo(flush); !data.vbo_data.empty())
+        if (VBOData data = refresh_point_vbo(flush); !data.chunks.empty())
+        {
+            makeCurrent();
+            upload_chunks(data.chunks, _shape_vbo.point, _selected_vbo.point, 0);
+            doneCurrent();
+        }
+        break;
+    case Geo::Type::ARRAY:
+        if (VBOData data = refresh_array_vbo(flush); !data.instance_data.empty())
         {
             makeCurrent();
-            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.point); // point
+            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.array); // array
             glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.array_instance);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.instance_data.size(), data.instance_data.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, _selected_vbo.array);
+            glBufferData(GL_ARRAY_BUFFER, data.selected_data.size(), data.selected_data.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.array);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
             doneCurrent();
         }
         break;
@@ -1408,9 +1583,16 @@ void Canvas::refresh_vbo(const bool flush, const std::set<Geo::Type> &types)
     {
         return refresh_vbo(flush);
     }
+    if (_editor.in_transaction())
+    {
+        _pending_refresh.types.insert(types.begin(), types.end());
+        _pending_refresh.flush |= flush;
+        return;
+    }
 
     _editor.refresh_visible_objects(_visible_area.aabbrect_params());
-    std::future<VBOData> polyline_vbo, polygon_vbo, circle_vbo, curve_vbo, circle_printable_points, curve_printable_points, point_vbo;
+    std::future<VBOData> polyline_vbo, polygon_vbo, circle_vbo, curve_vbo, circle_printable_points, curve_printable_points, point_vbo,
+        array_vbo;
     std::future<DimVBOData> dimension_vbo;
 
     if (types.find(Geo::Type::POLYLINE) != types.end())
@@ -1434,6 +1616,10 @@ void Canvas::refresh_vbo(const bool flush, const std::set<Geo::Type> &types)
     {
         point_vbo = std::async(std::launch::async, &Canvas::refresh_point_vbo, this, flush);
     }
+    if (types.find(Geo::Type::ARRAY) != types.end())
+    {
+        array_vbo = std::async(std::launch::async, &Canvas::refresh_array_vbo, this, flush);
+    }
     if (types.find(Geo::Type::DIMENSION) != types.end())
     {
         dimension_vbo = std::async(std::launch::async, &Canvas::refresh_dimension_vbo, this, flush);
@@ -1443,11 +1629,11 @@ void Canvas::refresh_vbo(const bool flush, const std::set<Geo::Type> &types)
         if (types.find(Geo::Type::CIRCLE) != types.end() || types.find(Geo::Type::ELLIPSE) != types.end() ||
             types.find(Geo::Type::ARC) != types.end())
         {
-            circle_printable_points = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this);
+            circle_printable_points = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this, flush);
         }
         if (types.find(Geo::Type::BEZIER) != types.end() || types.find(Geo::Type::BSPLINE) != types.end())
         {
-            curve_printable_points = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this);
+            curve_printable_points = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this, flush);
         }
     }
 
@@ -1478,58 +1664,61 @@ void Canvas::refresh_vbo(const bool flush, const std::set<Geo::Type> &types)
     if (circle_vbo.valid())
     {
         circle_vbo.wait();
-        if (VBOData data = circle_vbo.get(); !data.vbo_data.empty())
+        if (VBOData data = circle_vbo.get(); !data.chunks.empty())
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.circle); // circle
-            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.circle);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+            upload_chunks(data.chunks, _shape_vbo.circle, _selected_vbo.circle, _shape_ibo.circle);
         }
     }
 
     if (curve_vbo.valid())
     {
         curve_vbo.wait();
-        if (VBOData data = curve_vbo.get(); !data.vbo_data.empty())
+        if (VBOData data = curve_vbo.get(); !data.chunks.empty())
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.curve); // curve
-            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.curve);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+            upload_chunks(data.chunks, _shape_vbo.curve, _selected_vbo.curve, _shape_ibo.curve);
         }
     }
 
     if (polyline_vbo.valid())
     {
         polyline_vbo.wait();
-        if (VBOData data = polyline_vbo.get(); !data.vbo_data.empty())
+        if (VBOData data = polyline_vbo.get(); !data.chunks.empty())
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.polyline);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.polyline);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+            upload_chunks(data.chunks, _shape_vbo.polyline, _selected_vbo.polyline, _shape_ibo.polyline);
         }
     }
 
     if (polygon_vbo.valid())
     {
         polygon_vbo.wait();
-        if (VBOData data = polygon_vbo.get(); !data.vbo_data.empty())
+        if (VBOData data = polygon_vbo.get(); !data.chunks.empty())
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.polygon);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.polygon);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
+            upload_chunks(data.chunks, _shape_vbo.polygon, _selected_vbo.polygon, _shape_ibo.polygon);
         }
     }
 
     if (point_vbo.valid())
     {
         point_vbo.wait();
-        if (VBOData data = point_vbo.get(); !data.vbo_data.empty())
+        if (VBOData data = point_vbo.get(); !data.chunks.empty())
+        {
+            upload_chunks(data.chunks, _shape_vbo.point, _selected_vbo.point, 0);
+        }
+    }
+
+    if (array_vbo.valid())
+    {
+        array_vbo.wait();
+        if (VBOData data = array_vbo.get(); !data.instance_data.empty())
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.point); // point
+            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.array); // array
             glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.array_instance);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.instance_data.size(), data.instance_data.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, _selected_vbo.array);
+            glBufferData(GL_ARRAY_BUFFER, data.selected_data.size(), data.selected_data.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _shape_ibo.array);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.ibo_data.size(), data.ibo_data.data(), GL_DYNAMIC_DRAW);
         }
     }
 
@@ -1548,338 +1737,421 @@ void Canvas::refresh_vbo(const bool flush, const std::set<Geo::Type> &types)
     doneCurrent();
 }
 
-Canvas::VBOData Canvas::refresh_polyline_vbo(const bool flush)
+bool Canvas::refresh_vbo(const Geo::Geometry *object)
 {
-    VBOData result;
-    _visible_objects[0].polyline = _visible_objects[1].polyline;
-    _visible_objects[1].polyline.clear();
-    for (Geo::Geometry *geo : _editor.visible_objects())
+    VBOChunks::Uploads uploads;
+    if ((object->type() != Geo::Type::BEZIER && object->type() != Geo::Type::BSPLINE) ||
+        !_chunks.curve.patch(object, &Canvas::write_curve, [this](const Geo::Geometry *owner) { return is_marked_selected(owner); },
+                             uploads))
     {
-        if (geo->type() == Geo::Type::POLYLINE)
-        {
-            _visible_objects[1].polyline.push_back(static_cast<Geo::Polyline *>(geo));
-        }
-        else if (geo->type() == Geo::Type::COMBINATION)
-        {
-            for (Geo::Geometry *child : *static_cast<Combination *>(geo))
-            {
-                if (child->type() == Geo::Type::POLYLINE)
-                {
-                    _visible_objects[1].polyline.push_back(static_cast<Geo::Polyline *>(child));
-                }
-            }
-        }
+        return false;
     }
 
-    if (CanvasOperations::CanvasOperation::tool[0] == CanvasOperations::Tool::Select && !flush &&
-        _visible_objects[0].polyline == _visible_objects[1].polyline)
+    std::future<VBOData> point;
+    if (GlobalSetting::setting().show_points)
     {
-        return result;
+        point = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this, true);
     }
-
-    for (Geo::Polyline *polyline : _visible_objects[1].polyline)
+    makeCurrent();
+    upload_chunks(uploads, _shape_vbo.curve, _selected_vbo.curve, _shape_ibo.curve);
+    doneCurrent();
+    if (GlobalSetting::setting().show_points)
     {
-        polyline->point_index = result.vbo_data.size() / 2;
-        for (const Geo::Point &point : *polyline)
+        point.wait();
+        if (VBOData data = point.get(); !data.vbo_data.empty())
         {
-            result.ibo_data.push_back(result.vbo_data.size() / 2);
-            result.vbo_data.push_back(point.x);
-            result.vbo_data.push_back(point.y);
+            makeCurrent();
+            glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.curve_printable_points); // curve printable points
+            glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+            doneCurrent();
         }
-        result.ibo_data.push_back(UINT_MAX);
-        polyline->point_count = polyline->size();
     }
-    _point_count.polyline = result.vbo_data.size() / 2;
-    _shape_index_count.polyline = result.ibo_data.size();
-    return result;
+    return true;
 }
 
-Canvas::VBOData Canvas::refresh_polygon_vbo(const bool flush)
+std::vector<VBOChunks::Item> Canvas::resident_items(const std::set<Geo::Type> &types) const
 {
-    VBOData result;
-    _visible_objects[0].polygon = _visible_objects[1].polygon;
-    _visible_objects[1].polygon.clear();
-    for (Geo::Geometry *geo : _editor.visible_objects())
+    std::vector<VBOChunks::Item> items;
+    for (const ContainerGroup &group : _editor.graph()->container_groups())
     {
-        if (geo->type() == Geo::Type::POLYGON)
+        if (!group.visible())
         {
-            _visible_objects[1].polygon.push_back(static_cast<Geo::Polygon *>(geo));
+            continue;
         }
-        else if (geo->type() == Geo::Type::COMBINATION)
+
+        for (Geo::Geometry *geo : group)
         {
-            for (Geo::Geometry *child : *static_cast<Combination *>(geo))
+            if (types.find(geo->type()) != types.end())
+            {
+                items.push_back(VBOChunks::Item{geo, geo});
+            }
+            else if (geo->type() == Geo::Type::COMBINATION)
             {
-                if (child->type() == Geo::Type::POLYGON)
+                for (Geo::Geometry *child : *static_cast<Combination *>(geo))
                 {
-                    _visible_objects[1].polygon.push_back(static_cast<Geo::Polygon *>(child));
+                    if (types.find(child->type()) != types.end())
+                    {
+                        items.push_back(VBOChunks::Item{child, geo});
+                    }
                 }
             }
         }
     }
+    return items;
+}
 
-    if (CanvasOperations::CanvasOperation::tool[0] == CanvasOperations::Tool::Select && !flush &&
-        _visible_objects[0].polygon == _visible_objects[1].polygon)
+void Canvas::upload_chunks(const VBOChunks::Uploads &uploads, const unsigned int vbo, const unsigned int selected_vbo,
+                           const unsigned int ibo)
+{
+    if (uploads.reallocate)
     {
-        return result;
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * 2 * uploads.vertex_capacity, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, selected_vbo);
+        glBufferData(GL_ARRAY_BUFFER, uploads.vertex_capacity, nullptr, GL_DYNAMIC_DRAW);
+        if (ibo != 0)
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * uploads.index_capacity, nullptr, GL_DYNAMIC_DRAW);
+        }
     }
 
-    for (Geo::Polygon *polygon : _visible_objects[1].polygon)
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    for (const VBOChunks::Upload &upload : uploads.chunks)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(double) * 2 * upload.vertex_offset, sizeof(double) * upload.vbo_data.size(),
+                        upload.vbo_data.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, selected_vbo);
+    for (const VBOChunks::Upload &upload : uploads.chunks)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, upload.vertex_offset, upload.selected_data.size(), upload.selected_data.data());
+    }
+    if (ibo != 0)
     {
-        polygon->point_index = result.vbo_data.size() / 2;
-        for (const Geo::Point &point : *polygon)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        for (const VBOChunks::Upload &upload : uploads.chunks)
         {
-            result.ibo_data.push_back(result.vbo_data.size() / 2);
-            result.vbo_data.push_back(point.x);
-            result.vbo_data.push_back(point.y);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * upload.index_offset,
+                            sizeof(unsigned int) * upload.ibo_data.size(), upload.ibo_data.data());
         }
-        result.ibo_data.push_back(UINT_MAX);
-        polygon->point_count = polygon->size();
     }
-    _point_count.polygon = result.vbo_data.size() / 2;
-    _shape_index_count.polygon = result.ibo_data.size();
-    return result;
 }
 
-Canvas::VBOData Canvas::refresh_circle_vbo(const bool flush)
+Canvas::VBOData Canvas::refresh_polyline_vbo(const bool flush)
 {
     VBOData result;
-    _visible_objects[0].circle = _visible_objects[1].circle;
-    _visible_objects[1].circle.clear();
-    for (Geo::Geometry *geo : _editor.visible_objects())
+    const double pixel = 1 / _ratio;
+    if (!flush && !_chunks.polyline.outdated(_editor, pixel))
     {
-        if (geo->type() == Geo::Type::CIRCLE || geo->type() == Geo::Type::ARC || geo->type() == Geo::Type::ELLIPSE)
-        {
-            _visible_objects[1].circle.push_back(geo);
-        }
-        else if (geo->type() == Geo::Type::COMBINATION)
-        {
-            for (Geo::Geometry *child : *static_cast<Combination *>(geo))
-            {
-                if (child->type() == Geo::Type::CIRCLE || child->type() == Geo::Type::ARC || child->type() == Geo::Type::ELLIPSE)
-                {
-                    _visible_objects[1].circle.push_back(child);
-                }
-            }
-        }
+        return result;
     }
 
-    if (CanvasOperations::CanvasOperation::tool[0] == CanvasOperations::Tool::Select && !flush &&
-        _visible_objects[0].circle == _visible_objects[1].circle)
+    const std::vector<VBOChunks::Item> items = resident_items({Geo::Type::POLYLINE});
+    auto write = [](Geo::Geometry *object, const double pixel, std::vector<double> &vbo_data, std::vector<unsigned int> &ibo_data)
+    {
+        // 只读访问,不复制共享的点数据
+        return VBOChunks::write_polyline(*static_cast<const Geo::Polyline *>(object), pixel, vbo_data, ibo_data);
+    };
+    auto selected = [this](const Geo::Geometry *owner) { return is_marked_selected(owner); };
+    if (!_chunks.polyline.update(_editor, items, pixel, flush, write, selected, result.chunks))
     {
         return result;
     }
 
-    for (Geo::Geometry *item : _visible_objects[1].circle)
+    std::vector<const Geo::Geometry *> owners;
+    for (const VBOChunks::Item &item : items)
     {
-        switch (item->type())
-        {
-        case Geo::Type::CIRCLE:
-            {
-                Geo::Circle *circle = static_cast<Geo::Circle *>(item);
-                circle->point_index = result.vbo_data.size() / 2;
-                for (const Geo::Point &point : circle->shape())
-                {
-                    result.ibo_data.push_back(result.vbo_data.size() / 2);
-                    result.vbo_data.push_back(point.x);
-                    result.vbo_data.push_back(point.y);
-                }
-                result.ibo_data.push_back(UINT_MAX);
-                circle->point_count = circle->shape().size();
-            }
-            break;
-        case Geo::Type::ELLIPSE:
-            {
-                Geo::Ellipse *ellipse = static_cast<Geo::Ellipse *>(item);
-                ellipse->point_index = result.vbo_data.size() / 2;
-                for (const Geo::Point &point : ellipse->shape())
-                {
-                    result.ibo_data.push_back(result.vbo_data.size() / 2);
-                    result.vbo_data.push_back(point.x);
-                    result.vbo_data.push_back(point.y);
-                }
-                result.ibo_data.push_back(UINT_MAX);
-                ellipse->point_count = ellipse->shape().size();
-            }
-            break;
-        case Geo::Type::ARC:
-            {
-                Geo::Arc *arc = static_cast<Geo::Arc *>(item);
-                arc->point_index = result.vbo_data.size() / 2;
-                for (const Geo::Point &point : arc->shape())
-                {
-                    result.ibo_data.push_back(result.vbo_data.size() / 2);
-                    result.vbo_data.push_back(point.x);
-                    result.vbo_data.push_back(point.y);
-                }
-                result.ibo_data.push_back(UINT_MAX);
-                arc->point_count = arc->shape().size();
-            }
-            break;
-        default:
-            break;
-        }
+        owners.push_back(item.owner);
     }
-
-    _shape_index_count.circle = result.ibo_data.size();
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+    _vbo_owners.polyline = std::move(owners);
+    _point_count.polyline = result.chunks.vertex_count;
+    _shape_index_count.polyline = result.chunks.index_count;
     return result;
 }
 
-Canvas::VBOData Canvas::refresh_curve_vbo(const bool flush)
+Canvas::VBOData Canvas::refresh_polygon_vbo(const bool flush)
 {
     VBOData result;
-    _visible_objects[0].curve = _visible_objects[1].curve;
-    _visible_objects[1].curve.clear();
-    for (Geo::Geometry *geo : _editor.visible_objects())
+    const double pixel = 1 / _ratio;
+    if (!flush && !_chunks.polygon.outdated(_editor, pixel))
     {
-        if (geo->type() == Geo::Type::BEZIER || geo->type() == Geo::Type::BSPLINE)
-        {
-            _visible_objects[1].curve.push_back(geo);
-        }
-        else if (geo->type() == Geo::Type::COMBINATION)
-        {
-            for (Geo::Geometry *child : *static_cast<Combination *>(geo))
-            {
-                if (child->type() == Geo::Type::BEZIER || child->type() == Geo::Type::BSPLINE)
-                {
-                    _visible_objects[1].curve.push_back(child);
-                }
-            }
-        }
+        return result;
     }
 
-    if (CanvasOperations::CanvasOperation::tool[0] == CanvasOperations::Tool::Select && !flush &&
-        _visible_objects[0].curve == _visible_objects[1].curve)
+    const std::vector<VBOChunks::Item> items = resident_items({Geo::Type::POLYGON});
+    auto write = [](Geo::Geometry *object, const double pixel, std::vector<double> &vbo_data, std::vector<unsigned int> &ibo_data)
+    {
+        return VBOChunks::write_polyline(*static_cast<const Geo::Polygon *>(object), pixel, vbo_data, ibo_data);
+    };
+    auto selected = [this](const Geo::Geometry *owner) { return is_marked_selected(owner); };
+    if (!_chunks.polygon.update(_editor, items, pixel, flush, write, selected, result.chunks))
     {
         return result;
     }
 
-    for (Geo::Geometry *item : _visible_objects[1].curve)
+    std::vector<const Geo::Geometry *> owners;
+    for (const VBOChunks::Item &item : items)
     {
-        switch (item->type())
-        {
-        case Geo::Type::BEZIER:
-            {
-                Geo::CubicBezier *bezier = static_cast<Geo::CubicBezier *>(item);
-                bezier->point_index = result.vbo_data.size() / 2;
-                for (const Geo::Point &point : bezier->shape())
-                {
-                    result.ibo_data.push_back(result.vbo_data.size() / 2);
-                    result.vbo_data.push_back(point.x);
-                    result.vbo_data.push_back(point.y);
-                }
-                result.ibo_data.push_back(UINT_MAX);
-                bezier->point_count = bezier->shape().size();
-            }
-            break;
-        case Geo::Type::BSPLINE:
-            {
-                Geo::BSpline *bspline = static_cast<Geo::BSpline *>(item);
-                bspline->point_index = result.vbo_data.size() / 2;
-                for (const Geo::Point &point : bspline->shape())
-                {
-                    result.ibo_data.push_back(result.vbo_data.size() / 2);
-                    result.vbo_data.push_back(point.x);
-                    result.vbo_data.push_back(point.y);
-                }
-                result.ibo_data.push_back(UINT_MAX);
-                bspline->point_count = bspline->shape().size();
-            }
+        owners.push_back(item.owner);
+    }
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+    _vbo_owners.polygon = std::move(owners);
+    _point_count.polygon = result.chunks.vertex_count;
+    _shape_index_count.polygon = result.chunks.index_count;
+    return result;
+}
+
+Canvas::VBOData Canvas::refresh_circle_vbo(const bool flush)
+{
+    VBOData result;
+    const double pixel = 1 / _ratio;
+    if (!flush && !_chunks.circle.outdated(_editor, pixel))
+    {
+        return result;
+    }
+
+    const std::vector<VBOChunks::Item> items = resident_items({Geo::Type::CIRCLE, Geo::Type::ELLIPSE, Geo::Type::ARC});
+    auto write = [](Geo::Geometry *object, const double pixel, std::vector<double> &vbo_data, std::vector<unsigned int> &ibo_data)
+    {
+        const Geo::Polyline *shape = nullptr;
+        switch (object->type())
+        {
+        case Geo::Type::CIRCLE:
+            shape = &static_cast<const Geo::Circle *>(object)->shape();
             break;
-        default:
+        case Geo::Type::ELLIPSE:
+            shape = &static_cast<const Geo::Ellipse *>(object)->shape();
             break;
+        case Geo::Type::ARC:
+            shape = &static_cast<const Geo::Arc *>(object)->shape();
+            break;
+        default:
+            return false;
         }
+        return VBOChunks::write_polyline(*shape, pixel, vbo_data, ibo_data);
+    };
+    auto selected = [this](const Geo::Geometry *owner) { return is_marked_selected(owner); };
+    if (!_chunks.circle.update(_editor, items, pixel, flush, write, selected, result.chunks))
+    {
+        return result;
     }
 
-    _shape_index_count.curve = result.ibo_data.size();
+    std::vector<const Geo::Geometry *> owners;
+    for (const VBOChunks::Item &item : items)
+    {
+        owners.push_back(item.owner);
+    }
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+    _vbo_owners.circle = std::move(owners);
+    _shape_index_count.circle = result.chunks.index_count;
     return result;
 }
 
-Canvas::VBOData Canvas::refresh_point_vbo(const bool flush)
+bool Canvas::write_curve(Geo::Geometry *object, const double pixel, std::vector<double> &vbo_data, std::vector<unsigned int> &ibo_data)
+{
+    switch (object->type())
+    {
+    case Geo::Type::BEZIER:
+        return VBOChunks::write_polyline(static_cast<const Geo::CubicBezier *>(object)->shape(), pixel, vbo_data, ibo_data);
+    case Geo::Type::BSPLINE:
+        return VBOChunks::write_polyline(static_cast<const Geo::BSpline *>(object)->shape(), pixel, vbo_data, ibo_data);
+    default:
+        return false;
+    }
+}
+
+Canvas::VBOData Canvas::refresh_curve_vbo(const bool flush)
 {
     VBOData result;
-    Geo::AABBRectParams visible_area_params;
-    visible_area_params.left = _visible_area.left() - 2;
-    visible_area_params.right = _visible_area.right() + 2;
-    visible_area_params.bottom = _visible_area.bottom() - 2;
-    visible_area_params.top = _visible_area.top() + 2;
-    _visible_objects[0].point = _visible_objects[1].point;
-    _visible_objects[1].point.clear();
+    const double pixel = 1 / _ratio;
+    if (!flush && !_chunks.curve.outdated(_editor, pixel))
+    {
+        return result;
+    }
 
-    for (const ContainerGroup &group : _editor.graph()->container_groups())
+    const std::vector<VBOChunks::Item> items = resident_items({Geo::Type::BEZIER, Geo::Type::BSPLINE});
+    auto selected = [this](const Geo::Geometry *owner) { return is_marked_selected(owner); };
+    if (!_chunks.curve.update(_editor, items, pixel, flush, &Canvas::write_curve, selected, result.chunks))
     {
-        if (!group.visible())
-        {
-            continue;
-        }
+        return result;
+    }
 
-        for (Geo::Geometry *geo : group)
-        {
-            if (geo->type() == Geo::Type::POINT)
-            {
-                if (Geo::Point *point = static_cast<Geo::Point *>(geo); Geo::is_inside(*point, visible_area_params))
-                {
-                    _visible_objects[1].point.push_back(point);
-                }
-            }
-            else if (geo->type() == Geo::Type::COMBINATION)
-            {
-                for (Geo::Geometry *item : *static_cast<Combination *>(geo))
-                {
-                    if (item->type() == Geo::Type::POINT)
-                    {
-                        if (Geo::Point *point = static_cast<Geo::Point *>(item); Geo::is_inside(*point, visible_area_params))
-                        {
-                            _visible_objects[1].point.push_back(point);
-                        }
-                    }
-                }
-            }
-        }
+    std::vector<const Geo::Geometry *> owners;
+    for (const VBOChunks::Item &item : items)
+    {
+        owners.push_back(item.owner);
     }
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+    _vbo_owners.curve = std::move(owners);
+    _shape_index_count.curve = result.chunks.index_count;
+    return result;
+}
 
-    if (CanvasOperations::CanvasOperation::tool[0] == CanvasOperations::Tool::Select && !flush &&
-        _visible_objects[0].point == _visible_objects[1].point)
+Canvas::VBOData Canvas::refresh_point_vbo(const bool flush)
+{
+    VBOData result;
+    if (!flush && !_chunks.point.outdated(_editor, 0)) // 点不抽稀
     {
         return result;
     }
 
-    unsigned int index = 0;
-    for (Geo::Point *point : _visible_objects[1].point)
+    const std::vector<VBOChunks::Item> items = resident_items({Geo::Type::POINT});
+    auto write = [](Geo::Geometry *object, const double, std::vector<double> &vbo_data, std::vector<unsigned int> &)
     {
-        point->point_index = index++;
-        point->point_count = 1;
-        result.vbo_data.push_back(point->x);
-        result.vbo_data.push_back(point->y);
+        vbo_data.push_back(static_cast<const Geo::Point *>(object)->x);
+        vbo_data.push_back(static_cast<const Geo::Point *>(object)->y);
+        return false;
+    };
+    auto selected = [this](const Geo::Geometry *owner) { return is_marked_selected(owner); };
+    if (!_chunks.point.update(_editor, items, 0, flush, write, selected, result.chunks))
+    {
+        return result;
+    }
+
+    std::vector<const Geo::Geometry *> owners;
+    for (const VBOChunks::Item &item : items)
+    {
+        owners.push_back(item.owner);
     }
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+    _vbo_owners.point = std::move(owners);
 
-    _point_count.point = result.vbo_data.size() / 2;
+    _point_count.point = result.chunks.vertex_count;
     return result;
 }
 
-Canvas::VBOData Canvas::refresh_circle_printable_points()
+Canvas::VBOData Canvas::refresh_array_vbo(const bool flush)
 {
     VBOData result;
-    std::vector<Geo::Geometry *> output;
-    for (Geo::Geometry *geo : _editor.visible_objects())
+    const size_t modification = _modifications.array;
+    if (!flush && modification == _editor.view_modification())
+    {
+        return result;
+    }
+    _modifications.array = _editor.view_modification();
+
+    _vbo_objects[0].array = _vbo_objects[1].array;
+    _vbo_objects[1].array.clear();
+    for (const VBOChunks::Item &item : resident_items({Geo::Type::ARRAY}))
+    {
+        if (item.object == item.owner)
+        {
+            _vbo_objects[1].array.push_back(static_cast<Array *>(item.object));
+        }
+    }
+
+    if (!flush && _vbo_objects[0].array == _vbo_objects[1].array &&
+        std::none_of(_vbo_objects[1].array.begin(), _vbo_objects[1].array.end(),
+                     [&](const Array *array) { return _editor.view_modification(array) > modification; }))
+    {
+        return result;
+    }
+
+    // 源图形只上传一份,折线顶点在前,点在后,逐实例数据为变换矩阵和选中标记
+    std::vector<ArrayDraw> draws;
+    std::vector<std::vector<Geo::Point>> points(_vbo_objects[1].array.size());
+    auto append_shape = [&result](const Geo::Polyline &shape)
     {
-        if (geo->type() == Geo::Type::CIRCLE || geo->type() == Geo::Type::ELLIPSE || geo->type() == Geo::Type::ARC)
+        for (const Geo::Point &point : shape)
         {
-            output.push_back(geo);
+            result.ibo_data.push_back(result.vbo_data.size() / 2);
+            result.vbo_data.push_back(point.x);
+            result.vbo_data.push_back(point.y);
         }
-        else if (geo->type() == Geo::Type::COMBINATION)
+        result.ibo_data.push_back(UINT_MAX);
+    };
+    for (size_t i = 0, count = _vbo_objects[1].array.size(); i < count; ++i)
+    {
+        Array *array = _vbo_objects[1].array[i];
+        ArrayDraw draw;
+        draw.rect = array->aabbrect_params();
+        draw.index_offset = result.ibo_data.size();
+        std::vector<const Geo::Geometry *> items(array->source().begin(), array->source().end());
+        while (!items.empty())
         {
-            for (Geo::Geometry *child : *static_cast<Combination *>(geo))
+            const Geo::Geometry *item = items.back();
+            items.pop_back();
+            switch (item->type())
             {
-                if (child->type() == Geo::Type::CIRCLE || child->type() == Geo::Type::ELLIPSE || child->type() == Geo::Type::ARC)
-                {
-                    output.push_back(child);
-                }
+            case Geo::Type::POLYLINE:
+            case Geo::Type::POLYGON:
+                append_shape(*static_cast<const Geo::Polyline *>(item));
+                break;
+            case Geo::Type::CIRCLE:
+                append_shape(static_cast<const Geo::Circle *>(item)->shape());
+                break;
+            case Geo::Type::ELLIPSE:
+                append_shape(static_cast<const Geo::Ellipse *>(item)->shape());
+                break;
+            case Geo::Type::ARC:
+                append_shape(static_cast<const Geo::Arc *>(item)->shape());
+                break;
+            case Geo::Type::BEZIER:
+                append_shape(static_cast<const Geo::CubicBezier *>(item)->shape());
+                break;
+            case Geo::Type::BSPLINE:
+                append_shape(static_cast<const Geo::BSpline *>(item)->shape());
+                break;
+            case Geo::Type::POINT:
+                points[i].push_back(*static_cast<const Geo::Point *>(item));
+                break;
+            case Geo::Type::COMBINATION:
+                items.insert(items.end(), static_cast<const Combination *>(item)->begin(), static_cast<const Combination *>(item)->end());
+                break;
+            default:
+                break;
             }
         }
+        draw.index_count = result.ibo_data.size() - draw.index_offset;
+
+        draw.instance_offset = result.instance_data.size() / 6;
+        draw.instance_count = array->size();
+        for (size_t j = 0, instance_count = array->size(); j < instance_count; ++j)
+        {
+            result.instance_data.insert(result.instance_data.end(), (*array)[j].begin(), (*array)[j].end());
+        }
+        array->point_index = draw.instance_offset;
+        array->point_count = draw.instance_count;
+        result.selected_data.insert(result.selected_data.end(), draw.instance_count, is_marked_selected(array));
+        draws.push_back(draw);
     }
+    for (size_t i = 0, count = draws.size(); i < count; ++i)
+    {
+        draws[i].point_offset = result.vbo_data.size() / 2;
+        draws[i].point_count = points[i].size();
+        for (const Geo::Point &point : points[i])
+        {
+            result.vbo_data.push_back(point.x);
+            result.vbo_data.push_back(point.y);
+        }
+    }
+
+    std::vector<const Geo::Geometry *> owners(_vbo_objects[1].array.begin(), _vbo_objects[1].array.end());
+    std::sort(owners.begin(), owners.end());
+    _vbo_owners.array = std::move(owners);
+    _array_draws = std::move(draws);
+    return result;
+}
+
+Canvas::VBOData Canvas::refresh_circle_printable_points(const bool flush)
+{
+    VBOData result;
+    if (!flush && _modifications.circle_printable_points == _editor.view_modification())
+    {
+        return result;
+    }
+    _modifications.circle_printable_points = _editor.view_modification();
 
-    for (const Geo::Geometry *geo : output)
+    for (const VBOChunks::Item &item : resident_items({Geo::Type::CIRCLE, Geo::Type::ELLIPSE, Geo::Type::ARC}))
     {
+        const Geo::Geometry *geo = item.object;
         switch (geo->type())
         {
         case Geo::Type::CIRCLE:
@@ -1937,55 +2209,21 @@ Canvas::VBOData Canvas::refresh_circle_printable_points()
     return result;
 }
 
-Canvas::VBOData Canvas::refresh_curve_printable_points()
+Canvas::VBOData Canvas::refresh_curve_printable_points(const bool flush)
 {
     VBOData result;
-    Geo::AABBRectParams visible_area_params;
-    visible_area_params.left = _visible_area.left() - 2;
-    visible_area_params.right = _visible_area.right() + 2;
-    visible_area_params.top = _visible_area.top() + 2;
-    visible_area_params.bottom = _visible_area.bottom() - 2;
-
-    for (ContainerGroup &group : _editor.graph()->container_groups())
+    if (!flush && _modifications.curve_printable_points == _editor.view_modification())
     {
-        if (!group.visible())
-        {
-            continue;
-        }
+        return result;
+    }
+    _modifications.curve_printable_points = _editor.view_modification();
 
-        for (Geo::Geometry *geo : group)
+    for (const VBOChunks::Item &item : resident_items({Geo::Type::BSPLINE}))
+    {
+        for (const Geo::Point &point : static_cast<const Geo::BSpline *>(item.object)->path_points)
         {
-            switch (geo->type())
-            {
-            case Geo::Type::COMBINATION:
-                for (Geo::Geometry *item : *static_cast<Combination *>(geo))
-                {
-                    if (const Geo::BSpline *bspline = dynamic_cast<const Geo::BSpline *>(item))
-                    {
-                        for (const Geo::Point &point : bspline->path_points)
-                        {
-                            if (Geo::is_inside(point, visible_area_params))
-                            {
-                                result.vbo_data.push_back(point.x);
-                                result.vbo_data.push_back(point.y);
-                            }
-                        }
-                    }
-                }
-                break;
-            case Geo::Type::BSPLINE:
-                for (const Geo::Point &point : static_cast<const Geo::BSpline *>(geo)->path_points)
-                {
-                    if (Geo::is_inside(point, visible_area_params))
-                    {
-                        result.vbo_data.push_back(point.x);
-                        result.vbo_data.push_back(point.y);
-                    }
-                }
-                break;
-            default:
-                break;
-            }
+            result.vbo_data.push_back(point.x);
+            result.vbo_data.push_back(point.y);
         }
     }
 
@@ -1996,33 +2234,30 @@ Canvas::VBOData Canvas::refresh_curve_printable_points()
 Canvas::DimVBOData Canvas::refresh_dimension_vbo(const bool flush)
 {
     DimVBOData result;
-    _visible_objects[0].dimensions = _visible_objects[1].dimensions;
-    _visible_objects[1].dimensions.clear();
-    for (Geo::Geometry *geo : _editor.visible_objects())
+    const size_t modification = _modifications.dimension;
+    if (!flush && modification == _editor.view_modification())
     {
-        if (geo->type() == Geo::Type::DIMENSION)
-        {
-            _visible_objects[1].dimensions.push_back(static_cast<Dim::Dimension *>(geo));
-        }
-        else if (geo->type() == Geo::Type::COMBINATION)
-        {
-            for (Geo::Geometry *child : *static_cast<Combination *>(geo))
-            {
-                if (child->type() == Geo::Type::DIMENSION)
-                {
-                    _visible_objects[1].dimensions.push_back(static_cast<Dim::Dimension *>(child));
-                }
-            }
-        }
+        return result;
+    }
+    _modifications.dimension = _editor.view_modification();
+
+    _vbo_objects[0].dimensions = _vbo_objects[1].dimensions;
+    _vbo_objects[1].dimensions.clear();
+    std::vector<const Geo::Geometry *> owners; // _vbo_objects[1].dimensions中各标注所属的顶层图形
+    for (const VBOChunks::Item &item : resident_items({Geo::Type::DIMENSION}))
+    {
+        _vbo_objects[1].dimensions.push_back(static_cast<Dim::Dimension *>(item.object));
+        owners.push_back(item.owner);
     }
 
-    if (CanvasOperations::CanvasOperation::tool[0] == CanvasOperations::Tool::Select && !flush &&
-        _visible_objects[0].dimensions == _visible_objects[1].dimensions)
+    if (!flush && _vbo_objects[0].dimensions == _vbo_objects[1].dimensions &&
+        std::none_of(owners.begin(), owners.end(),
+                     [&](const Geo::Geometry *owner) { return _editor.view_modification(owner) > modification; }))
     {
         return result;
     }
 
-    for (const Dim::Dimension *dim : _visible_objects[1].dimensions)
+    for (const Dim::Dimension *dim : _vbo_objects[1].dimensions)
     {
         dim->paintable_lines(result.lines);
         dim->paintable_arrows(result.arrows);
@@ -2043,430 +2278,148 @@ void Canvas::refresh_select_rect(const double x0, const double y0, const double
 
 void Canvas::refresh_selected_ibo()
 {
-    refresh_selected_dimension_vbo();
-
-    std::vector<unsigned int> polyline_indexs, polygon_indexs, circle_indexs, curve_indexs, point_indexs;
-    for (const Geo::Geometry *geo : _editor.visible_objects())
+    if (_editor.in_transaction())
     {
-        if (!geo->is_selected)
-        {
-            continue;
-        }
-        switch (geo->type())
-        {
-        case Geo::Type::POLYLINE:
-            for (size_t index = geo->point_index, i = 0, count = geo->point_count; i < count; ++i)
-            {
-                polyline_indexs.push_back(index++);
-            }
-            polyline_indexs.push_back(UINT_MAX);
-            break;
-        case Geo::Type::POLYGON:
-            for (size_t index = geo->point_index, i = 0, count = geo->point_count; i < count; ++i)
-            {
-                polygon_indexs.push_back(index++);
-            }
-            polygon_indexs.push_back(UINT_MAX);
-            break;
-        case Geo::Type::CIRCLE:
-        case Geo::Type::ELLIPSE:
-        case Geo::Type::ARC:
-            for (size_t index = geo->point_index, i = 0, count = geo->point_count; i < count; ++i)
-            {
-                circle_indexs.push_back(index++);
-            }
-            circle_indexs.push_back(UINT_MAX);
-            break;
-        case Geo::Type::BEZIER:
-        case Geo::Type::BSPLINE:
-            for (size_t index = geo->point_index, i = 0, count = geo->point_count; i < count; ++i)
-            {
-                curve_indexs.push_back(index++);
-            }
-            curve_indexs.push_back(UINT_MAX);
-            break;
-        case Geo::Type::COMBINATION:
-            for (const Geo::Geometry *item : *static_cast<const Combination *>(geo))
-            {
-                switch (item->type())
-                {
-                case Geo::Type::POLYLINE:
-                    for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                    {
-                        polyline_indexs.push_back(index++);
-                    }
-                    polyline_indexs.push_back(UINT_MAX);
-                    break;
-                case Geo::Type::POLYGON:
-                    for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                    {
-                        polygon_indexs.push_back(index++);
-                    }
-                    polygon_indexs.push_back(UINT_MAX);
-                    break;
-                case Geo::Type::CIRCLE:
-                case Geo::Type::ELLIPSE:
-                case Geo::Type::ARC:
-                    for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                    {
-                        circle_indexs.push_back(index++);
-                    }
-                    circle_indexs.push_back(UINT_MAX);
-                    break;
-                case Geo::Type::BEZIER:
-                case Geo::Type::BSPLINE:
-                    for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                    {
-                        curve_indexs.push_back(index++);
-                    }
-                    curve_indexs.push_back(UINT_MAX);
-                    break;
-                case Geo::Type::POINT:
-                    point_indexs.push_back(item->point_index);
-                    break;
-                default:
-                    break;
-                }
-            }
-            break;
-        case Geo::Type::POINT:
-            point_indexs.push_back(geo->point_index);
-            break;
-        default:
-            continue;
-        }
+        _pending_refresh.selected = true;
+        return;
     }
 
-    _selected_index_count.polyline = polyline_indexs.size();
-    _selected_index_count.polygon = polygon_indexs.size();
-    _selected_index_count.circle = circle_indexs.size();
-    _selected_index_count.curve = curve_indexs.size();
-    _selected_index_count.point = point_indexs.size();
+    refresh_selected_dimension_vbo();
 
-    makeCurrent();
-    if (!polyline_indexs.empty())
-    {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.polyline);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, polyline_indexs.size() * sizeof(unsigned int), polyline_indexs.data(), GL_DYNAMIC_DRAW);
-    }
-    if (!polygon_indexs.empty())
+    std::vector<const Geo::Geometry *> selected_objects, changed_objects;
+    for (const Geo::Geometry *object : _editor.selected())
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.polygon);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, polygon_indexs.size() * sizeof(unsigned int), polygon_indexs.data(), GL_DYNAMIC_DRAW);
+        selected_objects.push_back(object);
     }
-    if (!circle_indexs.empty())
+    std::set_symmetric_difference(_selected_objects.begin(), _selected_objects.end(), selected_objects.begin(), selected_objects.end(),
+                                  std::back_inserter(changed_objects));
+    _selected_objects = std::move(selected_objects);
+    if (changed_objects.empty())
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.circle);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, circle_indexs.size() * sizeof(unsigned int), circle_indexs.data(), GL_DYNAMIC_DRAW);
-    }
-    if (!curve_indexs.empty())
-    {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.curve);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, curve_indexs.size() * sizeof(unsigned int), curve_indexs.data(), GL_DYNAMIC_DRAW);
+        return;
     }
-    if (!point_indexs.empty())
+
+    makeCurrent();
+    for (const Geo::Geometry *object : changed_objects)
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.point);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, point_indexs.size() * sizeof(unsigned int), point_indexs.data(), GL_DYNAMIC_DRAW);
+        write_selected_flags(object, is_marked_selected(object));
     }
     doneCurrent();
 }
 
-void Canvas::refresh_selected_ibo(const Geo::Geometry *object)
+bool Canvas::is_marked_selected(const Geo::Geometry *object) const
 {
-    {
-        Geo::AABBRectParams visible_area_params;
-        visible_area_params.left = _visible_area.left() - 2;
-        visible_area_params.right = _visible_area.right() + 2;
-        visible_area_params.top = _visible_area.top() + 2;
-        visible_area_params.bottom = _visible_area.bottom() - 2;
-        if (!Geo::is_intersected(visible_area_params, object->aabbrect_params()))
-        {
-            return;
-        }
-    }
-    if (object->type() == Geo::Type::COMBINATION)
-    {
-        std::vector<unsigned int> polyline_indexs, polygon_indexs, circle_indexs, curve_indexs, point_indexs;
-        for (const Geo::Geometry *item : *static_cast<const Combination *>(object))
-        {
-            switch (item->type())
-            {
-            case Geo::Type::POLYLINE:
-                for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                {
-                    polyline_indexs.push_back(index++);
-                }
-                polyline_indexs.push_back(UINT_MAX);
-                break;
-            case Geo::Type::POLYGON:
-                for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                {
-                    polygon_indexs.push_back(index++);
-                }
-                polygon_indexs.push_back(UINT_MAX);
-                break;
-            case Geo::Type::CIRCLE:
-            case Geo::Type::ELLIPSE:
-            case Geo::Type::ARC:
-                for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                {
-                    circle_indexs.push_back(index++);
-                }
-                circle_indexs.push_back(UINT_MAX);
-                break;
-            case Geo::Type::BEZIER:
-            case Geo::Type::BSPLINE:
-                for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                {
-                    curve_indexs.push_back(index++);
-                }
-                curve_indexs.push_back(UINT_MAX);
-                break;
-            case Geo::Type::POINT:
-                point_indexs.push_back(item->point_index);
-                break;
-            default:
-                break;
-            }
-        }
-
-        _selected_index_count.polyline = polyline_indexs.size();
-        _selected_index_count.polygon = polygon_indexs.size();
-        _selected_index_count.circle = circle_indexs.size();
-        _selected_index_count.curve = curve_indexs.size();
-        _selected_index_count.point = point_indexs.size();
-        makeCurrent();
-        if (!polyline_indexs.empty())
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.polyline);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, polyline_indexs.size() * sizeof(unsigned int), polyline_indexs.data(), GL_DYNAMIC_DRAW);
-        }
-        if (!polygon_indexs.empty())
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.polygon);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, polygon_indexs.size() * sizeof(unsigned int), polygon_indexs.data(), GL_DYNAMIC_DRAW);
-        }
-        if (!circle_indexs.empty())
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.circle);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, circle_indexs.size() * sizeof(unsigned int), circle_indexs.data(), GL_DYNAMIC_DRAW);
-        }
-        if (!curve_indexs.empty())
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.curve);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, curve_indexs.size() * sizeof(unsigned int), curve_indexs.data(), GL_DYNAMIC_DRAW);
-        }
-        if (!point_indexs.empty())
-        {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.point);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, point_indexs.size() * sizeof(unsigned int), point_indexs.data(), GL_DYNAMIC_DRAW);
-        }
-        doneCurrent();
-    }
-    else if (object->type() == Geo::Type::DIMENSION)
-    {
-        refresh_selected_dimension_vbo();
-    }
-    else
-    {
-        std::vector<unsigned int> indexs;
-        for (size_t i = 0, index = object->point_index, count = object->point_count; i < count; ++i)
-        {
-            indexs.push_back(index++);
-        }
-        indexs.push_back(UINT_MAX);
-        clear_selected_ibo();
-        unsigned int IBO_index = 0;
-        switch (object->type())
-        {
-        case Geo::Type::POLYLINE:
-            IBO_index = _selected_ibo.polyline;
-            _selected_index_count.polyline = indexs.size();
-            break;
-        case Geo::Type::POLYGON:
-            IBO_index = _selected_ibo.polygon;
-            _selected_index_count.polygon = indexs.size();
-            break;
-        case Geo::Type::CIRCLE:
-        case Geo::Type::ELLIPSE:
-        case Geo::Type::ARC:
-            IBO_index = _selected_ibo.circle;
-            _selected_index_count.circle = indexs.size();
-            break;
-        case Geo::Type::BEZIER:
-        case Geo::Type::BSPLINE:
-            IBO_index = _selected_ibo.curve;
-            _selected_index_count.curve = indexs.size();
-            break;
-        case Geo::Type::POINT:
-            IBO_index = _selected_ibo.point;
-            _selected_index_count.point = indexs.size();
-            break;
-        default:
-            break;
-        }
-        if (!indexs.empty())
-        {
-            makeCurrent();
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO_index);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexs.size() * sizeof(unsigned int), indexs.data(), GL_DYNAMIC_DRAW);
-            doneCurrent();
-        }
-    }
+    return std::binary_search(_selected_objects.begin(), _selected_objects.end(), object);
 }
 
-void Canvas::refresh_selected_ibo(const std::vector<Geo::Geometry *> &objects)
+void Canvas::write_selected_flags(const Geo::Geometry *object, const unsigned char value)
 {
-    if (objects.empty())
+    // 先按地址确认object仍在某个VBO中,已删除的图形不会被访问
+    const std::vector<const Geo::Geometry *> *owners[6] = {&_vbo_owners.polyline, &_vbo_owners.polygon, &_vbo_owners.circle,
+                                                          &_vbo_owners.curve,    &_vbo_owners.point,   &_vbo_owners.array};
+    if (std::none_of(owners, owners + 6, [=](const std::vector<const Geo::Geometry *> *items)
+                     { return std::binary_search(items->begin(), items->end(), object); }))
     {
         return;
     }
 
-    refresh_selected_dimension_vbo();
-    Geo::AABBRectParams visible_area_params;
-    visible_area_params.left = _visible_area.left() - 2;
-    visible_area_params.right = _visible_area.right() + 2;
-    visible_area_params.top = _visible_area.top() + 2;
-    visible_area_params.bottom = _visible_area.bottom() - 2;
-    std::vector<unsigned int> polyline_indexs, polygon_indexs, circle_indexs, curve_indexs, point_indexs;
-    for (const Geo::Geometry *geo : objects)
+    std::vector<unsigned char> flags;
+    auto write = [&](const Geo::Geometry *item)
     {
-        if (!Geo::is_intersected(visible_area_params, geo->aabbrect_params()))
-        {
-            continue;
-        }
-        switch (geo->type())
+        size_t index = 6;
+        unsigned int vbo = 0;
+        switch (item->type())
         {
         case Geo::Type::POLYLINE:
-            for (size_t index = geo->point_index, i = 0, count = geo->point_count; i < count; ++i)
-            {
-                polyline_indexs.push_back(index++);
-            }
-            polyline_indexs.push_back(UINT_MAX);
+            index = 0, vbo = _selected_vbo.polyline;
             break;
         case Geo::Type::POLYGON:
-            for (size_t index = geo->point_index, i = 0, count = geo->point_count; i < count; ++i)
-            {
-                polygon_indexs.push_back(index++);
-            }
-            polygon_indexs.push_back(UINT_MAX);
+            index = 1, vbo = _selected_vbo.polygon;
             break;
         case Geo::Type::CIRCLE:
         case Geo::Type::ELLIPSE:
         case Geo::Type::ARC:
-            for (size_t index = geo->point_index, i = 0, count = geo->point_count; i < count; ++i)
-            {
-                circle_indexs.push_back(index++);
-            }
-            circle_indexs.push_back(UINT_MAX);
+            index = 2, vbo = _selected_vbo.circle;
             break;
         case Geo::Type::BEZIER:
         case Geo::Type::BSPLINE:
-            for (size_t index = geo->point_index, i = 0, count = geo->point_count; i < count; ++i)
-            {
-                curve_indexs.push_back(index++);
-            }
-            curve_indexs.push_back(UINT_MAX);
-            break;
-        case Geo::Type::COMBINATION:
-            for (const Geo::Geometry *item : *static_cast<const Combination *>(geo))
-            {
-                switch (item->type())
-                {
-                case Geo::Type::POLYLINE:
-                    for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                    {
-                        polyline_indexs.push_back(index++);
-                    }
-                    polyline_indexs.push_back(UINT_MAX);
-                    break;
-                case Geo::Type::POLYGON:
-                    for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                    {
-                        polygon_indexs.push_back(index++);
-                    }
-                    polygon_indexs.push_back(UINT_MAX);
-                    break;
-                case Geo::Type::CIRCLE:
-                case Geo::Type::ELLIPSE:
-                case Geo::Type::ARC:
-                    for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                    {
-                        circle_indexs.push_back(index++);
-                    }
-                    circle_indexs.push_back(UINT_MAX);
-                    break;
-                case Geo::Type::BEZIER:
-                case Geo::Type::BSPLINE:
-                    for (size_t i = 0, index = item->point_index, count = item->point_count; i < count; ++i)
-                    {
-                        curve_indexs.push_back(index++);
-                    }
-                    curve_indexs.push_back(UINT_MAX);
-                    break;
-                case Geo::Type::POINT:
-                    point_indexs.push_back(item->point_index);
-                    break;
-                default:
-                    break;
-                }
-            }
+            index = 3, vbo = _selected_vbo.curve;
             break;
         case Geo::Type::POINT:
-            point_indexs.push_back(geo->point_index);
+            index = 4, vbo = _selected_vbo.point;
+            break;
+        case Geo::Type::ARRAY:
+            index = 5, vbo = _selected_vbo.array; // 阵列按实例记录选中标记
             break;
         default:
-            continue;
+            return;
         }
-    }
-
-    _selected_index_count.polyline = polyline_indexs.size();
-    _selected_index_count.polygon = polygon_indexs.size();
-    _selected_index_count.circle = circle_indexs.size();
-    _selected_index_count.curve = curve_indexs.size();
-    _selected_index_count.point = point_indexs.size();
+        if (item->point_count > 0 && std::binary_search(owners[index]->begin(), owners[index]->end(), object))
+        {
+            flags.assign(item->point_count, value);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, item->point_index, item->point_count, flags.data());
+        }
+    };
 
-    makeCurrent();
-    if (!polyline_indexs.empty())
-    {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.polyline);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, polyline_indexs.size() * sizeof(unsigned int), polyline_indexs.data(), GL_DYNAMIC_DRAW);
-    }
-    if (!polygon_indexs.empty())
-    {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.polygon);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, polygon_indexs.size() * sizeof(unsigned int), polygon_indexs.data(), GL_DYNAMIC_DRAW);
-    }
-    if (!circle_indexs.empty())
-    {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.circle);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, circle_indexs.size() * sizeof(unsigned int), circle_indexs.data(), GL_DYNAMIC_DRAW);
-    }
-    if (!curve_indexs.empty())
+    if (object->type() == Geo::Type::COMBINATION)
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.curve);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, curve_indexs.size() * sizeof(unsigned int), curve_indexs.data(), GL_DYNAMIC_DRAW);
+        for (const Geo::Geometry *item : *static_cast<const Combination *>(object))
+        {
+            write(item);
+        }
     }
-    if (!point_indexs.empty())
+    else
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _selected_ibo.point);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, point_indexs.size() * sizeof(unsigned int), point_indexs.data(), GL_DYNAMIC_DRAW);
+        write(object);
     }
-    doneCurrent();
 }
 
 void Canvas::refresh_selected_vbo()
 {
-    std::future<VBOData> polyline_vbo, polygon_vbo, circle_vbo, curve_vbo, circle_point, curve_point, point_vbo;
-    bool refresh[5] = {false, false, false, false, false};
-    for (const ContainerGroup &group : _editor.graph()->container_groups())
+    std::future<VBOData> polyline_vbo, polygon_vbo, circle_vbo, curve_vbo, circle_point, curve_point, point_vbo, array_vbo;
+    bool refresh[6] = {false, false, false, false, false, false};
+    for (const Geo::Geometry *object : _editor.selected())
     {
-        for (const Geo::Geometry *object : group)
+        switch (object->type())
         {
-            if (object->is_selected)
+        case Geo::Type::POLYLINE:
+            if (!refresh[0])
+            {
+                polyline_vbo = std::async(std::launch::async, &Canvas::refresh_polyline_vbo, this, true);
+                refresh[0] = true;
+            }
+            break;
+        case Geo::Type::POLYGON:
+            if (!refresh[1])
+            {
+                polygon_vbo = std::async(std::launch::async, &Canvas::refresh_polygon_vbo, this, true);
+                refresh[1] = true;
+            }
+            break;
+        case Geo::Type::CIRCLE:
+        case Geo::Type::ELLIPSE:
+        case Geo::Type::ARC:
+            if (!refresh[2])
+            {
+                circle_vbo = std::async(std::launch::async, &Canvas::refresh_circle_vbo, this, true);
+                circle_point = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this, true);
+                refresh[2] = true;
+            }
+            break;
+        case Geo::Type::BEZIER:
+        case Geo::Type::BSPLINE:
+            if (!refresh[3])
             {
-                switch (object->type())
+                curve_vbo = std::async(std::launch::async, &Canvas::refresh_curve_vbo, this, true);
+                curve_point = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this, true);
+                refresh[3] = true;
+            }
+            break;
+        case Geo::Type::COMBINATION:
+            for (const Geo::Geometry *item : *static_cast<const Combination *>(object))
+            {
+                switch (item->type())
                 {
                 case Geo::Type::POLYLINE:
                     if (!refresh[0])
@@ -2488,7 +2441,7 @@ void Canvas::refresh_selected_vbo()
                     if (!refresh[2])
                     {
                         circle_vbo = std::async(std::launch::async, &Canvas::refresh_circle_vbo, this, true);
-                        circle_point = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this);
+                        circle_point = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this, true);
                         refresh[2] = true;
                     }
                     break;
@@ -2497,60 +2450,10 @@ void Canvas::refresh_selected_vbo()
                     if (!refresh[3])
                     {
                         curve_vbo = std::async(std::launch::async, &Canvas::refresh_curve_vbo, this, true);
-                        curve_point = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this);
+                        curve_point = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this, true);
                         refresh[3] = true;
                     }
                     break;
-                case Geo::Type::COMBINATION:
-                    for (const Geo::Geometry *item : *static_cast<const Combination *>(object))
-                    {
-                        switch (item->type())
-                        {
-                        case Geo::Type::POLYLINE:
-                            if (!refresh[0])
-                            {
-                                polyline_vbo = std::async(std::launch::async, &Canvas::refresh_polyline_vbo, this, true);
-                                refresh[0] = true;
-                            }
-                            break;
-                        case Geo::Type::POLYGON:
-                            if (!refresh[1])
-                            {
-                                polygon_vbo = std::async(std::launch::async, &Canvas::refresh_polygon_vbo, this, true);
-                                refresh[1] = true;
-                            }
-                            break;
-                        case Geo::Type::CIRCLE:
-                        case Geo::Type::ELLIPSE:
-                        case Geo::Type::ARC:
-                            if (!refresh[2])
-                            {
-                                circle_vbo = std::async(std::launch::async, &Canvas::refresh_circle_vbo, this, true);
-                                circle_point = std::async(std::launch::async, &Canvas::refresh_circle_printable_points, this);
-                                refresh[2] = true;
-                            }
-                            break;
-                        case Geo::Type::BEZIER:
-                        case Geo::Type::BSPLINE:
-                            if (!refresh[3])
-                            {
-                                curve_vbo = std::async(std::launch::async, &Canvas::refresh_curve_vbo, this, true);
-                                curve_point = std::async(std::launch::async, &Canvas::refresh_curve_printable_points, this);
-                                refresh[3] = true;
-                            }
-                            break;
-                        case Geo::Type::POINT:
-                            if (!refresh[4])
-                            {
-                                point_vbo = std::async(std::launch::async, &Canvas::refresh_point_vbo, this, true);
-                                refresh[4] = true;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-                    }
-                    break;
                 case Geo::Type::POINT:
                     if (!refresh[4])
                     {
@@ -2562,6 +2465,23 @@ void Canvas::refresh_selected_vbo()
                     break;
                 }
             }
+            break;
+        case Geo::Type::POINT:
+            if (!refresh[4])
+            {
+                point_vbo = std::async(std::launch::async, &Canvas::refresh_point_vbo, this, true);
+                refresh[4] = true;
+            }
+            break;
+        case Geo::Type::ARRAY:
+            if (!refresh[5])
+            {
+                array_vbo = std::async(std::launch::async, &Canvas::refresh_array_vbo, this, true);
+                refresh[5] = true;
+            }
+            break;
+        default:
+            break;
         }
     }
 
@@ -2572,8 +2492,7 @@ void Canvas::refresh_selected_vbo()
     {
         point_vbo.wait();
         VBOData data = point_vbo.get();
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.point); // point
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.point, _selected_vbo.point, 0);
     }
     if (refresh[2])
     {
@@ -2584,8 +2503,7 @@ void Canvas::refresh_selected_vbo()
 
         circle_vbo.wait();
         data = circle_vbo.get();
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.circle); // circle
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.circle, _selected_vbo.circle, _shape_ibo.circle);
     }
     if (refresh[3])
     {
@@ -2596,22 +2514,26 @@ void Canvas::refresh_selected_vbo()
 
         curve_vbo.wait();
         data = curve_vbo.get();
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.curve); // curve
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.curve, _selected_vbo.curve, _shape_ibo.curve);
     }
     if (refresh[0])
     {
         polyline_vbo.wait();
         VBOData data = polyline_vbo.get();
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.polyline); // polyline
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.polyline, _selected_vbo.polyline, _shape_ibo.polyline);
     }
     if (refresh[1])
     {
         polygon_vbo.wait();
         VBOData data = polygon_vbo.get();
-        glBindBuffer(GL_ARRAY_BUFFER, _shape_vbo.polygon); // polygon
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * data.vbo_data.size(), data.vbo_data.data(), GL_DYNAMIC_DRAW);
+        upload_chunks(data.chunks, _shape_vbo.polygon, _selected_vbo.polygon, _shape_ibo.polygon);
+    }
+    if (refresh[5])
+    {
+        array_vbo.wait();
+        VBOData data = array_vbo.get();
+        glBindBuffer(GL_ARRAY_BUFFER, _selected_vbo.array); // array
+        glBufferData(GL_ARRAY_BUFFER, data.selected_data.size(), data.selected_data.data(), GL_DYNAMIC_DRAW);
     }
     doneCurrent();
 }
@@ -2619,19 +2541,12 @@ void Canvas::refresh_selected_vbo()
 void Canvas::refresh_selected_dimension_vbo()
 {
     DimVBOData data;
-    for (const ContainerGroup &group : _editor.graph()->container_groups())
+    for (const Geo::Geometry *object : _editor.selected())
     {
-        if (!group.visible())
-        {
-            continue;
-        }
-        for (const Geo::Geometry *object : group)
+        if (object->type() == Geo::Type::DIMENSION)
         {
-            if (object->is_selected && object->type() == Geo::Type::DIMENSION)
-            {
-                static_cast<const Dim::Dimension *>(object)->paintable_lines(data.lines);
-                static_cast<const Dim::Dimension *>(object)->paintable_arrows(data.arrows);
-            }
+            static_cast<const Dim::Dimension *>(object)->paintable_lines(data.lines);
+            static_cast<const Dim::Dimension *>(object)->paintable_arrows(data.arrows);
         }
     }
 
@@ -2653,8 +2568,18 @@ void Canvas::refresh_selected_dimension_vbo()
 
 void Canvas::clear_selected_ibo()
 {
-    _selected_index_count.polyline = _selected_index_count.polygon = _selected_index_count.circle = _selected_index_count.curve =
-        _selected_index_count.point = _point_count.selected_dim_lines = _point_count.selected_dim_arrows = 0;
+    _point_count.selected_dim_lines = _point_count.selected_dim_arrows = 0;
+    if (_selected_objects.empty())
+    {
+        return;
+    }
+    makeCurrent();
+    for (const Geo::Geometry *object : _selected_objects)
+    {
+        write_selected_flags(object, 0);
+    }
+    doneCurrent();
+    _selected_objects.clear();
 }
 
 void Canvas::paint_text()
@@ -2664,6 +2589,29 @@ void Canvas::paint_text()
     QPainter painter(&_texture.text_image);
     // painter.setRenderHint(QPainter::RenderHint::Antialiasing, true);
     painter.setCompositionMode(QPainter::CompositionMode::CompositionMode_Source);
+    size_t style = SIZE_MAX; // 只在样式变化时切换字体
+
+    auto paint = [&](const Text *text, const bool selected)
+    {
+        if (text->text().isEmpty() ||
+            !Geo::is_intersected(_visible_area, text->shape(0), text->shape(1), text->shape(2), text->shape(3)))
+        {
+            return;
+        }
+        const double x = text->shape(3).x * _canvas_ctm[0] + text->shape(3).y * _canvas_ctm[3] + _canvas_ctm[6];
+        const double y = text->shape(3).x * _canvas_ctm[1] + text->shape(3).y * _canvas_ctm[4] + _canvas_ctm[7];
+        if (text->style() != style)
+        {
+            style = text->style();
+            painter.setFont(text->font());
+        }
+        painter.save();
+        painter.setPen(selected ? red : white);
+        painter.translate(x, y);
+        painter.scale(_ratio, _ratio);
+        text->paint(painter);
+        painter.restore();
+    };
 
     for (const ContainerGroup &group : _editor.graph()->container_groups())
     {
@@ -2677,41 +2625,51 @@ void Canvas::paint_text()
             switch (geo->type())
             {
             case Geo::Type::TEXT:
+                paint(static_cast<const Text *>(geo), geo->is_selected);
+                break;
+            case Geo::Type::COMBINATION:
+                for (Geo::Geometry *item : *static_cast<const Combination *>(geo))
                 {
-                    Text *text = static_cast<Text *>(geo);
-                    if (text->text().isEmpty() ||
-                        !Geo::is_intersected(_visible_area, text->shape(0), text->shape(1), text->shape(2), text->shape(3)))
+                    if (const Text *text = dynamic_cast<const Text *>(item); text != nullptr)
                     {
-                        continue;
+                        paint(text, text->is_selected);
                     }
-                    const double x = text->shape(3).x * _canvas_ctm[0] + text->shape(3).y * _canvas_ctm[3] + _canvas_ctm[6];
-                    const double y = text->shape(3).x * _canvas_ctm[1] + text->shape(3).y * _canvas_ctm[4] + _canvas_ctm[7];
-                    painter.save();
-                    painter.setPen(text->is_selected ? red : white);
-                    painter.translate(x, y);
-                    painter.scale(_ratio, _ratio);
-                    text->paint(painter);
-                    painter.restore();
                 }
                 break;
-            case Geo::Type::COMBINATION:
-                for (Geo::Geometry *item : *static_cast<const Combination *>(geo))
+            case Geo::Type::ARRAY:
                 {
-                    if (Text *text = dynamic_cast<Text *>(item); text != nullptr)
+                    // 文字无法实例化绘制,按实例变换源文字的副本后逐个绘制
+                    const Array *array = static_cast<const Array *>(geo);
+                    std::vector<const Text *> texts;
+                    for (const Geo::Geometry *item : array->source())
+                    {
+                        if (item->type() == Geo::Type::TEXT)
+                        {
+                            texts.push_back(static_cast<const Text *>(item));
+                        }
+                        else if (item->type() == Geo::Type::COMBINATION)
+                        {
+                            for (const Geo::Geometry *child : *static_cast<const Combination *>(item))
+                            {
+                                if (child->type() == Geo::Type::TEXT)
+                                {
+                                    texts.push_back(static_cast<const Text *>(child));
+                                }
+                            }
+                        }
+                    }
+                    for (size_t i = 0, count = texts.empty() ? 0 : array->size(); i < count; ++i)
                     {
-                        if (text->text().isEmpty() ||
-                            !Geo::is_intersected(_visible_area, text->shape(0), text->shape(1), text->shape(2), text->shape(3)))
+                        if (!Geo::is_intersected(_visible_area.aabbrect_params(), array->aabbrect_params(i)))
                         {
                             continue;
                         }
-                        const double x = text->shape(3).x * _canvas_ctm[0] + text->shape(3).y * _canvas_ctm[3] + _canvas_ctm[6];
-                        const double y = text->shape(3).x * _canvas_ctm[1] + text->shape(3).y * _canvas_ctm[4] + _canvas_ctm[7];
-                        painter.save();
-                        painter.setPen(text->is_selected ? red : white);
-                        painter.translate(x, y);
-                        painter.scale(_ratio, _ratio);
-                        text->paint(painter);
-                        painter.restore();
+                        for (const Text *text : texts)
+                        {
+                            Text copy(*text);
+                            copy.transform((*array)[i].data());
+                            paint(&copy, array->is_selected);
+                        }
                     }
                 }
                 break;
@@ -2805,7 +2763,7 @@ void Canvas::paint_dim_text()
 
 bool Canvas::refresh_catached_points(const double x, const double y, const double distance,
                                      std::vector<const Geo::Geometry *> &catched_objects, const bool skip_selected,
-                                     const bool current_group_only) const
+                                     const bool current_group_only)
 {
     if (!(_catch_types.vertex || _catch_types.center || _catch_types.foot || _catch_types.tangency || _catch_types.intersection))
     {
@@ -2816,179 +2774,232 @@ bool Canvas::refresh_catached_points(const double x, const double y, const doubl
     const Geo::Point pos(x, y);
     const size_t count = catched_objects.size();
 
+    // 只检查四叉树中包围盒与捕捉范围相交的图形
+    std::vector<Geo::Geometry *> objects;
+    _editor.find_objects(rect.aabbrect_params(), objects);
     if (current_group_only)
     {
-        std::vector<Geo::Geometry *> objects;
-        std::vector<Geo::Geometry *> current_group_objects(_editor.graph()->container_group(_editor.current_group()).begin(),
-                                                           _editor.graph()->container_group(_editor.current_group()).end());
-        std::sort(current_group_objects.begin(), current_group_objects.end());
-        std::set_intersection(_editor.visible_objects().begin(), _editor.visible_objects().end(), current_group_objects.begin(),
-                              current_group_objects.end(), std::back_inserter(objects));
-        for (const Geo::Geometry *geo : objects)
+        const std::vector<Geo::Geometry *> &current_group_objects = _editor.current_group_objects();
+        objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                     [&](Geo::Geometry *object)
+                                     { return !std::binary_search(current_group_objects.begin(), current_group_objects.end(), object); }),
+                      objects.end());
+    }
+
+    for (const Geo::Geometry *geo : objects)
+    {
+        if (skip_selected && geo->is_selected)
+        {
+            continue;
+        }
+        switch (geo->type())
         {
-            if (skip_selected && geo->is_selected)
+        case Geo::Type::POLYGON:
+            if (Geo::distance(pos, *static_cast<const Geo::Polygon *>(geo)) * _ratio < distance)
             {
-                continue;
+                catched_objects.push_back(geo);
             }
-            switch (geo->type())
+            break;
+        case Geo::Type::CIRCLE:
+            if (Geo::distance(pos, *static_cast<const Geo::Circle *>(geo)) * _ratio < distance ||
+                std::abs(Geo::distance(pos, *static_cast<const Geo::Circle *>(geo)) - static_cast<const Geo::Circle *>(geo)->radius) *
+                        _ratio <
+                    distance)
             {
-            case Geo::Type::POLYGON:
-                if (Geo::is_intersected(rect, geo->bounding_rect()))
-                {
-                    if (Geo::distance(pos, *static_cast<const Geo::Polygon *>(geo)) * _ratio < distance)
-                    {
-                        catched_objects.push_back(geo);
-                    }
-                }
-                break;
-            case Geo::Type::CIRCLE:
-                if (Geo::distance(pos, *static_cast<const Geo::Circle *>(geo)) * _ratio < distance ||
-                    std::abs(Geo::distance(pos, *static_cast<const Geo::Circle *>(geo)) - static_cast<const Geo::Circle *>(geo)->radius) *
-                            _ratio <
-                        distance)
+                catched_objects.push_back(geo);
+            }
+            break;
+        case Geo::Type::ELLIPSE:
+            {
+                const Geo::Ellipse *e = static_cast<const Geo::Ellipse *>(geo);
+                if (Geo::distance(pos, e->center()) * _ratio < distance || Geo::distance(pos, *e) * _ratio < distance)
                 {
                     catched_objects.push_back(geo);
                 }
-                break;
-            case Geo::Type::ELLIPSE:
-                if (Geo::is_intersected(rect, geo->bounding_rect()))
-                {
-                    const Geo::Ellipse *e = static_cast<const Geo::Ellipse *>(geo);
-                    if (Geo::distance(pos, e->center()) * _ratio < distance || Geo::distance(pos, *e) * _ratio < distance)
-                    {
-                        catched_objects.push_back(geo);
-                    }
-                }
-                break;
-            case Geo::Type::POLYLINE:
-                if (Geo::is_intersected(rect, geo->bounding_rect()))
-                {
-                    if (Geo::distance(pos, *static_cast<const Geo::Polyline *>(geo)) * _ratio < distance)
-                    {
-                        catched_objects.push_back(geo);
-                    }
-                }
-                break;
-            case Geo::Type::BSPLINE:
-                if (Geo::is_intersected(rect, geo->bounding_rect()))
+            }
+            break;
+        case Geo::Type::POLYLINE:
+            if (Geo::distance(pos, *static_cast<const Geo::Polyline *>(geo)) * _ratio < distance)
+            {
+                catched_objects.push_back(geo);
+            }
+            break;
+        case Geo::Type::BSPLINE:
+            if (Geo::distance(pos, static_cast<const Geo::BSpline *>(geo)->shape()) * _ratio < distance)
+            {
+                catched_objects.push_back(geo);
+            }
+            break;
+        case Geo::Type::BEZIER:
+            if (Geo::distance(pos, static_cast<const Geo::CubicBezier *>(geo)->shape()) * _ratio < distance)
+            {
+                catched_objects.push_back(geo);
+            }
+            break;
+        case Geo::Type::ARC:
+            if (Geo::is_intersected(rect, *static_cast<const Geo::Arc *>(geo)))
+            {
+                catched_objects.push_back(geo);
+            }
+            break;
+        case Geo::Type::POINT:
+            if (Geo::distance(pos, *static_cast<const Geo::Point *>(geo)) * _ratio < distance)
+            {
+                catched_objects.push_back(geo);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    return catched_objects.size() > count;
+}
+
+bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &objects, const double distance, Geo::Point &pos)
+{
+    const CanvasOperations::Tool tool = CanvasOperations::CanvasOperation::tool[0];
+    const bool catch_foot = _catch_types.foot && (tool > CanvasOperations::Tool::Move && tool < CanvasOperations::Tool::Mirror);
+    const bool catch_tangency = _catch_types.tangency && (tool > CanvasOperations::Tool::Move && tool < CanvasOperations::Tool::Mirror);
+    if (!_catch_types.vertex && !_catch_types.center && !catch_foot && !catch_tangency && !_catch_types.intersection)
+    {
+        return false;
+    }
+
+    CatchedPoints points;
+    find_catched_points(objects, distance, pos, points);
+    const Geo::Point press_pos(CanvasOperations::CanvasOperation::press_pos[0], CanvasOperations::CanvasOperation::press_pos[1]);
+    find_curve_catched_points(objects, pos, press_pos, catch_foot, catch_tangency, points);
+    return apply_catched_points(points, distance, pos);
+}
+
+void Canvas::find_catched_points(const std::vector<const Geo::Geometry *> &objects, const double distance, const Geo::Point &pos,
+                                 CatchedPoints &points)
+{
+    const CanvasOperations::Tool tool = CanvasOperations::CanvasOperation::tool[0];
+    const bool catch_vertex = _catch_types.vertex;
+    const bool catch_center = _catch_types.center;
+    const bool catch_foot = _catch_types.foot && (tool > CanvasOperations::Tool::Move && tool < CanvasOperations::Tool::Mirror);
+    const bool catch_intersection = _catch_types.intersection;
+    Geo::Point &vertex_catch_point = points.points[0], &center_catch_point = points.points[1], &foot_catch_point = points.points[2],
+               &intersection_catch_point = points.points[4];
+    double &vertex_catch_distance = points.distances[0], &center_catch_distance = points.distances[1],
+           &foot_catch_distance = points.distances[2], &intersection_catch_distance = points.distances[4];
+    const Geo::Point press_pos(CanvasOperations::CanvasOperation::press_pos[0], CanvasOperations::CanvasOperation::press_pos[1]);
+
+    // 顶点、中点和交点从捕捉点索引中查找,只保留属于已捕捉图形的点
+    std::vector<const Geo::Geometry *> sorted_objects(objects);
+    std::sort(sorted_objects.begin(), sorted_objects.end());
+    const std::function<bool(const Geo::Geometry *)> filter = [&](const Geo::Geometry *object)
+    { return std::binary_search(sorted_objects.begin(), sorted_objects.end(), object); };
+    const double catch_range = distance / _ratio;
+    SnapIndex &snap_index = _editor.snap_index();
+    if (catch_vertex)
+    {
+        snap_index.nearest(pos, catch_range, SnapIndex::Type::Vertex, filter, vertex_catch_point, vertex_catch_distance);
+    }
+    if (catch_center)
+    {
+        snap_index.nearest(pos, catch_range, SnapIndex::Type::Center, filter, center_catch_point, center_catch_distance);
+    }
+    if (catch_intersection)
+    {
+        snap_index.nearest(pos, catch_range, SnapIndex::Type::Intersection, filter, intersection_catch_point,
+                           intersection_catch_distance);
+        // 多段线自身的交点
+        for (const Geo::Geometry *object : objects)
+        {
+            if (object->type() != Geo::Type::POLYLINE)
+            {
+                continue;
+            }
+            const Geo::Polyline &polyline = *static_cast<const Geo::Polyline *>(object);
+            for (size_t i = 1, count = polyline.size(); i < count; ++i)
+            {
+                if (Geo::distance(pos, polyline[i - 1], polyline[i], false) > catch_range)
                 {
-                    if (Geo::distance(pos, static_cast<const Geo::BSpline *>(geo)->shape()) * _ratio < distance)
-                    {
-                        catched_objects.push_back(geo);
-                    }
+                    continue;
                 }
-                break;
-            case Geo::Type::BEZIER:
-                if (Geo::is_intersected(rect, geo->bounding_rect()))
+                for (size_t j = i + 2; j < count; ++j)
                 {
-                    if (Geo::distance(pos, static_cast<const Geo::CubicBezier *>(geo)->shape()) < distance)
+                    if (Geo::Point point; Geo::is_intersected(polyline[i - 1], polyline[i], polyline[j - 1], polyline[j], point, false))
                     {
-                        catched_objects.push_back(geo);
+                        if (const double d = Geo::distance(pos, point); d < intersection_catch_distance)
+                        {
+                            intersection_catch_distance = d;
+                            intersection_catch_point = point;
+                        }
                     }
                 }
-                break;
-            case Geo::Type::ARC:
-                if (Geo::is_intersected(rect, *static_cast<const Geo::Arc *>(geo)))
-                {
-                    catched_objects.push_back(geo);
-                }
-                break;
-            case Geo::Type::POINT:
-                if (Geo::distance(pos, *static_cast<const Geo::Point *>(geo)) * _ratio < distance)
+            }
+        }
+    }
+
+    if (_editor.point_cache().size() > 2)
+    {
+        if (const double d = Geo::distance(pos, _editor.point_cache().front()); catch_vertex && d < vertex_catch_distance)
+        {
+            vertex_catch_distance = d;
+            vertex_catch_point = _editor.point_cache().front();
+        }
+        for (size_t i = 1, count = _editor.point_cache().size() - 1; i < count; ++i)
+        {
+            if (const double d = Geo::distance(pos, _editor.point_cache()[i]); catch_vertex && d < vertex_catch_distance)
+            {
+                vertex_catch_distance = d;
+                vertex_catch_point = _editor.point_cache()[i];
+            }
+            const Geo::Point center((_editor.point_cache()[i - 1] + _editor.point_cache()[i]) / 2);
+            if (const double d = Geo::distance(pos, center); catch_center && d < center_catch_distance)
+            {
+                center_catch_distance = d;
+                center_catch_point = center;
+            }
+            if (Geo::Point foot; catch_foot && Geo::foot_point(_editor.point_cache()[i - 1], _editor.point_cache()[i], press_pos, foot))
+            {
+                if (const double d = Geo::distance(pos, foot); d < foot_catch_distance)
                 {
-                    catched_objects.push_back(geo);
+                    foot_catch_distance = d;
+                    foot_catch_point = foot;
                 }
-                break;
-            default:
-                break;
             }
         }
-    }
-    else
-    {
-        for (const Geo::Geometry *geo : _editor.visible_objects())
+
+        if (catch_intersection)
         {
-            if (skip_selected && geo->is_selected)
-            {
-                continue;
-            }
-            switch (geo->type())
+            for (size_t i = 1, count = _editor.point_cache().size() - 1; i < count; ++i)
             {
-            case Geo::Type::POLYGON:
-                if (Geo::is_intersected(rect, geo->bounding_rect()))
-                {
-                    if (Geo::distance(pos, *static_cast<const Geo::Polygon *>(geo)) * _ratio < distance)
-                    {
-                        catched_objects.push_back(geo);
-                    }
-                }
-                break;
-            case Geo::Type::CIRCLE:
-                if (Geo::distance(pos, *static_cast<const Geo::Circle *>(geo)) * _ratio < distance ||
-                    std::abs(Geo::distance(pos, *static_cast<const Geo::Circle *>(geo)) - static_cast<const Geo::Circle *>(geo)->radius) *
-                            _ratio <
-                        distance)
-                {
-                    catched_objects.push_back(geo);
-                }
-                break;
-            case Geo::Type::ELLIPSE:
-                if (Geo::is_intersected(rect, geo->bounding_rect()))
+                if (Geo::distance(pos, _editor.point_cache()[i - 1], _editor.point_cache()[i], false) > distance)
                 {
-                    const Geo::Ellipse *e = static_cast<const Geo::Ellipse *>(geo);
-                    if (Geo::distance(pos, e->center()) * _ratio < distance || Geo::distance(pos, *e) * _ratio < distance)
-                    {
-                        catched_objects.push_back(geo);
-                    }
+                    continue;
                 }
-                break;
-            case Geo::Type::POLYLINE:
-                if (Geo::is_intersected(rect, geo->bounding_rect()))
+                for (size_t j = i + 2; j < count; ++j)
                 {
-                    if (Geo::distance(pos, *static_cast<const Geo::Polyline *>(geo)) * _ratio < distance)
+                    if (Geo::Point point; Geo::is_intersected(_editor.point_cache()[i - 1], _editor.point_cache()[i],
+                                                              _editor.point_cache()[j - 1], _editor.point_cache()[j], point, false))
                     {
-                        catched_objects.push_back(geo);
+                        if (const double d = Geo::distance(pos, point); d < intersection_catch_distance)
+                        {
+                            intersection_catch_distance = d;
+                            intersection_catch_point = point;
+                        }
                     }
                 }
-                break;
-            case Geo::Type::ARC:
-                if (Geo::is_intersected(rect, *static_cast<const Geo::Arc *>(geo)))
-                {
-                    catched_objects.push_back(geo);
-                }
-                break;
-            case Geo::Type::POINT:
-                if (Geo::distance(pos, *static_cast<const Geo::Point *>(geo)) * _ratio < distance)
-                {
-                    catched_objects.push_back(geo);
-                }
-                break;
-            default:
-                break;
             }
         }
     }
-
-    return catched_objects.size() > count;
 }
 
-bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &objects, const double distance, Geo::Point &pos)
+void Canvas::find_curve_catched_points(const std::vector<const Geo::Geometry *> &objects, const Geo::Point &pos,
+                                       const Geo::Point &press_pos, const bool catch_foot, const bool catch_tangency, CatchedPoints &points)
 {
-    const CanvasOperations::Tool tool = CanvasOperations::CanvasOperation::tool[0];
-    const bool catch_vertex = _catch_types.vertex;
-    const bool catch_center = _catch_types.center;
-    const bool catch_foot = _catch_types.foot && (tool > CanvasOperations::Tool::Move && tool < CanvasOperations::Tool::Mirror);
-    const bool catch_tangency = _catch_types.tangency && (tool > CanvasOperations::Tool::Move && tool < CanvasOperations::Tool::Mirror);
-    const bool catch_intersection = _catch_types.intersection;
-    if (!catch_vertex && !catch_center && !catch_foot && !catch_tangency && !catch_intersection)
+    if (!catch_foot && !catch_tangency)
     {
-        return false;
+        return;
     }
 
-    Geo::Point vertex_catch_point, center_catch_point, foot_catch_point, tangency_catch_point, intersection_catch_point;
-    double vertex_catch_distance = DBL_MAX, center_catch_distance = DBL_MAX, foot_catch_distance = DBL_MAX,
-           tangency_catch_distance = DBL_MAX, intersection_catch_distance = DBL_MAX;
-    const Geo::Point press_pos(CanvasOperations::CanvasOperation::press_pos[0], CanvasOperations::CanvasOperation::press_pos[1]);
+    Geo::Point &foot_catch_point = points.points[2], &tangency_catch_point = points.points[3];
+    double &foot_catch_distance = points.distances[2], &tangency_catch_distance = points.distances[3];
     for (const Geo::Geometry *object : objects)
     {
         switch (object->type())
@@ -2996,24 +3007,8 @@ bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &
         case Geo::Type::POLYLINE:
             {
                 const Geo::Polyline &polyline = *static_cast<const Geo::Polyline *>(object);
-                if (const double d = Geo::distance(pos, polyline.front()); catch_vertex && d < vertex_catch_distance)
-                {
-                    vertex_catch_distance = d;
-                    vertex_catch_point = polyline.front();
-                }
                 for (size_t i = 1, count = polyline.size(); i < count; ++i)
                 {
-                    if (const double d = Geo::distance(pos, polyline[i]); catch_vertex && d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point = polyline[i];
-                    }
-                    const Geo::Point center((polyline[i - 1] + polyline[i]) / 2);
-                    if (const double d = Geo::distance(pos, center); catch_center && d < center_catch_distance)
-                    {
-                        center_catch_distance = d;
-                        center_catch_point = center;
-                    }
                     if (Geo::Point foot; catch_foot && Geo::foot_point(polyline[i - 1], polyline[i], press_pos, foot))
                     {
                         if (const double d = Geo::distance(pos, foot); d < foot_catch_distance)
@@ -3023,51 +3018,13 @@ bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &
                         }
                     }
                 }
-                if (catch_intersection)
-                {
-                    for (size_t i = 1, count = polyline.size(); i < count; ++i)
-                    {
-                        if (Geo::distance(pos, polyline[i - 1], polyline[i], false) > distance)
-                        {
-                            continue;
-                        }
-                        for (size_t j = i + 2; j < count; ++j)
-                        {
-                            if (Geo::Point point;
-                                Geo::is_intersected(polyline[i - 1], polyline[i], polyline[j - 1], polyline[j], point, false))
-                            {
-                                if (const double d = Geo::distance(pos, point); d < intersection_catch_distance)
-                                {
-                                    intersection_catch_distance = d;
-                                    intersection_catch_point = point;
-                                }
-                            }
-                        }
-                    }
-                }
             }
             break;
         case Geo::Type::POLYGON:
             {
                 const Geo::Polygon &polygon = *static_cast<const Geo::Polygon *>(object);
-                if (const double d = Geo::distance(pos, polygon.front()); catch_vertex && d < vertex_catch_distance)
-                {
-                    vertex_catch_distance = d;
-                    vertex_catch_point = polygon.front();
-                }
                 for (size_t i = 1, count = polygon.size(); i < count; ++i)
                 {
-                    if (const double d = Geo::distance(pos, polygon[i]); catch_vertex && d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point = polygon[i];
-                    }
-                    const Geo::Point center((polygon[i - 1] + polygon[i]) / 2);
-                    if (const double d = Geo::distance(pos, center); catch_center && d < center_catch_distance)
-                    {
-                        center_catch_distance = d;
-                        center_catch_point = center;
-                    }
                     if (Geo::Point foot; catch_foot && Geo::foot_point(polygon[i - 1], polygon[i], press_pos, foot))
                     {
                         if (const double d = Geo::distance(pos, foot); d < foot_catch_distance)
@@ -3082,39 +3039,6 @@ bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &
         case Geo::Type::CIRCLE:
             {
                 const Geo::Circle *c = static_cast<const Geo::Circle *>(object);
-                if (catch_vertex)
-                {
-                    if (const double d = Geo::distance(pos.x, pos.y, c->x, c->y); d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point.x = c->x;
-                        vertex_catch_point.y = c->y;
-                    }
-                    if (const double d = Geo::distance(pos.x, pos.y, c->x - c->radius, c->y); d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point.x = c->x - c->radius;
-                        vertex_catch_point.y = c->y;
-                    }
-                    if (const double d = Geo::distance(pos.x, pos.y, c->x + c->radius, c->y); d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point.x = c->x + c->radius;
-                        vertex_catch_point.y = c->y;
-                    }
-                    if (const double d = Geo::distance(pos.x, pos.y, c->x, c->y + c->radius); d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point.x = c->x;
-                        vertex_catch_point.y = c->y + c->radius;
-                    }
-                    if (const double d = Geo::distance(pos.x, pos.y, c->x, c->y - c->radius); d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point.x = c->x;
-                        vertex_catch_point.y = c->y - c->radius;
-                    }
-                }
                 if (Geo::Point output0(DBL_MAX, DBL_MAX), output1(DBL_MAX, DBL_MAX);
                     catch_foot && Geo::foot_point(*c, press_pos, output0, output1))
                 {
@@ -3148,50 +3072,6 @@ bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &
         case Geo::Type::ELLIPSE:
             {
                 const Geo::Ellipse *e = static_cast<const Geo::Ellipse *>(object);
-                if (catch_vertex)
-                {
-                    if (e->is_arc())
-                    {
-                        if (const double d = Geo::distance(pos, e->shape().front()); d < vertex_catch_distance)
-                        {
-                            vertex_catch_distance = d;
-                            vertex_catch_point = e->shape().front();
-                        }
-                        if (const double d = Geo::distance(pos, e->shape().back()); d < vertex_catch_distance)
-                        {
-                            vertex_catch_distance = d;
-                            vertex_catch_point = e->shape().back();
-                        }
-                    }
-                    else
-                    {
-                        if (const double d = Geo::distance(pos, e->center()); d < vertex_catch_distance)
-                        {
-                            vertex_catch_distance = d;
-                            vertex_catch_point = e->center();
-                        }
-                        if (const double d = Geo::distance(pos, e->a0()); d < vertex_catch_distance)
-                        {
-                            vertex_catch_distance = d;
-                            vertex_catch_point = e->a0();
-                        }
-                        if (const double d = Geo::distance(pos, e->a1()); d < vertex_catch_distance)
-                        {
-                            vertex_catch_distance = d;
-                            vertex_catch_point = e->a1();
-                        }
-                        if (const double d = Geo::distance(pos, e->b0()); d < vertex_catch_distance)
-                        {
-                            vertex_catch_distance = d;
-                            vertex_catch_point = e->b0();
-                        }
-                        if (const double d = Geo::distance(pos, e->b1()); d < vertex_catch_distance)
-                        {
-                            vertex_catch_distance = d;
-                            vertex_catch_point = e->b1();
-                        }
-                    }
-                }
                 if (std::vector<Geo::Point> output; catch_foot && Geo::foot_point(*e, press_pos, output))
                 {
                     for (const Geo::Point &p : output)
@@ -3222,11 +3102,6 @@ bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &
         case Geo::Type::BSPLINE:
             {
                 const Geo::BSpline &bspline = *static_cast<const Geo::BSpline *>(object);
-                if (const double d = Geo::distance(pos, bspline.path_points.front()); catch_vertex && d < vertex_catch_distance)
-                {
-                    vertex_catch_distance = d;
-                    vertex_catch_point = bspline.path_points.front();
-                }
                 if (std::vector<Geo::Point> points; catch_foot && Geo::foot_point(press_pos, bspline, points, nullptr))
                 {
                     for (const Geo::Point &point : points)
@@ -3249,32 +3124,11 @@ bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &
                         }
                     }
                 }
-                for (size_t i = 1, count = bspline.path_points.size(); i < count; ++i)
-                {
-                    if (const double d = Geo::distance(pos, bspline.path_points[i]); catch_vertex && d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point = bspline.path_points[i];
-                    }
-                }
             }
             break;
         case Geo::Type::BEZIER:
             {
                 const Geo::CubicBezier &bezier = *static_cast<const Geo::CubicBezier *>(object);
-                if (catch_vertex)
-                {
-                    if (double dis0 = Geo::distance(pos, bezier.front()), dis1 = Geo::distance(pos, bezier.back()); dis0 <= dis1)
-                    {
-                        vertex_catch_distance = dis0;
-                        vertex_catch_point = bezier.front();
-                    }
-                    else
-                    {
-                        vertex_catch_distance = dis1;
-                        vertex_catch_point = bezier.back();
-                    }
-                }
                 if (std::vector<Geo::Point> points; catch_foot && Geo::foot_point(press_pos, bezier, points, nullptr))
                 {
                     for (const Geo::Point &point : points)
@@ -3299,115 +3153,19 @@ bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &
                 }
             }
             break;
-        case Geo::Type::ARC:
-            {
-                const Geo::Arc *arc = static_cast<const Geo::Arc *>(object);
-                if (const double d = Geo::distance(pos, arc->control_points[0]); catch_vertex && d < vertex_catch_distance)
-                {
-                    vertex_catch_distance = d;
-                    vertex_catch_point = arc->control_points[0];
-                }
-                for (int i = 1; i < 3; ++i)
-                {
-                    if (double d = Geo::distance(pos, arc->control_points[i]); d < vertex_catch_distance)
-                    {
-                        vertex_catch_distance = d;
-                        vertex_catch_point = arc->control_points[i];
-                    }
-                }
-            }
-            break;
-        case Geo::Type::POINT:
-            {
-                const Geo::Point *point = static_cast<const Geo::Point *>(object);
-                if (const double d = Geo::distance(pos, *point); catch_vertex && d < vertex_catch_distance)
-                {
-                    vertex_catch_distance = d;
-                    vertex_catch_point = *point;
-                }
-            }
-            break;
         default:
             break;
         }
     }
+}
 
-    if (catch_intersection)
-    {
-        for (size_t i = 0, count = objects.size(); i < count; ++i)
-        {
-            for (size_t j = i + 1; j < count; ++j)
-            {
-                std::vector<Geo::Point> points;
-                if (Geo::find_intersections(objects[i], objects[j], pos, distance, points))
-                {
-                    for (const Geo::Point &point : points)
-                    {
-                        if (const double d = Geo::distance(pos, point); d < intersection_catch_distance)
-                        {
-                            intersection_catch_distance = d;
-                            intersection_catch_point = point;
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    if (_editor.point_cache().size() > 2)
-    {
-        if (const double d = Geo::distance(pos, _editor.point_cache().front()); catch_vertex && d < vertex_catch_distance)
-        {
-            vertex_catch_distance = d;
-            vertex_catch_point = _editor.point_cache().front();
-        }
-        for (size_t i = 1, count = _editor.point_cache().size() - 1; i < count; ++i)
-        {
-            if (const double d = Geo::distance(pos, _editor.point_cache()[i]); catch_vertex && d < vertex_catch_distance)
-            {
-                vertex_catch_distance = d;
-                vertex_catch_point = _editor.point_cache()[i];
-            }
-            const Geo::Point center((_editor.point_cache()[i - 1] + _editor.point_cache()[i]) / 2);
-            if (const double d = Geo::distance(pos, center); catch_center && d < center_catch_distance)
-            {
-                center_catch_distance = d;
-                center_catch_point = center;
-            }
-            if (Geo::Point foot; catch_foot && Geo::foot_point(_editor.point_cache()[i - 1], _editor.point_cache()[i], press_pos, foot))
-            {
-                if (const double d = Geo::distance(pos, foot); d < foot_catch_distance)
-                {
-                    foot_catch_distance = d;
-                    foot_catch_point = foot;
-                }
-            }
-        }
-
-        if (catch_intersection)
-        {
-            for (size_t i = 1, count = _editor.point_cache().size() - 1; i < count; ++i)
-            {
-                if (Geo::distance(pos, _editor.point_cache()[i - 1], _editor.point_cache()[i], false) > distance)
-                {
-                    continue;
-                }
-                for (size_t j = i + 2; j < count; ++j)
-                {
-                    if (Geo::Point point; Geo::is_intersected(_editor.point_cache()[i - 1], _editor.point_cache()[i],
-                                                              _editor.point_cache()[j - 1], _editor.point_cache()[j], point, false))
-                    {
-                        if (const double d = Geo::distance(pos, point); d < intersection_catch_distance)
-                        {
-                            intersection_catch_distance = d;
-                            intersection_catch_point = point;
-                        }
-                    }
-                }
-            }
-        }
-    }
-
+bool Canvas::apply_catched_points(const CatchedPoints &points, const double distance, Geo::Point &pos)
+{
+    const Geo::Point &vertex_catch_point = points.points[0], &center_catch_point = points.points[1], &foot_catch_point = points.points[2],
+                     &tangency_catch_point = points.points[3], &intersection_catch_point = points.points[4];
+    const double vertex_catch_distance = points.distances[0], center_catch_distance = points.distances[1],
+                 foot_catch_distance = points.distances[2], tangency_catch_distance = points.distances[3],
+                 intersection_catch_distance = points.distances[4];
     if (vertex_catch_distance > distance / _ratio && center_catch_distance > distance / _ratio && foot_catch_distance > distance / _ratio &&
         tangency_catch_distance > distance / _ratio && intersection_catch_distance > distance / _ratio)
     {
@@ -3510,3 +3268,66 @@ bool Canvas::refresh_catchline_points(const std::vector<const Geo::Geometry *> &
 
     return true;
 }
+
+void Canvas::catch_worker_loop()
+{
+    std::unique_lock<std::mutex> lock(_catch_worker.mutex);
+    while (true)
+    {
+        _catch_worker.condition.wait(lock, [this]() { return _catch_worker.quit || _catch_worker.pending; });
+        if (_catch_worker.quit)
+        {
+            return;
+        }
+        CatchTask task(std::move(_catch_worker.task));
+        _catch_worker.pending = false;
+        lock.unlock();
+
+        std::vector<const Geo::Geometry *> objects;
+        for (const std::shared_ptr<const Geo::Geometry> &object : task.objects)
+        {
+            objects.push_back(object.get());
+        }
+        find_curve_catched_points(objects, task.pos, task.press_pos, task.catch_foot, task.catch_tangency, task.points);
+
+        lock.lock();
+        if (!_catch_worker.pending && !_catch_worker.quit) // 已有更新的请求时直接丢弃结果
+        {
+            QMetaObject::invokeMethod(
+                this, [this, id = task.id, points = task.points]() { publish_catched_points(id, points); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void Canvas::publish_catched_points(const size_t id, const CatchedPoints &points)
+{
+    Geo::Point pos(_catch_worker.cursor);
+    if (id != _catch_worker.latest_id || !apply_catched_points(points, _catch_distance, pos))
+    {
+        return;
+    }
+    _bool_flags.show_catched_points = true;
+    if (pos == _catch_worker.coord)
+    {
+        return update();
+    }
+
+    // 捕捉到更近的垂足或切点,按新坐标重新执行当前操作的鼠标移动
+    _catch_worker.coord = pos;
+    const Geo::Point coord = real_coord_to_view_coord(pos.x, pos.y);
+    _mouse_pos_1.setX(coord.x);
+    _mouse_pos_1.setY(coord.y);
+    _info_labels[0]->setText(QString("X:%1 Y:%2").arg(pos.x, 0, 'f', 2).arg(pos.y, 0, 'f', 2));
+    CanvasOperations::CanvasOperation::real_pos[0] = pos.x, CanvasOperations::CanvasOperation::real_pos[1] = pos.y;
+    if (CanvasOperations::CanvasOperation *op = CanvasOperations::CanvasOperation::operation()[CanvasOperations::CanvasOperation::tool[0]];
+        op != nullptr)
+    {
+        QMouseEvent event(QEvent::MouseMove, _mouse_pos_1, mapToGlobal(_mouse_pos_1), Qt::MouseButton::NoButton, _catch_worker.buttons,
+                          _catch_worker.modifiers);
+        if (op->mouse_move(&event))
+        {
+            _info_labels[1]->setText(CanvasOperations::CanvasOperation::info);
+        }
+    }
+    update();
+}
@@ -1,5 +1,11 @@
 #pragma once
+#include <cfloat>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <thread>
+#include <unordered_map>
 #include <QOpenGLWidget>
 #include <QPaintEvent>
 #include <QLabel>
@@ -10,6 +16,7 @@
 #include "base/Editor.hpp"
 #include "draw/CanvasMenu.hpp"
 #include "draw/CanvasOperation.hpp"
+#include "draw/VBOChunks.hpp"
 
 
 class Canvas : public QOpenGLWidget, protected QOpenGLFunctions_4_5_Core
@@ -56,6 +63,8 @@ private:
         unsigned int circle_printable_points = 0;
         unsigned int curve_printable_points = 0;
         unsigned int point = 0;
+        unsigned int array = 0;          // 阵列源图形的顶点
+        unsigned int array_instance = 0; // 阵列实例的变换矩阵,每个实例6个double
     } _shape_vbo;
 
     struct ShapeIBO
@@ -64,16 +73,19 @@ private:
         unsigned int polygon = 0;
         unsigned int circle = 0;
         unsigned int curve = 0;
+        unsigned int array = 0;
     } _shape_ibo;
 
-    struct SelectedIBO
+    // 与_shape_vbo顶点一一对应的选中标记,着色器按标记在常规颜色和选中颜色间选择
+    struct SelectedVBO
     {
         unsigned int polyline = 0;
         unsigned int polygon = 0;
         unsigned int circle = 0;
         unsigned int curve = 0;
         unsigned int point = 0;
-    } _selected_ibo;
+        unsigned int array = 0; // 逐实例的选中标记
+    } _selected_vbo;
 
     struct DimensionVBO
     {
@@ -110,7 +122,8 @@ private:
         unsigned int operation_tool_lines = 0;
         unsigned int catched_points = 0;
         unsigned int origin_and_select_rect = 0;
-        unsigned int text = 0; // 位置+纹理坐标双属性
+        unsigned int text = 0;  // 位置+纹理坐标双属性
+        unsigned int array = 0; // 逐顶点位置+逐实例变换矩阵和选中标记
     } _vao;
 
     struct Uniforms
@@ -119,6 +132,8 @@ private:
         int ctm = 0;
         int color = 0;
         int enable_tex = 0;
+        int selected_color = 0;
+        int enable_instance = 0;
     } _uniforms;
 
     struct PointCount
@@ -142,24 +157,66 @@ private:
         unsigned int curve = 0;
     } _shape_index_count;
 
-    struct SelectedIndexCount
+    // 各VBO中顶点所属的顶层图形,按地址排序,VBO重建时更新
+    struct VBOOwners
     {
-        unsigned int polyline = 0;
-        unsigned int polygon = 0;
-        unsigned int circle = 0;
-        unsigned int curve = 0;
-        unsigned int point = 0;
-    } _selected_index_count;
-
-    struct VisibleObject
+        std::vector<const Geo::Geometry *> polyline;
+        std::vector<const Geo::Geometry *> polygon;
+        std::vector<const Geo::Geometry *> circle;
+        std::vector<const Geo::Geometry *> curve;
+        std::vector<const Geo::Geometry *> point;
+        std::vector<const Geo::Geometry *> array;
+    } _vbo_owners;
+
+    std::vector<const Geo::Geometry *> _selected_objects; // 已写入选中标记的选中图形,按地址排序
+
+    // 常驻VBO中的图形,[0]为上次重建时的结果
+    struct VBOObject
     {
-        std::vector<Geo::Polyline *> polyline;
-        std::vector<Geo::Polygon *> polygon;
-        std::vector<Geo::Geometry *> circle;
-        std::vector<Geo::Geometry *> curve;
-        std::vector<Geo::Point *> point;
+        std::vector<Array *> array;
         std::vector<Dim::Dimension *> dimensions;
-    } _visible_objects[2];
+    } _vbo_objects[2];
+
+    // 折线、多边形、圆、曲线和点的VBO包含可见图层的全部图形并按空间分块,平移缩放视图时不重建,绘制时剔除不可见的块
+    struct Chunks
+    {
+        VBOChunks polyline;
+        VBOChunks polygon;
+        VBOChunks circle;
+        VBOChunks curve;
+        VBOChunks point;
+    } _chunks;
+
+    // 其余常驻VBO上次重建时视图四叉树的增删改计数
+    struct Modifications
+    {
+        size_t array = SIZE_MAX;
+        size_t dimension = SIZE_MAX;
+        size_t circle_printable_points = SIZE_MAX;
+        size_t curve_printable_points = SIZE_MAX;
+    } _modifications;
+
+    // 事务提交前推迟的VBO刷新
+    struct PendingRefresh
+    {
+        bool all = false;
+        bool flush = false;
+        bool selected = false;
+        std::set<Geo::Type> types;
+    } _pending_refresh;
+
+    // 每个阵列一次实例化绘制,偏移和数量均以元素个数计
+    struct ArrayDraw
+    {
+        unsigned int index_offset = 0; // 源图形折线在_shape_ibo.array中的位置
+        unsigned int index_count = 0;
+        unsigned int point_offset = 0; // 源图形中的点在_shape_vbo.array中的位置
+        unsigned int point_count = 0;
+        unsigned int instance_offset = 0;
+        unsigned int instance_count = 0;
+        Geo::AABBRectParams rect; // 全部实例的包围盒,用于剔除
+    };
+    std::vector<ArrayDraw> _array_draws;
 
     unsigned int _cpus = 2;
 
@@ -168,6 +225,41 @@ private:
     double _catch_distance = 0;
     static const int catch_count = 5;
 
+    struct CatchedPoints // 按CatchedPointType排列的捕捉点及其与光标的距离
+    {
+        Geo::Point points[catch_count];
+        double distances[catch_count] = {DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX};
+    };
+
+    struct CatchTask
+    {
+        size_t id = 0;
+        Geo::Point pos, press_pos;
+        bool catch_foot = false, catch_tangency = false;
+        std::vector<std::shared_ptr<const Geo::Geometry>> objects; // 已捕捉图形的只读快照,避免后台线程访问正在编辑的图形
+        CatchedPoints points;
+    };
+
+    // 光标移动时的垂足和切点在后台线程计算,只处理最新的请求
+    struct CatchWorker
+    {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable condition;
+        CatchTask task;
+        bool pending = false;
+        bool quit = false;
+
+        // 以下只在GUI线程访问
+        size_t latest_id = 0;
+        Geo::Point cursor, coord; // 最近一次请求的光标位置和已交给操作的坐标
+        Qt::MouseButtons buttons;
+        Qt::KeyboardModifiers modifiers;
+        // 图形快照,视图四叉树的增删改计数变化前复用,不在每次移动光标时复制图形
+        std::unordered_map<const Geo::Geometry *, std::shared_ptr<const Geo::Geometry>> snapshots;
+        size_t modification = SIZE_MAX;
+    } _catch_worker;
+
     struct CatchTypes
     {
         bool vertex = false;
@@ -280,11 +372,18 @@ public:
 
     Geo::Point canvas_coord_to_real_coord(const double x, const double y) const;
 
-    bool catch_cursor(const double x, const double y, Geo::Point &coord, const double distance, const bool skip_selected);
+    // async为true时垂足和切点交给后台线程计算,结果就绪后再更新捕捉点
+    bool catch_cursor(const double x, const double y, Geo::Point &coord, const double distance, const bool skip_selected,
+                      const bool async = false);
 
     bool catch_point(const double x, const double y, Geo::Point &coord, const double distance);
 
 
+    // 事务期间的VBO刷新推迟到最外层提交时合并进行,事务可嵌套
+    void begin_transaction();
+
+    void commit_transaction();
+
     // 直接更新所有VBO,点数量可能发生变化
     void refresh_vbo(const bool flush);
 
@@ -292,10 +391,17 @@ public:
 
     void refresh_vbo(const bool flush, const std::set<Geo::Type> &types);
 
+    // 拖动曲线时只改写object在所在块中的数据并上传该块,返回false时需要调用refresh_vbo;
+    // 块的划分和其余级别留到松开鼠标后的refresh_vbo更新
+    bool refresh_vbo(const Geo::Geometry *object);
+
     struct VBOData
     {
         std::vector<double> vbo_data;
         std::vector<unsigned int> ibo_data;
+        std::vector<unsigned char> selected_data; // 逐顶点选中标记
+        std::vector<double> instance_data;        // 阵列实例的变换矩阵
+        VBOChunks::Uploads chunks;                // 分块VBO中需要上传的块
     };
 
     struct DimVBOData
@@ -309,37 +415,66 @@ public:
 
     VBOData refresh_circle_vbo(const bool flush);
 
+    // 按像素尺寸写入贝塞尔曲线或B样条的离散点
+    static bool write_curve(Geo::Geometry *object, const double pixel, std::vector<double> &vbo_data, std::vector<unsigned int> &ibo_data);
+
     VBOData refresh_curve_vbo(const bool flush);
 
     VBOData refresh_point_vbo(const bool flush);
 
-    VBOData refresh_circle_printable_points();
+    VBOData refresh_array_vbo(const bool flush);
+
+    VBOData refresh_circle_printable_points(const bool flush);
+
+    VBOData refresh_curve_printable_points(const bool flush);
+
+    // 可见图层中type类型的图形及组合中type类型的子图形
+    std::vector<VBOChunks::Item> resident_items(const std::set<Geo::Type> &types) const;
 
-    VBOData refresh_curve_printable_points();
+    // 将块写入各自的槽位,需要时先按容量重新分配缓冲区;ibo为0时没有索引
+    void upload_chunks(const VBOChunks::Uploads &uploads, const unsigned int vbo, const unsigned int selected_vbo, const unsigned int ibo);
 
     DimVBOData refresh_dimension_vbo(const bool flush);
 
     void refresh_select_rect(const double x0, const double y0, const double x1, const double y1);
 
+    // 按Editor中的选中图形更新顶点选中标记,只改写选中状态变化的图形
     void refresh_selected_ibo();
 
-    void refresh_selected_ibo(const Geo::Geometry *object);
-
-    void refresh_selected_ibo(const std::vector<Geo::Geometry *> &objects);
-
     void refresh_selected_vbo();
 
     void refresh_selected_dimension_vbo();
 
     void clear_selected_ibo();
 
+    bool is_marked_selected(const Geo::Geometry *object) const;
+
+    // 改写object在各VBO中顶点的选中标记,object不在VBO中时不访问object
+    void write_selected_flags(const Geo::Geometry *object, const unsigned char value);
+
     void paint_text();
 
     void paint_dim_text();
 
 
     bool refresh_catached_points(const double x, const double y, const double distance, std::vector<const Geo::Geometry *> &catched_objects,
-                                 const bool skip_selected, const bool current_group_only = true) const;
+                                 const bool skip_selected, const bool current_group_only = true);
 
     bool refresh_catchline_points(const std::vector<const Geo::Geometry *> &objects, const double distance, Geo::Point &pos);
+
+    // 顶点、中点和交点
+    void find_catched_points(const std::vector<const Geo::Geometry *> &objects, const double distance, const Geo::Point &pos,
+                             CatchedPoints &points);
+
+    // 垂足和切点,只读取objects,可在后台线程调用
+    static void find_curve_catched_points(const std::vector<const Geo::Geometry *> &objects, const Geo::Point &pos,
+                                          const Geo::Point &press_pos, const bool catch_foot, const bool catch_tangency,
+                                          CatchedPoints &points);
+
+    // 选出最近的捕捉点并更新捕捉标记
+    bool apply_catched_points(const CatchedPoints &points, const double distance, Geo::Point &pos);
+
+    void catch_worker_loop();
+
+    void publish_catched_points(const size_t id, const CatchedPoints &points);
 };
\ No newline at end of file
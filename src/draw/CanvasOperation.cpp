@@ -278,7 +278,7 @@ bool SelectOperation::mouse_press(QMouseEvent *event)
         {
             if (event->modifiers() == Qt::KeyboardModifier::ControlModifier)
             {
-                clicked_object->is_selected = false;
+                Canvas::canvas->editor().set_selected(clicked_object, false);
                 Canvas::canvas->refresh_selected_ibo();
             }
             else
@@ -314,16 +314,8 @@ bool SelectOperation::mouse_move(QMouseEvent *event)
     if (_select)
     {
         Canvas::canvas->refresh_select_rect(_pos[0], _pos[1], real_pos[0], real_pos[1]);
-        if (std::vector<Geo::Geometry *> selected_objects =
-                Canvas::canvas->editor().select(Geo::AABBRect(_pos[0], _pos[1], real_pos[0], real_pos[1]), false, true);
-            selected_objects.empty())
-        {
-            Canvas::canvas->clear_selected_ibo();
-        }
-        else
-        {
-            Canvas::canvas->refresh_selected_ibo(selected_objects);
-        }
+        Canvas::canvas->editor().select(Geo::AABBRect(_pos[0], _pos[1], real_pos[0], real_pos[1]), false, true);
+        Canvas::canvas->refresh_selected_ibo();
         tool_lines.clear();
         return true;
     }
@@ -403,6 +395,11 @@ bool MoveOperation::mouse_release(QMouseEvent *event)
                 }
                 Canvas::canvas->editor().edited_shape.clear();
             }
+            if (selected_objects.size() == 1)
+            {
+                // 拖动曲线时只改写了所在块,松开后重新划分并按块完整更新
+                Canvas::canvas->refresh_vbo(false, selected_objects.front()->type());
+            }
         }
     }
     return false;
@@ -417,10 +414,13 @@ bool MoveOperation::mouse_move(QMouseEvent *event)
         Canvas::canvas->editor().translate_points(clicked_object, real_pos[2], real_pos[3], real_pos[0], real_pos[1],
                                                   event->modifiers() == Qt::ControlModifier);
         refresh_tool_lines(clicked_object);
-        Canvas::canvas->refresh_vbo(false, clicked_object->type());
+        if (!Canvas::canvas->refresh_vbo(clicked_object))
+        {
+            Canvas::canvas->refresh_vbo(false, clicked_object->type());
+        }
         if (event->modifiers() == Qt::ControlModifier)
         {
-            Canvas::canvas->refresh_selected_ibo(clicked_object);
+            Canvas::canvas->refresh_selected_ibo();
         }
         if (event->modifiers() != Qt::ControlModifier && GlobalSetting::setting().auto_aligning)
         {
@@ -447,10 +447,7 @@ bool MoveOperation::mouse_move(QMouseEvent *event)
             types.insert(object->type());
         }
         Canvas::canvas->refresh_vbo(false, types);
-        std::vector<Geo::Geometry *> visible_selected_objects;
-        std::set_intersection(selected_objects.begin(), selected_objects.end(), Canvas::canvas->editor().visible_objects().begin(),
-                              Canvas::canvas->editor().visible_objects().end(), std::back_inserter(visible_selected_objects));
-        Canvas::canvas->refresh_selected_ibo(visible_selected_objects);
+        Canvas::canvas->refresh_selected_ibo();
     }
     return true;
 }
@@ -3537,22 +3534,7 @@ bool RingArrayOperation::mouse_press(QMouseEvent *event)
         if (std::vector<Geo::Geometry *> selected_objects = Canvas::canvas->editor().selected();
             !selected_objects.empty() && Canvas::canvas->editor().ring_array(selected_objects, real_pos[0], real_pos[1], _count))
         {
-            std::set<Geo::Type> types;
-            for (const Geo::Geometry *object : selected_objects)
-            {
-                if (const Combination *combination = dynamic_cast<const Combination *>(object))
-                {
-                    for (const Geo::Geometry *item : *combination)
-                    {
-                        types.insert(item->type());
-                    }
-                }
-                else
-                {
-                    types.insert(object->type());
-                }
-            }
-            Canvas::canvas->refresh_vbo(false, types);
+            Canvas::canvas->refresh_vbo(false, Geo::Type::ARRAY);
             Canvas::canvas->refresh_selected_ibo();
             tool[0] = Tool::Select;
             return true;
@@ -3580,22 +3562,7 @@ bool RingArrayOperation::read_parameters(const double *params, const int count)
         if (std::vector<Geo::Geometry *> selected_objects = Canvas::canvas->editor().selected();
             !selected_objects.empty() && Canvas::canvas->editor().ring_array(selected_objects, params[0], params[1], _count))
         {
-            std::set<Geo::Type> types;
-            for (const Geo::Geometry *object : selected_objects)
-            {
-                if (const Combination *combination = dynamic_cast<const Combination *>(object))
-                {
-                    for (const Geo::Geometry *item : *combination)
-                    {
-                        types.insert(item->type());
-                    }
-                }
-                else
-                {
-                    types.insert(object->type());
-                }
-            }
-            Canvas::canvas->refresh_vbo(false, types);
+            Canvas::canvas->refresh_vbo(false, Geo::Type::ARRAY);
             Canvas::canvas->refresh_selected_ibo();
             tool[0] = Tool::Select;
             return true;
@@ -3626,7 +3593,7 @@ bool ShapeDifferenceOperation::mouse_press(QMouseEvent *event)
             if (_shape == nullptr)
             {
                 _shape = clicked_object;
-                _shape->is_selected = true;
+                Canvas::canvas->editor().set_selected(_shape, true);
                 Canvas::canvas->refresh_selected_ibo();
                 return true;
             }
@@ -3678,7 +3645,7 @@ bool FilletOperation::mouse_press(QMouseEvent *event)
                 switch (clicked_object->type())
                 {
                 case Geo::Type::POLYGON:
-                    for (const Geo::Point &p : *static_cast<Geo::Polygon *>(clicked_object))
+                    for (const Geo::Point &p : *static_cast<const Geo::Polygon *>(clicked_object))
                     {
                         if (Geo::distance(p.x, p.y, real_pos[0], real_pos[1]) < dis)
                         {
@@ -3702,7 +3669,7 @@ bool FilletOperation::mouse_press(QMouseEvent *event)
                     }
                     break;
                 case Geo::Type::POLYLINE:
-                    for (const Geo::Point &p : *static_cast<Geo::Polyline *>(clicked_object))
+                    for (const Geo::Point &p : *static_cast<const Geo::Polyline *>(clicked_object))
                     {
                         if (Geo::distance(p.x, p.y, real_pos[0], real_pos[1]) < dis)
                         {
@@ -3739,7 +3706,7 @@ bool FilletOperation::mouse_press(QMouseEvent *event)
                     dynamic_cast<Geo::Polyline *>(_object0) != nullptr)
                 {
                     _pos0.x = real_pos[0], _pos0.y = real_pos[1];
-                    _object0->is_selected = true;
+                    Canvas::canvas->editor().set_selected(_object0, true);
                     Canvas::canvas->refresh_selected_ibo();
                 }
                 else
@@ -3842,7 +3809,7 @@ bool FreeFilletOperation::mouse_press(QMouseEvent *event)
                  (type == Geo::Type::ELLIPSE && static_cast<Geo::Ellipse *>(clicked_object)->is_arc())))
             {
                 _object1 = clicked_object;
-                _object0->is_selected = true;
+                Canvas::canvas->editor().set_selected(_object0, true);
                 Canvas::canvas->refresh_selected_ibo();
                 return true;
             }
@@ -4062,7 +4029,7 @@ bool ChamferOperation::mouse_press(QMouseEvent *event)
             switch (clicked_object->type())
             {
             case Geo::Type::POLYGON:
-                for (const Geo::Point &p : *static_cast<Geo::Polygon *>(clicked_object))
+                for (const Geo::Point &p : *static_cast<const Geo::Polygon *>(clicked_object))
                 {
                     if (Geo::distance(p.x, p.y, real_pos[0], real_pos[1]) < dis)
                     {
@@ -4078,7 +4045,7 @@ bool ChamferOperation::mouse_press(QMouseEvent *event)
                 }
                 break;
             case Geo::Type::POLYLINE:
-                for (const Geo::Point &p : *static_cast<Geo::Polyline *>(clicked_object))
+                for (const Geo::Point &p : *static_cast<const Geo::Polyline *>(clicked_object))
                 {
                     if (Geo::distance(p.x, p.y, real_pos[0], real_pos[1]) < dis)
                     {
@@ -4447,7 +4414,7 @@ bool BlendOperation::mouse_press(QMouseEvent *event)
                 _object1 = clicked_object;
                 if (Canvas::canvas->editor().blend(_object0, _object1, _pos[0], _pos[1]))
                 {
-                    _object1->is_selected = false;
+                    Canvas::canvas->editor().set_selected(_object1, false);
                     Canvas::canvas->refresh_vbo(false, Geo::Type::BEZIER);
                     Canvas::canvas->refresh_selected_ibo();
                 }
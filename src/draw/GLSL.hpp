@@ -6,16 +6,24 @@ namespace GLSL
 const char *const base_vss = "#version 450 core\n"
                              "layout (location = 0) in dvec2 pos;\n"
                              "layout (location = 1) in dvec2 texCoord;\n"
+                             "layout (location = 2) in float selected;\n"
+                             "layout (location = 3) in dvec3 instanceRow0;\n"
+                             "layout (location = 4) in dvec3 instanceRow1;\n"
                              "uniform vec2 window;\n"
                              "uniform dmat3 ctm;\n"
                              "uniform int enableTex;\n"
+                             "uniform int enableInstance;\n"
                              "out vec2 TexCoord;\n"
+                             "out float Selected;\n"
                              "void main()\n"
                              "{\n"
-                             "   const dvec3 result = ctm * dvec3(pos.x, pos.y, 1.0);\n"
+                             "   const dvec3 point = dvec3(pos.x, pos.y, 1.0);\n"
+                             "   const dvec3 result = ctm * (enableInstance == 1 ?"
+                             " dvec3(dot(instanceRow0, point), dot(instanceRow1, point), 1.0) : point);\n"
                              "   gl_Position = vec4(result.x / window.x - 1.0, 1.0 - result.y / window.y, 1.0, 1.0)"
                              " * step(enableTex, 0) + vec4(pos.x, pos.y, 1.0, 1.0) * step(1, enableTex);\n"
                              "   TexCoord = vec2(texCoord);\n"
+                             "   Selected = selected;\n"
                              "}\0";
 
 const char *const base_fss = "#version 450 core\n"
@@ -23,10 +31,13 @@ const char *const base_fss = "#version 450 core\n"
                              "uniform vec4 color;\n"
                              "uniform int enableTex;\n"
                              "uniform sampler2D textTexture;\n"
+                             "uniform vec4 selectedColor;\n"
                              "in vec2 TexCoord;\n"
+                             "in float Selected;\n"
                              "void main()\n"
                              "{\n"
-                             "   FragColor = color * step(enableTex, 0) + texture(textTexture, TexCoord) * step(1, enableTex);\n"
+                             "   FragColor = mix(color, selectedColor, Selected) * step(enableTex, 0)"
+                             " + texture(textTexture, TexCoord) * step(1, enableTex);\n"
                              "}\0";
 
 }; // namespace GLSL
\ No newline at end of file
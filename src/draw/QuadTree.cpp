@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <unordered_set>
 #include "QuadTree.hpp"
 #include "base/Algorithm.hpp"
@@ -22,7 +23,7 @@ void QuadTreeNode::clear()
         delete _nodes[i];
         _nodes[i] = nullptr;
     }
-    _objects.clear();
+    _entries.clear();
     _rect.left = _rect.top = _rect.right = _rect.bottom = 0;
 }
 
@@ -31,7 +32,12 @@ Geo::AABBRectParams &QuadTreeNode::rect()
     return _rect;
 }
 
-void QuadTreeNode::find_visible_objects(const Geo::AABBRectParams &rect, std::vector<Geo::Geometry *> &visible_objects)
+const Geo::AABBRectParams &QuadTreeNode::rect() const
+{
+    return _rect;
+}
+
+void QuadTreeNode::find_entries(const Geo::AABBRectParams &rect, const size_t query, std::vector<QuadTreeEntry *> &entries)
 {
     if (!Geo::is_intersected(_rect, rect))
     {
@@ -42,44 +48,40 @@ void QuadTreeNode::find_visible_objects(const Geo::AABBRectParams &rect, std::ve
     {
         for (int i = 0; i < 4; ++i)
         {
-            _nodes[i]->find_visible_objects(rect, visible_objects);
+            _nodes[i]->find_entries(rect, query, entries);
         }
     }
     else
     {
-        if (rect.bottom <= _rect.bottom && rect.left <= _rect.left && rect.right >= _rect.right && rect.top >= _rect.top)
-        {
-            visible_objects.insert(visible_objects.end(), _objects.begin(), _objects.end());
-        }
-        else
+        const bool contained = rect.bottom <= _rect.bottom && rect.left <= _rect.left && rect.right >= _rect.right && rect.top >= _rect.top;
+        for (QuadTreeEntry *entry : _entries)
         {
-            for (Geo::Geometry *object : _objects)
+            // 跨越多个节点的图形只在本次查询第一次遇到时加入
+            if (entry->query != query && (contained || Geo::is_intersected(rect, entry->rect)))
             {
-                if (Geo::is_intersected(rect, object->aabbrect_params()))
-                {
-                    visible_objects.push_back(object);
-                }
+                entry->query = query;
+                entries.push_back(entry);
             }
         }
     }
 }
 
-void QuadTreeNode::build(const Geo::AABBRectParams &rect, const std::vector<Geo::Geometry *> &objects)
+void QuadTreeNode::build(const Geo::AABBRectParams &rect, const std::vector<QuadTreeEntry *> &entries)
 {
     _rect = rect;
-    _objects.clear();
+    _entries.clear();
     for (int i = 0; i < 4; ++i)
     {
         delete _nodes[i];
         _nodes[i] = nullptr;
     }
-    if (objects.empty())
+    if (entries.empty())
     {
         return;
     }
 
     if (const double width = rect.right - rect.left, height = rect.top - rect.bottom;
-        _depth < max_depth && objects.size() > min_size && (width > min_width || height > min_height))
+        _depth < max_depth && entries.size() > min_size && (width > min_width || height > min_height))
     {
         Geo::AABBRectParams rects[4];
         rects[0].left = rect.left, rects[0].top = rect.top, rects[0].right = (rect.left + rect.right) / 2,
@@ -91,15 +93,14 @@ void QuadTreeNode::build(const Geo::AABBRectParams &rect, const std::vector<Geo:
         rects[2].left = (rect.left + rect.right) / 2, rects[2].top = (rect.top + rect.bottom) / 2, rects[2].right = rect.right,
         rects[2].bottom = rect.bottom;
 
-        std::vector<Geo::Geometry *> children[4];
-        for (Geo::Geometry *object : objects)
+        std::vector<QuadTreeEntry *> children[4];
+        for (QuadTreeEntry *entry : entries)
         {
-            const Geo::AABBRectParams params = object->aabbrect_params();
             for (int i = 0; i < 4; ++i)
             {
-                if (Geo::is_intersected(rects[i], params))
+                if (Geo::is_intersected(rects[i], entry->rect))
                 {
-                    children[i].push_back(object);
+                    children[i].push_back(entry);
                 }
             }
         }
@@ -111,19 +112,19 @@ void QuadTreeNode::build(const Geo::AABBRectParams &rect, const std::vector<Geo:
     }
     else
     {
-        _objects.assign(objects.begin(), objects.end());
+        _entries.assign(entries.begin(), entries.end());
     }
 }
 
-void QuadTreeNode::update(const Geo::AABBRectParams &rect, Geo::Geometry *object)
+void QuadTreeNode::update(QuadTreeEntry *entry)
 {
     if (_nodes[0] != nullptr || _nodes[1] != nullptr || _nodes[2] != nullptr || _nodes[3] != nullptr)
     {
-        if (Geo::is_intersected(_rect, rect))
+        if (Geo::is_intersected(_rect, entry->rect))
         {
             for (int i = 0; i < 4; ++i)
             {
-                _nodes[i]->update(rect, object);
+                _nodes[i]->update(entry);
             }
             if (_nodes[0]->empty() && _nodes[1]->empty() && _nodes[2]->empty() && _nodes[3]->empty())
             {
@@ -136,37 +137,37 @@ void QuadTreeNode::update(const Geo::AABBRectParams &rect, Geo::Geometry *object
         }
         else
         {
-            remove(object);
+            remove(entry);
         }
     }
     else
     {
-        if (Geo::is_intersected(_rect, rect))
+        if (Geo::is_intersected(_rect, entry->rect))
         {
-            if (std::find(_objects.begin(), _objects.end(), object) == _objects.end())
+            if (std::find(_entries.begin(), _entries.end(), entry) == _entries.end())
             {
-                _objects.push_back(object);
-                if (_objects.size() > min_size && (_rect.top - _rect.bottom > min_height || _rect.right - _rect.left > min_width))
+                _entries.push_back(entry);
+                if (_entries.size() > min_size && (_rect.top - _rect.bottom > min_height || _rect.right - _rect.left > min_width))
                 {
-                    std::vector<Geo::Geometry *> objects(_objects);
-                    build(_rect, objects);
+                    std::vector<QuadTreeEntry *> entries(_entries);
+                    build(_rect, entries);
                 }
             }
         }
         else
         {
-            _objects.erase(std::remove(_objects.begin(), _objects.end(), object), _objects.end());
+            _entries.erase(std::remove(_entries.begin(), _entries.end(), entry), _entries.end());
         }
     }
 }
 
-void QuadTreeNode::remove(Geo::Geometry *object)
+void QuadTreeNode::remove(QuadTreeEntry *entry)
 {
     if (_nodes[0] != nullptr || _nodes[1] != nullptr || _nodes[2] != nullptr || _nodes[3] != nullptr)
     {
         for (QuadTreeNode *node : _nodes)
         {
-            node->remove(object);
+            node->remove(entry);
         }
         if (_nodes[0]->empty() && _nodes[1]->empty() && _nodes[2]->empty() && _nodes[3]->empty())
         {
@@ -179,17 +180,17 @@ void QuadTreeNode::remove(Geo::Geometry *object)
     }
     else
     {
-        _objects.erase(std::remove(_objects.begin(), _objects.end(), object), _objects.end());
+        _entries.erase(std::remove(_entries.begin(), _entries.end(), entry), _entries.end());
     }
 }
 
-void QuadTreeNode::remove(const std::vector<Geo::Geometry *> &objects)
+void QuadTreeNode::remove(const std::vector<QuadTreeEntry *> &entries)
 {
     if (_nodes[0] != nullptr || _nodes[1] != nullptr || _nodes[2] != nullptr || _nodes[3] != nullptr)
     {
         for (int i = 0; i < 4; ++i)
         {
-            _nodes[i]->remove(objects);
+            _nodes[i]->remove(entries);
         }
         if (_nodes[0]->empty() && _nodes[1]->empty() && _nodes[2]->empty() && _nodes[3]->empty())
         {
@@ -202,16 +203,16 @@ void QuadTreeNode::remove(const std::vector<Geo::Geometry *> &objects)
     }
     else
     {
-        for (Geo::Geometry *object : objects)
+        for (QuadTreeEntry *entry : entries)
         {
-            _objects.erase(std::remove(_objects.begin(), _objects.end(), object), _objects.end());
+            _entries.erase(std::remove(_entries.begin(), _entries.end(), entry), _entries.end());
         }
     }
 }
 
-void QuadTreeNode::append(const Geo::AABBRectParams &rect, Geo::Geometry *object)
+void QuadTreeNode::append(QuadTreeEntry *entry)
 {
-    if (!Geo::is_intersected(_rect, rect))
+    if (!Geo::is_intersected(_rect, entry->rect))
     {
         return;
     }
@@ -219,18 +220,18 @@ void QuadTreeNode::append(const Geo::AABBRectParams &rect, Geo::Geometry *object
     {
         for (QuadTreeNode *node : _nodes)
         {
-            node->append(rect, object);
+            node->append(entry);
         }
     }
-    else if (_depth >= max_depth || _objects.size() < min_size)
+    else if (_depth >= max_depth || _entries.size() < min_size)
     {
-        _objects.push_back(object);
+        _entries.push_back(entry);
     }
     else
     {
-        std::vector<Geo::Geometry *> objects(_objects);
-        objects.push_back(object);
-        build(_rect, objects);
+        std::vector<QuadTreeEntry *> entries(_entries);
+        entries.push_back(entry);
+        build(_rect, entries);
     }
 }
 
@@ -238,7 +239,7 @@ bool QuadTreeNode::empty() const
 {
     if (_nodes[0] == nullptr || _nodes[1] == nullptr || _nodes[2] == nullptr || _nodes[3] == nullptr)
     {
-        return _objects.empty();
+        return _entries.empty();
     }
     else
     {
@@ -247,45 +248,313 @@ bool QuadTreeNode::empty() const
 }
 
 
+void QuadTree::record(Geo::Geometry *object, const Change change, Changes &changes)
+{
+    auto it = changes.changes.find(object);
+    if (it == changes.changes.end())
+    {
+        changes.changes.emplace(object, change);
+        changes.objects.push_back(object);
+        return;
+    }
+    switch (change)
+    {
+    case Change::Remove:
+        if (it->second == Change::Append)
+        {
+            changes.changes.erase(it); // 加入后又移除,无需更新
+        }
+        else
+        {
+            it->second = Change::Remove;
+        }
+        break;
+    case Change::Append:
+        if (it->second == Change::Remove)
+        {
+            it->second = Change::Update;
+        }
+        break;
+    case Change::Update:
+        break;
+    }
+}
+
+void QuadTree::take(Changes &changes, std::vector<Geo::Geometry *> &removed, std::vector<Geo::Geometry *> &appended,
+                    std::vector<Geo::Geometry *> &updated)
+{
+    for (Geo::Geometry *object : changes.objects)
+    {
+        if (auto it = changes.changes.find(object); it != changes.changes.end())
+        {
+            switch (it->second)
+            {
+            case Change::Remove:
+                removed.push_back(object);
+                break;
+            case Change::Append:
+                appended.push_back(object);
+                break;
+            case Change::Update:
+                updated.push_back(object);
+                break;
+            }
+            changes.changes.erase(it);
+        }
+    }
+    changes.changes.clear();
+    changes.objects.clear();
+}
+
+void QuadTree::begin_batch()
+{
+    ++_batch_depth;
+}
+
+void QuadTree::end_batch()
+{
+    if (_batch_depth == 0 || --_batch_depth > 0)
+    {
+        return;
+    }
+
+    std::vector<Geo::Geometry *> removed, appended, updated;
+    take(_batch, removed, appended, updated);
+    remove(removed);
+    append(appended);
+    update(updated);
+}
+
+void QuadTree::notify_removed(const std::vector<Geo::Geometry *> &kept)
+{
+    if (!_removed_callback)
+    {
+        return;
+    }
+    const std::unordered_set<const Geo::Geometry *> temp(kept.begin(), kept.end());
+    for (const auto &[object, entry] : _entries)
+    {
+        if (temp.count(object) == 0)
+        {
+            _removed_callback(object);
+        }
+    }
+    for (const auto &[object, change] : _batch.changes)
+    {
+        if (change == Change::Append && temp.count(object) == 0)
+        {
+            _removed_callback(object);
+        }
+    }
+}
+
 void QuadTree::clear()
 {
+    notify_removed({});
+    _batch = Changes();
     _root.clear();
     _objects.clear();
+    _entries.clear();
+    _snap_index.clear();
+    _snap_changes = Changes();
+    _modifications.clear();
+    ++_version;
+    ++_modification;
+}
+
+void QuadTree::set_removed_callback(std::function<void(const Geo::Geometry *)> callback)
+{
+    _removed_callback = std::move(callback);
+}
+
+size_t QuadTree::version() const
+{
+    return _version;
+}
+
+size_t QuadTree::modification() const
+{
+    return _modification;
+}
+
+size_t QuadTree::modification(const Geo::Geometry *object) const
+{
+    if (auto it = _modifications.find(object); it != _modifications.end())
+    {
+        return it->second;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+const Geo::AABBRectParams *QuadTree::rect(const Geo::Geometry *object) const
+{
+    if (auto it = _entries.find(object); it != _entries.end())
+    {
+        return &it->second.rect;
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+const Geo::AABBRectParams &QuadTree::rect() const
+{
+    return _root.rect();
+}
+
+SnapIndex &QuadTree::snap_index()
+{
+    // 索引只覆盖可见区域向四周各扩展半个视图的范围,小幅平移无需重建;视图移出覆盖范围或图形数量变化较大时重建
+    if (!_snap_index.covers(_visible_rect) || _snap_index.stale())
+    {
+        const double dx = (_visible_rect.right - _visible_rect.left) / 2, dy = (_visible_rect.top - _visible_rect.bottom) / 2;
+        Geo::AABBRectParams range = _visible_rect;
+        range.left -= dx;
+        range.right += dx;
+        range.bottom -= dy;
+        range.top += dy;
+        _found.clear();
+        _root.find_entries(range, ++_query, _found);
+        std::vector<SnapIndex::Object> objects;
+        objects.reserve(_found.size());
+        for (const QuadTreeEntry *entry : _found)
+        {
+            objects.emplace_back(entry->object, entry->rect);
+        }
+        _snap_index.build(range, objects);
+        _snap_changes = Changes();
+        return _snap_index;
+    }
+
+    std::vector<Geo::Geometry *> removed, appended, updated;
+    take(_snap_changes, removed, appended, updated);
+    for (const std::vector<Geo::Geometry *> *objects : {&removed, &updated})
+    {
+        for (const Geo::Geometry *object : *objects)
+        {
+            _snap_index.remove(object);
+        }
+    }
+    appended.insert(appended.end(), updated.begin(), updated.end());
+    std::vector<SnapIndex::Object> neighbours;
+    for (Geo::Geometry *object : appended)
+    {
+        const auto it = _entries.find(object);
+        if (it == _entries.end() || !_snap_index.overlaps(it->second.rect))
+        {
+            continue;
+        }
+        // 从四叉树中查找包围盒相交的图形求交点
+        _found.clear();
+        neighbours.clear();
+        _root.find_entries(it->second.rect, ++_query, _found);
+        for (const QuadTreeEntry *other : _found)
+        {
+            if (other != &it->second)
+            {
+                neighbours.emplace_back(other->object, other->rect);
+            }
+        }
+        _snap_index.append(SnapIndex::Object(object, it->second.rect), neighbours);
+    }
+    return _snap_index;
+}
+
+std::vector<QuadTreeEntry *> QuadTree::all_entries()
+{
+    std::vector<QuadTreeEntry *> entries;
+    entries.reserve(_entries.size());
+    for (auto &[object, entry] : _entries)
+    {
+        entries.push_back(&entry);
+    }
+    return entries;
 }
 
 void QuadTree::find_visible_objects(const Geo::AABBRectParams &rect, std::vector<Geo::Geometry *> &visible_objects)
 {
-    _root.find_visible_objects(rect, visible_objects);
-    std::unordered_set<Geo::Geometry *> temp(visible_objects.begin(), visible_objects.end());
-    visible_objects.assign(temp.begin(), temp.end());
-    std::sort(visible_objects.begin(), visible_objects.end());
+    _found.clear();
+    _root.find_entries(rect, ++_query, _found);
+    visible_objects.reserve(visible_objects.size() + _found.size());
+    for (const QuadTreeEntry *entry : _found)
+    {
+        visible_objects.push_back(entry->object);
+    }
 }
 
-void QuadTree::find_visible_objects(const Geo::AABBRectParams &rect)
+void QuadTree::set_visible_rect(const Geo::AABBRectParams &rect)
 {
-    _visible_objects.clear();
-    find_visible_objects(rect, _visible_objects);
+    if (rect.left != _visible_rect.left || rect.top != _visible_rect.top || rect.right != _visible_rect.right ||
+        rect.bottom != _visible_rect.bottom)
+    {
+        _visible_rect = rect;
+        _visible_modification = SIZE_MAX;
+    }
 }
 
-const std::vector<Geo::Geometry *> &QuadTree::visible_objects() const
+const std::vector<Geo::Geometry *> &QuadTree::visible_objects()
 {
+    if (_visible_modification != _modification)
+    {
+        _visible_objects.clear();
+        find_visible_objects(_visible_rect, _visible_objects);
+        std::sort(_visible_objects.begin(), _visible_objects.end());
+        _visible_modification = _modification;
+    }
     return _visible_objects;
 }
 
+void QuadTree::find_objects(const Geo::AABBRectParams &rect, std::vector<Geo::Geometry *> &contained,
+                            std::vector<Geo::Geometry *> &crossed)
+{
+    _found.clear();
+    _root.find_entries(rect, ++_query, _found);
+    for (const QuadTreeEntry *entry : _found)
+    {
+        if (const Geo::AABBRectParams &params = entry->rect; params.left >= rect.left && params.right <= rect.right &&
+                                                              params.bottom >= rect.bottom && params.top <= rect.top)
+        {
+            contained.push_back(entry->object);
+        }
+        else
+        {
+            crossed.push_back(entry->object);
+        }
+    }
+}
+
 void QuadTree::build(const std::vector<Geo::Geometry *> &objects)
 {
+    notify_removed(objects);
+    _batch = Changes(); // 重建后未提交的修改已包含在objects中
+    _snap_index.clear();
+    _snap_changes = Changes();
+    _entries.clear();
+    _modifications.clear();
+    ++_version;
+    ++_modification;
     if (objects.empty())
     {
         Geo::AABBRectParams rect;
         rect.left = rect.bottom = -100;
         rect.top = 600;
         rect.right = 1000;
-        return _root.build(rect, objects);
+        return _root.build(rect, {});
     }
     Geo::AABBRectParams rect = objects.front()->aabbrect_params();
+    std::vector<QuadTreeEntry *> entries;
+    entries.reserve(objects.size());
     for (Geo::Geometry *object : objects)
     {
         Geo::AABBRectParams temp = object->aabbrect_params();
+        QuadTreeEntry &entry = _entries[object];
+        entry.object = object, entry.rect = temp;
+        entries.push_back(&entry);
+        _modifications.insert_or_assign(object, _modification);
         if (temp.left < rect.left)
         {
             rect.left = temp.left;
@@ -308,7 +577,7 @@ void QuadTree::build(const std::vector<Geo::Geometry *> &objects)
     rect.right += std::max(width / 20, 100.0);
     rect.top += std::max(height / 20, 100.0);
     rect.bottom -= std::max(height / 20, 100.0);
-    _root.build(rect, objects);
+    _root.build(rect, entries);
     _objects.assign(objects.begin(), objects.end());
 }
 
@@ -331,10 +600,22 @@ void QuadTree::build(const Graph *graph)
 
 void QuadTree::update(Geo::Geometry *object)
 {
-    if (Geo::AABBRectParams rect = object->aabbrect_params(); rect.left >= _root.rect().left && rect.right <= _root.rect().right &&
-                                                              rect.bottom >= _root.rect().bottom && rect.top <= _root.rect().top)
+    if (_batch_depth > 0)
     {
-        _root.update(rect, object);
+        return record(object, Change::Update, _batch);
+    }
+    if (_snap_index.valid())
+    {
+        record(object, Change::Update, _snap_changes);
+    }
+    _modifications.insert_or_assign(object, ++_modification);
+    Geo::AABBRectParams rect = object->aabbrect_params();
+    QuadTreeEntry &entry = _entries[object];
+    entry.object = object, entry.rect = rect;
+    if (rect.left >= _root.rect().left && rect.right <= _root.rect().right && rect.bottom >= _root.rect().bottom &&
+        rect.top <= _root.rect().top)
+    {
+        _root.update(&entry);
     }
     else
     {
@@ -359,7 +640,7 @@ void QuadTree::update(Geo::Geometry *object)
         rect.right += std::max(width / 20, 100.0);
         rect.top += std::max(height / 20, 100.0);
         rect.bottom -= std::max(height / 20, 100.0);
-        _root.build(rect, _objects);
+        _root.build(rect, all_entries());
     }
 }
 
@@ -369,12 +650,31 @@ void QuadTree::update(const std::vector<Geo::Geometry *> &objects)
     {
         return;
     }
+    if (_batch_depth > 0)
+    {
+        for (Geo::Geometry *object : objects)
+        {
+            record(object, Change::Update, _batch);
+        }
+        return;
+    }
+    ++_modification;
+    for (Geo::Geometry *object : objects)
+    {
+        if (_snap_index.valid())
+        {
+            record(object, Change::Update, _snap_changes);
+        }
+        _modifications.insert_or_assign(object, _modification);
+    }
     Geo::AABBRectParams rect = objects.front()->aabbrect_params();
-    std::vector<Geo::AABBRectParams> rects({rect});
+    std::vector<QuadTreeEntry *> entries;
     for (Geo::Geometry *object : objects)
     {
         const Geo::AABBRectParams temp = object->aabbrect_params();
-        rects.emplace_back(temp);
+        QuadTreeEntry &entry = _entries[object];
+        entry.object = object, entry.rect = temp;
+        entries.push_back(&entry);
         if (temp.left < rect.left)
         {
             rect.left = temp.left;
@@ -395,9 +695,9 @@ void QuadTree::update(const std::vector<Geo::Geometry *> &objects)
     if (rect.left >= _root.rect().left && rect.right <= _root.rect().right && rect.bottom >= _root.rect().bottom &&
         rect.top <= _root.rect().top)
     {
-        for (size_t i = 0, count = objects.size(); i < count; ++i)
+        for (QuadTreeEntry *entry : entries)
         {
-            _root.update(rects[i], objects[i]);
+            _root.update(entry);
         }
     }
     else
@@ -423,13 +723,32 @@ void QuadTree::update(const std::vector<Geo::Geometry *> &objects)
         rect.right += std::max(width / 20, 100.0);
         rect.top += std::max(height / 20, 100.0);
         rect.bottom -= std::max(height / 20, 100.0);
-        _root.build(rect, objects);
+        _root.build(rect, all_entries());
     }
 }
 
 void QuadTree::remove(Geo::Geometry *object)
 {
-    _root.remove(object);
+    if (_removed_callback)
+    {
+        _removed_callback(object);
+    }
+    if (_batch_depth > 0)
+    {
+        return record(object, Change::Remove, _batch);
+    }
+    if (_snap_index.valid())
+    {
+        record(object, Change::Remove, _snap_changes);
+    }
+    if (auto it = _entries.find(object); it != _entries.end())
+    {
+        _root.remove(&it->second);
+        _entries.erase(it);
+    }
+    _modifications.erase(object);
+    ++_version;
+    ++_modification;
     _objects.erase(std::remove(_objects.begin(), _objects.end(), object), _objects.end());
 }
 
@@ -439,20 +758,66 @@ void QuadTree::remove(const std::vector<Geo::Geometry *> &objects)
     {
         return;
     }
-    _root.remove(objects);
+    if (_removed_callback)
+    {
+        for (const Geo::Geometry *object : objects)
+        {
+            _removed_callback(object);
+        }
+    }
+    if (_batch_depth > 0)
+    {
+        for (Geo::Geometry *object : objects)
+        {
+            record(object, Change::Remove, _batch);
+        }
+        return;
+    }
+    std::vector<QuadTreeEntry *> entries;
     for (Geo::Geometry *object : objects)
     {
-        _objects.erase(std::remove(_objects.begin(), _objects.end(), object), _objects.end());
+        if (auto it = _entries.find(object); it != _entries.end())
+        {
+            entries.push_back(&it->second);
+        }
+    }
+    _root.remove(entries);
+    ++_version;
+    ++_modification;
+    for (Geo::Geometry *object : objects)
+    {
+        if (_snap_index.valid())
+        {
+            record(object, Change::Remove, _snap_changes);
+        }
+        _entries.erase(object);
+        _modifications.erase(object);
     }
+    const std::unordered_set<Geo::Geometry *> temp(objects.begin(), objects.end());
+    _objects.erase(std::remove_if(_objects.begin(), _objects.end(), [&](Geo::Geometry *object) { return temp.count(object) > 0; }),
+                   _objects.end());
 }
 
 void QuadTree::append(Geo::Geometry *object)
 {
+    if (_batch_depth > 0)
+    {
+        return record(object, Change::Append, _batch);
+    }
+    if (_snap_index.valid())
+    {
+        record(object, Change::Append, _snap_changes);
+    }
+    ++_version;
+    _modifications.insert_or_assign(object, ++_modification);
     _objects.push_back(object);
-    if (Geo::AABBRectParams rect = object->aabbrect_params(); rect.left >= _root.rect().left && rect.right <= _root.rect().right &&
-                                                              rect.bottom >= _root.rect().bottom && rect.top <= _root.rect().top)
+    Geo::AABBRectParams rect = object->aabbrect_params();
+    QuadTreeEntry &entry = _entries[object];
+    entry.object = object, entry.rect = rect;
+    if (rect.left >= _root.rect().left && rect.right <= _root.rect().right && rect.bottom >= _root.rect().bottom &&
+        rect.top <= _root.rect().top)
     {
-        _root.append(rect, object);
+        _root.append(&entry);
     }
     else
     {
@@ -477,7 +842,7 @@ void QuadTree::append(Geo::Geometry *object)
         rect.right += std::max(width / 20, 100.0);
         rect.top += std::max(height / 20, 100.0);
         rect.bottom -= std::max(height / 20, 100.0);
-        _root.build(rect, _objects);
+        _root.build(rect, all_entries());
     }
 }
 
@@ -487,13 +852,33 @@ void QuadTree::append(const std::vector<Geo::Geometry *> &objects)
     {
         return;
     }
+    if (_batch_depth > 0)
+    {
+        for (Geo::Geometry *object : objects)
+        {
+            record(object, Change::Append, _batch);
+        }
+        return;
+    }
     _objects.insert(_objects.end(), objects.begin(), objects.end());
+    ++_modification;
+    for (Geo::Geometry *object : objects)
+    {
+        if (_snap_index.valid())
+        {
+            record(object, Change::Append, _snap_changes);
+        }
+        _modifications.insert_or_assign(object, _modification);
+    }
+    ++_version;
     Geo::AABBRectParams rect = objects.front()->aabbrect_params();
-    std::vector<Geo::AABBRectParams> rects;
+    std::vector<QuadTreeEntry *> entries;
     for (Geo::Geometry *object : objects)
     {
         Geo::AABBRectParams temp = object->aabbrect_params();
-        rects.emplace_back(temp);
+        QuadTreeEntry &entry = _entries[object];
+        entry.object = object, entry.rect = temp;
+        entries.push_back(&entry);
         if (temp.left < rect.left)
         {
             rect.left = temp.left;
@@ -514,9 +899,9 @@ void QuadTree::append(const std::vector<Geo::Geometry *> &objects)
     if (rect.left >= _root.rect().left && rect.right <= _root.rect().right && rect.bottom >= _root.rect().bottom &&
         rect.top <= _root.rect().top)
     {
-        for (size_t i = 0, count = objects.size(); i < count; ++i)
+        for (QuadTreeEntry *entry : entries)
         {
-            _root.append(rects[i], objects[i]);
+            _root.append(entry);
         }
     }
     else
@@ -542,6 +927,6 @@ void QuadTree::append(const std::vector<Geo::Geometry *> &objects)
         rect.right += std::max(width / 20, 100.0);
         rect.top += std::max(height / 20, 100.0);
         rect.bottom -= std::max(height / 20, 100.0);
-        _root.build(rect, _objects);
+        _root.build(rect, all_entries());
     }
 }
@@ -1,8 +1,21 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
 #include <vector>
 #include "base/Geometry.hpp"
 #include "base/Dimension.hpp"
 #include "base/Graph.hpp"
+#include "draw/SnapIndex.hpp"
+
+
+// 四叉树中的图形及其加入或修改时记录的包围盒,节点保存指向它的指针
+struct QuadTreeEntry
+{
+    Geo::Geometry *object = nullptr;
+    Geo::AABBRectParams rect;
+    size_t query = 0; // 最后一次查询到该图形的查询序号,跨越多个节点的图形在一次查询中只返回一次
+};
 
 
 class QuadTreeNode
@@ -11,7 +24,7 @@ private:
     static const int min_height = 60, min_width = 80, max_depth = 5, multithreading_depth = 5, min_size = 64;
     int _depth = 1;
     Geo::AABBRectParams _rect;
-    std::vector<Geo::Geometry *> _objects;
+    std::vector<QuadTreeEntry *> _entries;
     QuadTreeNode *_nodes[4] = {nullptr, nullptr, nullptr, nullptr};
 
 public:
@@ -25,17 +38,20 @@ public:
 
     Geo::AABBRectParams &rect();
 
-    void find_visible_objects(const Geo::AABBRectParams &rect, std::vector<Geo::Geometry *> &visible_objects);
+    const Geo::AABBRectParams &rect() const;
 
-    void build(const Geo::AABBRectParams &rect, const std::vector<Geo::Geometry *> &objects);
+    // 查找包围盒与rect相交的图形,query为本次查询的序号,已标记为query的图形不重复加入
+    void find_entries(const Geo::AABBRectParams &rect, const size_t query, std::vector<QuadTreeEntry *> &entries);
 
-    void update(const Geo::AABBRectParams &rect, Geo::Geometry *object);
+    void build(const Geo::AABBRectParams &rect, const std::vector<QuadTreeEntry *> &entries);
 
-    void remove(Geo::Geometry *object);
+    void update(QuadTreeEntry *entry);
 
-    void remove(const std::vector<Geo::Geometry *> &objects);
+    void remove(QuadTreeEntry *entry);
+
+    void remove(const std::vector<QuadTreeEntry *> &entries);
 
-    void append(const Geo::AABBRectParams &rect, Geo::Geometry *object);
+    void append(QuadTreeEntry *entry);
 
     bool empty() const;
 };
@@ -44,20 +60,91 @@ public:
 class QuadTree
 {
 private:
+    enum class Change
+    {
+        Remove,
+        Append,
+        Update
+    };
+
+    // 按首次记录的顺序保存各图形的净变化
+    struct Changes
+    {
+        std::unordered_map<Geo::Geometry *, Change> changes;
+        std::vector<Geo::Geometry *> objects;
+    };
+
     QuadTreeNode _root;
     std::vector<Geo::Geometry *> _objects, _visible_objects;
+    Geo::AABBRectParams _visible_rect;
+    size_t _visible_modification = SIZE_MAX; // 查找_visible_objects时的_modification
+    std::unordered_map<const Geo::Geometry *, QuadTreeEntry> _entries; // 各图形的包围盒,元素地址在删除前不变
+    size_t _query = 0;                                                 // 查询序号,每次查询递增
+    std::vector<QuadTreeEntry *> _found;                               // 查询结果的缓冲区
+    SnapIndex _snap_index;
+    Changes _snap_changes; // 捕捉点索引构建后尚未应用的修改,查询索引时统一应用
+    size_t _version = 0; // 增删图形时递增
+    size_t _modification = 0; // 增删改图形时递增
+    std::unordered_map<const Geo::Geometry *, size_t> _modifications; // 各图形最后一次加入或修改时的_modification
+    size_t _batch_depth = 0;
+    Changes _batch; // 批量修改期间各图形的净变化
+    std::function<void(const Geo::Geometry *)> _removed_callback; // 图形移出四叉树时调用
+
+private:
+    static void record(Geo::Geometry *object, const Change change, Changes &changes);
+
+    // 取出changes中的净变化并清空changes
+    static void take(Changes &changes, std::vector<Geo::Geometry *> &removed, std::vector<Geo::Geometry *> &appended,
+                     std::vector<Geo::Geometry *> &updated);
+
+    // 全部图形的条目,用于重建节点
+    std::vector<QuadTreeEntry *> all_entries();
+
+    // 清空或重建前对不在kept中的图形调用_removed_callback,含批量修改中待加入的图形
+    void notify_removed(const std::vector<Geo::Geometry *> &kept);
 
 public:
     void clear();
 
+    // 图形移出四叉树(含清空和重建)时调用callback,批量修改期间在移除时立即调用,回调中不应访问图形
+    void set_removed_callback(std::function<void(const Geo::Geometry *)> callback);
+
+    size_t version() const;
+
+    // 增删改图形的计数,只平移缩放视图时不变
+    size_t modification() const;
+
+    // object最后一次加入或修改时的modification(),不在四叉树中时返回0
+    size_t modification(const Geo::Geometry *object) const;
+
+    // 图形加入四叉树时记录的包围盒,不在四叉树中时返回nullptr
+    const Geo::AABBRectParams *rect(const Geo::Geometry *object) const;
+
+    // 四叉树覆盖的区域
+    const Geo::AABBRectParams &rect() const;
+
+    // 可见区域附近图形的捕捉点索引,视图移出覆盖范围或图形数量变化较大时重建,否则只应用期间增删改的图形
+    SnapIndex &snap_index();
+
+    // 向visible_objects追加包围盒与rect相交的图形,结果不排序
     void find_visible_objects(const Geo::AABBRectParams &rect, std::vector<Geo::Geometry *> &visible_objects);
 
-    void find_visible_objects(const Geo::AABBRectParams &rect);
+    // 记录可见区域,可见图形在visible_objects取用时才查找,平移视图只需记录区域
+    void set_visible_rect(const Geo::AABBRectParams &rect);
 
-    const std::vector<Geo::Geometry *> &visible_objects() const;
+    // 包围盒与可见区域相交的图形,按地址排序,可见区域或图形变化后首次取用时重新查找
+    const std::vector<Geo::Geometry *> &visible_objects();
+
+    // 查找包围盒与rect相交的图形,包围盒在rect内的放入contained,其余放入crossed,结果不排序
+    void find_objects(const Geo::AABBRectParams &rect, std::vector<Geo::Geometry *> &contained, std::vector<Geo::Geometry *> &crossed);
 
     void build(const std::vector<Geo::Geometry *> &objects);
 
+    // 开始批量修改,期间的增删改只做记录,最外层end_batch时合并为一次更新,此前的查询结果不包含这些修改
+    void begin_batch();
+
+    void end_batch();
+
     void build(const Graph *graph);
 
     void update(Geo::Geometry *object);
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "SnapIndex.hpp"
+#include "base/Algorithm.hpp"
+#include "base/Container.hpp"
+
+
+void SnapIndex::insert(const Item &item)
+{
+    const unsigned long long key = _grid.key(item.point);
+    _cells[key].push_back(item);
+    _object_cells[item.object0].push_back(key);
+    if (item.object1 != nullptr)
+    {
+        _object_cells[item.object1].push_back(key);
+    }
+}
+
+void SnapIndex::object_points(const Geo::Geometry *object, std::vector<Item> &items)
+{
+    Item item;
+    item.object0 = object;
+    switch (object->type())
+    {
+    case Geo::Type::POLYLINE:
+    case Geo::Type::POLYGON:
+        {
+            const Geo::Polyline &polyline = *static_cast<const Geo::Polyline *>(object);
+            item.type = Type::Vertex;
+            for (const Geo::Point &point : polyline)
+            {
+                item.point = point;
+                items.push_back(item);
+            }
+            item.type = Type::Center;
+            for (size_t i = 1, count = polyline.size(); i < count; ++i)
+            {
+                item.point = (polyline[i - 1] + polyline[i]) / 2;
+                items.push_back(item);
+            }
+        }
+        break;
+    case Geo::Type::CIRCLE:
+        {
+            const Geo::Circle *circle = static_cast<const Geo::Circle *>(object);
+            const double x = circle->x, y = circle->y, r = circle->radius;
+            const Geo::Point points[5] = {Geo::Point(x, y), Geo::Point(x - r, y), Geo::Point(x + r, y), Geo::Point(x, y + r),
+                                          Geo::Point(x, y - r)};
+            item.type = Type::Vertex;
+            for (const Geo::Point &point : points)
+            {
+                item.point = point;
+                items.push_back(item);
+            }
+        }
+        break;
+    case Geo::Type::ELLIPSE:
+        {
+            const Geo::Ellipse *ellipse = static_cast<const Geo::Ellipse *>(object);
+            item.type = Type::Vertex;
+            if (ellipse->is_arc())
+            {
+                item.point = ellipse->shape().front();
+                items.push_back(item);
+                item.point = ellipse->shape().back();
+                items.push_back(item);
+            }
+            else
+            {
+                for (const Geo::Point &point : {ellipse->center(), ellipse->a0(), ellipse->a1(), ellipse->b0(), ellipse->b1()})
+                {
+                    item.point = point;
+                    items.push_back(item);
+                }
+            }
+        }
+        break;
+    case Geo::Type::BSPLINE:
+        item.type = Type::Vertex;
+        for (const Geo::Point &point : static_cast<const Geo::BSpline *>(object)->path_points)
+        {
+            item.point = point;
+            items.push_back(item);
+        }
+        break;
+    case Geo::Type::BEZIER:
+        item.type = Type::Vertex;
+        item.point = static_cast<const Geo::CubicBezier *>(object)->front();
+        items.push_back(item);
+        item.point = static_cast<const Geo::CubicBezier *>(object)->back();
+        items.push_back(item);
+        break;
+    case Geo::Type::ARC:
+        item.type = Type::Vertex;
+        for (const Geo::Point &point : static_cast<const Geo::Arc *>(object)->control_points)
+        {
+            item.point = point;
+            items.push_back(item);
+        }
+        break;
+    case Geo::Type::POINT:
+        item.type = Type::Vertex;
+        item.point = *static_cast<const Geo::Point *>(object);
+        items.push_back(item);
+        break;
+    default:
+        break;
+    }
+}
+
+void SnapIndex::append_points(const Geo::Geometry *object)
+{
+    std::vector<Item> items;
+    if (object->type() != Geo::Type::ARRAY)
+    {
+        object_points(object, items);
+        for (const Item &item : items)
+        {
+            insert(item);
+        }
+        return;
+    }
+
+    // 阵列的捕捉点为源图形的捕捉点经各实例矩阵变换后的位置
+    const Array *array = static_cast<const Array *>(object);
+    std::vector<const Geo::Geometry *> sources(array->source().begin(), array->source().end());
+    while (!sources.empty())
+    {
+        const Geo::Geometry *source = sources.back();
+        sources.pop_back();
+        if (const Combination *combination = dynamic_cast<const Combination *>(source))
+        {
+            sources.insert(sources.end(), combination->begin(), combination->end());
+        }
+        else
+        {
+            object_points(source, items);
+        }
+    }
+    for (size_t i = 0, count = array->size(); i < count; ++i)
+    {
+        for (Item item : items)
+        {
+            item.point.transform((*array)[i].data());
+            item.object0 = object;
+            insert(item);
+        }
+    }
+}
+
+void SnapIndex::append_intersections(const Geo::Geometry *object0, const Geo::AABBRectParams &rect0, const Geo::Geometry *object1,
+                                     const Geo::AABBRectParams &rect1)
+{
+    // 交点只可能位于两个包围盒的公共区域内
+    const double left = std::max(rect0.left, rect1.left), right = std::min(rect0.right, rect1.right);
+    const double bottom = std::max(rect0.bottom, rect1.bottom), top = std::min(rect0.top, rect1.top);
+    if (left > right || bottom > top)
+    {
+        return;
+    }
+    const Geo::Point center((left + right) / 2, (top + bottom) / 2);
+    const double distance = std::hypot(right - left, top - bottom) / 2 + Geo::EPSILON;
+    std::vector<Geo::Point> points;
+    if (!Geo::find_intersections(object0, object1, center, distance, points))
+    {
+        return;
+    }
+    Item item;
+    item.type = Type::Intersection;
+    item.object0 = object0;
+    item.object1 = object1;
+    for (const Geo::Point &point : points)
+    {
+        item.point = point;
+        insert(item);
+    }
+}
+
+bool SnapIndex::valid() const
+{
+    return _valid;
+}
+
+bool SnapIndex::contains(const Geo::Geometry *object) const
+{
+    return _objects.find(object) != _objects.end();
+}
+
+bool SnapIndex::covers(const Geo::AABBRectParams &rect) const
+{
+    return _valid && _range.left <= rect.left && _range.right >= rect.right && _range.bottom <= rect.bottom && _range.top >= rect.top;
+}
+
+bool SnapIndex::overlaps(const Geo::AABBRectParams &rect) const
+{
+    return rect.left <= _range.right && rect.right >= _range.left && rect.bottom <= _range.top && rect.top >= _range.bottom;
+}
+
+bool SnapIndex::stale() const
+{
+    // 数量较少时网格边长影响不大,不必重建
+    const size_t count = std::max<size_t>(_objects.size(), 64), fit_count = std::max<size_t>(_fit_count, 64);
+    return count > fit_count * 4 || count * 4 < fit_count;
+}
+
+void SnapIndex::clear()
+{
+    _valid = false;
+    _cells.clear();
+    _object_cells.clear();
+    _objects.clear();
+}
+
+void SnapIndex::build(const Geo::AABBRectParams &range, const std::vector<Object> &objects)
+{
+    clear();
+    _valid = true;
+    _range = range;
+    _fit_count = objects.size();
+
+    // 图形范围裁剪到覆盖范围后确定网格边长
+    Geo::AABBRectParams extent{DBL_MAX, -DBL_MAX, -DBL_MAX, DBL_MAX};
+    for (const auto &[object, rect] : objects)
+    {
+        extent.left = std::min(extent.left, rect.left);
+        extent.right = std::max(extent.right, rect.right);
+        extent.bottom = std::min(extent.bottom, rect.bottom);
+        extent.top = std::max(extent.top, rect.top);
+    }
+    extent.left = std::max(extent.left, range.left);
+    extent.right = std::min(extent.right, range.right);
+    extent.bottom = std::max(extent.bottom, range.bottom);
+    extent.top = std::min(extent.top, range.top);
+    _grid.fit(extent, objects.size());
+
+    std::vector<Object> items(objects);
+    for (const auto &[object, rect] : items)
+    {
+        append_points(object);
+        _objects.insert(object);
+    }
+
+    // 按包围盒左边界排序后扫描,只对包围盒相交的图形求交点
+    std::sort(items.begin(), items.end(), [](const Object &a, const Object &b) { return a.second.left < b.second.left; });
+    for (size_t i = 0, count = items.size(); i < count; ++i)
+    {
+        const auto &[object0, rect0] = items[i];
+        for (size_t j = i + 1; j < count && items[j].second.left <= rect0.right; ++j)
+        {
+            if (const auto &[object1, rect1] = items[j]; rect1.bottom <= rect0.top && rect1.top >= rect0.bottom)
+            {
+                append_intersections(object0, rect0, object1, rect1);
+            }
+        }
+    }
+}
+
+void SnapIndex::append(const Object &object, const std::vector<Object> &neighbours)
+{
+    if (!_valid || contains(object.first) || !overlaps(object.second))
+    {
+        return;
+    }
+
+    append_points(object.first);
+    for (const auto &[other, other_rect] : neighbours)
+    {
+        if (other != object.first && contains(other))
+        {
+            append_intersections(object.first, object.second, other, other_rect);
+        }
+    }
+    _objects.insert(object.first);
+}
+
+void SnapIndex::remove(const Geo::Geometry *object)
+{
+    if (!_valid)
+    {
+        return;
+    }
+
+    if (auto it = _object_cells.find(object); it != _object_cells.end())
+    {
+        std::vector<unsigned long long> keys(std::move(it->second));
+        _object_cells.erase(it);
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        for (const unsigned long long key : keys)
+        {
+            if (auto cell = _cells.find(key); cell != _cells.end())
+            {
+                cell->second.erase(std::remove_if(cell->second.begin(), cell->second.end(), [=](const Item &item)
+                                                  { return item.object0 == object || item.object1 == object; }),
+                                   cell->second.end());
+                if (cell->second.empty())
+                {
+                    _cells.erase(cell);
+                }
+            }
+        }
+    }
+    _objects.erase(object);
+}
+
+bool SnapIndex::nearest(const Geo::Point &pos, const double distance, const Type type,
+                        const std::function<bool(const Geo::Geometry *)> &filter, Geo::Point &point, double &point_distance) const
+{
+    if (!_valid || _cells.empty())
+    {
+        return false;
+    }
+
+    bool result = false;
+    auto check = [&](const std::vector<Item> &items)
+    {
+        for (const Item &item : items)
+        {
+            if (item.type != type || !filter(item.object0) || (item.object1 != nullptr && !filter(item.object1)))
+            {
+                continue;
+            }
+            if (const double d = Geo::distance(pos, item.point); d <= distance && d < point_distance)
+            {
+                point_distance = d;
+                point = item.point;
+                result = true;
+            }
+        }
+    };
+
+    const long long left = _grid.index(pos.x - distance), right = _grid.index(pos.x + distance);
+    const long long bottom = _grid.index(pos.y - distance), top = _grid.index(pos.y + distance);
+    if (static_cast<double>(right - left + 1) * (top - bottom + 1) > _cells.size())
+    {
+        // 查找范围覆盖的网格比已有网格多时直接遍历已有网格
+        for (const auto &[key, items] : _cells)
+        {
+            check(items);
+        }
+        return result;
+    }
+    for (long long col = left; col <= right; ++col)
+    {
+        for (long long row = bottom; row <= top; ++row)
+        {
+            if (const auto cell = _cells.find(Geo::HashGrid::key(col, row)); cell != _cells.end())
+            {
+                check(cell->second);
+            }
+        }
+    }
+    return result;
+}
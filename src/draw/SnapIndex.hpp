@@ -0,0 +1,80 @@
+#pragma once
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "base/Geometry.hpp"
+#include "base/algorithm/HashGrid.hpp"
+
+
+// 捕捉点索引,按网格存储覆盖范围内图形的顶点、中点和图形间的交点,图形增删改时增量更新
+class SnapIndex
+{
+public:
+    enum class Type
+    {
+        Vertex,
+        Center,
+        Intersection
+    };
+
+    struct Item
+    {
+        Geo::Point point;
+        Type type = Type::Vertex;
+        const Geo::Geometry *object0 = nullptr;
+        const Geo::Geometry *object1 = nullptr; // 交点所在的另一个图形
+    };
+
+    using Object = std::pair<const Geo::Geometry *, Geo::AABBRectParams>; // 图形及其包围盒
+
+private:
+    bool _valid = false;
+    Geo::AABBRectParams _range; // 覆盖范围,只收录包围盒与其相交的图形
+    size_t _fit_count = 0;      // 确定网格边长时的图形数量
+    Geo::HashGrid _grid;
+    std::unordered_map<unsigned long long, std::vector<Item>> _cells;
+    std::unordered_map<const Geo::Geometry *, std::vector<unsigned long long>> _object_cells;
+    std::unordered_set<const Geo::Geometry *> _objects;
+
+private:
+    void insert(const Item &item);
+
+    // object的顶点和中点,不含交点
+    static void object_points(const Geo::Geometry *object, std::vector<Item> &items);
+
+    // 阵列按实例逐个加入源图形的捕捉点
+    void append_points(const Geo::Geometry *object);
+
+    void append_intersections(const Geo::Geometry *object0, const Geo::AABBRectParams &rect0, const Geo::Geometry *object1,
+                              const Geo::AABBRectParams &rect1);
+
+public:
+    bool valid() const;
+
+    bool contains(const Geo::Geometry *object) const;
+
+    // 覆盖范围包含rect
+    bool covers(const Geo::AABBRectParams &rect) const;
+
+    // rect与覆盖范围相交,包围盒为rect的图形应收录
+    bool overlaps(const Geo::AABBRectParams &rect) const;
+
+    // 图形数量与确定网格边长时相差数倍,网格边长已不合适,需重建
+    bool stale() const;
+
+    void clear();
+
+    // 以range为覆盖范围重建索引,objects为包围盒与range相交的图形,由其范围和数量确定网格边长
+    void build(const Geo::AABBRectParams &range, const std::vector<Object> &objects);
+
+    // 加入object,neighbours为包围盒与object相交的图形,只与其中已在索引中的图形求交点
+    void append(const Object &object, const std::vector<Object> &neighbours);
+
+    void remove(const Geo::Geometry *object);
+
+    // 查找pos附近distance范围内type类型的捕捉点,比point_distance更近时更新point和point_distance,filter返回false的图形不参与捕捉
+    bool nearest(const Geo::Point &pos, const double distance, const Type type, const std::function<bool(const Geo::Geometry *)> &filter,
+                 Geo::Point &point, double &point_distance) const;
+};
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "draw/VBOChunks.hpp"
+
+
+void VBOChunks::clear()
+{
+    _cell_size = 0;
+    _modification = 0;
+    _level = INT_MIN;
+    _chunks.clear();
+    _vertex_capacity = _index_capacity = 0;
+    _vertex_end = _index_end = 0;
+}
+
+unsigned int VBOChunks::slot_capacity(const size_t count)
+{
+    return static_cast<unsigned int>(std::min<size_t>(count + count / 2, UINT_MAX / 2));
+}
+
+void VBOChunks::relayout()
+{
+    _vertex_end = _index_end = 0;
+    for (auto &[key, chunk] : _chunks)
+    {
+        chunk.vertex_capacity = slot_capacity(chunk.range.vertex_count);
+        chunk.index_capacity = slot_capacity(chunk.range.index_count);
+        chunk.range.vertex_offset = _vertex_end;
+        chunk.range.index_offset = _index_end;
+        _vertex_end += chunk.vertex_capacity;
+        _index_end += chunk.index_capacity;
+    }
+    // 末尾另留余量供新块追加
+    _vertex_capacity = slot_capacity(_vertex_end);
+    _index_capacity = slot_capacity(_index_end);
+}
+
+int VBOChunks::level(const double pixel)
+{
+    if (pixel > 0 && std::isfinite(pixel))
+    {
+        return std::clamp(static_cast<int>(std::floor(std::log2(pixel))), -1000, 1000);
+    }
+    return INT_MIN;
+}
+
+bool VBOChunks::outdated(const Editor &editor, const double pixel) const
+{
+    return editor.view_modification() != _modification || level(pixel) != _level;
+}
+
+bool VBOChunks::update(const Editor &editor, const std::vector<Item> &items, const double pixel, const bool flush, const Writer &write,
+                       const std::function<unsigned char(const Geo::Geometry *owner)> &selected, Uploads &uploads)
+{
+    const size_t modification = _modification;
+    _modification = editor.view_modification();
+    _level = level(pixel);
+    const double level_pixel = _level == INT_MIN ? 0 : std::exp2(_level);
+
+    std::vector<Geo::AABBRectParams> rects(items.size()); // 各图形所属顶层图形的包围盒
+    double left = DBL_MAX, right = -DBL_MAX, bottom = DBL_MAX, top = -DBL_MAX;
+    for (size_t i = 0, count = items.size(); i < count; ++i)
+    {
+        if (i > 0 && items[i].owner == items[i - 1].owner)
+        {
+            rects[i] = rects[i - 1];
+        }
+        else if (const Geo::AABBRectParams *rect = editor.view_rect(items[i].owner); rect != nullptr)
+        {
+            rects[i] = *rect;
+        }
+        else
+        {
+            rects[i] = items[i].owner->aabbrect_params();
+        }
+        left = std::min(left, rects[i].left);
+        right = std::max(right, rects[i].right);
+        bottom = std::min(bottom, rects[i].bottom);
+        top = std::max(top, rects[i].top);
+    }
+
+    // 块边长取2的幂,图形范围小幅变化时划分保持不变
+    double cell_size = 1;
+    if (const double length = std::max(right - left, top - bottom) / grid_size; length > 0 && std::isfinite(length))
+    {
+        cell_size = std::exp2(std::ceil(std::log2(length)));
+    }
+    if (cell_size != _cell_size)
+    {
+        // 重新划分后全部块都是新块,槽位随块表一起清空,下面会重新排布
+        _cell_size = cell_size;
+        _chunks.clear();
+        _vertex_capacity = _index_capacity = 0;
+        _vertex_end = _index_end = 0;
+    }
+
+    std::map<unsigned long long, std::vector<size_t>> buckets;
+    const Geo::HashGrid grid(_cell_size);
+    for (size_t i = 0, count = items.size(); i < count; ++i)
+    {
+        buckets[grid.key(Geo::Point((rects[i].left + rects[i].right) / 2, (rects[i].bottom + rects[i].top) / 2))].push_back(i);
+    }
+
+    bool changed = false;
+    std::vector<Chunk *> dirty; // 数据需要重新写入缓冲区的块
+    for (auto it = _chunks.begin(); it != _chunks.end();)
+    {
+        if (buckets.find(it->first) == buckets.end())
+        {
+            it = _chunks.erase(it);
+            changed = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    for (const auto &[key, indices] : buckets)
+    {
+        Chunk &chunk = _chunks[key];
+        bool regenerate = flush || chunk.items.size() != indices.size();
+        chunk.rect = Geo::AABBRectParams{DBL_MAX, -DBL_MAX, -DBL_MAX, DBL_MAX};
+        for (size_t i = 0, count = indices.size(); i < count; ++i)
+        {
+            const Item &item = items[indices[i]];
+            const Geo::AABBRectParams &rect = rects[indices[i]];
+            chunk.rect.left = std::min(chunk.rect.left, rect.left);
+            chunk.rect.right = std::max(chunk.rect.right, rect.right);
+            chunk.rect.bottom = std::min(chunk.rect.bottom, rect.bottom);
+            chunk.rect.top = std::max(chunk.rect.top, rect.top);
+            // 旧成员只比较地址,不访问可能已删除的图形
+            regenerate = regenerate || chunk.items[i].object != item.object || chunk.items[i].owner != item.owner ||
+                         editor.view_modification(item.owner) > modification;
+        }
+        if (regenerate)
+        {
+            chunk.items.clear();
+            for (const size_t index : indices)
+            {
+                chunk.items.push_back(items[index]);
+            }
+            chunk.levels.clear();
+            chunk.exact_level = INT_MIN;
+            changed = true;
+        }
+
+        const int current = std::max(_level, chunk.exact_level);
+        if (chunk.levels.find(current) == chunk.levels.end())
+        {
+            Level &data = chunk.levels[current];
+            bool decimated = false;
+            for (const Item &item : chunk.items)
+            {
+                data.offsets.push_back(data.vbo_data.size() / 2);
+                data.index_offsets.push_back(data.ibo_data.size());
+                decimated = write(item.object, level_pixel, data.vbo_data, data.ibo_data) || decimated;
+            }
+            if (!decimated)
+            {
+                // 更精细的级别与此级别相同,不再单独缓存
+                chunk.exact_level = current;
+                chunk.levels.erase(chunk.levels.begin(), chunk.levels.find(current));
+            }
+        }
+        if (regenerate || chunk.level != current)
+        {
+            chunk.level = current;
+            dirty.push_back(&chunk);
+            changed = true;
+        }
+    }
+    if (!changed && !flush)
+    {
+        return false;
+    }
+
+    // 放得下的块原位改写,放不下的块在末尾重新分配槽位,缓冲区容量不足时重新排布全部块
+    bool reallocate = flush;
+    for (Chunk *chunk : dirty)
+    {
+        const Level &data = chunk->levels[chunk->level];
+        chunk->range.vertex_count = data.vbo_data.size() / 2;
+        chunk->range.index_count = data.ibo_data.size();
+        if (reallocate || (chunk->range.vertex_count <= chunk->vertex_capacity && chunk->range.index_count <= chunk->index_capacity))
+        {
+            continue;
+        }
+        chunk->vertex_capacity = slot_capacity(chunk->range.vertex_count);
+        chunk->index_capacity = slot_capacity(chunk->range.index_count);
+        if (static_cast<size_t>(_vertex_end) + chunk->vertex_capacity > _vertex_capacity ||
+            static_cast<size_t>(_index_end) + chunk->index_capacity > _index_capacity)
+        {
+            reallocate = true;
+            continue;
+        }
+        chunk->range.vertex_offset = _vertex_end;
+        chunk->range.index_offset = _index_end;
+        _vertex_end += chunk->vertex_capacity;
+        _index_end += chunk->index_capacity;
+    }
+    if (reallocate)
+    {
+        relayout();
+        dirty.clear();
+        for (auto &[key, chunk] : _chunks)
+        {
+            dirty.push_back(&chunk);
+        }
+    }
+
+    uploads.reallocate = reallocate;
+    uploads.vertex_capacity = _vertex_capacity;
+    uploads.index_capacity = _index_capacity;
+    uploads.vertex_count = uploads.index_count = 0;
+    for (const auto &[key, chunk] : _chunks)
+    {
+        uploads.vertex_count += chunk.range.vertex_count;
+        uploads.index_count += chunk.range.index_count;
+    }
+    for (const Chunk *chunk : dirty)
+    {
+        const Level &data = chunk->levels.at(chunk->level);
+        Upload &upload = uploads.chunks.emplace_back();
+        upload.vertex_offset = chunk->range.vertex_offset;
+        upload.index_offset = chunk->range.index_offset;
+        upload.vbo_data = data.vbo_data;
+        upload.ibo_data = data.ibo_data;
+        for (size_t i = 0, count = chunk->items.size(); i < count; ++i)
+        {
+            Geo::Geometry *object = chunk->items[i].object;
+            object->point_index = chunk->range.vertex_offset + data.offsets[i];
+            object->point_count = (i + 1 < count ? data.offsets[i + 1] : chunk->range.vertex_count) - data.offsets[i];
+            upload.selected_data.insert(upload.selected_data.end(), object->point_count, selected(chunk->items[i].owner));
+        }
+    }
+    return true;
+}
+
+bool VBOChunks::patch(const Geo::Geometry *object, const Writer &write,
+                      const std::function<unsigned char(const Geo::Geometry *owner)> &selected, Uploads &uploads)
+{
+    for (auto &[key, chunk] : _chunks)
+    {
+        // 先按上次写入的顶点位置排除其余块
+        if (object->point_index < chunk.range.vertex_offset || object->point_index >= chunk.range.vertex_offset + chunk.range.vertex_count)
+        {
+            continue;
+        }
+        const auto it = std::find_if(chunk.items.begin(), chunk.items.end(), [=](const Item &item) { return item.object == object; });
+        if (it == chunk.items.end())
+        {
+            continue;
+        }
+
+        const size_t index = it - chunk.items.begin(), count = chunk.items.size();
+        Level &data = chunk.levels.at(chunk.level);
+        std::vector<double> vbo_data;
+        std::vector<unsigned int> ibo_data;
+        write(it->object, _level == INT_MIN ? 0 : std::exp2(_level), vbo_data, ibo_data);
+
+        const size_t vertex_begin = data.offsets[index], index_begin = data.index_offsets[index];
+        const size_t vertex_end = index + 1 < count ? data.offsets[index + 1] : data.vbo_data.size() / 2;
+        const size_t index_end = index + 1 < count ? data.index_offsets[index + 1] : data.ibo_data.size();
+        if (data.vbo_data.size() / 2 - (vertex_end - vertex_begin) + vbo_data.size() / 2 > chunk.vertex_capacity ||
+            data.ibo_data.size() - (index_end - index_begin) + ibo_data.size() > chunk.index_capacity)
+        {
+            return false;
+        }
+
+        for (size_t i = 0, size = vbo_data.size(); i < size; i += 2)
+        {
+            chunk.rect.left = std::min(chunk.rect.left, vbo_data[i]);
+            chunk.rect.right = std::max(chunk.rect.right, vbo_data[i]);
+            chunk.rect.bottom = std::min(chunk.rect.bottom, vbo_data[i + 1]);
+            chunk.rect.top = std::max(chunk.rect.top, vbo_data[i + 1]);
+        }
+        // 新写入的索引从0开始,平移到object的起始顶点,其后图形的索引随顶点数的变化平移
+        for (unsigned int &i : ibo_data)
+        {
+            if (i != UINT_MAX)
+            {
+                i += vertex_begin;
+            }
+        }
+        const long long vertex_delta = static_cast<long long>(vbo_data.size() / 2) - static_cast<long long>(vertex_end - vertex_begin);
+        const long long index_delta = static_cast<long long>(ibo_data.size()) - static_cast<long long>(index_end - index_begin);
+        for (size_t i = index_end, size = data.ibo_data.size(); i < size; ++i)
+        {
+            if (data.ibo_data[i] != UINT_MAX)
+            {
+                data.ibo_data[i] += vertex_delta;
+            }
+        }
+        for (size_t i = index + 1; i < count; ++i)
+        {
+            data.offsets[i] += vertex_delta;
+            data.index_offsets[i] += index_delta;
+        }
+        data.vbo_data.erase(data.vbo_data.begin() + vertex_begin * 2, data.vbo_data.begin() + vertex_end * 2);
+        data.vbo_data.insert(data.vbo_data.begin() + vertex_begin * 2, vbo_data.begin(), vbo_data.end());
+        data.ibo_data.erase(data.ibo_data.begin() + index_begin, data.ibo_data.begin() + index_end);
+        data.ibo_data.insert(data.ibo_data.begin() + index_begin, ibo_data.begin(), ibo_data.end());
+
+        // 只保留按当前级别改写后的数据
+        if (chunk.level != _level)
+        {
+            chunk.levels[_level] = std::move(data);
+        }
+        for (auto cached = chunk.levels.begin(); cached != chunk.levels.end();)
+        {
+            cached = cached->first == _level ? std::next(cached) : chunk.levels.erase(cached);
+        }
+        chunk.level = _level;
+        chunk.exact_level = INT_MIN;
+
+        const Level &patched = chunk.levels.at(_level);
+        chunk.range.vertex_count = patched.vbo_data.size() / 2;
+        chunk.range.index_count = patched.ibo_data.size();
+        Upload &upload = uploads.chunks.emplace_back();
+        upload.vertex_offset = chunk.range.vertex_offset;
+        upload.index_offset = chunk.range.index_offset;
+        upload.vbo_data = patched.vbo_data;
+        upload.ibo_data = patched.ibo_data;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Geo::Geometry *item = chunk.items[i].object;
+            item->point_index = chunk.range.vertex_offset + patched.offsets[i];
+            item->point_count = (i + 1 < count ? patched.offsets[i + 1] : chunk.range.vertex_count) - patched.offsets[i];
+            upload.selected_data.insert(upload.selected_data.end(), item->point_count, selected(chunk.items[i].owner));
+        }
+        return true;
+    }
+    return false;
+}
+
+void VBOChunks::visible_ranges(const Geo::AABBRectParams &rect, std::vector<Range> &ranges) const
+{
+    for (const auto &[key, chunk] : _chunks)
+    {
+        if (chunk.range.vertex_count > 0 && Geo::is_intersected(rect, chunk.rect))
+        {
+            ranges.push_back(chunk.range);
+        }
+    }
+}
+
+bool VBOChunks::write_polyline(const Geo::Polyline &polyline, const double pixel, std::vector<double> &vbo_data,
+                               std::vector<unsigned int> &ibo_data)
+{
+    if (pixel > 0 && polyline.size() > 2)
+    {
+        const Geo::AABBRectParams rect = polyline.aabbrect_params();
+        if (rect.right - rect.left < pixel && rect.top - rect.bottom < pixel)
+        {
+            ibo_data.push_back(vbo_data.size() / 2);
+            vbo_data.push_back(rect.left);
+            vbo_data.push_back(rect.bottom);
+            ibo_data.push_back(vbo_data.size() / 2);
+            vbo_data.push_back(rect.right);
+            vbo_data.push_back(rect.top);
+            ibo_data.push_back(UINT_MAX);
+            return true;
+        }
+
+        std::vector<size_t> indices;
+        Geo::down_sampling(polyline, pixel / 2, indices);
+        if (indices.size() < polyline.size())
+        {
+            for (const size_t index : indices)
+            {
+                ibo_data.push_back(vbo_data.size() / 2);
+                vbo_data.push_back(polyline[index].x);
+                vbo_data.push_back(polyline[index].y);
+            }
+            ibo_data.push_back(UINT_MAX);
+            return true;
+        }
+    }
+
+    for (const Geo::Point &point : polyline)
+    {
+        ibo_data.push_back(vbo_data.size() / 2);
+        vbo_data.push_back(point.x);
+        vbo_data.push_back(point.y);
+    }
+    ibo_data.push_back(UINT_MAX);
+    return false;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <climits>
+#include <functional>
+#include <map>
+#include <vector>
+#include "base/Editor.hpp"
+#include "base/algorithm/HashGrid.hpp"
+
+
+// 常驻VBO的空间分块,图形按所属顶层图形包围盒的中心划入网格块,每块缓存块内的顶点和块内索引,
+// 只有成员或成员几何变化的块才重新生成,绘制时只提交与可见区域相交的块;
+// 块数据按像素尺寸分级抽稀,缩放跨过2的幂时切换级别,已生成的级别缓存在块中;
+// 各块在VBO和IBO中占据留有余量的固定槽位,重新生成的块放得下时原位改写,只上传变化的块
+class VBOChunks
+{
+public:
+    struct Item
+    {
+        Geo::Geometry *object = nullptr;      // 写入VBO的图形
+        const Geo::Geometry *owner = nullptr; // object所属的顶层图形
+    };
+
+    // 块的绘制区间,索引为块内索引,绘制时以vertex_offset为基准顶点
+    struct Range
+    {
+        unsigned int index_offset = 0;
+        unsigned int index_count = 0;
+        unsigned int vertex_offset = 0;
+        unsigned int vertex_count = 0;
+    };
+
+    // 一个块待写入缓冲区的数据,vertex_offset和index_offset为块的槽位在VBO和IBO中的起点
+    struct Upload
+    {
+        unsigned int vertex_offset = 0;
+        unsigned int index_offset = 0;
+        std::vector<double> vbo_data;
+        std::vector<unsigned int> ibo_data;
+        std::vector<unsigned char> selected_data;
+    };
+
+    struct Uploads
+    {
+        bool reallocate = false; // 为true时需先按容量重新分配缓冲区,chunks包含全部块
+        unsigned int vertex_capacity = 0;
+        unsigned int index_capacity = 0;
+        unsigned int vertex_count = 0; // 全部块的顶点数
+        unsigned int index_count = 0;  // 全部块的索引数
+        std::vector<Upload> chunks;
+
+        bool empty() const
+        {
+            return !reallocate && chunks.empty();
+        }
+    };
+
+    // 以pixel为一个像素的尺寸将object的顶点追加到vbo_data,以vbo_data中的顶点序号向ibo_data追加索引,省略了顶点时返回true
+    using Writer = std::function<bool(Geo::Geometry *object, const double pixel, std::vector<double> &vbo_data,
+                                      std::vector<unsigned int> &ibo_data)>;
+
+private:
+    struct Level
+    {
+        std::vector<unsigned int> offsets;       // 各图形在块内的起始顶点
+        std::vector<unsigned int> index_offsets; // 各图形在块内的起始索引
+        std::vector<double> vbo_data;
+        std::vector<unsigned int> ibo_data;
+    };
+
+    struct Chunk
+    {
+        Geo::AABBRectParams rect; // 块内顶层图形包围盒的并集
+        std::vector<Item> items;
+        std::map<int, Level> levels;
+        int exact_level = INT_MIN; // 该级别未省略任何顶点,更精细的级别与之相同
+        int level = INT_MIN;       // 上次写入缓冲区时使用的级别
+        Range range;
+        unsigned int vertex_capacity = 0; // 槽位容量
+        unsigned int index_capacity = 0;
+    };
+
+    static const int grid_size = 16; // 图形范围长边划分的块数,块边长取不小于范围/grid_size的2的幂
+    double _cell_size = 0;
+    size_t _modification = 0; // 上次更新时视图四叉树的增删改计数
+    int _level = INT_MIN;     // 上次更新时的抽稀级别
+    std::map<unsigned long long, Chunk> _chunks;
+    unsigned int _vertex_capacity = 0; // 缓冲区容量
+    unsigned int _index_capacity = 0;
+    unsigned int _vertex_end = 0; // 已分配槽位的末尾,删除的块留下的空洞在重新排布时回收
+    unsigned int _index_end = 0;
+
+    // 为count个元素的数据留出余量
+    static unsigned int slot_capacity(const size_t count);
+
+    // 按顺序重新排布全部块的槽位
+    void relayout();
+
+public:
+    void clear();
+
+    // 一个像素的尺寸pixel所在的抽稀级别,该级别以2^level为一个像素
+    static int level(const double pixel);
+
+    // 自上次更新后视图四叉树中有图形增删改或抽稀级别变化时返回true,其余平移缩放视图时无需更新
+    bool outdated(const Editor &editor, const double pixel) const;
+
+    // items为VBO中的全部图形,flush为true时重新生成全部块,否则只重新生成成员变化、含有修改过图形或缺少当前级别数据的块;
+    // 有块变化或flush为true时向uploads写入需要上传的块,设置这些块中各图形的point_index和point_count并返回true;
+    // 槽位放不下时为块重新分配槽位,缓冲区容量不足或flush为true时重新排布全部块
+    bool update(const Editor &editor, const std::vector<Item> &items, const double pixel, const bool flush, const Writer &write,
+                const std::function<unsigned char(const Geo::Geometry *owner)> &selected, Uploads &uploads);
+
+    // 按上次更新的级别只重写object在所在块中的数据,块的包围盒只扩大,块的其余级别被丢弃,向uploads追加该块;
+    // object不在任何块中或块的槽位放不下时返回false,此时需要调用update
+    bool patch(const Geo::Geometry *object, const Writer &write, const std::function<unsigned char(const Geo::Geometry *owner)> &selected,
+               Uploads &uploads);
+
+    // 包围盒与rect相交的块的绘制区间
+    void visible_ranges(const Geo::AABBRectParams &rect, std::vector<Range> &ranges) const;
+
+    // 按像素尺寸写入折线:包围盒小于一个像素时只写入包围盒的对角线,否则以半个像素为容差做Douglas-Peucker化简
+    static bool write_polyline(const Geo::Polyline &polyline, const double pixel, std::vector<double> &vbo_data,
+                               std::vector<unsigned int> &ibo_data);
+};
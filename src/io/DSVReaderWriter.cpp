@@ -1,5 +1,6 @@
 #include <set>
 #include <iomanip>
+#include <memory>
 #include <QDebug>
 #include "DSVReaderWriter.hpp"
 #include "io/GlobalSetting.hpp"
@@ -49,8 +50,17 @@ void DSVReaderWriter::write(std::ofstream &stream)
 {
     stream << std::setprecision(16);
     check_group_name(_graph);
-    record_handle(_graph);
-    for (ContainerGroup &group : *_graph)
+    // 阵列按展开后的图形写出
+    std::unique_ptr<Graph> exploded;
+    Graph *graph = _graph;
+    if (_graph->count(Geo::Type::ARRAY, false) > 0)
+    {
+        exploded.reset(_graph->clone());
+        exploded->explode_arrays();
+        graph = exploded.get();
+    }
+    record_handle(graph);
+    for (ContainerGroup &group : *graph)
     {
         _current_layer = group.name.toStdString();
         std::vector<Geo::Geometry *> temp(group.rbegin(), group.rend());
@@ -82,6 +82,9 @@ DXFReaderWriter::~DXFReaderWriter()
 
 void DXFReaderWriter::addHeader(const DRW_Header *data)
 {
+    // 每个文件从头部开始读取,上一个文件的文字样式不再适用
+    _text_style_font.clear();
+    _text_styles.clear();
 }
 
 void DXFReaderWriter::addLType(const DRW_LType &data)
@@ -123,6 +126,26 @@ void DXFReaderWriter::addTextStyle(const DRW_Textstyle &data)
     std::string name;
     std::transform(data.name.begin(), data.name.end(), std::back_inserter(name), [](char c) { return std::tolower(c); });
     _text_style_font.insert_or_assign(name, data.font);
+    // 样式重新定义后,按旧字体缓存的样式序号作废
+    for (auto it = _text_styles.lower_bound(std::make_tuple(name, std::numeric_limits<double>::lowest()));
+         it != _text_styles.end() && std::get<0>(it->first) == name;)
+    {
+        it = _text_styles.erase(it);
+    }
+}
+
+size_t DXFReaderWriter::text_style(const std::string &style, const double height)
+{
+    if (auto it = _text_styles.find(std::make_tuple(style, height)); it != _text_styles.end())
+    {
+        return it->second;
+    }
+    const auto it = _text_style_font.find(style);
+    QFont font(it == _text_style_font.end() ? QString("SimSun") : QString::fromStdString(it->second));
+    font.setPointSizeF(height);
+    const size_t index = TextStyleTable::table().intern(font);
+    _text_styles.emplace(std::make_tuple(style, height), index);
+    return index;
 }
 
 void DXFReaderWriter::addAppId(const DRW_AppId &data)
@@ -993,19 +1016,7 @@ void DXFReaderWriter::addMText(const DRW_MText &data)
         {
             if (group.name.toStdString() == data.layer)
             {
-                Text *text = nullptr;
-                if (_text_style_font.find(style) == _text_style_font.end())
-                {
-                    QFont font("SimSun");
-                    font.setPointSizeF(data.height);
-                    text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 0);
-                }
-                else
-                {
-                    QFont font(QString::fromStdString(_text_style_font[style]));
-                    font.setPointSizeF(data.height);
-                    text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 0);
-                }
+                Text *text = new Text(data.basePoint.x, data.basePoint.y, text_style(style, data.height), txt, 0);
                 text->rotate(text->anchor().x, text->anchor().y, Geo::degree_to_rad(data.angle));
                 group.append(text);
                 _object_map[group.back()] = data.handle;
@@ -1015,19 +1026,7 @@ void DXFReaderWriter::addMText(const DRW_MText &data)
         }
         _graph->append_group();
         _graph->container_groups().back().name = QString::fromStdString(data.layer);
-        Text *text = nullptr;
-        if (_text_style_font.find(style) == _text_style_font.end())
-        {
-            QFont font("SimSun");
-            font.setPointSizeF(data.height);
-            text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 0);
-        }
-        else
-        {
-            QFont font(QString::fromStdString(_text_style_font[style]));
-            font.setPointSizeF(data.height);
-            text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 0);
-        }
+        Text *text = new Text(data.basePoint.x, data.basePoint.y, text_style(style, data.height), txt, 0);
         text->rotate(text->anchor().x, text->anchor().y, Geo::degree_to_rad(data.angle));
         _graph->container_groups().back().append(text);
         _object_map[_graph->container_groups().back().back()] = data.handle;
@@ -1035,19 +1034,7 @@ void DXFReaderWriter::addMText(const DRW_MText &data)
     }
     else
     {
-        Text *text = nullptr;
-        if (_text_style_font.find(style) == _text_style_font.end())
-        {
-            QFont font("SimSun");
-            font.setPointSizeF(data.height);
-            text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 0);
-        }
-        else
-        {
-            QFont font(QString::fromStdString(_text_style_font[style]));
-            font.setPointSizeF(data.height);
-            text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 0);
-        }
+        Text *text = new Text(data.basePoint.x, data.basePoint.y, text_style(style, data.height), txt, 0);
         text->rotate(text->anchor().x, text->anchor().y, Geo::degree_to_rad(data.angle));
         _combination->append(text);
         _object_map[_combination->back()] = data.handle;
@@ -1072,19 +1059,7 @@ void DXFReaderWriter::addText(const DRW_Text &data)
         {
             if (group.name.toStdString() == data.layer)
             {
-                Text *text = nullptr;
-                if (_text_style_font.find(style) == _text_style_font.end())
-                {
-                    QFont font("SimSun");
-                    font.setPointSizeF(data.height);
-                    text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 3);
-                }
-                else
-                {
-                    QFont font(QString::fromStdString(_text_style_font[style]));
-                    font.setPointSizeF(data.height);
-                    text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 3);
-                }
+                Text *text = new Text(data.basePoint.x, data.basePoint.y, text_style(style, data.height), txt, 3);
                 text->rotate(text->anchor().x, text->anchor().y, Geo::degree_to_rad(data.angle));
                 group.append(text);
                 _object_map[group.back()] = data.handle;
@@ -1094,19 +1069,7 @@ void DXFReaderWriter::addText(const DRW_Text &data)
         }
         _graph->append_group();
         _graph->container_groups().back().name = QString::fromStdString(data.layer);
-        Text *text = nullptr;
-        if (_text_style_font.find(style) == _text_style_font.end())
-        {
-            QFont font("SimSun");
-            font.setPointSizeF(data.height);
-            text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 3);
-        }
-        else
-        {
-            QFont font(QString::fromStdString(_text_style_font[style]));
-            font.setPointSizeF(data.height);
-            text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 3);
-        }
+        Text *text = new Text(data.basePoint.x, data.basePoint.y, text_style(style, data.height), txt, 3);
         text->rotate(text->anchor().x, text->anchor().y, Geo::degree_to_rad(data.angle));
         _graph->container_groups().back().append(text);
         _object_map[_graph->container_groups().back().back()] = data.handle;
@@ -1114,19 +1077,7 @@ void DXFReaderWriter::addText(const DRW_Text &data)
     }
     else
     {
-        Text *text = nullptr;
-        if (_text_style_font.find(style) == _text_style_font.end())
-        {
-            QFont font("SimSun");
-            font.setPointSizeF(data.height);
-            text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 3);
-        }
-        else
-        {
-            QFont font(QString::fromStdString(_text_style_font[style]));
-            font.setPointSizeF(data.height);
-            text = new Text(data.basePoint.x, data.basePoint.y, font, txt, 3);
-        }
+        Text *text = new Text(data.basePoint.x, data.basePoint.y, text_style(style, data.height), txt, 3);
         text->rotate(text->anchor().x, text->anchor().y, Geo::degree_to_rad(data.angle));
         _combination->append(text);
         _object_map[_combination->back()] = data.handle;
@@ -1567,6 +1518,24 @@ void DXFReaderWriter::write_geometry_object(const Geo::Geometry *object)
         break;
     case Geo::Type::CONTAINERGROUP:
         break;
+    case Geo::Type::ARRAY:
+        // 阵列展开后逐个写出,其中的组合不再生成块
+        for (Geo::Geometry *item : static_cast<const Array *>(object)->explode())
+        {
+            if (item->type() == Geo::Type::COMBINATION)
+            {
+                for (const Geo::Geometry *child : *static_cast<const Combination *>(item))
+                {
+                    write_geometry_object(child);
+                }
+            }
+            else
+            {
+                write_geometry_object(item);
+            }
+            delete item;
+        }
+        break;
     case Geo::Type::ELLIPSE:
         write_ellipse(static_cast<const Geo::Ellipse *>(object));
         break;
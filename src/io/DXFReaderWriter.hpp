@@ -1,6 +1,7 @@
 #pragma once
 #include <map>
 #include <set>
+#include <tuple>
 #include <unordered_map>
 #include <QString>
 #include "libdxfrw/libdxfrw.h"
@@ -54,6 +55,7 @@ private:
     std::unordered_map<Combination *, std::string> _block_names;
     std::unordered_map<std::string, Combination *> _block_name_map;
     std::unordered_map<std::string, std::string> _text_style_font;
+    std::map<std::tuple<std::string, double>, size_t> _text_styles; // (样式名,字高)-TextStyleTable中的样式序号
     std::unordered_map<int, int> _handle_pairs; // handle-parentHandle
 
 public:
@@ -239,6 +241,9 @@ public:
     void writeAppId() override;
 
 private:
+    // 样式名和字高对应的文字样式,同样的组合只创建一次字体
+    size_t text_style(const std::string &style, const double height);
+
     void write_geometry_object(const Geo::Geometry *object);
 
     void write_bezier(const Geo::CubicBezier *bezier);
@@ -1,4 +1,5 @@
 #include <fstream>
+#include <memory>
 
 #include "io/File.hpp"
 #include "io/GlobalSetting.hpp"
@@ -17,6 +18,15 @@ void File::write_plt(const std::string &path, const Graph *graph)
     const Geo::Arc *arc = nullptr;
     const double x_ratio = 40, y_ratio = 40;
 
+    // 阵列按展开后的图形写出
+    std::unique_ptr<Graph> exploded;
+    if (graph->count(Geo::Type::ARRAY, false) > 0)
+    {
+        exploded.reset(graph->clone());
+        exploded->explode_arrays();
+        graph = exploded.get();
+    }
+
     std::ofstream output(path);
     output << "IN;PA;SP1;" << '\n';
     for (const ContainerGroup &group : graph->container_groups())
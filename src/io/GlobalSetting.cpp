@@ -50,6 +50,14 @@ void GlobalSetting::load_setting()
     {
         this->backup_times = values.value("backup_times").toInt();
     }
+    if (values.contains("backup_memory"))
+    {
+        this->backup_memory = values.value("backup_memory").toInt();
+    }
+    if (values.contains("backup_spill"))
+    {
+        this->backup_spill = values.value("backup_spill").toBool();
+    }
     if (values.contains("catch_distance"))
     {
         this->catch_distance = values.value("catch_distance").toDouble();
@@ -145,6 +153,8 @@ void GlobalSetting::save_setting()
     values.insert("auto_combinate", this->auto_combinate);
     values.insert("auto_save", this->auto_save);
     values.insert("backup_times", this->backup_times);
+    values.insert("backup_memory", this->backup_memory);
+    values.insert("backup_spill", this->backup_spill);
     values.insert("catch_distance", this->catch_distance);
     values.insert("catch_center", this->catch_center);
     values.insert("catch_foot", this->catch_foot);
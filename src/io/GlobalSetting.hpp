@@ -17,6 +17,7 @@ public:
     bool auto_layering = false;
     bool auto_combinate = false;
     bool auto_save = false;
+    bool backup_spill = false; // 撤销记录中被删除的图形写入临时文件
 
     bool catch_center = false;
     bool catch_foot = false;
@@ -32,6 +33,7 @@ public:
     bool show_text = true;
 
     int backup_times = 50;
+    int backup_memory = 256; // 撤销记录的内存上限,单位MB
     int text_size = 16;
     int offset_join_type = 2;
     int offset_end_type = 0;
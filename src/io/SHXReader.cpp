@@ -1,3 +1,6 @@
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include "SHXReader.hpp"
 #include "base/Algorithm.hpp"
 
@@ -61,99 +64,157 @@ SHXShape &SHXShape::normalized_to_origin()
 }
 
 
+ByteView::ByteView(const uchar *data, const size_t size)
+    : _data(data), _size(size)
+{}
+
+const uchar *ByteView::begin() const
+{
+    return _data;
+}
+
+const uchar *ByteView::end() const
+{
+    return _data + _size;
+}
+
+size_t ByteView::size() const
+{
+    return _size;
+}
+
+bool ByteView::empty() const
+{
+    return _size == 0;
+}
+
+ByteView ByteView::sub(const size_t start) const
+{
+    return start < _size ? ByteView(_data + start, _size - start) : ByteView();
+}
+
+uchar ByteView::operator[](const size_t index) const
+{
+    return index < _size ? _data[index] : 0;
+}
+
+
 int SHXFileReader::byte_to_sbyte(const int value)
 {
     return (value & 127) - (value & 128 ? 128 : 0);
 }
 
 SHXFileReader::SHXFileReader(std::ifstream *stream)
-    : _stream(stream)
+    : _buffer(std::make_shared<std::vector<uchar>>())
+{
+    stream->seekg(0, std::ios::end);
+    const std::streamoff length = stream->tellg();
+    stream->clear();
+    stream->seekg(0, std::ios::beg);
+    if (length > 0)
+    {
+        _buffer->resize(length);
+        stream->read(reinterpret_cast<char *>(_buffer->data()), length);
+        _buffer->resize(stream->gcount());
+    }
+    _length = _buffer->size();
+}
+
+void SHXFileReader::read(void *value, const int size)
+{
+    const int count = std::clamp(_length - _position, 0, size);
+    std::memcpy(value, _buffer->data() + _position, count);
+    std::memset(static_cast<uchar *>(value) + count, 0, size - count);
+    _position = std::min(_position + size, _length);
+}
+
+std::shared_ptr<const std::vector<uchar>> SHXFileReader::buffer() const
 {
-    _stream->seekg(0, std::ios::end);
-    _length = _stream->tellg();
-    _stream->clear();
-    _stream->seekg(0, std::ios::beg);
+    return _buffer;
 }
 
-std::vector<uchar> SHXFileReader::read_bytes(const int length)
+ByteView SHXFileReader::read_bytes(const int length)
 {
-    std::vector<uchar> data(length);
-    _stream->read(reinterpret_cast<char *>(data.data()), length);
+    const int count = std::clamp(_length - _position, 0, std::max(length, 0));
+    const ByteView data(_buffer->data() + _position, count);
+    _position += count;
     return data;
 }
 
 void SHXFileReader::skip(const int length)
 {
-    char *data = new char[length];
-    _stream->read(data, length);
-    delete []data;
+    _position = std::clamp(_position + length, 0, _length);
 }
 
 uint8_t SHXFileReader::read_uint8()
 {
-    return _stream->get();
+    uint8_t value = 0;
+    read(&value, sizeof(value));
+    return value;
 }
 
 int8_t SHXFileReader::read_int8()
 {
-    return _stream->get();
+    int8_t value = 0;
+    read(&value, sizeof(value));
+    return value;
 }
 
 uint16_t SHXFileReader::read_uint16()
 {
-    char data[2] = {0, 0};
-    _stream->read(data, 2);
-    return *reinterpret_cast<uint16_t *>(data);
+    uint16_t value = 0;
+    read(&value, sizeof(value));
+    return value;
 }
 
 int16_t SHXFileReader::read_int16()
 {
-    char data[2] = {0, 0};
-    _stream->read(data, 2);
-    return *reinterpret_cast<int16_t *>(data);
+    int16_t value = 0;
+    read(&value, sizeof(value));
+    return value;
 }
 
 uint32_t SHXFileReader::read_uint32()
 {
-    char data[4] = {0, 0, 0, 0};
-    _stream->read(data, 4);
-    return *reinterpret_cast<uint32_t *>(data);
+    uint32_t value = 0;
+    read(&value, sizeof(value));
+    return value;
 }
 
 int32_t SHXFileReader::read_int32()
 {
-    char data[4] = {0, 0, 0, 0};
-    _stream->read(data, 4);
-    return *reinterpret_cast<int32_t *>(data);
+    int32_t value = 0;
+    read(&value, sizeof(value));
+    return value;
 }
 
 float SHXFileReader::read_float32()
 {
-    char data[4] = {0, 0, 0, 0};
-    _stream->read(data, 4);
-    return *reinterpret_cast<float *>(data);
+    float value = 0;
+    read(&value, sizeof(value));
+    return value;
 }
 
 double SHXFileReader::read_float64()
 {
-    char data[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-    _stream->read(data, 8);
-    return *reinterpret_cast<double *>(data);
+    double value = 0;
+    read(&value, sizeof(value));
+    return value;
 }
 
 void SHXFileReader::set_position(const int pos)
 {
-    _stream->seekg(pos);
+    _position = std::clamp(pos, 0, _length);
 }
 
 bool SHXFileReader::is_end() const
 {
-    return _stream->tellg() == _length;
+    return _position >= _length;
 }
 
 int SHXFileReader::position() const
 {
-    return _stream->tellg();
+    return _position;
 }
 
 int SHXFileReader::length() const
@@ -246,6 +307,11 @@ SHXShape SHXShapeParser::char_shape(const int code, const int size)
     return parse_and_scale(code, { scale, 0, 0 });
 }
 
+SHXShape SHXShapeParser::glyph(const int code)
+{
+    return parse_and_scale(code, ScalingOptions());
+}
+
 SHXShape SHXShapeParser::parse_and_scale(const int code, const ScalingOptions &options)
 {
     if (code == 0)
@@ -254,20 +320,24 @@ SHXShape SHXShapeParser::parse_and_scale(const int code, const ScalingOptions &o
     }
 
     SHXShape shape;
-    if (_shape_cache.find(code) == _shape_cache.end())
+    bool found = false;
     {
-        std::map<int, std::vector<uchar>> &codes = _font_data.content.data;
-        if (codes.find(code) != codes.end())
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        if (const auto it = _shape_cache.find(code); it != _shape_cache.end())
         {
-            const std::vector<uchar> &data = codes[code];
-            shape = parse_shape(data);
-            _shape_data.insert_or_assign(code, shape);
-            _shape_cache.insert_or_assign(code, shape);
+            shape = it->second;
+            found = true;
         }
     }
-    else
+    if (!found)
     {
-        shape = _shape_cache[code];
+        if (const auto it = _font_data.content.data.find(code); it != _font_data.content.data.end())
+        {
+            shape = parse_shape(it->second); // 子形会重入缓存,不能持锁解析
+            std::unique_lock<std::shared_mutex> lock(_mutex);
+            _shape_data.insert_or_assign(code, shape);
+            _shape_cache.insert_or_assign(code, shape);
+        }
     }
 
     if (shape.last_point.x == DBL_MAX && shape.last_point.y == DBL_MAX
@@ -326,7 +396,7 @@ void SHXShapeParser::scale(SHXShape &shape, const double height, const double wi
     }
 }
 
-SHXShape SHXShapeParser::parse_shape(const std::vector<uchar> &data)
+SHXShape SHXShapeParser::parse_shape(const ByteView &data)
 {
     State state;
     for (int i = 0, count = data.size(); i < count; ++i)
@@ -346,7 +416,7 @@ SHXShape SHXShapeParser::parse_shape(const std::vector<uchar> &data)
     return shape;
 }
 
-int SHXShapeParser::special_cmd(const int cmd, const std::vector<uchar> &data, const int index, State &state)
+int SHXShapeParser::special_cmd(const int cmd, const ByteView &data, const int index, State &state)
 {
     int i = index;
     switch (cmd)
@@ -520,7 +590,7 @@ Geo::Point SHXShapeParser::vector_direction(const int dir)
     return vec;
 }
 
-int SHXShapeParser::subshape_cmd(const std::vector<uchar> &data, const int index, State &state)
+int SHXShapeParser::subshape_cmd(const ByteView &data, const int index, State &state)
 {
     int i = index, subcode = 0;
     double height = state.scale * _font_data.content.height;
@@ -577,7 +647,7 @@ int SHXShapeParser::subshape_cmd(const std::vector<uchar> &data, const int index
     return i;
 }
 
-int SHXShapeParser::xy_displacement(const std::vector<uchar> &data, const int index, State &state)
+int SHXShapeParser::xy_displacement(const ByteView &data, const int index, State &state)
 {
     int i = index;
     Geo::Point vec;
@@ -598,7 +668,7 @@ int SHXShapeParser::xy_displacement(const std::vector<uchar> &data, const int in
     return i;
 }
 
-int SHXShapeParser::multiple_xy_displacement(const std::vector<uchar> &data, const int index, State &state)
+int SHXShapeParser::multiple_xy_displacement(const ByteView &data, const int index, State &state)
 {
     int i = index;
     while (true)
@@ -627,7 +697,7 @@ int SHXShapeParser::multiple_xy_displacement(const std::vector<uchar> &data, con
     return i;
 }
 
-int SHXShapeParser::octant_arc(const std::vector<uchar> &data, const int index, State &state)
+int SHXShapeParser::octant_arc(const ByteView &data, const int index, State &state)
 {
     int i = index;
     const double radius = data[++i] * state.scale;
@@ -689,7 +759,7 @@ int SHXShapeParser::octant_arc(const std::vector<uchar> &data, const int index,
     return i;
 }
 
-int SHXShapeParser::fractional_arc(const std::vector<uchar> &data, const int index, State &state)
+int SHXShapeParser::fractional_arc(const ByteView &data, const int index, State &state)
 {
     int i = index;
     const int start_offset = data[++i];
@@ -755,7 +825,7 @@ int SHXShapeParser::fractional_arc(const std::vector<uchar> &data, const int ind
     return i;
 }
 
-int SHXShapeParser::bulge_arc(const std::vector<uchar> &data, const int index, State &state)
+int SHXShapeParser::bulge_arc(const ByteView &data, const int index, State &state)
 {
     int i = index;
     Geo::Point vec;
@@ -767,7 +837,7 @@ int SHXShapeParser::bulge_arc(const std::vector<uchar> &data, const int index, S
     return i;
 }
 
-int SHXShapeParser::multiple_bulge_arcs(const std::vector<uchar> &data, const int index, State &state)
+int SHXShapeParser::multiple_bulge_arcs(const ByteView &data, const int index, State &state)
 {
     int i = index;
     while (true)
@@ -786,7 +856,7 @@ int SHXShapeParser::multiple_bulge_arcs(const std::vector<uchar> &data, const in
     return i;
 }
 
-int SHXShapeParser::skip_code(const std::vector<uchar> &data, int index)
+int SHXShapeParser::skip_code(const ByteView &data, int index)
 {
     const int cb = data[index];
     switch (cb) 
@@ -871,14 +941,23 @@ int SHXShapeParser::skip_code(const std::vector<uchar> &data, int index)
 
 SHXShape SHXShapeParser::scale_subshape_at_insert_point(const int code, const double width, const double height, const Geo::Point &point)
 {
-    SHXShape shape = (_shape_cache.find(code) == _shape_cache.end()) ? SHXShape() : _shape_cache[code];
+    SHXShape shape;
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        if (const auto it = _shape_cache.find(code); it != _shape_cache.end())
+        {
+            shape = it->second;
+        }
+    }
     if ((shape.last_point.x < DBL_MAX && shape.last_point.y < DBL_MAX) || !shape.polylines.empty())
     {
-        if (_font_data.content.data.find(code) == _font_data.content.data.end())
+        const auto it = _font_data.content.data.find(code);
+        if (it == _font_data.content.data.end())
         {
             return shape;
         }
-        shape = parse_shape(_font_data.content.data[code]);
+        shape = parse_shape(it->second);
+        std::unique_lock<std::shared_mutex> lock(_mutex);
         _shape_cache.insert_or_assign(code, shape);
         _shape_data.insert_or_assign(code, shape);
     }
@@ -924,6 +1003,7 @@ Geo::Point SHXShapeParser::arc_segment(const Geo::Point &point, Geo::Point vec,
 SHXFontContentData SHXShapeContentParser::parse(SHXFileReader &reader)
 {
     SHXFontContentData result;
+    result.buffer = reader.buffer();
     reader.read_bytes(4);
     const int count = reader.read_int16();
     if (count <= 0)
@@ -943,19 +1023,18 @@ SHXFontContentData SHXShapeContentParser::parse(SHXFileReader &reader)
 
     for (const auto &[code, length] : items)
     {
-        const std::vector<uchar> bytes = reader.read_bytes(length);
-        if (bytes.size() == length) 
+        const ByteView bytes = reader.read_bytes(length);
+        if (bytes.size() == length)
         {
             // Parse and skip the null-terminated label at the beginning of the data
-            const std::vector<uchar>::const_iterator nulit = std::find(bytes.begin(), bytes.end(), 0x00);
-            int startOfBytecode = 0;
+            const uchar *nulit = std::find(bytes.begin(), bytes.end(), 0x00);
             // Handle the null-terminated label header
-            if (nulit != bytes.cend())
+            if (nulit != bytes.end())
             {
-                if (int index = std::distance(bytes.cbegin(), nulit) + 1; index < bytes.size())
+                if (int index = std::distance(bytes.begin(), nulit) + 1; index < bytes.size())
                 {
                     // Only add if we got all the bytes and there's actual bytecode data
-                    result.data.insert_or_assign(code, std::vector<uchar>(bytes.begin() + index, bytes.end()));
+                    result.data.insert_or_assign(code, bytes.sub(index));
                 }
             }
         }
@@ -963,7 +1042,7 @@ SHXFontContentData SHXShapeContentParser::parse(SHXFileReader &reader)
 
     if (result.data.find(0) != result.data.end())
     {
-        const std::vector<uint8_t> infodata = result.data[0];
+        const ByteView infodata = result.data[0];
         const std::string str(infodata.begin(), infodata.end());
         if (size_t index = str.find('\x00'); index != std::string::npos)
         {
@@ -984,6 +1063,7 @@ SHXFontContentData SHXShapeContentParser::parse(SHXFileReader &reader)
 SHXFontContentData SHXBigfontContentParser::parse(SHXFileReader &reader)
 {
     SHXFontContentData result;
+    result.buffer = reader.buffer();
     // const int item_length = reader.read_int16();
     reader.read_int16();
     const int count = reader.read_int16();
@@ -1010,7 +1090,7 @@ SHXFontContentData SHXBigfontContentParser::parse(SHXFileReader &reader)
     for (const auto &[code, length, offset] : items)
     {
         reader.set_position(offset);
-        if (const std::vector<uint8_t> bytes = reader.read_bytes(length); length == bytes.size())
+        if (const ByteView bytes = reader.read_bytes(length); length == bytes.size())
         {
             result.data.insert_or_assign(code, bytes);
         }
@@ -1018,7 +1098,7 @@ SHXFontContentData SHXBigfontContentParser::parse(SHXFileReader &reader)
 
     if (result.data.find(0) != result.data.end())
     {
-        const std::vector<uint8_t> infodata = result.data[0];
+        const ByteView infodata = result.data[0];
         auto [str, pos] = utf8_array_to_str(infodata);
         if (int index = pos; index >= 0)
         {
@@ -1049,7 +1129,7 @@ SHXFontContentData SHXBigfontContentParser::parse(SHXFileReader &reader)
     return result;
 }
 
-std::tuple<std::string, int> SHXBigfontContentParser::utf8_array_to_str(const std::vector<uint8_t> &array)
+std::tuple<std::string, int> SHXBigfontContentParser::utf8_array_to_str(const ByteView &array)
 {
     std::string out;
     int i = 0;
@@ -1094,6 +1174,7 @@ std::tuple<std::string, int> SHXBigfontContentParser::utf8_array_to_str(const st
 SHXFontContentData SHXUnifontContentParser::parse(SHXFileReader &reader)
 {
     SHXFontContentData result;
+    result.buffer = reader.buffer();
     const int count = reader.read_int32();
     if (count <= 0)
     {
@@ -1101,7 +1182,7 @@ SHXFontContentData SHXUnifontContentParser::parse(SHXFileReader &reader)
     }
 
     const int info_length = reader.read_int16();
-    const std::vector<uint8_t> infodata = reader.read_bytes(info_length);
+    const ByteView infodata = reader.read_bytes(info_length);
 
     std::string info(infodata.begin(), infodata.end());
     if (size_t index = info.find('\x00'); index != std::string::npos)
@@ -1123,15 +1204,14 @@ SHXFontContentData SHXUnifontContentParser::parse(SHXFileReader &reader)
         const int length = reader.read_uint16();
         if (length > 0)
         {
-            const std::vector<uint8_t> bytes = reader.read_bytes(length);
+            const ByteView bytes = reader.read_bytes(length);
             if (length == bytes.size())
             {
-                if (const std::vector<uint8_t>::const_iterator it = std::find(bytes.cbegin(), bytes.cend(), 0x00);
-                    it != bytes.cend())
+                if (const uchar *it = std::find(bytes.begin(), bytes.end(), 0x00); it != bytes.end())
                 {
-                    if (int index = std::distance(bytes.cbegin(), it) + 1; index < bytes.size())
+                    if (int index = std::distance(bytes.begin(), it) + 1; index < bytes.size())
                     {
-                        result.data.insert_or_assign(code, std::vector<uint8_t>(bytes.begin() + index, bytes.end()));
+                        result.data.insert_or_assign(code, bytes.sub(index));
                     }
                 }
             }
@@ -1173,9 +1253,10 @@ bool SHXFont::has_char(const int code) const
 
 SHXShape SHXFont::char_shape(const int code, const int size)
 {
-    SHXShape shape = _shapeparser.char_shape(code, size);
+    SHXShape shape = _shapeparser.glyph(code);
     if ((shape.last_point.x < DBL_MAX && shape.last_point.y < DBL_MAX) || !shape.polylines.empty())
     {
+        SHXShapeParser::scale(shape, size / fontdata.content.height);
         if (fontdata.header.type == SHXFontHeaderData::SHXFontType::BIGFONT)
         {
             shape.normalized_to_origin();
@@ -1184,4 +1265,24 @@ SHXShape SHXFont::char_shape(const int code, const int size)
     return shape;
 }
 
-}
\ No newline at end of file
+SHXFont *SHXFont::font(const std::string &path)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::unique_ptr<SHXFont>> fonts;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto it = fonts.find(path); it != fonts.end())
+    {
+        return it->second.get();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return nullptr;
+    }
+    SHXFont *font = new SHXFont(&file);
+    fonts.emplace(path, font);
+    return font;
+}
+
+}
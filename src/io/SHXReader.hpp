@@ -1,8 +1,10 @@
 #pragma once
 #include <map>
 #include <tuple>
+#include <memory>
 #include <string>
 #include <fstream>
+#include <shared_mutex>
 #include "base/Geometry.hpp"
 
 namespace SHXReader
@@ -37,6 +39,34 @@ public:
 };
 
 
+// 字体文件缓冲区中一段字节的视图,不持有数据
+class ByteView
+{
+private:
+    const uchar *_data = nullptr;
+    size_t _size = 0;
+
+public:
+    ByteView() = default;
+
+    ByteView(const uchar *data, const size_t size);
+
+    const uchar *begin() const;
+
+    const uchar *end() const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    // 从start开始到末尾的子视图
+    ByteView sub(const size_t start) const;
+
+    // 越界时返回0
+    uchar operator[](const size_t index) const;
+};
+
+
 struct SHXFontContentData
 {
     bool horizontal = true;
@@ -46,7 +76,8 @@ struct SHXFontContentData
     double height = 10;
     double width = 10;
     std::string info;
-    std::map<int, std::vector<uint8_t>> data;
+    std::shared_ptr<const std::vector<uchar>> buffer; // 字体文件的全部内容
+    std::map<int, ByteView> data;                     // 各字形的字节码,指向buffer
 };
 
 struct SHXFontHeaderData
@@ -66,18 +97,27 @@ struct SHXFontData
 };
 
 
+// 一次读入整个文件,此后的读取都在内存缓冲区中进行
 class SHXFileReader
 {
 private:
-    std::ifstream *_stream = nullptr;
+    std::shared_ptr<std::vector<uchar>> _buffer;
+    int _position = 0;
     int _length = 0;
 
+private:
+    // 读取size字节到value,超出文件末尾的部分填0
+    void read(void *value, const int size);
+
 public:
     static int byte_to_sbyte(const int value);
 
     SHXFileReader(std::ifstream *stream);
 
-    std::vector<uchar> read_bytes(const int length = 1);
+    std::shared_ptr<const std::vector<uchar>> buffer() const;
+
+    // 返回指向缓冲区的视图,不复制数据
+    ByteView read_bytes(const int length = 1);
 
     void skip(const int length);
 
@@ -132,6 +172,7 @@ class SHXShapeParser
 private:
     SHXFontData &_font_data;
     std::map<int, SHXShape> _shape_cache, _shape_data;
+    mutable std::shared_mutex _mutex; // 保护_shape_cache与_shape_data,解析在锁外进行
 
 public:
     struct State
@@ -149,36 +190,39 @@ public:
 
     SHXShape char_shape(const int code, const int size);
 
-private:
-    SHXShape parse_and_scale(const int code, const ScalingOptions &options);
+    // 未缩放的字形,可在多个线程中同时调用
+    SHXShape glyph(const int code);
 
     static void scale(SHXShape &shape, const double factor);
 
+private:
+    SHXShape parse_and_scale(const int code, const ScalingOptions &options);
+
     static void scale(SHXShape &shape, const double height, const double width);
 
-    SHXShape parse_shape(const std::vector<uchar> &data);
+    SHXShape parse_shape(const ByteView &data);
 
-    int special_cmd(const int cmd, const std::vector<uchar> &data, const int index, State &state);
+    int special_cmd(const int cmd, const ByteView &data, const int index, State &state);
 
     static void vector_cmd(const int cmd, State &state);
 
     static Geo::Point vector_direction(const int dir);
 
-    int subshape_cmd(const std::vector<uchar> &data, const int index, State &state);
+    int subshape_cmd(const ByteView &data, const int index, State &state);
 
-    static int xy_displacement(const std::vector<uchar> &data, const int index, State &state);
+    static int xy_displacement(const ByteView &data, const int index, State &state);
 
-    static int multiple_xy_displacement(const std::vector<uchar> &data, const int index, State &state);
+    static int multiple_xy_displacement(const ByteView &data, const int index, State &state);
 
-    static int octant_arc(const std::vector<uchar> &data, const int index, State &state);
+    static int octant_arc(const ByteView &data, const int index, State &state);
 
-    static int fractional_arc(const std::vector<uchar> &data, const int index, State &state);
+    static int fractional_arc(const ByteView &data, const int index, State &state);
 
-    static int bulge_arc(const std::vector<uchar> &data, const int index, State &state);
+    static int bulge_arc(const ByteView &data, const int index, State &state);
 
-    static int multiple_bulge_arcs(const std::vector<uchar> &data, const int index, State &state);
+    static int multiple_bulge_arcs(const ByteView &data, const int index, State &state);
 
-    int skip_code(const std::vector<uchar> &data, int index);
+    int skip_code(const ByteView &data, int index);
 
     SHXShape scale_subshape_at_insert_point(const int code, const double width, const double height, const Geo::Point &point);
 
@@ -206,7 +250,7 @@ public:
     SHXFontContentData parse(SHXFileReader &reader) override;
 
 private:
-    std::tuple<std::string, int> utf8_array_to_str(const std::vector<uint8_t> &array);
+    std::tuple<std::string, int> utf8_array_to_str(const ByteView &array);
 };
 
 class SHXUnifontContentParser : public SHXContentParser
@@ -233,8 +277,12 @@ private:
 public:
     SHXFont(std::ifstream *stream);
 
+    // 进程内共享的字体,每个文件只加载一次,无法打开时返回nullptr
+    static SHXFont *font(const std::string &path);
+
     bool has_char(const int code) const;
 
+    // 可在多个线程中同时调用
     SHXShape char_shape(const int code, const int size);
 };
 
@@ -427,6 +427,12 @@ bool CMDWidget::work()
     _completer->setCurrentRow(0);
     if (std::find(_direct_cmd_list.begin(), _direct_cmd_list.end(), _current_cmd) != _direct_cmd_list.end())
     {
+        // 命令对选中图形的全部修改合并为一个撤销记录,VBO在提交时统一刷新,撤销不能在事务中进行
+        const bool transaction = _current_cmd != CMD::Undo_CMD;
+        if (transaction)
+        {
+            Canvas::canvas->begin_transaction();
+        }
         switch (_current_cmd)
         {
         case CMD::Main_CMD:
@@ -522,9 +528,17 @@ bool CMDWidget::work()
             _current_cmd = CMD::Error_CMD;
             break;
         default:
+            if (transaction)
+            {
+                Canvas::canvas->commit_transaction();
+            }
             clear();
             return false;
         }
+        if (transaction)
+        {
+            Canvas::canvas->commit_transaction();
+        }
         Canvas::canvas->update();
     }
     else
@@ -753,6 +767,14 @@ void CMDWidget::combinate()
                     types.insert(item->type());
                 }
             }
+            else if (const Array *array = dynamic_cast<const Array *>(object))
+            {
+                types.insert(Geo::Type::ARRAY); // 阵列展开后加入组合
+                for (const Geo::Geometry *item : array->source())
+                {
+                    types.insert(item->type());
+                }
+            }
             else
             {
                 types.insert(object->type());
@@ -776,6 +798,14 @@ void CMDWidget::detach()
                 types.insert(item->type());
             }
         }
+        else if (const Array *array = dynamic_cast<const Array *>(object))
+        {
+            types.insert(Geo::Type::ARRAY);
+            for (const Geo::Geometry *item : array->source())
+            {
+                types.insert(item->type());
+            }
+        }
     }
     if (!types.empty())
     {
@@ -821,7 +851,7 @@ void CMDWidget::scale()
                 Canvas::canvas->refresh_vbo(true, types);
                 if (objects.size() == 1)
                 {
-                    Canvas::canvas->refresh_selected_ibo(objects.front());
+                    Canvas::canvas->refresh_selected_ibo();
                 }
                 clear();
             }
@@ -892,22 +922,7 @@ void CMDWidget::line_array()
             Canvas::canvas->editor().line_array(objects, GlobalSetting::setting().array_x_item, GlobalSetting::setting().array_y_item,
                                                 GlobalSetting::setting().array_x_space, GlobalSetting::setting().array_y_space))
         {
-            std::set<Geo::Type> types;
-            for (const Geo::Geometry *object : objects)
-            {
-                if (const Combination *combination = dynamic_cast<const Combination *>(object))
-                {
-                    for (const Geo::Geometry *item : *combination)
-                    {
-                        types.insert(item->type());
-                    }
-                }
-                else
-                {
-                    types.insert(object->type());
-                }
-            }
-            Canvas::canvas->refresh_vbo(false, types);
+            Canvas::canvas->refresh_vbo(false, Geo::Type::ARRAY);
             Canvas::canvas->refresh_selected_ibo();
         }
         clear();
@@ -918,22 +933,7 @@ void CMDWidget::line_array()
             if (std::vector<Geo::Geometry *> objects = Canvas::canvas->editor().selected();
                 Canvas::canvas->editor().line_array(objects, _parameters[1], _parameters[2], _parameters[3], _parameters[4]))
             {
-                std::set<Geo::Type> types;
-                for (const Geo::Geometry *object : objects)
-                {
-                    if (const Combination *combination = dynamic_cast<const Combination *>(object))
-                    {
-                        for (const Geo::Geometry *item : *combination)
-                        {
-                            types.insert(item->type());
-                        }
-                    }
-                    else
-                    {
-                        types.insert(object->type());
-                    }
-                }
-                Canvas::canvas->refresh_vbo(false, types);
+                Canvas::canvas->refresh_vbo(false, Geo::Type::ARRAY);
                 Canvas::canvas->refresh_selected_ibo();
             }
             clear();
@@ -976,7 +976,7 @@ void CMDWidget::flip_x()
     }
     if (objects.size() == 1)
     {
-        Canvas::canvas->refresh_selected_ibo(objects.front());
+        Canvas::canvas->refresh_selected_ibo();
     }
     CanvasOperations::CanvasOperation::operation().clear();
 }
@@ -1011,7 +1011,7 @@ void CMDWidget::flip_y()
     }
     if (objects.size() == 1)
     {
-        Canvas::canvas->refresh_selected_ibo(objects.front());
+        Canvas::canvas->refresh_selected_ibo();
     }
     CanvasOperations::CanvasOperation::operation().clear();
 }
@@ -52,7 +52,12 @@ void MainWindow::init()
     connect(&_clock, &QTimer::timeout, this, &MainWindow::auto_save);
 
     connect(ui->auto_aligning, &QAction::triggered, [this]() { GlobalSetting::setting().auto_aligning = ui->auto_aligning->isChecked(); });
-    connect(ui->actionadvanced, &QAction::triggered, _setting, &Setting::exec);
+    connect(ui->actionadvanced, &QAction::triggered,
+            [this]()
+            {
+                _setting->set_backup_memory_usage(ui->canvas->editor().backup_memory_usage());
+                _setting->exec();
+            });
     connect(ui->show_origin, &QAction::triggered,
             [this]() { ui->show_origin->isChecked() ? ui->canvas->show_origin() : ui->canvas->hide_origin(); });
     connect(ui->show_cmdline, &QAction::triggered,
@@ -570,6 +575,8 @@ void MainWindow::refresh_settings()
         ui->canvas->refresh_vbo(true);
     }
     ui->canvas->editor().set_backup_count(GlobalSetting::setting().backup_times);
+    ui->canvas->editor().set_backup_memory_limit(static_cast<size_t>(GlobalSetting::setting().backup_memory) * 1024 * 1024);
+    ui->canvas->editor().set_backup_spill(GlobalSetting::setting().backup_spill);
     ui->canvas->set_catch_distance(GlobalSetting::setting().catch_distance);
     GlobalSetting::setting().save_setting();
 }
@@ -583,6 +590,8 @@ void MainWindow::load_settings()
 
     ui->canvas->editor().set_path(GlobalSetting::setting().file_path);
     ui->canvas->editor().set_backup_count(GlobalSetting::setting().backup_times);
+    ui->canvas->editor().set_backup_memory_limit(static_cast<size_t>(GlobalSetting::setting().backup_memory) * 1024 * 1024);
+    ui->canvas->editor().set_backup_spill(GlobalSetting::setting().backup_spill);
     ui->auto_save->setChecked(GlobalSetting::setting().auto_save);
     ui->auto_layering->setChecked(GlobalSetting::setting().auto_layering);
     ui->auto_combinate->setChecked(GlobalSetting::setting().auto_combinate);
@@ -24,6 +24,7 @@ void Setting::init()
 
     ui->catch_distance->setValue(GlobalSetting::setting().catch_distance);
     ui->backup_times->setValue(GlobalSetting::setting().backup_times);
+    ui->backup_memory->setValue(GlobalSetting::setting().backup_memory);
     ui->text_size->setValue(GlobalSetting::setting().text_size);
     ui->sampling_step->setValue(GlobalSetting::setting().sampling_step);
     ui->down_sampling->setValue(GlobalSetting::setting().down_sampling);
@@ -48,6 +49,7 @@ void Setting::accept()
 {
     GlobalSetting::setting().catch_distance = ui->catch_distance->value();
     GlobalSetting::setting().backup_times = ui->backup_times->value();
+    GlobalSetting::setting().backup_memory = ui->backup_memory->value();
     GlobalSetting::setting().text_size = ui->text_size->value();
     GlobalSetting::setting().sampling_step = ui->sampling_step->value();
     GlobalSetting::setting().down_sampling = ui->down_sampling->value();
@@ -84,4 +86,9 @@ bool Setting::update_text_vbo() const
 bool Setting::update_curve_vbo() const
 {
     return _down_sampling_value == ui->down_sampling->value();
+}
+
+void Setting::set_backup_memory_usage(const size_t bytes)
+{
+    ui->backup_memory->setToolTip(QString("In use: %1 MB").arg(bytes / 1048576.0, 0, 'f', 1));
 }
\ No newline at end of file
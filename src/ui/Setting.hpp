@@ -33,4 +33,7 @@ public:
     bool update_text_vbo() const;
 
     bool update_curve_vbo() const;
+
+    // 在撤销记录内存上限的提示中显示当前占用
+    void set_backup_memory_usage(const size_t bytes);
 };
\ No newline at end of file